@@ -0,0 +1,396 @@
+#include <stdlib.h>
+#include <string.h>
+#include "aig.h"
+
+// Function to hash the two fanin literals of an AND node
+static unsigned aig_hash(int a, int b) {
+    unsigned h = (unsigned)a * 0x9E3779B1u ^ (unsigned)b * 0x85EBCA77u;
+    return h ^ (h >> 15);
+}
+
+int aig_init(Aig* aig) {
+    memset(aig, 0, sizeof(Aig));
+    aig->capacity = 64;
+    aig->fanin0 = malloc(aig->capacity * sizeof(int));
+    aig->fanin1 = malloc(aig->capacity * sizeof(int));
+    aig->origin = malloc(aig->capacity * sizeof(int));
+    aig->table_mask = 127;
+    aig->table = calloc(aig->table_mask + 1, sizeof(int));
+    if (!aig->fanin0 || !aig->fanin1 || !aig->origin || !aig->table) {
+        aig_free(aig);
+        return -1;
+    }
+    aig->current_origin = -1;
+    aig->fanin0[0] = -1;
+    aig->fanin1[0] = -1;
+    aig->origin[0] = -1;
+    aig->node_count = 1;
+    return 0;
+}
+
+void aig_free(Aig* aig) {
+    free(aig->fanin0);
+    free(aig->fanin1);
+    free(aig->origin);
+    free(aig->inputs);
+    free(aig->outputs);
+    free(aig->table);
+    memset(aig, 0, sizeof(Aig));
+}
+
+// Function to append a node, returns its index or -1 when out of memory
+static int aig_new_node(Aig* aig, int fanin0, int fanin1) {
+    if (aig->node_count == aig->capacity) {
+        int capacity = aig->capacity * 2;
+        int* f0 = realloc(aig->fanin0, capacity * sizeof(int));
+        if (f0) aig->fanin0 = f0;
+        int* f1 = realloc(aig->fanin1, capacity * sizeof(int));
+        if (f1) aig->fanin1 = f1;
+        int* origin = realloc(aig->origin, capacity * sizeof(int));
+        if (origin) aig->origin = origin;
+        if (!f0 || !f1 || !origin) return -1;
+        aig->capacity = capacity;
+    }
+    int node = aig->node_count++;
+    aig->fanin0[node] = fanin0;
+    aig->fanin1[node] = fanin1;
+    aig->origin[node] = aig->current_origin;
+    return node;
+}
+
+// Function to double the structural hash table and reinsert every AND node
+static int aig_grow_table(Aig* aig) {
+    int mask = aig->table_mask * 2 + 1;
+    int* table = calloc(mask + 1, sizeof(int));
+    if (!table) return -1;
+    for (int node = 1; node < aig->node_count; node++) {
+        if (aig->fanin0[node] < 0) continue;
+        unsigned slot = aig_hash(aig->fanin0[node], aig->fanin1[node]) & mask;
+        while (table[slot]) slot = (slot + 1) & mask;
+        table[slot] = node;
+    }
+    free(aig->table);
+    aig->table = table;
+    aig->table_mask = mask;
+    return 0;
+}
+
+int aig_add_input(Aig* aig) {
+    if (aig->input_count == aig->input_capacity) {
+        int capacity = aig->input_capacity ? aig->input_capacity * 2 : 16;
+        int* inputs = realloc(aig->inputs, capacity * sizeof(int));
+        if (!inputs) return -1;
+        aig->inputs = inputs;
+        aig->input_capacity = capacity;
+    }
+    int node = aig_new_node(aig, -1, -1);
+    if (node < 0) return -1;
+    aig->inputs[aig->input_count++] = node;
+    return node;
+}
+
+int aig_add_output(Aig* aig, int lit) {
+    if (aig->output_count == aig->output_capacity) {
+        int capacity = aig->output_capacity ? aig->output_capacity * 2 : 16;
+        int* outputs = realloc(aig->outputs, capacity * sizeof(int));
+        if (!outputs) return -1;
+        aig->outputs = outputs;
+        aig->output_capacity = capacity;
+    }
+    aig->outputs[aig->output_count] = lit;
+    return aig->output_count++;
+}
+
+// Function to fold trivial ANDs and look up the rest in the hash table. Returns
+// the literal, or -1 with *slot set to the empty slot where the node belongs.
+// Operands are only compared, so they need not be nodes of the graph.
+static int aig_find(const Aig* aig, int a, int b, unsigned* slot) {
+    if (a > b) {
+        int t = a;
+        a = b;
+        b = t;
+    }
+    if (a == AIG_FALSE || a == AIG_NOT(b)) return AIG_FALSE;
+    if (a == AIG_TRUE || a == b) return b;
+
+    *slot = aig_hash(a, b) & aig->table_mask;
+    while (aig->table[*slot]) {
+        int node = aig->table[*slot];
+        if (aig->fanin0[node] == a && aig->fanin1[node] == b) return AIG_LIT(node, 0);
+        *slot = (*slot + 1) & aig->table_mask;
+    }
+    return -1;
+}
+
+int aig_lookup(const Aig* aig, int a, int b) {
+    unsigned slot;
+    if (a < 0 || b < 0) return -1;
+    return aig_find(aig, a, b, &slot);
+}
+
+int aig_and(Aig* aig, int a, int b) {
+    if (a < 0 || b < 0) return -1;
+    unsigned slot;
+    int lit = aig_find(aig, a, b, &slot);
+    if (lit >= 0) return lit;
+    if (a > b) {
+        int t = a;
+        a = b;
+        b = t;
+    }
+    // Keep the table at most half full
+    if (2 * (aig->and_count + 1) > aig->table_mask + 1) {
+        if (aig_grow_table(aig) != 0) return -1;
+        slot = aig_hash(a, b) & aig->table_mask;
+        while (aig->table[slot]) slot = (slot + 1) & aig->table_mask;
+    }
+    int node = aig_new_node(aig, a, b);
+    if (node < 0) return -1;
+    aig->table[slot] = node;
+    aig->and_count++;
+    return AIG_LIT(node, 0);
+}
+
+int aig_or(Aig* aig, int a, int b) {
+    if (a < 0 || b < 0) return -1;
+    int nor = aig_and(aig, AIG_NOT(a), AIG_NOT(b));
+    return nor < 0 ? -1 : AIG_NOT(nor);
+}
+
+int aig_xor(Aig* aig, int a, int b) {
+    if (a < 0 || b < 0) return -1;
+    return aig_or(aig, aig_and(aig, a, AIG_NOT(b)), aig_and(aig, AIG_NOT(a), b));
+}
+
+int aig_from_program(Aig* aig, const SimProgram* prog, const int* input_gates, int num_inputs,
+                     const int* output_gates, int num_outputs, int* lit_of_gate) {
+    if (prog->cyclic) return -1;
+    for (int g = 0; g <= prog->gate_count; g++) {
+        lit_of_gate[g] = AIG_FALSE;
+    }
+    while (aig->input_count < num_inputs) {
+        if (aig_add_input(aig) < 0) return -1;
+    }
+    for (int i = 0; i < num_inputs; i++) {
+        int node = aig->inputs[i];
+        if (aig->origin[node] < 0) aig->origin[node] = input_gates[i];
+        lit_of_gate[input_gates[i]] = AIG_LIT(node, 0);
+    }
+
+    // The program is in level order, so every operand is lowered before its reader
+    for (int k = 0; k < prog->instr_count; k++) {
+        const SimInstr* ins = &prog->code[k];
+        int a = lit_of_gate[ins->in0];
+        int b = lit_of_gate[ins->in1];
+        int lit;
+        aig->current_origin = ins->out;
+        switch (ins->op) {
+            case SIM_AND:    lit = aig_and(aig, a, b); break;
+            case SIM_OR:     lit = aig_or(aig, a, b); break;
+            case SIM_NOT:    lit = AIG_NOT(a); break;
+            case SIM_NAND:   lit = aig_and(aig, a, b); lit = lit < 0 ? -1 : AIG_NOT(lit); break;
+            case SIM_NOR:    lit = aig_and(aig, AIG_NOT(a), AIG_NOT(b)); break;
+            case SIM_XOR:    lit = aig_xor(aig, a, b); break;
+            case SIM_OUTPUT: lit = a; break;
+            default:         lit = AIG_FALSE; break;
+        }
+        aig->current_origin = -1;
+        if (lit < 0) return -1;
+        lit_of_gate[ins->out] = lit;
+    }
+
+    for (int o = 0; o < num_outputs; o++) {
+        if (aig_add_output(aig, lit_of_gate[output_gates[o]]) < 0) return -1;
+    }
+    return 0;
+}
+
+int aig_match_xor(const Aig* aig, const int* refs, int v, int* l1, int* l2) {
+    int x = aig->fanin0[v], y = aig->fanin1[v];
+    if (!AIG_IS_COMPLEMENT(x) || !AIG_IS_COMPLEMENT(y)) return 0;
+    int nx = AIG_NODE(x), ny = AIG_NODE(y);
+    if (aig->fanin0[nx] < 0 || aig->fanin0[ny] < 0 || refs[nx] != 1 || refs[ny] != 1) return 0;
+    int a = aig->fanin0[nx], b = aig->fanin1[nx];
+    int c = aig->fanin0[ny], d = aig->fanin1[ny];
+    if (!((c == AIG_NOT(a) && d == AIG_NOT(b)) || (c == AIG_NOT(b) && d == AIG_NOT(a)))) return 0;
+    *l1 = a;
+    *l2 = b;
+    return 1;
+}
+
+// Function to return a netlist gate carrying a literal, given the polarity each
+// node was emitted in. Adds a shared NOT gate when the other polarity is needed;
+// the constant false is an unconnected pin (-1), true a NOT of one.
+static int aig_signal(SimNetlist* net, int* gate_count, const int* gate_of, const unsigned char* flipped,
+                      int* not_of, int lit) {
+    int node = AIG_NODE(lit);
+    int invert = AIG_IS_COMPLEMENT(lit) ^ flipped[node];
+    if (node == 0 && !invert) return -1;
+    if (!invert) return gate_of[node];
+    if (not_of[node] < 0) {
+        int g = (*gate_count)++;
+        net->types[g] = SIM_NOT;
+        net->fanin[g * SIM_MAX_PINS] = node == 0 ? -1 : gate_of[node];
+        not_of[node] = g;
+    }
+    return not_of[node];
+}
+
+int aig_to_netlist(const Aig* aig, SimNetlist* net, int* input_gates, int* output_gates) {
+    int n = aig->node_count;
+    int* refs = calloc(n, sizeof(int));
+    int* xor_a = malloc(n * sizeof(int));
+    int* xor_b = malloc(n * sizeof(int));
+    int* positive = calloc(n, sizeof(int));
+    int* negative = calloc(n, sizeof(int));
+    unsigned char* used = calloc(n, 1);
+    unsigned char* flipped = calloc(n, 1);
+    int* gate_of = malloc(n * sizeof(int));
+    int* not_of = malloc(n * sizeof(int));
+    if (!refs || !xor_a || !xor_b || !positive || !negative || !used || !flipped || !gate_of || !not_of ||
+        sim_netlist_init(net, aig->input_count + 2 * n + aig->output_count + 1) != 0) {
+        free(refs);
+        free(xor_a);
+        free(xor_b);
+        free(positive);
+        free(negative);
+        free(used);
+        free(flipped);
+        free(gate_of);
+        free(not_of);
+        return -1;
+    }
+
+    // Readers of every node inside the cone of the outputs
+    for (int o = 0; o < aig->output_count; o++) {
+        used[AIG_NODE(aig->outputs[o])] = 1;
+        refs[AIG_NODE(aig->outputs[o])]++;
+    }
+    for (int v = n - 1; v > 0; v--) {
+        if (!used[v] || aig->fanin0[v] < 0) continue;
+        used[AIG_NODE(aig->fanin0[v])] = 1;
+        used[AIG_NODE(aig->fanin1[v])] = 1;
+        refs[AIG_NODE(aig->fanin0[v])]++;
+        refs[AIG_NODE(aig->fanin1[v])]++;
+    }
+
+    // Recognize XORs, then mark again with XOR nodes reading their operands directly
+    for (int v = 1; v < n; v++) {
+        xor_a[v] = -1;
+        if (used[v] && aig->fanin0[v] >= 0) aig_match_xor(aig, refs, v, &xor_a[v], &xor_b[v]);
+    }
+    memset(used, 0, n);
+    for (int o = 0; o < aig->output_count; o++) {
+        int lit = aig->outputs[o];
+        used[AIG_NODE(lit)] = 1;
+        if (AIG_IS_COMPLEMENT(lit)) negative[AIG_NODE(lit)]++;
+        else positive[AIG_NODE(lit)]++;
+    }
+    for (int v = n - 1; v > 0; v--) {
+        if (!used[v] || aig->fanin0[v] < 0) continue;
+        int operands[2];
+        operands[0] = xor_a[v] >= 0 ? xor_a[v] : aig->fanin0[v];
+        operands[1] = xor_a[v] >= 0 ? xor_b[v] : aig->fanin1[v];
+        for (int k = 0; k < 2; k++) {
+            used[AIG_NODE(operands[k])] = 1;
+            if (xor_a[v] >= 0) continue;
+            if (AIG_IS_COMPLEMENT(operands[k])) negative[AIG_NODE(operands[k])]++;
+            else positive[AIG_NODE(operands[k])]++;
+        }
+    }
+
+    int gates = 0;
+    for (int v = 0; v < n; v++) {
+        gate_of[v] = -1;
+        not_of[v] = -1;
+    }
+    for (int i = 0; i < aig->input_count; i++) {
+        net->types[gates] = SIM_INPUT;
+        gate_of[aig->inputs[i]] = gates;
+        input_gates[i] = gates++;
+    }
+    for (int v = 1; v < n; v++) {
+        if (!used[v] || aig->fanin0[v] < 0) continue;
+        int g;
+        if (xor_a[v] >= 0) {
+            // An XOR gate of the emitted signals absorbs every inversion into its polarity
+            int a = xor_a[v], b = xor_b[v];
+            flipped[v] = AIG_IS_COMPLEMENT(a) ^ flipped[AIG_NODE(a)] ^ AIG_IS_COMPLEMENT(b) ^ flipped[AIG_NODE(b)];
+            g = gates++;
+            net->types[g] = SIM_XOR;
+            net->fanin[g * SIM_MAX_PINS] = gate_of[AIG_NODE(a)];
+            net->fanin[g * SIM_MAX_PINS + 1] = gate_of[AIG_NODE(b)];
+        } else {
+            int a = aig->fanin0[v], b = aig->fanin1[v];
+            int invert_a = AIG_IS_COMPLEMENT(a) ^ flipped[AIG_NODE(a)];
+            int invert_b = AIG_IS_COMPLEMENT(b) ^ flipped[AIG_NODE(b)];
+            flipped[v] = negative[v] > positive[v];
+            if (invert_a && invert_b) {
+                // !x & !y is NOR(x, y), its complement OR(x, y)
+                g = gates++;
+                net->types[g] = flipped[v] ? SIM_OR : SIM_NOR;
+                net->fanin[g * SIM_MAX_PINS] = gate_of[AIG_NODE(a)];
+                net->fanin[g * SIM_MAX_PINS + 1] = gate_of[AIG_NODE(b)];
+            } else {
+                int in0 = aig_signal(net, &gates, gate_of, flipped, not_of, a);
+                int in1 = aig_signal(net, &gates, gate_of, flipped, not_of, b);
+                g = gates++;
+                net->types[g] = flipped[v] ? SIM_NAND : SIM_AND;
+                net->fanin[g * SIM_MAX_PINS] = in0;
+                net->fanin[g * SIM_MAX_PINS + 1] = in1;
+            }
+        }
+        gate_of[v] = g;
+    }
+    for (int o = 0; o < aig->output_count; o++) {
+        int in = aig_signal(net, &gates, gate_of, flipped, not_of, aig->outputs[o]);
+        int g = gates++;
+        net->types[g] = SIM_OUTPUT;
+        net->fanin[g * SIM_MAX_PINS] = in;
+        output_gates[o] = g;
+    }
+    net->gate_count = gates;
+
+    free(refs);
+    free(xor_a);
+    free(xor_b);
+    free(positive);
+    free(negative);
+    free(used);
+    free(flipped);
+    free(gate_of);
+    free(not_of);
+    return 0;
+}
+
+int aig_depth(const Aig* aig) {
+    int* level = calloc(aig->node_count, sizeof(int));
+    if (!level) return -1;
+    for (int v = 1; v < aig->node_count; v++) {
+        if (aig->fanin0[v] < 0) continue;
+        int l0 = level[AIG_NODE(aig->fanin0[v])], l1 = level[AIG_NODE(aig->fanin1[v])];
+        level[v] = 1 + (l0 > l1 ? l0 : l1);
+    }
+    int depth = 0;
+    for (int o = 0; o < aig->output_count; o++) {
+        if (level[AIG_NODE(aig->outputs[o])] > depth) depth = level[AIG_NODE(aig->outputs[o])];
+    }
+    free(level);
+    return depth;
+}
+
+void aig_simulate(const Aig* aig, uint64_t* values, int nwords) {
+    memset(values, 0, nwords * sizeof(uint64_t));
+    for (int v = 1; v < aig->node_count; v++) {
+        if (aig->fanin0[v] < 0) continue;
+        int a = aig->fanin0[v], b = aig->fanin1[v];
+        const uint64_t* va = values + (size_t)AIG_NODE(a) * nwords;
+        const uint64_t* vb = values + (size_t)AIG_NODE(b) * nwords;
+        uint64_t ma = AIG_IS_COMPLEMENT(a) ? ~0ULL : 0;
+        uint64_t mb = AIG_IS_COMPLEMENT(b) ? ~0ULL : 0;
+        uint64_t* out = values + (size_t)v * nwords;
+        for (int w = 0; w < nwords; w++) {
+            out[w] = (va[w] ^ ma) & (vb[w] ^ mb);
+        }
+    }
+}
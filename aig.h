@@ -0,0 +1,80 @@
+#ifndef AIG_H
+#define AIG_H
+
+#include <stdint.h>
+#include "simulator.h"
+
+// Literals are 2 * node + complement, node 0 is the constant false
+#define AIG_FALSE 0
+#define AIG_TRUE 1
+#define AIG_LIT(node, complement) (2 * (node) + ((complement) ? 1 : 0))
+#define AIG_NODE(lit) ((lit) >> 1)
+#define AIG_IS_COMPLEMENT(lit) ((lit) & 1)
+#define AIG_NOT(lit) ((lit) ^ 1)
+
+// And-inverter graph. Every node after the constant is an input or a two-input
+// AND of two literals, created in topological order. A structural hash table
+// returns the existing node for an AND of the same literals, so duplicate logic
+// is stored (and simulated) once.
+typedef struct {
+    int node_count;
+    int capacity;
+    int* fanin0;            // literals with fanin0 < fanin1, -1 for inputs and the constant
+    int* fanin1;
+    int* origin;            // gate index the node was first created for, -1 if none
+    int current_origin;     // origin given to new nodes
+    int input_count;
+    int input_capacity;
+    int* inputs;            // node of each input
+    int output_count;
+    int output_capacity;
+    int* outputs;           // literal of each output
+    int* table;             // open addressing over AND nodes, 0 = empty slot
+    int table_mask;
+    int and_count;
+} Aig;
+
+int aig_init(Aig* aig);
+void aig_free(Aig* aig);
+
+// Returns the new input's node / the output index, -1 when out of memory
+int aig_add_input(Aig* aig);
+int aig_add_output(Aig* aig, int lit);
+
+// Gate constructors return a literal, -1 when out of memory (or given -1).
+// Constant and trivial operands (a & a, a & !a) fold without new nodes.
+int aig_and(Aig* aig, int a, int b);
+int aig_or(Aig* aig, int a, int b);
+int aig_xor(Aig* aig, int a, int b);
+
+// Literal aig_and would return without adding a node, -1 if it would need one
+int aig_lookup(const Aig* aig, int a, int b);
+
+// Lower a compiled circuit into the graph. Input i of the circuit becomes input i
+// of the graph (created if needed, so a second circuit shares the inputs of the
+// first) and the outputs are appended. lit_of_gate (gate_count + 1 entries)
+// receives the literal of every gate; unconnected pins and INPUT gates not in
+// input_gates read constant 0. Returns -1 on cyclic circuits or out of memory.
+int aig_from_program(Aig* aig, const SimProgram* prog, const int* input_gates, int num_inputs,
+                     const int* output_gates, int num_outputs, int* lit_of_gate);
+
+// Detect AND node v = !(l1 & l2) & !(!l1 & !l2), which is l1 XOR l2 and lowers to
+// one gate. Both inner ANDs must have v as their only reader, refs holding the
+// readers of every node. Returns 1 and the operands, 0 otherwise.
+int aig_match_xor(const Aig* aig, const int* refs, int v, int* l1, int* l2);
+
+// Build a netlist holding only the logic the outputs depend on. Each AND is
+// emitted in the polarity most of its readers want (AND, NAND, OR or NOR, with
+// shared NOT gates for the rest) and AND triples that form an XOR become one XOR
+// gate. INPUT gates come first, OUTPUT gates last; input_gates / output_gates
+// receive them in port order.
+int aig_to_netlist(const Aig* aig, SimNetlist* net, int* input_gates, int* output_gates);
+
+// Longest chain of AND nodes from an input to an output, -1 when out of memory
+int aig_depth(const Aig* aig);
+
+// Simulate nwords * 64 vectors: values holds nwords words per node, the caller
+// fills the input nodes, node 0 and the AND nodes are written
+void aig_simulate(const Aig* aig, uint64_t* values, int nwords);
+
+#endif
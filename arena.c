@@ -0,0 +1,97 @@
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+
+#define ARENA_BLOCK_SIZE (1 << 20)
+#define ARENA_ALIGN 16
+
+static AllocationCounters counters;
+
+struct ArenaBlock {
+    ArenaBlock* next;
+    size_t size;            // bytes in data
+    size_t used;
+    max_align_t data[];
+};
+
+void arena_free(Arena* a) {
+    ArenaBlock* block = a->first;
+    while (block) {
+        ArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+    a->first = NULL;
+    a->current = NULL;
+}
+
+void* arena_alloc(Arena* a, size_t count, size_t size) {
+    if (size != 0 && count > ((size_t)-1 - ARENA_ALIGN) / size) return NULL;
+    size_t bytes = (count * size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    if (bytes == 0) bytes = ARENA_ALIGN;
+
+    // Move on to the first spare block with room, the blocks skipped over stay
+    // where they are and are used again after a release
+    ArenaBlock* block = a->current;
+    while (block && block->size - block->used < bytes) {
+        block = block->next;
+        if (block) block->used = 0;
+    }
+    if (!block) {
+        size_t capacity = bytes > ARENA_BLOCK_SIZE ? bytes : ARENA_BLOCK_SIZE;
+        block = malloc(sizeof(ArenaBlock) + capacity);
+        if (!block) return NULL;
+        counters.arena_blocks++;
+        counters.bytes += sizeof(ArenaBlock) + capacity;
+        block->size = capacity;
+        block->used = 0;
+        // Spare blocks follow current, the new one goes after the last of them
+        ArenaBlock** link = a->current ? &a->current->next : &a->first;
+        while (*link) link = &(*link)->next;
+        block->next = NULL;
+        *link = block;
+    }
+    a->current = block;
+
+    void* memory = (char*)block->data + block->used;
+    block->used += bytes;
+    memset(memory, 0, bytes);
+    return memory;
+}
+
+ArenaMark arena_mark(const Arena* a) {
+    ArenaMark mark = {a->current, a->current ? a->current->used : 0};
+    return mark;
+}
+
+void arena_release(Arena* a, ArenaMark mark) {
+    a->current = mark.block ? mark.block : a->first;
+    if (a->current) a->current->used = mark.block ? mark.used : 0;
+}
+
+size_t arena_reserved(const Arena* a) {
+    size_t bytes = 0;
+    for (const ArenaBlock* block = a->first; block; block = block->next) {
+        bytes += sizeof(ArenaBlock) + block->size;
+    }
+    return bytes;
+}
+
+int array_reserve(void** items, int* capacity, int count, size_t size) {
+    if (count <= *capacity) return 0;
+    int grown = *capacity < 16 ? 16 : *capacity;
+    while (grown < count) {
+        grown = grown > (1 << 29) ? count : grown * 2;
+    }
+    void* bigger = realloc(*items, (size_t)grown * size);
+    if (!bigger) return -1;
+    counters.array_grows++;
+    counters.bytes += (size_t)grown * size;
+    *items = bigger;
+    *capacity = grown;
+    return 0;
+}
+
+AllocationCounters allocation_counters(void) {
+    return counters;
+}
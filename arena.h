@@ -0,0 +1,52 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// Bump allocator for the scratch space of one operation. Allocations come out
+// of large blocks and are never moved; arena_release hands back everything
+// allocated since a mark at once. Blocks are kept for the next operation, so
+// an editor that works on the same circuit again allocates nothing. A
+// zero-initialized Arena is empty.
+typedef struct ArenaBlock ArenaBlock;
+
+typedef struct {
+    ArenaBlock* first;
+    ArenaBlock* current;    // block allocations come from, later blocks are spare
+} Arena;
+
+typedef struct {
+    ArenaBlock* block;
+    size_t used;
+} ArenaMark;
+
+void arena_free(Arena* a);
+
+// count elements of size bytes, aligned for any type and zero-filled.
+// Returns NULL when out of memory.
+void* arena_alloc(Arena* a, size_t count, size_t size);
+
+// Position to release back to
+ArenaMark arena_mark(const Arena* a);
+void arena_release(Arena* a, ArenaMark mark);
+
+// Bytes the arena holds in blocks, in use or spare
+size_t arena_reserved(const Arena* a);
+
+// Make a growable array hold at least count elements of size bytes, doubling
+// its capacity so appending costs amortized O(1). Elements move when it grows,
+// keep an index or a handle rather than a pointer. Returns 0 on success, -1
+// when out of memory, leaving the array as it was.
+int array_reserve(void** items, int* capacity, int count, size_t size);
+
+// Heap calls made by the arenas and growable arrays since the program started,
+// to check that repeating an operation on the same circuit no longer allocates
+typedef struct {
+    long arena_blocks;      // blocks allocated for arenas
+    long array_grows;       // arrays moved to a bigger allocation
+    size_t bytes;           // bytes asked for by both
+} AllocationCounters;
+
+AllocationCounters allocation_counters(void);
+
+#endif
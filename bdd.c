@@ -0,0 +1,654 @@
+#include <stdlib.h>
+#include <string.h>
+#include "bdd.h"
+
+#define BDD_CACHE_SIZE (1 << 18)
+#define BDD_MIN_BUCKETS 64
+#define BDD_REORDER_START 50000
+#define BDD_REORDER_MAX_FRACTION 8   // no automatic sifting beyond max_nodes / 8 nodes
+#define BDD_SIFT_MAX_GROWTH 1.2
+
+static unsigned hash_pair(int a, int b) {
+    return (unsigned)a * 12582917u + (unsigned)b * 4256249u;
+}
+
+static int node_level(const BddManager* m, int f) {
+    return f <= BDD_TRUE ? m->var_count : m->level_of[m->nodes[f].var];
+}
+
+// Function to allocate a subtable with the given power-of-two bucket count
+static int subtable_init(BddSubtable* t, int buckets) {
+    t->buckets = malloc(buckets * sizeof(int));
+    if (!t->buckets) return -1;
+    for (int i = 0; i < buckets; i++) {
+        t->buckets[i] = -1;
+    }
+    t->mask = buckets - 1;
+    t->count = 0;
+    return 0;
+}
+
+int bdd_init(BddManager* m, int var_count, int max_nodes) {
+    memset(m, 0, sizeof(BddManager));
+    m->var_count = var_count;
+    m->max_nodes = max_nodes > 2 ? max_nodes : BDD_DEFAULT_MAX_NODES;
+    m->capacity = 1024;
+    m->nodes = malloc(m->capacity * sizeof(BddNode));
+    m->subtables = calloc(var_count + 1, sizeof(BddSubtable));
+    m->level_of = malloc((var_count + 1) * sizeof(int));
+    m->var_at_level = malloc((var_count + 1) * sizeof(int));
+    m->cache = malloc(BDD_CACHE_SIZE * sizeof(BddCacheEntry));
+    if (!m->nodes || !m->subtables || !m->level_of || !m->var_at_level || !m->cache) {
+        bdd_free(m);
+        return -1;
+    }
+    m->cache_mask = BDD_CACHE_SIZE - 1;
+    for (int i = 0; i < BDD_CACHE_SIZE; i++) {
+        m->cache[i].op = -1;
+    }
+    for (int v = 0; v < var_count; v++) {
+        m->level_of[v] = v;
+        m->var_at_level[v] = v;
+        if (subtable_init(&m->subtables[v], BDD_MIN_BUCKETS) != 0) {
+            bdd_free(m);
+            return -1;
+        }
+    }
+
+    // Terminals sit below every variable and are never freed
+    for (int t = BDD_FALSE; t <= BDD_TRUE; t++) {
+        m->nodes[t].var = var_count;
+        m->nodes[t].low = t;
+        m->nodes[t].high = t;
+        m->nodes[t].next = -1;
+        m->nodes[t].ref = 1;
+    }
+    m->free_list = -1;
+    for (int i = m->capacity - 1; i > BDD_TRUE; i--) {
+        m->nodes[i].next = m->free_list;
+        m->free_list = i;
+    }
+    m->reorder_threshold = BDD_REORDER_START;
+    return 0;
+}
+
+void bdd_free(BddManager* m) {
+    if (m->subtables) {
+        for (int v = 0; v < m->var_count; v++) {
+            free(m->subtables[v].buckets);
+        }
+    }
+    free(m->subtables);
+    free(m->nodes);
+    free(m->level_of);
+    free(m->var_at_level);
+    free(m->cache);
+    memset(m, 0, sizeof(BddManager));
+}
+
+int bdd_ref(BddManager* m, int f) {
+    if (f > BDD_TRUE && m->nodes[f].ref++ == 0) m->dead--;
+    return f;
+}
+
+void bdd_deref(BddManager* m, int f) {
+    if (f > BDD_TRUE && --m->nodes[f].ref == 0) m->dead++;
+}
+
+// Function to double the bucket count of a subtable once chains get long
+static void subtable_grow(BddManager* m, BddSubtable* t) {
+    int size = (t->mask + 1) * 2;
+    int* buckets = malloc(size * sizeof(int));
+    if (!buckets) return;  // keep the longer chains
+    for (int i = 0; i < size; i++) {
+        buckets[i] = -1;
+    }
+    for (int i = 0; i <= t->mask; i++) {
+        int n = t->buckets[i];
+        while (n != -1) {
+            int next = m->nodes[n].next;
+            unsigned h = hash_pair(m->nodes[n].low, m->nodes[n].high) & (size - 1);
+            m->nodes[n].next = buckets[h];
+            buckets[h] = n;
+            n = next;
+        }
+    }
+    free(t->buckets);
+    t->buckets = buckets;
+    t->mask = size - 1;
+}
+
+// Function to take a node off the free list, growing the node array up to max_nodes
+static int alloc_node(BddManager* m) {
+    if (m->free_list == -1) {
+        if (m->capacity >= m->max_nodes) return BDD_ERROR;
+        int capacity = m->capacity * 2 < m->max_nodes ? m->capacity * 2 : m->max_nodes;
+        BddNode* nodes = realloc(m->nodes, capacity * sizeof(BddNode));
+        if (!nodes) return BDD_ERROR;
+        m->nodes = nodes;
+        for (int i = capacity - 1; i >= m->capacity; i--) {
+            m->nodes[i].next = m->free_list;
+            m->free_list = i;
+        }
+        m->capacity = capacity;
+    }
+    int n = m->free_list;
+    m->free_list = m->nodes[n].next;
+    m->live++;
+    return n;
+}
+
+// Function to find or create the node (var ? high : low). A new node starts dead
+// (no references yet) and holds references to both children.
+static int make_node(BddManager* m, int var, int low, int high) {
+    if (low == high) return low;
+    if (low == BDD_ERROR || high == BDD_ERROR) return BDD_ERROR;
+
+    BddSubtable* t = &m->subtables[var];
+    unsigned h = hash_pair(low, high) & t->mask;
+    for (int n = t->buckets[h]; n != -1; n = m->nodes[n].next) {
+        if (m->nodes[n].low == low && m->nodes[n].high == high) return n;
+    }
+
+    int n = alloc_node(m);
+    if (n == BDD_ERROR) return BDD_ERROR;
+    m->nodes[n].var = var;
+    m->nodes[n].low = bdd_ref(m, low);
+    m->nodes[n].high = bdd_ref(m, high);
+    m->nodes[n].ref = 0;
+    m->dead++;
+    m->nodes[n].next = t->buckets[h];
+    t->buckets[h] = n;
+    if (++t->count > 2 * (t->mask + 1)) subtable_grow(m, t);
+    return n;
+}
+
+// Function to unlink a node from its subtable and put it on the free list
+static void release_node(BddManager* m, int n) {
+    BddSubtable* t = &m->subtables[m->nodes[n].var];
+    unsigned h = hash_pair(m->nodes[n].low, m->nodes[n].high) & t->mask;
+    int* link = &t->buckets[h];
+    while (*link != n) {
+        link = &m->nodes[*link].next;
+    }
+    *link = m->nodes[n].next;
+    t->count--;
+    m->nodes[n].next = m->free_list;
+    m->free_list = n;
+    m->live--;
+}
+
+// Function to drop a reference and free the node at once if it was the last one.
+// Only used while reordering, when there are no dead nodes to keep around.
+static void deref_release(BddManager* m, int f) {
+    if (f <= BDD_TRUE || --m->nodes[f].ref > 0) return;
+    int low = m->nodes[f].low;
+    int high = m->nodes[f].high;
+    release_node(m, f);
+    deref_release(m, low);
+    deref_release(m, high);
+}
+
+static void clear_cache(BddManager* m) {
+    for (int i = 0; i <= m->cache_mask; i++) {
+        m->cache[i].op = -1;
+    }
+}
+
+// Function to free every dead node, levels top-down so that children orphaned
+// by a freed parent are collected further down in the same sweep
+void bdd_gc(BddManager* m) {
+    for (int l = 0; l < m->var_count; l++) {
+        BddSubtable* t = &m->subtables[m->var_at_level[l]];
+        for (int b = 0; b <= t->mask; b++) {
+            int* link = &t->buckets[b];
+            while (*link != -1) {
+                int n = *link;
+                if (m->nodes[n].ref > 0) {
+                    link = &m->nodes[n].next;
+                    continue;
+                }
+                *link = m->nodes[n].next;
+                t->count--;
+                bdd_deref(m, m->nodes[n].low);
+                bdd_deref(m, m->nodes[n].high);
+                m->nodes[n].next = m->free_list;
+                m->free_list = n;
+                m->live--;
+                m->dead--;
+            }
+        }
+    }
+    clear_cache(m);
+}
+
+int bdd_var(BddManager* m, int var) {
+    return make_node(m, var, BDD_FALSE, BDD_TRUE);
+}
+
+// Function to apply a gate operation recursively on the Shannon cofactors.
+// Operations are commutative, so operands are ordered before the cache lookup.
+static int apply_rec(BddManager* m, int op, int f, int g) {
+    if (f <= BDD_TRUE && g <= BDD_TRUE) return sim_eval_gate(op, f, g);
+    switch (op) {
+        case SIM_AND:
+            if (f == BDD_FALSE || g == BDD_FALSE) return BDD_FALSE;
+            if (f == BDD_TRUE || f == g) return g;
+            if (g == BDD_TRUE) return f;
+            break;
+        case SIM_OR:
+            if (f == BDD_TRUE || g == BDD_TRUE) return BDD_TRUE;
+            if (f == BDD_FALSE || f == g) return g;
+            if (g == BDD_FALSE) return f;
+            break;
+        case SIM_XOR:
+            if (f == g) return BDD_FALSE;
+            if (f == BDD_FALSE) return g;
+            if (g == BDD_FALSE) return f;
+            break;
+        case SIM_NAND:
+            if (f == BDD_FALSE || g == BDD_FALSE) return BDD_TRUE;
+            break;
+        case SIM_NOR:
+            if (f == BDD_TRUE || g == BDD_TRUE) return BDD_FALSE;
+            break;
+    }
+    if (f > g) {
+        int swap = f;
+        f = g;
+        g = swap;
+    }
+
+    BddCacheEntry* entry = &m->cache[(hash_pair(f, g) + (unsigned)op * 7919u) & m->cache_mask];
+    if (entry->op == op && entry->f == f && entry->g == g) return entry->result;
+
+    int level_f = node_level(m, f);
+    int level_g = node_level(m, g);
+    int top = level_f < level_g ? level_f : level_g;
+    int f0 = level_f == top ? m->nodes[f].low : f;
+    int f1 = level_f == top ? m->nodes[f].high : f;
+    int g0 = level_g == top ? m->nodes[g].low : g;
+    int g1 = level_g == top ? m->nodes[g].high : g;
+
+    int low = apply_rec(m, op, f0, g0);
+    if (low == BDD_ERROR) return BDD_ERROR;
+    int high = apply_rec(m, op, f1, g1);
+    int result = make_node(m, m->var_at_level[top], low, high);
+    if (result == BDD_ERROR) return BDD_ERROR;
+
+    entry->op = op;
+    entry->f = f;
+    entry->g = g;
+    entry->result = result;
+    return result;
+}
+
+// Function to collect garbage before an operation once most nodes are dead.
+// Safe here because every node the caller still holds is referenced.
+static void maybe_gc(BddManager* m) {
+    if (m->dead > 4096 && m->dead > m->live / 2) bdd_gc(m);
+}
+
+int bdd_apply(BddManager* m, int op, int f, int g) {
+    maybe_gc(m);
+    return apply_rec(m, op, f, g);
+}
+
+int bdd_not(BddManager* m, int f) {
+    maybe_gc(m);
+    return apply_rec(m, SIM_XOR, f, BDD_TRUE);
+}
+
+// Function to exchange the variables at levels l and l + 1 in place.
+// Nodes of the upper variable that depend on the lower one are rewritten to test
+// the lower variable first; their index, and so every parent edge, is unchanged.
+static int swap_levels(BddManager* m, int l) {
+    int x = m->var_at_level[l];
+    int y = m->var_at_level[l + 1];
+    BddSubtable* tx = &m->subtables[x];
+    BddSubtable* ty = &m->subtables[y];
+
+    // Unlink the x nodes that have a y child, the others keep their meaning as is
+    int moved = -1;
+    for (int b = 0; b <= tx->mask; b++) {
+        int* link = &tx->buckets[b];
+        while (*link != -1) {
+            int n = *link;
+            if (m->nodes[m->nodes[n].low].var == y || m->nodes[m->nodes[n].high].var == y) {
+                *link = m->nodes[n].next;
+                tx->count--;
+                m->nodes[n].next = moved;
+                moved = n;
+            } else {
+                link = &m->nodes[n].next;
+            }
+        }
+    }
+
+    m->level_of[x] = l + 1;
+    m->level_of[y] = l;
+    m->var_at_level[l] = y;
+    m->var_at_level[l + 1] = x;
+
+    while (moved != -1) {
+        int n = moved;
+        moved = m->nodes[n].next;
+        int f0 = m->nodes[n].low;
+        int f1 = m->nodes[n].high;
+        int f00 = m->nodes[f0].var == y ? m->nodes[f0].low : f0;
+        int f01 = m->nodes[f0].var == y ? m->nodes[f0].high : f0;
+        int f10 = m->nodes[f1].var == y ? m->nodes[f1].low : f1;
+        int f11 = m->nodes[f1].var == y ? m->nodes[f1].high : f1;
+
+        int low = bdd_ref(m, make_node(m, x, f00, f10));
+        int high = bdd_ref(m, make_node(m, x, f01, f11));
+        if (low == BDD_ERROR || high == BDD_ERROR) return -1;
+        m->nodes[n].var = y;
+        m->nodes[n].low = low;
+        m->nodes[n].high = high;
+        unsigned h = hash_pair(low, high) & ty->mask;
+        m->nodes[n].next = ty->buckets[h];
+        ty->buckets[h] = n;
+        if (++ty->count > 2 * (ty->mask + 1)) subtable_grow(m, ty);
+        deref_release(m, f0);
+        deref_release(m, f1);
+    }
+    return 0;
+}
+
+// Function to sift variables one at a time, largest subtable first: move the
+// variable through every level, then back to the level with the fewest nodes.
+// A direction is abandoned once the BDD grows past BDD_SIFT_MAX_GROWTH times the best.
+void bdd_reorder_sift(BddManager* m) {
+    int n = m->var_count;
+    if (n < 2) return;
+    bdd_gc(m);
+    int saved_limit = m->max_nodes;
+    m->max_nodes = 0x7fffffff;  // a half done swap cannot be undone, never fail mid-swap
+
+    int* order = malloc(n * sizeof(int));
+    if (!order) {
+        m->max_nodes = saved_limit;
+        return;
+    }
+    for (int v = 0; v < n; v++) {
+        order[v] = v;
+    }
+    for (int i = 1; i < n; i++) {
+        int v = order[i], j = i;
+        while (j > 0 && m->subtables[order[j - 1]].count < m->subtables[v].count) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = v;
+    }
+
+    for (int i = 0; i < n; i++) {
+        int v = order[i];
+        int best = m->live;
+        int best_level = m->level_of[v];
+        int ok = 0;
+
+        while (m->level_of[v] < n - 1 && m->live <= best * BDD_SIFT_MAX_GROWTH) {
+            if ((ok = swap_levels(m, m->level_of[v])) != 0) break;
+            if (m->live < best) {
+                best = m->live;
+                best_level = m->level_of[v];
+            }
+        }
+        while (ok == 0 && m->level_of[v] > 0 && m->live <= best * BDD_SIFT_MAX_GROWTH) {
+            if ((ok = swap_levels(m, m->level_of[v] - 1)) != 0) break;
+            if (m->live < best) {
+                best = m->live;
+                best_level = m->level_of[v];
+            }
+        }
+        while (ok == 0 && m->level_of[v] < best_level) {
+            ok = swap_levels(m, m->level_of[v]);
+        }
+        while (ok == 0 && m->level_of[v] > best_level) {
+            ok = swap_levels(m, m->level_of[v] - 1);
+        }
+        if (ok != 0) break;
+    }
+
+    free(order);
+    m->max_nodes = saved_limit;
+    clear_cache(m);
+    m->reorderings++;
+}
+
+// Function to compute the fraction of assignments satisfying each node, memoized
+static double sat_fraction(const BddManager* m, int f, double* memo, unsigned char* done) {
+    if (f <= BDD_TRUE) return f;
+    if (done[f]) return memo[f];
+    double r = 0.5 * sat_fraction(m, m->nodes[f].low, memo, done) +
+               0.5 * sat_fraction(m, m->nodes[f].high, memo, done);
+    memo[f] = r;
+    done[f] = 1;
+    return r;
+}
+
+// Function to count satisfying assignments over all var_count variables
+double bdd_sat_count(BddManager* m, int f) {
+    double* memo = malloc(m->capacity * sizeof(double));
+    unsigned char* done = calloc(m->capacity, 1);
+    if (!memo || !done) {
+        free(memo);
+        free(done);
+        return -1.0;
+    }
+    double count = sat_fraction(m, f, memo, done);
+    for (int v = 0; v < m->var_count; v++) {
+        count *= 2.0;
+    }
+    free(memo);
+    free(done);
+    return count;
+}
+
+static int count_nodes(const BddManager* m, int f, unsigned char* seen) {
+    if (f <= BDD_TRUE || seen[f]) return 0;
+    seen[f] = 1;
+    return 1 + count_nodes(m, m->nodes[f].low, seen) + count_nodes(m, m->nodes[f].high, seen);
+}
+
+// Function to count the internal nodes reachable from f
+int bdd_node_count(BddManager* m, int f) {
+    unsigned char* seen = calloc(m->capacity, 1);
+    if (!seen) return -1;
+    int count = count_nodes(m, f, seen);
+    free(seen);
+    return count;
+}
+
+// Function to find one satisfying assignment (variables not on the path get 0),
+// returns 0 if f is unsatisfiable
+int bdd_pick_sat(BddManager* m, int f, unsigned char* assignment) {
+    memset(assignment, 0, m->var_count);
+    if (f == BDD_FALSE) return 0;
+    while (f > BDD_TRUE) {
+        int var = m->nodes[f].var;
+        if (m->nodes[f].low != BDD_FALSE) {
+            f = m->nodes[f].low;
+        } else {
+            assignment[var] = 1;
+            f = m->nodes[f].high;
+        }
+    }
+    return 1;
+}
+
+int bdd_eval(const BddManager* m, int f, const unsigned char* assignment) {
+    while (f > BDD_TRUE) {
+        f = assignment[m->nodes[f].var] ? m->nodes[f].high : m->nodes[f].low;
+    }
+    return f;
+}
+
+static void print_cubes(BddManager* m, int f, char* cube, FILE* out, long long max_cubes, long long* printed) {
+    if (f == BDD_FALSE || *printed >= max_cubes) return;
+    if (f == BDD_TRUE) {
+        fprintf(out, "%s\n", cube);
+        (*printed)++;
+        return;
+    }
+    int var = m->nodes[f].var;
+    cube[var] = '0';
+    print_cubes(m, m->nodes[f].low, cube, out, max_cubes, printed);
+    cube[var] = '1';
+    print_cubes(m, m->nodes[f].high, cube, out, max_cubes, printed);
+    cube[var] = '-';
+}
+
+long long bdd_print_cubes(BddManager* m, int f, FILE* out, long long max_cubes) {
+    char* cube = malloc(m->var_count + 1);
+    if (!cube) return 0;
+    memset(cube, '-', m->var_count);
+    cube[m->var_count] = '\0';
+    long long printed = 0;
+    print_cubes(m, f, cube, out, max_cubes, &printed);
+    free(cube);
+    return printed;
+}
+
+// Function to order the variables as a depth-first walk from the outputs meets
+// the inputs, which keeps inputs feeding the same logic next to each other
+static void order_by_fanin(BddManager* m, const SimProgram* prog, const int* var_of_gate,
+                           const int* position, const int* output_gates, int num_outputs) {
+    int n = prog->gate_count;
+    unsigned char* seen = calloc(n + 1, 1);
+    int* stack = malloc((2 * n + 2) * sizeof(int));
+    if (!seen || !stack) {
+        free(seen);
+        free(stack);
+        return;
+    }
+    int level = 0;
+    for (int o = 0; o < num_outputs; o++) {
+        int top = 0;
+        stack[top++] = output_gates[o];
+        while (top > 0) {
+            int g = stack[--top];
+            if (g >= n || seen[g]) continue;
+            seen[g] = 1;
+            if (var_of_gate[g] >= 0) {
+                m->var_at_level[level] = var_of_gate[g];
+                m->level_of[var_of_gate[g]] = level++;
+            } else if (position[g] >= 0) {
+                // Push pin 1 first so pin 0 is visited first
+                stack[top++] = prog->code[position[g]].in1;
+                stack[top++] = prog->code[position[g]].in0;
+            }
+        }
+    }
+    for (int v = 0; v < m->var_count; v++) {
+        int placed = 0;
+        for (int l = 0; l < level && !placed; l++) {
+            placed = m->var_at_level[l] == v;
+        }
+        if (!placed) {
+            m->var_at_level[level] = v;
+            m->level_of[v] = level++;
+        }
+    }
+    free(seen);
+    free(stack);
+}
+
+// Function to build one BDD per gate in level order. A gate's BDD is released right
+// after its last reader, and sifting runs between gates when the node count passes
+// reorder_threshold.
+int bdd_build_outputs(BddManager* m, const SimProgram* prog, const int* input_gates, int num_inputs,
+                      const int* output_gates, int num_outputs, int* outputs) {
+    if (prog->cyclic || num_inputs > m->var_count) return -1;
+    int n = prog->gate_count;
+    int* node_of = malloc((n + 1) * sizeof(int));
+    int* var_of_gate = malloc((n + 1) * sizeof(int));
+    int* position = malloc((n + 1) * sizeof(int));
+    int* last_reader = malloc((n + 1) * sizeof(int));
+    if (!node_of || !var_of_gate || !position || !last_reader) {
+        free(node_of);
+        free(var_of_gate);
+        free(position);
+        free(last_reader);
+        return -1;
+    }
+
+    for (int g = 0; g <= n; g++) {
+        node_of[g] = BDD_FALSE;
+        var_of_gate[g] = -1;
+        position[g] = -1;
+        last_reader[g] = -1;
+    }
+    for (int i = 0; i < prog->instr_count; i++) {
+        position[prog->code[i].out] = i;
+        last_reader[prog->code[i].in0] = i;
+        last_reader[prog->code[i].in1] = i;
+    }
+    for (int o = 0; o < num_outputs; o++) {
+        last_reader[output_gates[o]] = prog->instr_count;  // outputs are kept
+    }
+    for (int i = 0; i < num_inputs; i++) {
+        var_of_gate[input_gates[i]] = i;
+    }
+    if (m->live == 0) order_by_fanin(m, prog, var_of_gate, position, output_gates, num_outputs);
+
+    int result = 0;
+    for (int i = 0; i < num_inputs && result == 0; i++) {
+        node_of[input_gates[i]] = bdd_ref(m, bdd_var(m, i));
+        if (node_of[input_gates[i]] == BDD_ERROR) result = -1;
+    }
+
+    for (int i = 0; i < prog->instr_count && result == 0; i++) {
+        const SimInstr* ins = &prog->code[i];
+        int a = node_of[ins->in0];
+        int b = node_of[ins->in1];
+        int r;
+        switch (ins->op) {
+            case SIM_NOT:    r = bdd_not(m, a); break;
+            case SIM_OUTPUT: r = a; break;
+            case SIM_AND:
+            case SIM_OR:
+            case SIM_NAND:
+            case SIM_NOR:
+            case SIM_XOR:    r = bdd_apply(m, ins->op, a, b); break;
+            default:         r = BDD_FALSE; break;
+        }
+        if (r == BDD_ERROR) {
+            result = -1;
+            break;
+        }
+        node_of[ins->out] = bdd_ref(m, r);
+
+        // Drop operands whose last reader was this instruction
+        if (last_reader[ins->in0] == i && ins->in0 < n) {
+            bdd_deref(m, node_of[ins->in0]);
+            node_of[ins->in0] = BDD_FALSE;
+        }
+        if (last_reader[ins->in1] == i && ins->in1 != ins->in0 && ins->in1 < n) {
+            bdd_deref(m, node_of[ins->in1]);
+            node_of[ins->in1] = BDD_FALSE;
+        }
+        if (m->reorder_threshold > 0 && m->live - m->dead > m->reorder_threshold &&
+            m->live < m->max_nodes / BDD_REORDER_MAX_FRACTION) {
+            // Sift at doubling sizes so the reordering cost stays a fraction of the build
+            bdd_reorder_sift(m);
+            m->reorder_threshold = 2 * (m->live > m->reorder_threshold ? m->live : m->reorder_threshold);
+        }
+    }
+
+    // Hand the outputs to the caller, with one reference each
+    for (int o = 0; o < num_outputs; o++) {
+        outputs[o] = result == 0 ? bdd_ref(m, node_of[output_gates[o]]) : BDD_ERROR;
+    }
+    for (int g = 0; g < n; g++) {
+        bdd_deref(m, node_of[g]);
+    }
+
+    free(node_of);
+    free(var_of_gate);
+    free(position);
+    free(last_reader);
+    return result;
+}
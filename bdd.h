@@ -0,0 +1,94 @@
+#ifndef BDD_H
+#define BDD_H
+
+#include <stdio.h>
+#include "simulator.h"
+
+// Terminal nodes, every other node index is an internal node
+#define BDD_FALSE 0
+#define BDD_TRUE 1
+#define BDD_ERROR -1    // node limit reached or out of memory
+
+// Default node limit for one manager (about 20 bytes per node)
+#define BDD_DEFAULT_MAX_NODES (1 << 22)
+
+typedef struct {
+    int var;
+    int low;            // cofactor for var = 0
+    int high;           // cofactor for var = 1
+    int next;           // unique table chain
+    int ref;            // parents plus external references, 0 = dead
+} BddNode;
+
+// Unique table of one variable, chained through BddNode.next
+typedef struct {
+    int* buckets;
+    int mask;
+    int count;
+} BddSubtable;
+
+typedef struct {
+    int op;
+    int f;
+    int g;
+    int result;
+} BddCacheEntry;
+
+// Reduced ordered BDD manager. Nodes are hash-consed per variable, so two
+// functions are equal exactly when their node indices are equal.
+// Reference counts cover both parent edges and bdd_ref calls. Nodes whose count
+// drops to 0 stay in the unique table (and can be revived) until bdd_gc frees them.
+// Variables keep their index, reordering only changes which level they sit at.
+typedef struct {
+    int var_count;
+    BddNode* nodes;
+    int capacity;
+    int max_nodes;
+    int free_list;
+    int live;           // allocated internal nodes, dead ones included
+    int dead;
+    BddSubtable* subtables;
+    int* level_of;      // level of each variable, 0 is the root
+    int* var_at_level;
+    BddCacheEntry* cache;
+    int cache_mask;
+    int reorder_threshold;  // live nodes that trigger sifting while building, 0 = off
+    int reorderings;
+} BddManager;
+
+int bdd_init(BddManager* m, int var_count, int max_nodes);
+void bdd_free(BddManager* m);
+
+// Reference handling, every node kept across calls must be referenced.
+// Operands of the operations below must be referenced (or terminals).
+int bdd_ref(BddManager* m, int f);
+void bdd_deref(BddManager* m, int f);
+
+// Node for a single variable, and the two-input operations (SIM_AND .. SIM_XOR)
+int bdd_var(BddManager* m, int var);
+int bdd_apply(BddManager* m, int op, int f, int g);
+int bdd_not(BddManager* m, int f);
+
+// Free dead nodes and clear the operation cache
+void bdd_gc(BddManager* m);
+
+// Rudell's sifting: move every variable to the level that minimizes the node count
+void bdd_reorder_sift(BddManager* m);
+
+// Queries
+double bdd_sat_count(BddManager* m, int f);
+int bdd_node_count(BddManager* m, int f);
+int bdd_pick_sat(BddManager* m, int f, unsigned char* assignment);
+int bdd_eval(const BddManager* m, int f, const unsigned char* assignment);
+
+// Print the disjoint cubes of f (one per path to TRUE, '-' for free variables),
+// at most max_cubes lines, returns the number printed
+long long bdd_print_cubes(BddManager* m, int f, FILE* out, long long max_cubes);
+
+// Build referenced BDDs for the outputs of a compiled circuit, variable i is input i.
+// Variables start in the order a depth-first walk from the outputs reaches them.
+// Returns 0 on success, -1 on cyclic circuits or when the node limit is exceeded.
+int bdd_build_outputs(BddManager* m, const SimProgram* prog, const int* input_gates, int num_inputs,
+                      const int* output_gates, int num_outputs, int* outputs);
+
+#endif
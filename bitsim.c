@@ -0,0 +1,147 @@
+#include <stdlib.h>
+#include <string.h>
+#include "bitsim.h"
+#include "logicgates.h"
+
+// Function to apply one gate to 64 patterns at once
+uint64_t bitsim_eval_word(int op, uint64_t a, uint64_t b) {
+    switch (op) {
+        case SIM_AND:    return a & b;
+        case SIM_OR:     return a | b;
+        case SIM_NOT:    return ~a;
+        case SIM_NAND:   return ~(a & b);
+        case SIM_NOR:    return ~(a | b);
+        case SIM_XOR:    return a ^ b;
+        case SIM_OUTPUT: return a;
+        default:         return 0;
+    }
+}
+
+// Function to evaluate the whole program word-wide, 64 patterns per gate
+void bitsim_run(const SimProgram* prog, uint64_t* values) {
+    values[prog->gate_count] = 0;
+    bitsim_run_from(prog, values, 0);
+}
+
+// Function to re-evaluate instructions [first_instr, instr_count), values of the
+// gates before first_instr are taken as they are
+void bitsim_run_from(const SimProgram* prog, uint64_t* values, int first_instr) {
+    const SimInstr* ip = prog->code + first_instr;
+    const SimInstr* end = prog->code + prog->instr_count;
+
+    for (; ip < end; ip++) {
+        values[ip->out] = bitsim_eval_word(ip->op, values[ip->in0], values[ip->in1]);
+    }
+}
+
+// Function to evaluate the program on nwords words per gate with the SIMD gate kernels.
+// Gate g occupies values[g * nwords .. g * nwords + nwords).
+void bitsim_run_wide(const SimProgram* prog, uint64_t* values, int nwords) {
+    if (prog->native_eval) {
+        prog->native_eval(values, nwords);
+        return;
+    }
+
+    const LogicKernelSet* kernels = logic_kernels();
+    const SimInstr* ip = prog->code;
+    const SimInstr* end = ip + prog->instr_count;
+
+    memset(values + (size_t)prog->gate_count * nwords, 0, nwords * sizeof(uint64_t));
+    for (; ip < end; ip++) {
+        uint64_t* dst = values + (size_t)ip->out * nwords;
+        const uint64_t* a = values + (size_t)ip->in0 * nwords;
+        const uint64_t* b = values + (size_t)ip->in1 * nwords;
+        switch (ip->op) {
+            case SIM_AND:    kernels->op[LOGIC_OP_AND](dst, a, b, nwords); break;
+            case SIM_OR:     kernels->op[LOGIC_OP_OR](dst, a, b, nwords); break;
+            case SIM_NOT:    kernels->op[LOGIC_OP_NOT](dst, a, a, nwords); break;
+            case SIM_NAND:   kernels->op[LOGIC_OP_NAND](dst, a, b, nwords); break;
+            case SIM_NOR:    kernels->op[LOGIC_OP_NOR](dst, a, b, nwords); break;
+            case SIM_XOR:    kernels->op[LOGIC_OP_XOR](dst, a, b, nwords); break;
+            case SIM_OUTPUT: memcpy(dst, a, nwords * sizeof(uint64_t)); break;
+            default:         memset(dst, 0, nwords * sizeof(uint64_t)); break;
+        }
+    }
+}
+
+// Function to build the packed values of one input for 64 consecutive rows.
+// The first input is the most significant bit of the row number.
+uint64_t bitsim_input_pattern(int input, int num_inputs, long long block) {
+    static const uint64_t low_patterns[6] = {
+        0xAAAAAAAAAAAAAAAAULL, 0xCCCCCCCCCCCCCCCCULL, 0xF0F0F0F0F0F0F0F0ULL,
+        0xFF00FF00FF00FF00ULL, 0xFFFF0000FFFF0000ULL, 0xFFFFFFFF00000000ULL
+    };
+    int bit = num_inputs - 1 - input;
+    if (bit < 6) return low_patterns[bit];
+    return ((block >> (bit - 6)) & 1) ? ~0ULL : 0ULL;
+}
+
+// Function to allocate an all-zero truth table for num_inputs inputs
+int truth_table_alloc(TruthTable* table, int num_inputs, int num_outputs) {
+    memset(table, 0, sizeof(TruthTable));
+    if (num_inputs < 0 || num_inputs > TRUTH_TABLE_MAX_INPUTS) return -1;
+    table->num_inputs = num_inputs;
+    table->num_outputs = num_outputs;
+    table->num_rows = 1LL << num_inputs;
+    table->words_per_output = (table->num_rows + 63) / 64;
+    table->bits = calloc((size_t)(num_outputs * table->words_per_output) + 1, sizeof(uint64_t));
+    return table->bits ? 0 : -1;
+}
+
+// Function to fill words [first_word, first_word + word_count) of every output.
+// scratch must hold (gate_count + 1) * BITSIM_BLOCK_WORDS words. Calls on
+// disjoint word ranges touch disjoint memory, so they can run concurrently.
+void bitsim_fill_rows(const SimProgram* prog, const int* input_gates, const int* output_gates,
+                      TruthTable* table, long long first_word, long long word_count, uint64_t* scratch) {
+    int num_inputs = table->num_inputs;
+
+    // Tables smaller than one word only keep their valid rows
+    uint64_t tail_mask = table->num_rows >= 64 ? ~0ULL : ((1ULL << table->num_rows) - 1);
+
+    for (long long first = first_word; first < first_word + word_count; first += BITSIM_BLOCK_WORDS) {
+        long long left = first_word + word_count - first;
+        int block_words = left < BITSIM_BLOCK_WORDS ? (int)left : BITSIM_BLOCK_WORDS;
+        for (int i = 0; i < num_inputs; i++) {
+            uint64_t* in = scratch + (size_t)input_gates[i] * block_words;
+            for (int w = 0; w < block_words; w++) {
+                in[w] = bitsim_input_pattern(i, num_inputs, first + w);
+            }
+        }
+        bitsim_run_wide(prog, scratch, block_words);
+        for (int o = 0; o < table->num_outputs; o++) {
+            uint64_t* dst = table->bits + o * table->words_per_output + first;
+            const uint64_t* src = scratch + (size_t)output_gates[o] * block_words;
+            for (int w = 0; w < block_words; w++) {
+                dst[w] = src[w] & tail_mask;
+            }
+        }
+    }
+}
+
+// Function to enumerate every input combination, BITSIM_BLOCK_WORDS * 64 rows per pass
+int bitsim_truth_table(const SimProgram* prog, const int* input_gates, int num_inputs,
+                       const int* output_gates, int num_outputs, TruthTable* table) {
+    memset(table, 0, sizeof(TruthTable));
+    if (prog->cyclic || truth_table_alloc(table, num_inputs, num_outputs) != 0) {
+        truth_table_free(table);
+        return -1;
+    }
+    uint64_t* scratch = malloc((size_t)(prog->gate_count + 1) * BITSIM_BLOCK_WORDS * sizeof(uint64_t));
+    if (!scratch) {
+        truth_table_free(table);
+        return -1;
+    }
+    bitsim_fill_rows(prog, input_gates, output_gates, table, 0, table->words_per_output, scratch);
+    free(scratch);
+    return 0;
+}
+
+int truth_table_get(const TruthTable* table, int output, long long row) {
+    uint64_t word = table->bits[output * table->words_per_output + row / 64];
+    return (int)((word >> (row % 64)) & 1);
+}
+
+void truth_table_free(TruthTable* table) {
+    free(table->bits);
+    memset(table, 0, sizeof(TruthTable));
+}
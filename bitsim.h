@@ -0,0 +1,46 @@
+#ifndef BITSIM_H
+#define BITSIM_H
+
+#include <stdint.h>
+#include "simulator.h"
+
+// Largest input count a truth table can be generated for (2^30 rows)
+#define TRUTH_TABLE_MAX_INPUTS 30
+
+// Words evaluated per pass when enumerating truth tables (512 rows)
+#define BITSIM_BLOCK_WORDS 8
+
+// Truth table stored as one bitset per output.
+// Row r of output o is bit (r % 64) of bits[o * words_per_output + r / 64].
+// Input i of row r is (r >> (num_inputs - 1 - i)) & 1, the same order the tables are printed in.
+typedef struct {
+    int num_inputs;
+    int num_outputs;
+    long long num_rows;
+    long long words_per_output;
+    uint64_t* bits;
+} TruthTable;
+
+// Evaluate a compiled program on 64 input vectors at once, one word per gate.
+// values needs gate_count + 1 words, the last one is the constant-0 slot.
+void bitsim_run(const SimProgram* prog, uint64_t* values);
+void bitsim_run_from(const SimProgram* prog, uint64_t* values, int first_instr);
+uint64_t bitsim_eval_word(int op, uint64_t a, uint64_t b);
+
+// Same, nwords words per gate (values holds (gate_count + 1) * nwords words),
+// each gate is evaluated with the SIMD kernels from logicgates.c
+void bitsim_run_wide(const SimProgram* prog, uint64_t* values, int nwords);
+
+// Input word for block `block` of an exhaustive enumeration over num_inputs inputs
+uint64_t bitsim_input_pattern(int input, int num_inputs, long long block);
+
+// Generate the full truth table 64 rows per pass, returns 0 on success
+int bitsim_truth_table(const SimProgram* prog, const int* input_gates, int num_inputs,
+                       const int* output_gates, int num_outputs, TruthTable* table);
+int truth_table_alloc(TruthTable* table, int num_inputs, int num_outputs);
+void bitsim_fill_rows(const SimProgram* prog, const int* input_gates, const int* output_gates,
+                      TruthTable* table, long long first_word, long long word_count, uint64_t* scratch);
+int truth_table_get(const TruthTable* table, int output, long long row);
+void truth_table_free(TruthTable* table);
+
+#endif
@@ -3,9 +3,7 @@
 
 #include <SDL3/SDL.h>
 #include <stdbool.h>
-
-#define MAX_GATES 50
-#define MAX_WIRES 100
+#include "simulator.h"
 
 typedef struct {
     const char* name;
@@ -20,7 +18,7 @@ typedef struct {
     int drag_offset_y;
     bool in_palette;
     int id;
-    int* input_values;
+    int input_values[SIM_MAX_PINS];
     int output_value;
     int gate_type;
 } LogicGate;
@@ -36,5 +34,8 @@ typedef struct {
 // Function declarations from your visual circuit
 void propagate_signals(LogicGate* gates, int gate_count, Wire* wires, int wire_count);
 void compute_gate_output(LogicGate* gate);
+void mark_topology_changed(void);
+void update_signals(LogicGate* gates, int gate_count, Wire* wires, int wire_count);
+void input_gate_changed(int gate_index, int value);
 
 #endif
\ No newline at end of file
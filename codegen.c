@@ -0,0 +1,419 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include "codegen.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <direct.h>
+#include <process.h>
+#define LIBRARY_EXT "dll"
+#else
+#include <dlfcn.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#define LIBRARY_EXT "so"
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CODEGEN_X86 1
+#endif
+
+// Bump when the generated code changes so stale cache entries are not reused
+#define CODEGEN_VERSION 2
+
+static uint64_t fnv1a(uint64_t hash, int value) {
+    for (int i = 0; i < 4; i++) {
+        hash ^= (uint64_t)((value >> (i * 8)) & 0xFF);
+        hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+// Function to hash the compiled program (FNV-1a over every instruction)
+uint64_t codegen_netlist_hash(const SimProgram* prog) {
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    hash = fnv1a(hash, CODEGEN_VERSION);
+    hash = fnv1a(hash, prog->gate_count);
+    hash = fnv1a(hash, prog->instr_count);
+    for (int i = 0; i < prog->instr_count; i++) {
+        const SimInstr* ins = &prog->code[i];
+        hash = fnv1a(hash, ins->op);
+        hash = fnv1a(hash, ins->out);
+        hash = fnv1a(hash, ins->in0);
+        hash = fnv1a(hash, ins->in1);
+    }
+    return hash;
+}
+
+// Function to emit one pass over the gates, on either 8-word vectors or single words
+static void emit_body(const SimProgram* prog, FILE* out, const char* type, const char* load_fmt,
+                      const char* store_fmt, const char* is_source) {
+    int n = prog->gate_count;
+    fprintf(out, "        const %s g%d = {0};\n", type, n);
+    for (int g = 0; g < n; g++) {
+        if (!is_source[g]) continue;
+        fprintf(out, "        const %s g%d = ", type, g);
+        fprintf(out, load_fmt, g);
+        fprintf(out, ";\n");
+    }
+    for (int i = 0; i < prog->instr_count; i++) {
+        const SimInstr* ins = &prog->code[i];
+        int o = ins->out, a = ins->in0, b = ins->in1;
+        fprintf(out, "        const %s g%d = ", type, o);
+        switch (ins->op) {
+            case SIM_AND:    fprintf(out, "g%d & g%d;\n", a, b); break;
+            case SIM_OR:     fprintf(out, "g%d | g%d;\n", a, b); break;
+            case SIM_NOT:    fprintf(out, "~g%d;\n", a); break;
+            case SIM_NAND:   fprintf(out, "~(g%d & g%d);\n", a, b); break;
+            case SIM_NOR:    fprintf(out, "~(g%d | g%d);\n", a, b); break;
+            case SIM_XOR:    fprintf(out, "g%d ^ g%d;\n", a, b); break;
+            case SIM_OUTPUT: fprintf(out, "g%d;\n", a); break;
+            default:         fprintf(out, "g%d;\n", n); break;
+        }
+    }
+    for (int i = 0; i < prog->instr_count; i++) {
+        fprintf(out, "        ");
+        fprintf(out, store_fmt, prog->code[i].out, prog->code[i].out);
+        fprintf(out, ";\n");
+    }
+    fprintf(out, "        ");
+    fprintf(out, store_fmt, n, n);
+    fprintf(out, ";\n");
+}
+
+// Function to emit the evaluator: every gate becomes a local in level order, the
+// main loop works on 8-word vectors (GCC/Clang vector extension), the tail on words
+int codegen_emit_c(const SimProgram* prog, FILE* out) {
+    int n = prog->gate_count;
+    char* is_source = calloc(n + 1, 1);
+    char* is_computed = calloc(n + 1, 1);
+    if (!is_source || !is_computed) {
+        free(is_source);
+        free(is_computed);
+        return -1;
+    }
+    for (int i = 0; i < prog->instr_count; i++) {
+        is_computed[prog->code[i].out] = 1;
+    }
+    for (int i = 0; i < prog->instr_count; i++) {
+        const SimInstr* ins = &prog->code[i];
+        if (ins->in0 < n && !is_computed[ins->in0]) is_source[ins->in0] = 1;
+        if (ins->in1 < n && !is_computed[ins->in1]) is_source[ins->in1] = 1;
+    }
+
+    fprintf(out, "/* Generated by codegen.c, do not edit */\n");
+    fprintf(out, "#include <stdint.h>\n#include <string.h>\n\n");
+    fprintf(out, "typedef uint64_t vec8 __attribute__((vector_size(64)));\n\n");
+    fprintf(out, "static inline vec8 load8(const uint64_t* p) { vec8 v; memcpy(&v, p, sizeof(v)); return v; }\n");
+    fprintf(out, "static inline void store8(uint64_t* p, vec8 v) { memcpy(p, &v, sizeof(v)); }\n\n");
+    fprintf(out, "void %s(uint64_t* restrict v, int nwords) {\n", CODEGEN_SYMBOL);
+    fprintf(out, "    int w = 0;\n");
+    fprintf(out, "    for (; w + 8 <= nwords; w += 8) {\n");
+    emit_body(prog, out, "vec8", "load8(&v[%d * nwords + w])", "store8(&v[%d * nwords + w], g%d)", is_source);
+    fprintf(out, "    }\n");
+    fprintf(out, "    for (; w < nwords; w++) {\n");
+    emit_body(prog, out, "uint64_t", "v[%d * nwords + w]", "v[%d * nwords + w] = g%d", is_source);
+    fprintf(out, "    }\n}\n");
+
+    free(is_source);
+    free(is_computed);
+    return ferror(out) ? -1 : 0;
+}
+
+static void* open_library(const char* path) {
+#ifdef _WIN32
+    return (void*)LoadLibraryA(path);
+#else
+    return dlopen(path, RTLD_NOW | RTLD_LOCAL);
+#endif
+}
+
+static void* find_symbol(void* library, const char* name) {
+#ifdef _WIN32
+    return (void*)GetProcAddress((HMODULE)library, name);
+#else
+    return dlsym(library, name);
+#endif
+}
+
+static void close_library(void* library) {
+#ifdef _WIN32
+    FreeLibrary((HMODULE)library);
+#else
+    dlclose(library);
+#endif
+}
+
+// Function to create a directory and any missing parents, returns 0 when it exists
+static int make_dirs(char* path) {
+    for (char* p = path + 1; *p; p++) {
+        if (*p != '/' && *p != '\\') continue;
+        char separator = *p;
+        *p = '\0';
+#ifdef _WIN32
+        _mkdir(path);
+#else
+        mkdir(path, 0755);
+#endif
+        *p = separator;
+    }
+#ifdef _WIN32
+    _mkdir(path);
+#else
+    mkdir(path, 0755);
+#endif
+    struct stat st;
+    return stat(path, &st) == 0 && (st.st_mode & S_IFDIR) ? 0 : -1;
+}
+
+static int file_exists(const char* path) {
+    struct stat st;
+    return stat(path, &st) == 0;
+}
+
+// Function to compare two files byte by byte, returns 1 when both exist and match
+static int files_equal(const char* path_a, const char* path_b) {
+    FILE* a = fopen(path_a, "rb");
+    if (!a) return 0;
+    FILE* b = fopen(path_b, "rb");
+    if (!b) {
+        fclose(a);
+        return 0;
+    }
+    char buffer_a[4096], buffer_b[4096];
+    int equal = 1;
+    for (;;) {
+        size_t read_a = fread(buffer_a, 1, sizeof(buffer_a), a);
+        size_t read_b = fread(buffer_b, 1, sizeof(buffer_b), b);
+        if (read_a != read_b || memcmp(buffer_a, buffer_b, read_a) != 0) {
+            equal = 0;
+            break;
+        }
+        if (read_a == 0) break;
+    }
+    if (ferror(a) || ferror(b)) equal = 0;
+    fclose(a);
+    fclose(b);
+    return equal;
+}
+
+// Function to find the cache directory: LOGICSIM_CACHE, else logicsim under the
+// user's cache directory ($XDG_CACHE_HOME, ~/.cache or %LOCALAPPDATA%).
+// Returns 0 on success, -1 when none is known.
+static int cache_dir(char* dir, size_t size) {
+    const char* path = getenv("LOGICSIM_CACHE");
+    const char* base;
+    if (path && path[0]) {
+        snprintf(dir, size, "%s", path);
+    } else if ((base = getenv("XDG_CACHE_HOME")) && base[0]) {
+        snprintf(dir, size, "%s/%s", base, CODEGEN_CACHE_DIR);
+    } else if ((base = getenv("HOME")) && base[0]) {
+        snprintf(dir, size, "%s/.cache/%s", base, CODEGEN_CACHE_DIR);
+    } else if ((base = getenv("LOCALAPPDATA")) && base[0]) {
+        snprintf(dir, size, "%s/%s", base, CODEGEN_CACHE_DIR);
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+// Function to name what a library built with -march=native needs from the CPU:
+// the architecture and, on x86, the vector and bit extensions the compiler may
+// use. A cache shared between machines then never hands a library to a CPU
+// that cannot run it.
+static void isa_tag(char* tag, size_t size) {
+#ifdef CODEGEN_X86
+    unsigned features = 0;
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.2")) features |= 1u << 0;
+    if (__builtin_cpu_supports("avx")) features |= 1u << 1;
+    if (__builtin_cpu_supports("avx2")) features |= 1u << 2;
+    if (__builtin_cpu_supports("fma")) features |= 1u << 3;
+    if (__builtin_cpu_supports("bmi2")) features |= 1u << 4;
+    if (__builtin_cpu_supports("avx512f")) features |= 1u << 5;
+    if (__builtin_cpu_supports("avx512vl")) features |= 1u << 6;
+    if (__builtin_cpu_supports("avx512bw")) features |= 1u << 7;
+    if (__builtin_cpu_supports("avx512dq")) features |= 1u << 8;
+#if defined(__x86_64__)
+    snprintf(tag, size, "x86_64-%03x", features);
+#else
+    snprintf(tag, size, "x86-%03x", features);
+#endif
+#elif defined(__aarch64__)
+    snprintf(tag, size, "aarch64");
+#elif defined(__arm__)
+    snprintf(tag, size, "arm");
+#elif defined(__riscv)
+    snprintf(tag, size, "riscv");
+#else
+    snprintf(tag, size, "generic");
+#endif
+}
+
+// Function to run the compiler on source, writing library. CC may carry its own
+// flags ("gcc -m64"), so it is split on spaces; every argument goes to the
+// compiler as it is, no shell sees it. Diagnostics go to log. Returns the exit
+// status, -1 when the compiler could not be started.
+static int run_compiler(const char* compiler, const char* library, const char* source, const char* log) {
+    enum { MAX_ARGS = 32 };
+    char words[512];
+    char* argv[MAX_ARGS + 8];
+    int argc = 0;
+    snprintf(words, sizeof(words), "%s", compiler);
+    for (char* word = strtok(words, " \t"); word && argc < MAX_ARGS; word = strtok(NULL, " \t")) {
+        argv[argc++] = word;
+    }
+    if (argc == 0) return -1;
+    // -march=native lets the 8-word vectors map onto the widest registers of this host
+    argv[argc++] = "-O2";
+    argv[argc++] = "-march=native";
+    argv[argc++] = "-shared";
+    argv[argc++] = "-fPIC";
+    argv[argc++] = "-o";
+    argv[argc++] = (char*)library;
+    argv[argc++] = (char*)source;
+    argv[argc] = NULL;
+
+#ifdef _WIN32
+    (void)log;
+    intptr_t status = _spawnvp(_P_WAIT, argv[0], (const char* const*)argv);
+    return status < 0 ? -1 : (int)status;
+#else
+    pid_t pid = fork();
+    if (pid < 0) return -1;
+    if (pid == 0) {
+        int fd = open(log, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd >= 0) {
+            dup2(fd, STDOUT_FILENO);
+            dup2(fd, STDERR_FILENO);
+            close(fd);
+        }
+        execvp(argv[0], argv);
+        _exit(127);
+    }
+    int status;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) return -1;
+    }
+    if (!WIFEXITED(status)) return -1;
+    return WEXITSTATUS(status) == 127 ? -1 : WEXITSTATUS(status);
+#endif
+}
+
+// Function to attach the native evaluator, compiling it only on a cache miss
+int codegen_load(CompiledCircuit* cc, SimProgram* prog) {
+    memset(cc, 0, sizeof(CompiledCircuit));
+    prog->native_eval = NULL;
+    if (prog->cyclic) {
+        snprintf(cc->error, sizeof(cc->error), "the circuit has a feedback loop");
+        return -1;
+    }
+
+    char dir[512], isa[32];
+    if (cache_dir(dir, sizeof(dir)) != 0) {
+        snprintf(cc->error, sizeof(cc->error), "no cache directory, set LOGICSIM_CACHE or HOME");
+        return -1;
+    }
+    const char* compiler = getenv("CC");
+    if (!compiler || !compiler[0]) compiler = "cc";
+    isa_tag(isa, sizeof(isa));
+
+    // The emitter version and the instruction set are part of the name as well
+    // as the hash, so stale or foreign libraries are never picked up
+    cc->hash = codegen_netlist_hash(prog);
+#ifdef _WIN32
+    long pid = (long)_getpid();
+#else
+    long pid = (long)getpid();
+#endif
+    char stem[640], source_path[660], library_path[660], log_path[660];
+    char temp_source[700], temp_library[700];
+    snprintf(stem, sizeof(stem), "%s/circuit_v%d_%s_%016llx", dir, CODEGEN_VERSION, isa,
+             (unsigned long long)cc->hash);
+    snprintf(source_path, sizeof(source_path), "%s.c", stem);
+    snprintf(library_path, sizeof(library_path), "%s.%s", stem, LIBRARY_EXT);
+    snprintf(log_path, sizeof(log_path), "%s.log", stem);
+    snprintf(temp_source, sizeof(temp_source), "%s.%ld.tmp.c", stem, pid);
+    snprintf(temp_library, sizeof(temp_library), "%s.%ld.tmp.%s", stem, pid, LIBRARY_EXT);
+
+    if (make_dirs(dir) != 0) {
+        snprintf(cc->error, sizeof(cc->error), "cannot create the cache directory %s", dir);
+        return -1;
+    }
+    FILE* out = fopen(temp_source, "w");
+    if (!out) {
+        snprintf(cc->error, sizeof(cc->error), "cannot write %s", temp_source);
+        return -1;
+    }
+    int emitted = codegen_emit_c(prog, out);
+    if (fclose(out) != 0 || emitted != 0) {
+        remove(temp_source);
+        snprintf(cc->error, sizeof(cc->error), "cannot write %s", temp_source);
+        return -1;
+    }
+
+    // The 64-bit hash only names the entry: a cached library is reused when the
+    // source stored beside it is the very source this program emits
+    cc->from_cache = file_exists(library_path) && files_equal(temp_source, source_path);
+    if (cc->from_cache) {
+        remove(temp_source);
+    } else {
+        // Build under names private to this process and rename them into place,
+        // so a failed or concurrent compile never leaves a half-written library
+        int status = run_compiler(compiler, temp_library, temp_source, log_path);
+        if (status != 0) {
+            remove(temp_library);
+            remove(temp_source);
+            if (status < 0) {
+                snprintf(cc->error, sizeof(cc->error), "cannot run the C compiler '%s'", compiler);
+            } else {
+#ifdef _WIN32
+                snprintf(cc->error, sizeof(cc->error), "'%s' failed with status %d", compiler, status);
+#else
+                snprintf(cc->error, sizeof(cc->error), "'%s' failed with status %d, see %s", compiler, status, log_path);
+#endif
+            }
+            return -1;
+        }
+        // Library first: a reader that sees the new source must also see its library.
+        // Windows will not rename over an existing file.
+#ifdef _WIN32
+        remove(library_path);
+#endif
+        if (rename(temp_library, library_path) != 0) {
+            remove(temp_library);
+            remove(temp_source);
+            snprintf(cc->error, sizeof(cc->error), "cannot move the library into %s", dir);
+            return -1;
+        }
+#ifdef _WIN32
+        remove(source_path);
+#endif
+        if (rename(temp_source, source_path) != 0) remove(temp_source);
+        remove(log_path);
+    }
+
+    cc->library = open_library(library_path);
+    if (!cc->library) {
+        snprintf(cc->error, sizeof(cc->error), "cannot load %s", library_path);
+        return -1;
+    }
+    void* symbol = find_symbol(cc->library, CODEGEN_SYMBOL);
+    if (!symbol) {
+        close_library(cc->library);
+        cc->library = NULL;
+        snprintf(cc->error, sizeof(cc->error), "%s has no %s", library_path, CODEGEN_SYMBOL);
+        return -1;
+    }
+    prog->native_eval = (void (*)(uint64_t*, int))symbol;
+    return 0;
+}
+
+void codegen_unload(CompiledCircuit* cc, SimProgram* prog) {
+    if (prog) prog->native_eval = NULL;
+    if (cc->library) close_library(cc->library);
+    memset(cc, 0, sizeof(CompiledCircuit));
+}
@@ -0,0 +1,40 @@
+#ifndef CODEGEN_H
+#define CODEGEN_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "simulator.h"
+
+// Compiled-circuit mode: the levelized program is translated into a straight-line
+// C function over packed words, built with the local C compiler and loaded as a
+// shared library. Libraries are cached by emitter version, instruction set and
+// netlist hash in CODEGEN_CACHE_DIR under $XDG_CACHE_HOME (else ~/.cache, or
+// %LOCALAPPDATA% on Windows); override the directory with the LOGICSIM_CACHE
+// environment variable, the compiler with CC. Each library sits next to the C
+// source it was built from, and is only reused when that source matches.
+#define CODEGEN_CACHE_DIR "logicsim"
+#define CODEGEN_SYMBOL "circuit_eval"
+
+// Truth tables with at least this many inputs are worth a compile
+#define CODEGEN_MIN_INPUTS 16
+
+typedef struct {
+    void* library;      // shared library handle, NULL when interpreting
+    uint64_t hash;
+    int from_cache;     // library was found in the cache, no compiler run
+    char error[1024];   // why the circuit stays interpreted, when it does
+} CompiledCircuit;
+
+// Hash of everything the generated code depends on
+uint64_t codegen_netlist_hash(const SimProgram* prog);
+
+// Write the C source of the evaluator for prog, returns 0 on success
+int codegen_emit_c(const SimProgram* prog, FILE* out);
+
+// Compile (or fetch from the cache) and attach the native evaluator to prog.
+// Returns 0 when prog->native_eval is set, -1 when prog stays interpreted
+// with the reason in cc->error.
+int codegen_load(CompiledCircuit* cc, SimProgram* prog);
+void codegen_unload(CompiledCircuit* cc, SimProgram* prog);
+
+#endif
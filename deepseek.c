@@ -1,16 +1,48 @@
+// Build: gcc deepseek.c arena.c handle.c topo.c simulator.c bitsim.c ttpool.c codegen.c faultsim.c equiv.c bdd.c sat.c minimize.c aig.c rewrite.c lutmap.c logicgates.c -o deepseek -lpthread -ldl
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 #include <time.h>
+#include "simulator.h"
+#include "bitsim.h"
+#include "ttpool.h"
+#include "codegen.h"
+#include "faultsim.h"
+#include "equiv.h"
+#include "sat.h"
+#include "minimize.h"
+#include "aig.h"
+#include "rewrite.h"
+#include "simopt.h"
+#include "lutmap.h"
+#include "topo.h"
+#include "handle.h"
+#include "arena.h"
 
-#define MAX_GATES 100
-#define MAX_INPUTS 10
-#define MAX_OUTPUTS 10
-#define MAX_WIRES 200
 #define WORKSPACE_WIDTH 80
 #define WORKSPACE_HEIGHT 24
 
+// Random vectors simulated on both the gates and the LUT network when mapping
+#define LUT_CHECK_VECTORS 100000
+
+// Delta cycles a logic loop gets to settle or repeat a state
+#define MAX_SETTLE_DELTAS 100
+
+// Edits that can be undone; every one holds a copy of the circuit
+#define MAX_UNDO_ACTIONS 50
+
+// Layout of a saved circuit before the circuit could grow: fixed arrays of the
+// old sizes, written as one block without a header
+#define LEGACY_MAX_GATES 100
+#define LEGACY_MAX_INPUTS 10
+#define LEGACY_MAX_OUTPUTS 10
+#define LEGACY_MAX_WIRES 200
+
+// Saved circuits start with this tag, followed by the four counts
+#define CIRCUIT_FILE_TAG "DLC2"
+
 // Gate types
 typedef enum {
     GATE_NOT,
@@ -42,18 +74,35 @@ typedef struct {
     int to_pin;     // 1 or 2 for input gates
 } Wire;
 
-// Circuit structure
+// Circuit structure. The arrays grow as gates and wires are added, a
+// zero-initialized Circuit is empty.
 typedef struct {
-    Gate gates[MAX_GATES];
-    Wire wires[MAX_WIRES];
+    Gate* gates;
+    Wire* wires;
     int gate_count;
     int wire_count;
-    int input_gates[MAX_INPUTS];
-    int output_gates[MAX_OUTPUTS];
+    int* input_gates;
+    int* output_gates;
     int input_count;
     int output_count;
+    int gate_capacity;
+    int wire_capacity;
+    int input_capacity;
+    int output_capacity;
 } Circuit;
 
+// Saved circuit in the legacy layout
+typedef struct {
+    Gate gates[LEGACY_MAX_GATES];
+    Wire wires[LEGACY_MAX_WIRES];
+    int gate_count;
+    int wire_count;
+    int input_gates[LEGACY_MAX_INPUTS];
+    int output_gates[LEGACY_MAX_OUTPUTS];
+    int input_count;
+    int output_count;
+} LegacyCircuit;
+
 // Undo/Redo action structure
 typedef struct Action {
     Circuit circuit;
@@ -66,28 +115,61 @@ typedef struct Action {
 Circuit current_circuit;
 Action* undo_stack = NULL;
 Action* redo_stack = NULL;
+static int undo_count = 0;
 int next_gate_id = 1;
 int next_wire_id = 1;
 
+// Topological order of the gates by id, kept up to date wire by wire.
+// Wires that close a logic loop are held apart as feedback edges.
+static TopoOrder wire_order;
+
+// Index of each gate in current_circuit.gates by id
+static HandleTable gate_slots;
+
+// Evaluation cache, by gate index: a gate's output is current once its stamp
+// equals eval_epoch, so starting a new evaluation invalidates every gate at
+// once. eval_input holds the indices of the driving gates, -1 if none.
+static unsigned int eval_epoch = 0;
+static unsigned int* eval_stamp = NULL;
+static int (*eval_input)[2] = NULL;
+static int eval_stamp_capacity = 0;
+static int eval_input_capacity = 0;
+
+// Working space of one operation, sized by the circuit and released when it ends
+static Arena scratch;
+
+// Path of the logic loop a new wire closes
+static int* order_cycle = NULL;
+static int order_cycle_capacity = 0;
+
 // Function prototypes
 void initialize_circuit();
-void display_menu();
+static void display_menu();
 void display_workspace();
 void add_gate(GateType type, int x, int y);
 void delete_gate(int gate_id);
 void add_wire(int from_gate, int to_gate, int to_pin);
 void delete_wire(int wire_id);
 void evaluate_circuit();
-int evaluate_gate(int gate_id);
+int evaluate_gate(int index);
 void generate_truth_table();
+void fault_simulation(const char* filename, long long random_vectors);
+void equivalence_check(const char* file_a, const char* file_b, int match_by_label);
+void output_satisfiability();
+void minimize_circuit(int replace);
+void find_duplicate_logic();
+void rewrite_circuit(int replace);
+void map_to_luts(int k);
 void toggle_input(int input_index);
 void display_error(const char* message);
 int detect_loops();
+void evaluate_feedback_circuit();
 void save_action(const char* description);
 void undo();
 void redo();
 void save_circuit(const char* filename);
 void load_circuit(const char* filename);
+void report_memory();
 
 // Logic gate evaluation functions
 int gate_not(int input) { return !input; }
@@ -97,31 +179,183 @@ int gate_xor(int input1, int input2) { return input1 != input2; }
 int gate_nand(int input1, int input2) { return !(input1 && input2); }
 int gate_nor(int input1, int input2) { return !(input1 || input2); }
 
+// Find the array index of a gate by id through the circuit's index, -1 if it does not exist
+static int gate_index(const Circuit* circuit, const HandleTable* slots, int gate_id) {
+    int i = handle_slot(slots, gate_id);
+    return i < circuit->gate_count ? i : -1;
+}
+
+// Find the index of a gate of the current circuit by id, -1 if it does not exist
+static int current_gate_index(int gate_id) {
+    return gate_index(&current_circuit, &gate_slots, gate_id);
+}
+
+// Index the gates of a circuit other than the current one by id, for as long
+// as it is looked at. Returns 0 on success, -1 when out of memory.
+static int index_circuit(const Circuit* circuit, HandleTable* slots) {
+    handle_clear(slots);
+    for (int i = 0; i < circuit->gate_count; i++) {
+        if (handle_bind(slots, circuit->gates[i].id, i) != 0) return -1;
+    }
+    return 0;
+}
+
+// Find the current circuit's gate with an id, NULL if it does not exist
+static Gate* find_gate(int gate_id) {
+    int i = current_gate_index(gate_id);
+    return i >= 0 ? &current_circuit.gates[i] : NULL;
+}
+
+// Free the arrays of a circuit, leaving it empty
+static void circuit_free(Circuit* circuit) {
+    free(circuit->gates);
+    free(circuit->wires);
+    free(circuit->input_gates);
+    free(circuit->output_gates);
+    memset(circuit, 0, sizeof(Circuit));
+}
+
+// Add an id to a circuit's input or output gate list. Returns 0 on success,
+// -1 when out of memory.
+static int append_port(int** ports, int* count, int* capacity, int gate_id) {
+    if (array_reserve((void**)ports, capacity, *count + 1, sizeof(int)) != 0) return -1;
+    (*ports)[(*count)++] = gate_id;
+    return 0;
+}
+
+// Make a circuit hold gate_count gates, wire_count wires and the port counts.
+// Returns 0 on success, -1 when out of memory.
+static int circuit_reserve(Circuit* circuit, int gate_count, int wire_count, int input_count, int output_count) {
+    if (array_reserve((void**)&circuit->gates, &circuit->gate_capacity, gate_count, sizeof(Gate)) != 0 ||
+        array_reserve((void**)&circuit->wires, &circuit->wire_capacity, wire_count, sizeof(Wire)) != 0 ||
+        array_reserve((void**)&circuit->input_gates, &circuit->input_capacity, input_count, sizeof(int)) != 0 ||
+        array_reserve((void**)&circuit->output_gates, &circuit->output_capacity, output_count, sizeof(int)) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+// Copy a circuit into an empty one. Returns 0 on success, -1 when out of
+// memory, leaving the copy empty.
+static int circuit_copy(Circuit* copy, const Circuit* circuit) {
+    if (circuit_reserve(copy, circuit->gate_count, circuit->wire_count,
+                        circuit->input_count, circuit->output_count) != 0) {
+        circuit_free(copy);
+        return -1;
+    }
+    if (circuit->gate_count > 0) memcpy(copy->gates, circuit->gates, circuit->gate_count * sizeof(Gate));
+    if (circuit->wire_count > 0) memcpy(copy->wires, circuit->wires, circuit->wire_count * sizeof(Wire));
+    if (circuit->input_count > 0) memcpy(copy->input_gates, circuit->input_gates, circuit->input_count * sizeof(int));
+    if (circuit->output_count > 0) memcpy(copy->output_gates, circuit->output_gates, circuit->output_count * sizeof(int));
+    copy->gate_count = circuit->gate_count;
+    copy->wire_count = circuit->wire_count;
+    copy->input_count = circuit->input_count;
+    copy->output_count = circuit->output_count;
+    return 0;
+}
+
+// Add a wire to the gate order. Wires into INPUT gates are never read and are
+// left out. Returns 1 if the wire closes a logic loop, reported unless quiet.
+static int order_wire(const Wire* wire, int quiet) {
+    const Gate* to = find_gate(wire->to_gate);
+    if (to && to->type == GATE_INPUT) return 0;
+    int size = wire->from_gate > wire->to_gate ? wire->from_gate + 1 : wire->to_gate + 1;
+    int length = 0;
+    int status = -1;
+    // A path visits every gate at most once. The buffer is kept between wires,
+    // clearing one as large as the circuit for every wire would cost more than the wire
+    if (topo_reserve(&wire_order, size) == 0 &&
+        array_reserve((void**)&order_cycle, &order_cycle_capacity, wire_order.node_count, sizeof(int)) == 0) {
+        status = topo_add_edge(&wire_order, wire->from_gate, wire->to_gate, quiet ? NULL : order_cycle, &length);
+    }
+    if (status < 0) {
+        display_error("Not enough memory to check the wire for logic loops.");
+        return 0;
+    }
+    if (status == 1 && !quiet) {
+        ArenaMark mark = arena_mark(&scratch);
+        size_t message_size = 48 + 12 * (size_t)length;
+        char* message = arena_alloc(&scratch, message_size, 1);
+        if (message) {
+            int used = snprintf(message, message_size, "Logic loop detected: gates");
+            for (int i = 0; i < length; i++) {
+                used += snprintf(message + used, message_size - used, " %d ->", order_cycle[i]);
+            }
+            snprintf(message + used, message_size - used, " %d", order_cycle[0]);
+            display_error(message);
+        } else {
+            display_error("Logic loop detected.");
+        }
+        arena_release(&scratch, mark);
+    }
+    return status;
+}
+
+// Function to rebuild the gate index and the gate order after the whole
+// circuit was replaced
+static void rebuild_wire_order() {
+    int size = 0, count = 0;
+    handle_clear(&gate_slots);
+    for (int i = 0; i < current_circuit.gate_count; i++) {
+        if (handle_bind(&gate_slots, current_circuit.gates[i].id, i) != 0) {
+            display_error("Not enough memory to index the gates.");
+        }
+        if (current_circuit.gates[i].id + 1 > size) size = current_circuit.gates[i].id + 1;
+    }
+
+    ArenaMark mark = arena_mark(&scratch);
+    int* from = arena_alloc(&scratch, current_circuit.wire_count, sizeof(int));
+    int* to = arena_alloc(&scratch, current_circuit.wire_count, sizeof(int));
+    if (!from || !to) {
+        display_error("Not enough memory to order the gates.");
+        arena_release(&scratch, mark);
+        return;
+    }
+    for (int i = 0; i < current_circuit.wire_count; i++) {
+        const Wire* wire = &current_circuit.wires[i];
+        const Gate* target = find_gate(wire->to_gate);
+        if (target && target->type == GATE_INPUT) continue;
+        if (wire->from_gate + 1 > size) size = wire->from_gate + 1;
+        if (wire->to_gate + 1 > size) size = wire->to_gate + 1;
+        from[count] = wire->from_gate;
+        to[count] = wire->to_gate;
+        count++;
+    }
+    if (topo_build(&wire_order, size, from, to, count) < 0) {
+        display_error("Not enough memory to order the gates.");
+    }
+    arena_release(&scratch, mark);
+}
+
+// Free an undo or redo action and the circuit it holds
+static void free_action(Action* action) {
+    circuit_free(&action->circuit);
+    free(action);
+}
+
 // Initialize a new circuit
 void initialize_circuit() {
-    memset(&current_circuit, 0, sizeof(Circuit));
-    current_circuit.gate_count = 0;
-    current_circuit.wire_count = 0;
-    current_circuit.input_count = 0;
-    current_circuit.output_count = 0;
+    circuit_free(&current_circuit);
     next_gate_id = 1;
     next_wire_id = 1;
+    rebuild_wire_order();
     
-    // Free undo/redo stacks
+    // Free undo/redo stacks, the undo stack is linked from the newest action back
     while (undo_stack) {
         Action* temp = undo_stack;
-        undo_stack = undo_stack->next;
-        free(temp);
+        undo_stack = undo_stack->prev;
+        free_action(temp);
     }
+    undo_count = 0;
     while (redo_stack) {
         Action* temp = redo_stack;
         redo_stack = redo_stack->next;
-        free(temp);
+        free_action(temp);
     }
 }
 
 // Display main menu
-void display_menu() {
+static void display_menu() {
     printf("\n=== Digital Logic Circuit Simulator ===\n");
     printf("1. Add Gate\n");
     printf("2. Add Wire\n");
@@ -136,6 +370,14 @@ void display_menu() {
     printf("11. Save Circuit\n");
     printf("12. Load Circuit\n");
     printf("13. Clear Workspace\n");
+    printf("14. Fault Simulation\n");
+    printf("15. Equivalence Check\n");
+    printf("16. Output Satisfiability\n");
+    printf("17. Minimize Circuit\n");
+    printf("18. Find Duplicate Logic\n");
+    printf("19. Rewrite Circuit\n");
+    printf("20. Map to LUTs\n");
+    printf("21. Memory Usage\n");
     printf("0. Exit\n");
     printf("Choose an option: ");
 }
@@ -154,19 +396,17 @@ void display_workspace() {
     // Draw wires
     for (int i = 0; i < current_circuit.wire_count; i++) {
         Wire wire = current_circuit.wires[i];
-        Gate from_gate, to_gate;
         
         // Find gates
-        for (int j = 0; j < current_circuit.gate_count; j++) {
-            if (current_circuit.gates[j].id == wire.from_gate) from_gate = current_circuit.gates[j];
-            if (current_circuit.gates[j].id == wire.to_gate) to_gate = current_circuit.gates[j];
-        }
+        const Gate* from_gate = find_gate(wire.from_gate);
+        const Gate* to_gate = find_gate(wire.to_gate);
+        if (!from_gate || !to_gate) continue;
         
         // Simple line drawing (would be more complex in a real implementation)
-        int from_x = from_gate.x + 5;
-        int from_y = from_gate.y + 1;
-        int to_x = to_gate.x;
-        int to_y = to_gate.y + 1;
+        int from_x = from_gate->x + 5;
+        int from_y = from_gate->y + 1;
+        int to_x = to_gate->x;
+        int to_y = to_gate->y + 1;
         
         // Draw horizontal and vertical lines
         if (from_y == to_y) {
@@ -221,7 +461,7 @@ void display_workspace() {
             workspace[y+1][x+6] = '|';
             
             // Draw gate label
-            char label[3];
+            char label[5];
             switch (gate.type) {
                 case GATE_NOT: strcpy(label, "NOT"); break;
                 case GATE_AND: strcpy(label, "AND"); break;
@@ -243,7 +483,7 @@ void display_workspace() {
             }
             
             // Draw gate ID
-            char id_str[3];
+            char id_str[12];
             sprintf(id_str, "%d", gate.id);
             workspace[y+3][x+2] = id_str[0];
             if (strlen(id_str) > 1) workspace[y+3][x+3] = id_str[1];
@@ -291,13 +531,8 @@ void display_workspace() {
 
 // Add a gate to the circuit
 void add_gate(GateType type, int x, int y) {
-    if (current_circuit.gate_count >= MAX_GATES) {
-        display_error("Cannot add more gates. Maximum limit reached.");
-        return;
-    }
-    
     Gate new_gate;
-    new_gate.id = next_gate_id++;
+    new_gate.id = next_gate_id;
     new_gate.type = type;
     new_gate.x = x;
     new_gate.y = y;
@@ -313,17 +548,29 @@ void add_gate(GateType type, int x, int y) {
         case GATE_XOR: strcpy(new_gate.label, "XOR"); break;
         case GATE_NAND: strcpy(new_gate.label, "NAND"); break;
         case GATE_NOR: strcpy(new_gate.label, "NOR"); break;
-        case GATE_INPUT: 
-            strcpy(new_gate.label, "IN");
-            current_circuit.input_gates[current_circuit.input_count++] = new_gate.id;
-            break;
-        case GATE_OUTPUT: 
-            strcpy(new_gate.label, "OUT");
-            current_circuit.output_gates[current_circuit.output_count++] = new_gate.id;
-            break;
+        case GATE_INPUT: strcpy(new_gate.label, "IN"); break;
+        case GATE_OUTPUT: strcpy(new_gate.label, "OUT"); break;
     }
     
+    // Make room everywhere first, so running out of memory leaves the circuit as it was
+    if (circuit_reserve(&current_circuit, current_circuit.gate_count + 1, current_circuit.wire_count,
+                        current_circuit.input_count + 1, current_circuit.output_count + 1) != 0 ||
+        handle_bind(&gate_slots, new_gate.id, current_circuit.gate_count) != 0) {
+        display_error("Not enough memory to add the gate.");
+        return;
+    }
+    if (type == GATE_INPUT) {
+        append_port(&current_circuit.input_gates, &current_circuit.input_count,
+                    &current_circuit.input_capacity, new_gate.id);
+    } else if (type == GATE_OUTPUT) {
+        append_port(&current_circuit.output_gates, &current_circuit.output_count,
+                    &current_circuit.output_capacity, new_gate.id);
+    }
     current_circuit.gates[current_circuit.gate_count++] = new_gate;
+    next_gate_id++;
+    if (topo_reserve(&wire_order, new_gate.id + 1) != 0) {
+        display_error("Not enough memory to order the gates.");
+    }
     save_action("Add gate");
     printf("Added gate ID %d of type %s at position (%d,%d)\n", 
            new_gate.id, new_gate.label, x, y);
@@ -331,47 +578,43 @@ void add_gate(GateType type, int x, int y) {
 
 // Delete a gate from the circuit
 void delete_gate(int gate_id) {
-    int found = 0;
-    for (int i = 0; i < current_circuit.gate_count; i++) {
-        if (current_circuit.gates[i].id == gate_id) {
-            // Remove from input/output lists if needed
-            if (current_circuit.gates[i].type == GATE_INPUT) {
-                for (int j = 0; j < current_circuit.input_count; j++) {
-                    if (current_circuit.input_gates[j] == gate_id) {
-                        for (int k = j; k < current_circuit.input_count - 1; k++) {
-                            current_circuit.input_gates[k] = current_circuit.input_gates[k+1];
-                        }
-                        current_circuit.input_count--;
-                        break;
-                    }
+    int index = current_gate_index(gate_id);
+    if (index < 0) {
+        display_error("Gate not found.");
+        return;
+    }
+    
+    // Remove from input/output lists if needed
+    if (current_circuit.gates[index].type == GATE_INPUT) {
+        for (int j = 0; j < current_circuit.input_count; j++) {
+            if (current_circuit.input_gates[j] == gate_id) {
+                for (int k = j; k < current_circuit.input_count - 1; k++) {
+                    current_circuit.input_gates[k] = current_circuit.input_gates[k+1];
                 }
+                current_circuit.input_count--;
+                break;
             }
-            if (current_circuit.gates[i].type == GATE_OUTPUT) {
-                for (int j = 0; j < current_circuit.output_count; j++) {
-                    if (current_circuit.output_gates[j] == gate_id) {
-                        for (int k = j; k < current_circuit.output_count - 1; k++) {
-                            current_circuit.output_gates[k] = current_circuit.output_gates[k+1];
-                        }
-                        current_circuit.output_count--;
-                        break;
-                    }
+        }
+    }
+    if (current_circuit.gates[index].type == GATE_OUTPUT) {
+        for (int j = 0; j < current_circuit.output_count; j++) {
+            if (current_circuit.output_gates[j] == gate_id) {
+                for (int k = j; k < current_circuit.output_count - 1; k++) {
+                    current_circuit.output_gates[k] = current_circuit.output_gates[k+1];
                 }
+                current_circuit.output_count--;
+                break;
             }
-            
-            // Remove the gate
-            for (int j = i; j < current_circuit.gate_count - 1; j++) {
-                current_circuit.gates[j] = current_circuit.gates[j+1];
-            }
-            current_circuit.gate_count--;
-            found = 1;
-            break;
         }
     }
     
-    if (!found) {
-        display_error("Gate not found.");
-        return;
+    // Remove the gate, the gates after it move down one place
+    for (int j = index; j < current_circuit.gate_count - 1; j++) {
+        current_circuit.gates[j] = current_circuit.gates[j+1];
+        handle_bind(&gate_slots, current_circuit.gates[j].id, j);
     }
+    current_circuit.gate_count--;
+    handle_release(&gate_slots, current_circuit.gate_count);
     
     // Remove all wires connected to this gate
     for (int i = 0; i < current_circuit.wire_count; i++) {
@@ -388,65 +631,50 @@ void delete_gate(int gate_id) {
 
 // Add a wire between gates
 void add_wire(int from_gate, int to_gate, int to_pin) {
-    if (current_circuit.wire_count >= MAX_WIRES) {
-        display_error("Cannot add more wires. Maximum limit reached.");
-        return;
-    }
-    
     // Check if gates exist
-    int from_exists = 0, to_exists = 0;
-    GateType to_type;
+    Gate* to = find_gate(to_gate);
     
-    for (int i = 0; i < current_circuit.gate_count; i++) {
-        if (current_circuit.gates[i].id == from_gate) from_exists = 1;
-        if (current_circuit.gates[i].id == to_gate) {
-            to_exists = 1;
-            to_type = current_circuit.gates[i].type;
-        }
-    }
-    
-    if (!from_exists || !to_exists) {
+    if (!find_gate(from_gate) || !to) {
         display_error("One or both gates not found.");
         return;
     }
     
     // Check for NOT gate input constraints
-    if (to_type == GATE_NOT && to_pin == 2) {
+    if (to->type == GATE_NOT && to_pin == 2) {
         display_error("NOT gate has only one input (use pin 1).");
         return;
     }
     
-    // Check if wire already exists
-    for (int i = 0; i < current_circuit.wire_count; i++) {
-        if (current_circuit.wires[i].to_gate == to_gate && 
-            current_circuit.wires[i].to_pin == to_pin) {
-            display_error("A wire already connected to this pin.");
-            return;
-        }
+    // Check if wire already exists: the gate records the driver of each connected pin
+    if ((to_pin == 1 ? to->input1 : to->input2) != -1) {
+        display_error("A wire already connected to this pin.");
+        return;
     }
     
+    if (array_reserve((void**)&current_circuit.wires, &current_circuit.wire_capacity,
+                      current_circuit.wire_count + 1, sizeof(Wire)) != 0) {
+        display_error("Not enough memory to add the wire.");
+        return;
+    }
     Wire new_wire;
     new_wire.id = next_wire_id++;
     new_wire.from_gate = from_gate;
+    new_wire.from_pin = 1;
     new_wire.to_gate = to_gate;
     new_wire.to_pin = to_pin;
     
     current_circuit.wires[current_circuit.wire_count++] = new_wire;
     
     // Update gate connections
-    for (int i = 0; i < current_circuit.gate_count; i++) {
-        if (current_circuit.gates[i].id == to_gate) {
-            if (to_pin == 1) {
-                current_circuit.gates[i].input1 = from_gate;
-            } else {
-                current_circuit.gates[i].input2 = from_gate;
-            }
-            break;
-        }
+    if (to_pin == 1) {
+        to->input1 = from_gate;
+    } else {
+        to->input2 = from_gate;
     }
     
     save_action("Add wire");
     printf("Added wire from gate %d to gate %d (pin %d)\n", from_gate, to_gate, to_pin);
+    order_wire(&new_wire, 0);
 }
 
 // Delete a wire from the circuit
@@ -454,8 +682,10 @@ void delete_wire(int wire_id) {
     int found = 0;
     for (int i = 0; i < current_circuit.wire_count; i++) {
         if (current_circuit.wires[i].id == wire_id) {
+            int from_gate = current_circuit.wires[i].from_gate;
             int to_gate = current_circuit.wires[i].to_gate;
             int to_pin = current_circuit.wires[i].to_pin;
+            int to_input = 0;
             
             // Remove the wire
             for (int j = i; j < current_circuit.wire_count - 1; j++) {
@@ -465,16 +695,16 @@ void delete_wire(int wire_id) {
             found = 1;
             
             // Update gate connections
-            for (int j = 0; j < current_circuit.gate_count; j++) {
-                if (current_circuit.gates[j].id == to_gate) {
-                    if (to_pin == 1) {
-                        current_circuit.gates[j].input1 = -1;
-                    } else {
-                        current_circuit.gates[j].input2 = -1;
-                    }
-                    break;
+            Gate* to = find_gate(to_gate);
+            if (to) {
+                if (to_pin == 1) {
+                    to->input1 = -1;
+                } else {
+                    to->input2 = -1;
                 }
+                to_input = to->type == GATE_INPUT;
             }
+            if (!to_input) topo_remove_edge(&wire_order, from_gate, to_gate);
             break;
         }
     }
@@ -490,53 +720,56 @@ void delete_wire(int wire_id) {
 
 // Evaluate the entire circuit
 void evaluate_circuit() {
-    // Reset all outputs except inputs
-    for (int i = 0; i < current_circuit.gate_count; i++) {
-        if (current_circuit.gates[i].type != GATE_INPUT) {
-            current_circuit.gates[i].output = 0;
-        }
+    if (wire_order.feedback_count > 0) {
+        evaluate_feedback_circuit();
+        return;
     }
-    
-    // Evaluate all gates
-    for (int i = 0; i < current_circuit.gate_count; i++) {
-        evaluate_gate(current_circuit.gates[i].id);
+
+    // A new stamp array starts out stale for every gate
+    int stamps = eval_stamp_capacity;
+    if (array_reserve((void**)&eval_stamp, &eval_stamp_capacity, current_circuit.gate_count, sizeof(unsigned int)) != 0 ||
+        array_reserve((void**)&eval_input, &eval_input_capacity, current_circuit.gate_count, sizeof(int[2])) != 0) {
+        display_error("Not enough memory to evaluate the circuit.");
+        return;
+    }
+    if (eval_stamp_capacity > stamps) {
+        memset(eval_stamp + stamps, 0, (eval_stamp_capacity - stamps) * sizeof(unsigned int));
     }
-    
-    printf("Circuit evaluation completed.\n");
-}
 
-// Evaluate a specific gate
-int evaluate_gate(int gate_id) {
-    Gate* gate = NULL;
-    int index = -1;
-    
-    // Find the gate
+    // Resolve the input ids to indices once
     for (int i = 0; i < current_circuit.gate_count; i++) {
-        if (current_circuit.gates[i].id == gate_id) {
-            gate = &current_circuit.gates[i];
-            index = i;
-            break;
-        }
+        const Gate* gate = &current_circuit.gates[i];
+        eval_input[i][0] = current_gate_index(gate->input1);
+        eval_input[i][1] = current_gate_index(gate->input2);
     }
-    
-    if (!gate) return 0;
-    
-    // If already evaluated, return the value
-    if (gate->output != 0 || gate->type == GATE_INPUT) {
-        return gate->output;
+
+    // A new epoch makes every cached output stale
+    if (++eval_epoch == 0) {
+        memset(eval_stamp, 0, eval_stamp_capacity * sizeof(unsigned int));
+        eval_epoch = 1;
     }
-    
-    // Get input values
-    int input1_val = 0, input2_val = 0;
-    
-    if (gate->input1 != -1) {
-        input1_val = evaluate_gate(gate->input1);
+
+    // Evaluate all gates, drivers before the gates they feed
+    for (int i = 0; i < wire_order.node_count; i++) {
+        int index = current_gate_index(wire_order.order[i]);
+        if (index >= 0) evaluate_gate(index);
     }
-    
-    if (gate->input2 != -1) {
-        input2_val = evaluate_gate(gate->input2);
+
+    printf("Circuit evaluation completed.\n");
+}
+
+// Evaluate the gate at an index, computing each gate at most once per evaluation
+int evaluate_gate(int index) {
+    if (index < 0) return 0;
+    Gate* gate = &current_circuit.gates[index];
+    if (gate->type == GATE_INPUT || eval_stamp[index] == eval_epoch) {
+        return gate->output;
     }
-    
+    eval_stamp[index] = eval_epoch;
+
+    int input1_val = evaluate_gate(eval_input[index][0]);
+    int input2_val = evaluate_gate(eval_input[index][1]);
+
     // Calculate output based on gate type
     switch (gate->type) {
         case GATE_NOT:
@@ -567,21 +800,243 @@ int evaluate_gate(int gate_id) {
     return gate->output;
 }
 
-// Generate truth table for the circuit
-void generate_truth_table() {
+// Take arrays for the gate index of every input and output of the current
+// circuit from scratch and resolve the port ids into them. Returns 0 on
+// success, -1 when out of memory.
+static int port_indices(int** input_index, int** output_index) {
+    *input_index = arena_alloc(&scratch, current_circuit.input_count, sizeof(int));
+    *output_index = arena_alloc(&scratch, current_circuit.output_count, sizeof(int));
+    if (!*input_index || !*output_index) return -1;
+    for (int i = 0; i < current_circuit.input_count; i++) {
+        (*input_index)[i] = current_gate_index(current_circuit.input_gates[i]);
+    }
+    for (int i = 0; i < current_circuit.output_count; i++) {
+        (*output_index)[i] = current_gate_index(current_circuit.output_gates[i]);
+    }
+    return 0;
+}
+
+// Translate the circuit into the simulator's dense netlist
+static int build_sim_netlist(const Circuit* circuit, const HandleTable* slots, SimNetlist* net) {
+    static const int sim_type[] = {
+        SIM_NOT, SIM_AND, SIM_OR, SIM_XOR, SIM_NAND, SIM_NOR, SIM_INPUT, SIM_OUTPUT
+    };
+    if (sim_netlist_init(net, circuit->gate_count) != 0) return -1;
+    for (int i = 0; i < circuit->gate_count; i++) {
+        const Gate* gate = &circuit->gates[i];
+        net->types[i] = sim_type[gate->type];
+        if (gate->type == GATE_INPUT) continue;
+        if (gate->input1 != -1) net->fanin[i * SIM_MAX_PINS] = gate_index(circuit, slots, gate->input1);
+        if (gate->input2 != -1) net->fanin[i * SIM_MAX_PINS + 1] = gate_index(circuit, slots, gate->input2);
+    }
+    return 0;
+}
+
+// Read a circuit in the fixed layout save_circuit wrote before circuits could
+// grow, returns 0 on success
+static int read_legacy_circuit(FILE* file, Circuit* circuit) {
+    LegacyCircuit* legacy = malloc(sizeof(LegacyCircuit));
+    int status = -1;
+    rewind(file);
+    if (legacy && fread(legacy, sizeof(LegacyCircuit), 1, file) == 1 &&
+        legacy->gate_count >= 0 && legacy->gate_count <= LEGACY_MAX_GATES &&
+        legacy->wire_count >= 0 && legacy->wire_count <= LEGACY_MAX_WIRES &&
+        legacy->input_count >= 0 && legacy->input_count <= LEGACY_MAX_INPUTS &&
+        legacy->output_count >= 0 && legacy->output_count <= LEGACY_MAX_OUTPUTS &&
+        circuit_reserve(circuit, legacy->gate_count, legacy->wire_count,
+                        legacy->input_count, legacy->output_count) == 0) {
+        memcpy(circuit->gates, legacy->gates, legacy->gate_count * sizeof(Gate));
+        memcpy(circuit->wires, legacy->wires, legacy->wire_count * sizeof(Wire));
+        memcpy(circuit->input_gates, legacy->input_gates, legacy->input_count * sizeof(int));
+        memcpy(circuit->output_gates, legacy->output_gates, legacy->output_count * sizeof(int));
+        circuit->gate_count = legacy->gate_count;
+        circuit->wire_count = legacy->wire_count;
+        circuit->input_count = legacy->input_count;
+        circuit->output_count = legacy->output_count;
+        status = 0;
+    }
+    free(legacy);
+    return status;
+}
+
+// Check that a circuit read from a file is well formed: every gate has a known
+// type and its own id, pins and wires name gates of the circuit, and the ports
+// are INPUT and OUTPUT gates. Returns 0 if so, -1 otherwise.
+static int check_circuit(const Circuit* circuit) {
+    HandleTable slots = {0};
+    int status = 0;
+    for (int i = 0; i < circuit->gate_count && status == 0; i++) {
+        const Gate* gate = &circuit->gates[i];
+        if ((int)gate->type < GATE_NOT || (int)gate->type > GATE_OUTPUT ||
+            memchr(gate->label, '\0', sizeof(gate->label)) == NULL ||
+            handle_slot(&slots, gate->id) != -1 || handle_bind(&slots, gate->id, i) != 0) {
+            status = -1;
+        }
+    }
+    for (int i = 0; i < circuit->gate_count && status == 0; i++) {
+        const Gate* gate = &circuit->gates[i];
+        if ((gate->input1 != -1 && handle_slot(&slots, gate->input1) == -1) ||
+            (gate->input2 != -1 && handle_slot(&slots, gate->input2) == -1)) {
+            status = -1;
+        }
+    }
+    for (int i = 0; i < circuit->wire_count && status == 0; i++) {
+        const Wire* wire = &circuit->wires[i];
+        if (wire->id < 0 || handle_slot(&slots, wire->from_gate) == -1 ||
+            handle_slot(&slots, wire->to_gate) == -1 || wire->to_pin < 1 || wire->to_pin > 2) {
+            status = -1;
+        }
+    }
+    for (int i = 0; i < circuit->input_count && status == 0; i++) {
+        int slot = handle_slot(&slots, circuit->input_gates[i]);
+        if (slot == -1 || circuit->gates[slot].type != GATE_INPUT) status = -1;
+    }
+    for (int i = 0; i < circuit->output_count && status == 0; i++) {
+        int slot = handle_slot(&slots, circuit->output_gates[i]);
+        if (slot == -1 || circuit->gates[slot].type != GATE_OUTPUT) status = -1;
+    }
+    handle_free(&slots);
+    return status;
+}
+
+// Read a circuit saved by save_circuit into an empty circuit, returns 0 on
+// success. A file that does not hold a well-formed circuit fails, and on
+// failure the circuit is left empty.
+static int read_circuit(const char* filename, Circuit* circuit) {
+    FILE* file = fopen(filename, "rb");
+    if (!file) return -1;
+    char tag[4];
+    int counts[4];  // gates, wires, inputs, outputs
+    int status = -1;
+    if (fread(tag, sizeof(tag), 1, file) != 1 || memcmp(tag, CIRCUIT_FILE_TAG, sizeof(tag)) != 0) {
+        status = read_legacy_circuit(file, circuit);
+    } else if (fread(counts, sizeof(counts), 1, file) == 1 &&
+               counts[0] >= 0 && counts[1] >= 0 && counts[2] >= 0 && counts[3] >= 0 &&
+               counts[2] <= counts[0] && counts[3] <= counts[0] &&
+               circuit_reserve(circuit, counts[0], counts[1], counts[2], counts[3]) == 0 &&
+               fread(circuit->gates, sizeof(Gate), counts[0], file) == (size_t)counts[0] &&
+               fread(circuit->wires, sizeof(Wire), counts[1], file) == (size_t)counts[1] &&
+               fread(circuit->input_gates, sizeof(int), counts[2], file) == (size_t)counts[2] &&
+               fread(circuit->output_gates, sizeof(int), counts[3], file) == (size_t)counts[3]) {
+        circuit->gate_count = counts[0];
+        circuit->wire_count = counts[1];
+        circuit->input_count = counts[2];
+        circuit->output_count = counts[3];
+        status = 0;
+    }
+    fclose(file);
+    if (status == 0) status = check_circuit(circuit);
+    if (status != 0) circuit_free(circuit);
+    return status;
+}
+
+// Compile the circuit through its and-inverter graph, so duplicate, constant and
+// unobservable logic is gone and small cones are rewritten, when that saves
+// gates, before simulation. input_index / output_index receive the port gates
+// of the compiled netlist. A cyclic circuit is left as first compiled, with
+// prog->cyclic set.
+static int compile_structural(const Circuit* circuit, const HandleTable* slots, SimNetlist* net,
+                              SimProgram* prog, int* input_index, int* output_index) {
+    if (build_sim_netlist(circuit, slots, net) != 0 || simopt_prune(net) != 0 ||
+        sim_compile(prog, net) != 0) {
+        return -1;
+    }
+    for (int i = 0; i < circuit->input_count; i++) {
+        input_index[i] = gate_index(circuit, slots, circuit->input_gates[i]);
+    }
+    for (int i = 0; i < circuit->output_count; i++) {
+        output_index[i] = gate_index(circuit, slots, circuit->output_gates[i]);
+    }
+    if (prog->cyclic) return 0;
+
+    Aig aig;
+    if (aig_init(&aig) != 0) return -1;
+    SimNetlist lowered = {0};
+    int* lit_of_gate = malloc((prog->gate_count + 1) * sizeof(int));
+    int status = -1;
+    if (lit_of_gate &&
+        aig_from_program(&aig, prog, input_index, circuit->input_count, output_index,
+                         circuit->output_count, lit_of_gate) == 0 &&
+        aig_rewrite_netlist(&aig, &lowered, input_index, output_index, NULL) >= 0) {
+        sim_free_program(prog);
+        sim_netlist_free(net);
+        *net = lowered;
+        status = sim_compile(prog, net);
+    } else {
+        sim_netlist_free(&lowered);
+    }
+    free(lit_of_gate);
+    aig_free(&aig);
+    return status;
+}
+
+// Compute the truth table of the current circuit: compile once through the AIG
+// and evaluate 512 combinations per pass on every core. Reports its own errors.
+static int circuit_truth_table(TruthTable* table) {
     if (current_circuit.input_count == 0) {
         display_error("No input gates in the circuit.");
-        return;
+        return -1;
     }
     
     if (current_circuit.output_count == 0) {
         display_error("No output gates in the circuit.");
-        return;
+        return -1;
+    }
+    
+    if (current_circuit.input_count > TRUTH_TABLE_MAX_INPUTS) {
+        display_error("Too many input gates for a truth table.");
+        return -1;
     }
     
     int num_inputs = current_circuit.input_count;
     int num_outputs = current_circuit.output_count;
-    int num_combinations = 1 << num_inputs;  // 2^num_inputs
+    int* input_index;
+    int* output_index;
+    
+    ArenaMark mark = arena_mark(&scratch);
+    SimNetlist net = {0};
+    SimProgram prog = {0};
+    if (port_indices(&input_index, &output_index) != 0 ||
+        compile_structural(&current_circuit, &gate_slots, &net, &prog, input_index, output_index) != 0) {
+        display_error("Not enough memory to compile the circuit.");
+        sim_free_program(&prog);
+        sim_netlist_free(&net);
+        arena_release(&scratch, mark);
+        return -1;
+    }
+    if (prog.cyclic) {
+        display_error("Logic loop detected, truth table is undefined.");
+        sim_free_program(&prog);
+        sim_netlist_free(&net);
+        arena_release(&scratch, mark);
+        return -1;
+    }
+    CompiledCircuit native = {0};
+    if (num_inputs >= CODEGEN_MIN_INPUTS) {
+        if (codegen_load(&native, &prog) == 0) {
+            printf("Using compiled circuit%s\n", native.from_cache ? " (cached)" : "");
+        } else {
+            printf("Cannot compile the circuit (%s), using the interpreter\n", native.error);
+        }
+    }
+    int result = ttpool_truth_table(&prog, input_index, num_inputs, output_index, num_outputs, table, 0);
+    codegen_unload(&native, &prog);
+    sim_free_program(&prog);
+    sim_netlist_free(&net);
+    arena_release(&scratch, mark);
+    if (result != 0) {
+        display_error("Not enough memory for the truth table.");
+        return -1;
+    }
+    return 0;
+}
+
+// Generate truth table for the circuit
+void generate_truth_table() {
+    TruthTable table = {0};
+    if (circuit_truth_table(&table) != 0) return;
+    int num_inputs = table.num_inputs;
+    int num_outputs = table.num_outputs;
     
     printf("\nTruth Table:\n");
     
@@ -602,37 +1057,681 @@ void generate_truth_table() {
     }
     printf("\n");
     
-    // Generate all input combinations and evaluate
-    for (int comb = 0; comb < num_combinations; comb++) {
-        // Set input values
+    // Print every row from the packed table
+    for (long long comb = 0; comb < table.num_rows; comb++) {
+        printf("|");
         for (int i = 0; i < num_inputs; i++) {
-            int input_val = (comb >> (num_inputs - 1 - i)) & 1;
-            for (int j = 0; j < current_circuit.gate_count; j++) {
-                if (current_circuit.gates[j].id == current_circuit.input_gates[i]) {
-                    current_circuit.gates[j].output = input_val;
-                    break;
+            printf("  %d  |", (int)((comb >> (num_inputs - 1 - i)) & 1));
+        }
+        for (int i = 0; i < num_outputs; i++) {
+            printf("  %d  |", truth_table_get(&table, i, comb));
+        }
+        printf("\n");
+    }
+    
+    truth_table_free(&table);
+}
+
+// Read test vectors, one line of 0/1 characters per vector (I1 first), '#' starts a comment.
+// Returns the vector count, packed as faultsim_run expects, or -1 on error.
+static long long read_test_vectors(const char* filename, int num_inputs, uint64_t** vectors) {
+    FILE* file = fopen(filename, "r");
+    if (!file) return -1;
+
+    // First pass counts the vectors so the packed layout can be sized
+    char line[256];
+    long long count = 0;
+    while (fgets(line, sizeof(line), file)) {
+        if (line[0] == '0' || line[0] == '1') count++;
+    }
+    long long words = (count + 63) / 64;
+    *vectors = calloc(num_inputs * words + 1, sizeof(uint64_t));
+    if (!*vectors) {
+        fclose(file);
+        return -1;
+    }
+
+    rewind(file);
+    long long v = 0;
+    while (v < count && fgets(line, sizeof(line), file)) {
+        if (line[0] != '0' && line[0] != '1') continue;
+        int i = 0;
+        for (char* c = line; *c == '0' || *c == '1'; c++, i++) {
+            if (i < num_inputs && *c == '1') (*vectors)[i * words + v / 64] |= 1ULL << (v % 64);
+        }
+        if (i != num_inputs) {
+            printf("ERROR: Vector %lld has %d values, expected %d.\n", v + 1, i, num_inputs);
+            free(*vectors);
+            *vectors = NULL;
+            fclose(file);
+            return -1;
+        }
+        v++;
+    }
+    fclose(file);
+    return count;
+}
+
+// Grade a test vector set (a file, or random vectors when filename is NULL)
+// against every single stuck-at fault and report the fault coverage
+void fault_simulation(const char* filename, long long random_vectors) {
+    if (current_circuit.input_count == 0 || current_circuit.output_count == 0) {
+        display_error("Fault simulation needs input and output gates.");
+        return;
+    }
+
+    int num_inputs = current_circuit.input_count;
+    int num_outputs = current_circuit.output_count;
+    uint64_t* vectors = NULL;
+    long long num_vectors;
+    if (filename) {
+        num_vectors = read_test_vectors(filename, num_inputs, &vectors);
+        if (num_vectors < 0) {
+            display_error("Cannot read test vectors.");
+            return;
+        }
+    } else {
+        num_vectors = random_vectors;
+        long long words = (num_vectors + 63) / 64;
+        vectors = malloc((num_inputs * words + 1) * sizeof(uint64_t));
+        if (!vectors) {
+            display_error("Not enough memory for the test vectors.");
+            return;
+        }
+        srand((unsigned)time(NULL));
+        for (long long w = 0; w < num_inputs * words; w++) {
+            vectors[w] = 0;
+            for (int b = 0; b < 64; b += 16) {
+                vectors[w] |= (uint64_t)(rand() & 0xFFFF) << b;
+            }
+        }
+    }
+
+    ArenaMark mark = arena_mark(&scratch);
+    int* input_index;
+    int* output_index;
+    SimNetlist net = {0};
+    SimProgram prog = {0};
+    FaultList faults = {0};
+    if (port_indices(&input_index, &output_index) != 0 ||
+        build_sim_netlist(&current_circuit, &gate_slots, &net) != 0 || sim_compile(&prog, &net) != 0 ||
+        faultsim_enumerate(&net, &prog, &faults) != 0) {
+        display_error("Not enough memory to compile the circuit.");
+    } else if (prog.cyclic) {
+        display_error("Logic loop detected, fault simulation needs a combinational circuit.");
+    } else if (faultsim_run(&prog, input_index, num_inputs, output_index, num_outputs,
+                            vectors, num_vectors, &faults) != 0) {
+        display_error("Not enough memory for fault simulation.");
+    } else {
+        printf("\nFault Simulation: %lld vectors, %d stuck-at faults\n", num_vectors, faults.count);
+        printf("Detected: %d  Coverage: %.2f%%\n", faults.detected, faultsim_coverage(&faults));
+        if (faults.detected < faults.count) {
+            printf("Undetected faults:\n");
+            for (int k = 0; k < faults.count; k++) {
+                Fault* f = &faults.faults[k];
+                if (f->detected_by >= 0) continue;
+                Gate* gate = &current_circuit.gates[f->gate];
+                if (f->pin == FAULT_OUTPUT) {
+                    printf("  Gate %d (%s) output stuck-at-%d\n", gate->id, gate->label, f->stuck_at);
+                } else {
+                    printf("  Gate %d (%s) input %d stuck-at-%d\n", gate->id, gate->label, f->pin + 1, f->stuck_at);
                 }
             }
         }
-        
-        // Evaluate circuit
-        evaluate_circuit();
-        
-        // Print row
-        printf("|");
+    }
+
+    fault_list_free(&faults);
+    sim_free_program(&prog);
+    sim_netlist_free(&net);
+    free(vectors);
+    arena_release(&scratch, mark);
+}
+
+// Pair the ports of two circuits by position, or by label when match_by_label is set.
+// ports_b[i] receives the port of b that corresponds to ports_a[i].
+static int match_ports(const Circuit* a, const HandleTable* slots_a, const int* ids_a,
+                       const Circuit* b, const HandleTable* slots_b, const int* ids_b,
+                       int count, int match_by_label, int* ports_b) {
+    for (int i = 0; i < count; i++) {
+        if (!match_by_label) {
+            ports_b[i] = ids_b[i];
+            continue;
+        }
+        const char* label = a->gates[gate_index(a, slots_a, ids_a[i])].label;
+        int found = 0;
+        for (int j = 0; j < count; j++) {
+            if (strcmp(b->gates[gate_index(b, slots_b, ids_b[j])].label, label) == 0) {
+                ports_b[i] = ids_b[j];
+                found++;
+            }
+        }
+        if (found != 1) {
+            printf("ERROR: Label '%s' does not identify a single port in both circuits.\n", label);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Check that two circuits compute the same function, the files name them in the report
+static void compare_circuits(const Circuit* a, const Circuit* b, const char* file_a, const char* file_b,
+                             int match_by_label) {
+    if (a->input_count != b->input_count || a->output_count != b->output_count) {
+        printf("Not equivalent: %d inputs / %d outputs against %d inputs / %d outputs.\n",
+               a->input_count, a->output_count, b->input_count, b->output_count);
+        return;
+    }
+
+    int num_inputs = a->input_count;
+    int num_outputs = a->output_count;
+    ArenaMark mark = arena_mark(&scratch);
+    int* ports_b = arena_alloc(&scratch, num_inputs > num_outputs ? num_inputs : num_outputs, sizeof(int));
+    int* a_inputs = arena_alloc(&scratch, num_inputs, sizeof(int));
+    int* b_inputs = arena_alloc(&scratch, num_inputs, sizeof(int));
+    int* a_outputs = arena_alloc(&scratch, num_outputs, sizeof(int));
+    int* b_outputs = arena_alloc(&scratch, num_outputs, sizeof(int));
+    unsigned char* counterexample = arena_alloc(&scratch, num_inputs, 1);
+    HandleTable slots_a = {0}, slots_b = {0};
+    SimNetlist net_a = {0}, net_b = {0};
+    SimProgram prog_a = {0}, prog_b = {0};
+    EquivResult result;
+    if (!ports_b || !a_inputs || !b_inputs || !a_outputs || !b_outputs || !counterexample ||
+        index_circuit(a, &slots_a) != 0 || index_circuit(b, &slots_b) != 0) {
+        display_error("Not enough memory to compare the circuits.");
+        goto done;
+    }
+    if (match_ports(a, &slots_a, a->input_gates, b, &slots_b, b->input_gates, num_inputs,
+                    match_by_label, ports_b) != 0) {
+        goto done;
+    }
+    for (int i = 0; i < num_inputs; i++) {
+        a_inputs[i] = gate_index(a, &slots_a, a->input_gates[i]);
+        b_inputs[i] = gate_index(b, &slots_b, ports_b[i]);
+    }
+    if (match_ports(a, &slots_a, a->output_gates, b, &slots_b, b->output_gates, num_outputs,
+                    match_by_label, ports_b) != 0) {
+        goto done;
+    }
+    for (int i = 0; i < num_outputs; i++) {
+        a_outputs[i] = gate_index(a, &slots_a, a->output_gates[i]);
+        b_outputs[i] = gate_index(b, &slots_b, ports_b[i]);
+    }
+
+    if (build_sim_netlist(a, &slots_a, &net_a) != 0 || simopt_prune(&net_a) != 0 ||
+        sim_compile(&prog_a, &net_a) != 0 ||
+        build_sim_netlist(b, &slots_b, &net_b) != 0 || simopt_prune(&net_b) != 0 ||
+        sim_compile(&prog_b, &net_b) != 0) {
+        display_error("Not enough memory to compile the circuits.");
+    } else if (prog_a.cyclic || prog_b.cyclic) {
+        display_error("Logic loop detected, equivalence needs combinational circuits.");
+    } else if (equiv_check(&prog_a, a_inputs, a_outputs, &prog_b, b_inputs, b_outputs,
+                           num_inputs, num_outputs, EQUIV_RANDOM_VECTORS, &result, counterexample) != 0) {
+        display_error("Not enough memory for the equivalence check.");
+    } else if (result.equivalent && result.symbolic) {
+        printf("Equivalent: proven by %s.\n", equiv_method_name(result.method));
+    } else if (result.equivalent) {
+        printf("Equivalent: %s%lld%s vectors agree on every output.\n", result.exhaustive ? "all " : "",
+               result.vectors_checked, result.exhaustive ? "" : " random");
+    } else {
+        printf("Not equivalent: output O%d is %d in %s and %d in %s for inputs ",
+               result.output + 1, result.value_a, file_a, result.value_b, file_b);
         for (int i = 0; i < num_inputs; i++) {
-            printf("  %d  |", (comb >> (num_inputs - 1 - i)) & 1);
+            printf("I%d=%d ", i + 1, counterexample[i]);
         }
-        for (int i = 0; i < num_outputs; i++) {
-            for (int j = 0; j < current_circuit.gate_count; j++) {
-                if (current_circuit.gates[j].id == current_circuit.output_gates[i]) {
-                    printf("  %d  |", current_circuit.gates[j].output);
-                    break;
+        if (!result.symbolic) printf("(vector %lld)", result.vectors_checked);
+        printf("\n");
+    }
+
+done:
+    sim_free_program(&prog_a);
+    sim_free_program(&prog_b);
+    sim_netlist_free(&net_a);
+    sim_netlist_free(&net_b);
+    handle_free(&slots_a);
+    handle_free(&slots_b);
+    arena_release(&scratch, mark);
+}
+
+// Load two saved circuits and check that they compute the same function:
+// exhaustively up to EQUIV_EXHAUSTIVE_MAX_INPUTS inputs, on random vectors beyond
+void equivalence_check(const char* file_a, const char* file_b, int match_by_label) {
+    Circuit a = {0}, b = {0};
+    if (read_circuit(file_a, &a) != 0 || read_circuit(file_b, &b) != 0) {
+        display_error("Cannot open file for reading.");
+    } else {
+        compare_circuits(&a, &b, file_a, file_b, match_by_label);
+    }
+    circuit_free(&a);
+    circuit_free(&b);
+}
+
+// Ask the SAT solver whether each output can ever be 1. The circuit is encoded once
+// and every output is a separate query under an assumption, so clauses learnt
+// for one output speed up the next.
+void output_satisfiability() {
+    if (current_circuit.input_count == 0 || current_circuit.output_count == 0) {
+        display_error("Satisfiability needs input and output gates.");
+        return;
+    }
+
+    int num_inputs = current_circuit.input_count;
+    int* input_index;
+    int* output_index;
+
+    ArenaMark mark = arena_mark(&scratch);
+    SimNetlist net = {0};
+    SimProgram prog = {0};
+    SatSolver solver = {0};
+    int* var_of_gate = NULL;
+    if (port_indices(&input_index, &output_index) != 0 ||
+        compile_structural(&current_circuit, &gate_slots, &net, &prog, input_index, output_index) != 0 ||
+        sat_init(&solver) != 0 || !(var_of_gate = malloc((prog.gate_count + 1) * sizeof(int)))) {
+        display_error("Not enough memory to compile the circuit.");
+    } else if (prog.cyclic) {
+        display_error("Logic loop detected, satisfiability needs a combinational circuit.");
+    } else if (sat_encode_program(&solver, &prog, input_index, NULL, num_inputs, var_of_gate) != 0) {
+        display_error("Not enough memory to encode the circuit.");
+    } else {
+        printf("\nOutput Satisfiability:\n");
+        for (int o = 0; o < current_circuit.output_count; o++) {
+            int output_id = current_circuit.output_gates[o];
+            int assumption = SAT_LIT(var_of_gate[output_index[o]], 0);
+            int answer = sat_solve(&solver, &assumption, 1, 0);
+            printf("  O%d (gate %d): ", o + 1, output_id);
+            if (answer == SAT_SAT) {
+                printf("can be 1, for inputs ");
+                for (int i = 0; i < num_inputs; i++) {
+                    printf("I%d=%d ", i + 1, sat_model_value(&solver, var_of_gate[input_index[i]]));
                 }
+                printf("\n");
+            } else if (answer == SAT_UNSAT) {
+                printf("never 1\n");
+            } else {
+                printf("unknown (out of memory)\n");
             }
         }
-        printf("\n");
+        printf("%lld conflicts, %lld decisions\n", solver.conflicts, solver.decisions);
+    }
+
+    free(var_of_gate);
+    sat_free(&solver);
+    sim_free_program(&prog);
+    sim_netlist_free(&net);
+    arena_release(&scratch, mark);
+}
+
+// Rebuild a circuit from a netlist whose gates map one to one, ids are index + 1,
+// into an empty circuit. Port labels are taken from the current circuit, gates
+// are laid out in columns by logic level.
+static int circuit_from_netlist(const SimNetlist* net, const SimProgram* prog,
+                                const int* input_index, const int* output_index, Circuit* circuit) {
+    static const GateType gate_type[] = {
+        GATE_AND, GATE_OR, GATE_NOT, GATE_NAND, GATE_NOR, GATE_XOR, GATE_INPUT, GATE_OUTPUT
+    };
+    static const char* gate_label[] = { "NOT", "AND", "OR", "XOR", "NAND", "NOR", "IN", "OUT" };
+    int wire_count = 0;
+    for (int k = 0; k < net->gate_count * SIM_MAX_PINS; k++) {
+        if (net->fanin[k] >= 0) wire_count++;
+    }
+    if (circuit_reserve(circuit, net->gate_count, wire_count,
+                        current_circuit.input_count, current_circuit.output_count) != 0) {
+        return -1;
+    }
+    memset(circuit->gates, 0, net->gate_count * sizeof(Gate));
+
+    // A level holds at most every gate
+    ArenaMark mark = arena_mark(&scratch);
+    int* column_fill = arena_alloc(&scratch, net->gate_count + 1, sizeof(int));
+    if (!column_fill) return -1;
+    for (int g = 0; g < net->gate_count; g++) {
+        Gate* gate = &circuit->gates[circuit->gate_count++];
+        int level = prog->level[g];
+        gate->id = g + 1;
+        gate->type = gate_type[net->types[g]];
+        gate->x = 2 + level * 10 < WORKSPACE_WIDTH - 7 ? 2 + level * 10 : WORKSPACE_WIDTH - 7;
+        gate->y = (column_fill[level]++ * 3) % (WORKSPACE_HEIGHT - 3);
+        gate->input1 = -1;
+        gate->input2 = -1;
+        strcpy(gate->label, gate_label[gate->type]);
+        for (int pin = 0; pin < SIM_MAX_PINS; pin++) {
+            int from = net->fanin[g * SIM_MAX_PINS + pin];
+            if (from < 0) continue;
+            Wire* wire = &circuit->wires[circuit->wire_count++];
+            wire->id = circuit->wire_count;
+            wire->from_gate = from + 1;
+            wire->from_pin = 1;
+            wire->to_gate = g + 1;
+            wire->to_pin = pin + 1;
+            if (pin == 0) gate->input1 = from + 1;
+            else gate->input2 = from + 1;
+        }
+    }
+    for (int i = 0; i < current_circuit.input_count; i++) {
+        circuit->input_gates[circuit->input_count++] = input_index[i] + 1;
+        strcpy(circuit->gates[input_index[i]].label,
+               current_circuit.gates[current_gate_index(current_circuit.input_gates[i])].label);
+    }
+    for (int i = 0; i < current_circuit.output_count; i++) {
+        circuit->output_gates[circuit->output_count++] = output_index[i] + 1;
+        strcpy(circuit->gates[output_index[i]].label,
+               current_circuit.gates[current_gate_index(current_circuit.output_gates[i])].label);
+    }
+    arena_release(&scratch, mark);
+    return 0;
+}
+
+// Minimize every output of the truth table to a sum of products, rebuild the
+// circuit from NOT, AND and OR gates and compare the gate counts. With replace
+// set, the rebuilt circuit takes the place of the current one (undoable).
+void minimize_circuit(int replace) {
+    TruthTable table = {0};
+    if (circuit_truth_table(&table) != 0) return;
+
+    int num_inputs = table.num_inputs;
+    int num_outputs = table.num_outputs;
+    ArenaMark mark = arena_mark(&scratch);
+    SopCover* covers = arena_alloc(&scratch, num_outputs, sizeof(SopCover));
+    int minimized = 0;
+    while (covers && minimized < num_outputs && sop_minimize(&table, minimized, &covers[minimized]) == 0) {
+        minimized++;
+    }
+    truth_table_free(&table);
+
+    SimNetlist net = {0};
+    SimProgram prog = {0};
+    int* input_index = arena_alloc(&scratch, num_inputs, sizeof(int));
+    int* output_index = arena_alloc(&scratch, num_outputs, sizeof(int));
+    if (minimized < num_outputs || !input_index || !output_index ||
+        sop_build_netlist(covers, num_outputs, &net, input_index, output_index) != 0 ||
+        sim_compile(&prog, &net) != 0) {
+        display_error("Not enough memory to minimize the circuit.");
+    } else {
+        printf("\nMinimized Circuit:\n");
+        for (int o = 0; o < num_outputs; o++) {
+            printf("  O%d = ", o + 1);
+            sop_print(&covers[o], stdout, covers[o].count);
+            printf("   (%d terms, %d literals%s)\n", covers[o].count, sop_literal_count(&covers[o]),
+                   covers[o].exact ? "" : ", heuristic");
+        }
+        printf("Logic gates: %d in the circuit, %d in the minimized form\n",
+               current_circuit.gate_count - num_inputs - num_outputs, net.gate_count - num_inputs - num_outputs);
+
+        Circuit rebuilt = {0};
+        if (replace && circuit_from_netlist(&net, &prog, input_index, output_index, &rebuilt) != 0) {
+            display_error("Not enough memory to rebuild the circuit.");
+            circuit_free(&rebuilt);
+        } else if (replace) {
+            circuit_free(&current_circuit);
+            current_circuit = rebuilt;
+            next_gate_id = current_circuit.gate_count + 1;
+            next_wire_id = current_circuit.wire_count + 1;
+            rebuild_wire_order();
+            save_action("Minimize circuit");
+            printf("Circuit replaced by its minimized form.\n");
+        }
+    }
+
+    for (int o = 0; o < minimized; o++) {
+        sop_cover_free(&covers[o]);
+    }
+    sim_free_program(&prog);
+    sim_netlist_free(&net);
+    arena_release(&scratch, mark);
+}
+
+// Report gates that structural hashing folds away: constants, gates that only
+// repeat an input, and gates computing the same function (or its inverse) as an
+// earlier gate. Gates are compared as built, not by full functional equivalence.
+void find_duplicate_logic() {
+    int num_inputs = current_circuit.input_count;
+    int num_outputs = current_circuit.output_count;
+    int* input_index;
+    int* output_index;
+
+    ArenaMark mark = arena_mark(&scratch);
+    SimNetlist net = {0};
+    SimProgram prog = {0};
+    Aig aig = {0};
+    int* lit_of_gate = arena_alloc(&scratch, current_circuit.gate_count + 1, sizeof(int));
+    if (!lit_of_gate || port_indices(&input_index, &output_index) != 0 ||
+        build_sim_netlist(&current_circuit, &gate_slots, &net) != 0 || sim_compile(&prog, &net) != 0 ||
+        aig_init(&aig) != 0) {
+        display_error("Not enough memory to compile the circuit.");
+    } else if (prog.cyclic) {
+        display_error("Logic loop detected, duplicate logic needs a combinational circuit.");
+    } else if (aig_from_program(&aig, &prog, input_index, num_inputs, output_index, num_outputs,
+                                lit_of_gate) != 0) {
+        display_error("Not enough memory to build the and-inverter graph.");
+    } else {
+        printf("\nDuplicate Logic:\n");
+        int found = 0;
+        for (int g = 0; g < current_circuit.gate_count; g++) {
+            const Gate* gate = &current_circuit.gates[g];
+            if (gate->type == GATE_INPUT || gate->type == GATE_OUTPUT) continue;
+            int lit = lit_of_gate[g];
+            int node = AIG_NODE(lit);
+            int h = aig.origin[node];
+            if (node == 0) {
+                printf("  Gate %d (%s) is always %d\n", gate->id, gate->label, lit == AIG_TRUE);
+            } else if (h == g || h < 0 || AIG_NODE(lit_of_gate[h]) != node) {
+                continue;
+            } else if (gate->type == GATE_NOT && current_gate_index(gate->input1) == h) {
+                continue;
+            } else if (current_circuit.gates[h].type == GATE_INPUT) {
+                printf("  Gate %d (%s) is %sinput gate %d\n", gate->id, gate->label,
+                       lit == lit_of_gate[h] ? "" : "the inverse of ", current_circuit.gates[h].id);
+            } else {
+                printf("  Gate %d (%s) %s gate %d (%s)\n", gate->id, gate->label,
+                       lit == lit_of_gate[h] ? "duplicates" : "is the inverse of",
+                       current_circuit.gates[h].id, current_circuit.gates[h].label);
+            }
+            found++;
+        }
+        if (!found) printf("  No duplicate logic found.\n");
+        printf("%d logic gates lower to %d AND nodes\n",
+               current_circuit.gate_count - num_inputs - num_outputs, aig.and_count);
+    }
+
+    aig_free(&aig);
+    sim_free_program(&prog);
+    sim_netlist_free(&net);
+    arena_release(&scratch, mark);
+}
+
+// Rewrite the and-inverter graph of the circuit cut by cut into fewer nodes,
+// report the node count and logic depth before and after, and check that the
+// rewritten circuit is equivalent to the original. With replace set, the
+// rewritten circuit takes the place of the current one (undoable) unless it
+// has more gates.
+void rewrite_circuit(int replace) {
+    int num_inputs = current_circuit.input_count;
+    int num_outputs = current_circuit.output_count;
+    int* input_index;
+    int* output_index;
+    int* rewritten_inputs;
+    int* rewritten_outputs;
+
+    ArenaMark mark = arena_mark(&scratch);
+    SimNetlist net = {0};
+    SimProgram prog = {0};
+    SimNetlist rewritten = {0};
+    SimProgram rewritten_prog = {0};
+    Aig aig = {0};
+    AigRewriteStats stats;
+    int kept = 0;
+    EquivResult result;
+    unsigned char* counterexample = arena_alloc(&scratch, num_inputs, 1);
+    int* lit_of_gate = arena_alloc(&scratch, current_circuit.gate_count + 1, sizeof(int));
+    if (!counterexample || !lit_of_gate || port_indices(&input_index, &output_index) != 0 ||
+        port_indices(&rewritten_inputs, &rewritten_outputs) != 0 ||
+        build_sim_netlist(&current_circuit, &gate_slots, &net) != 0 || sim_compile(&prog, &net) != 0 ||
+        aig_init(&aig) != 0) {
+        display_error("Not enough memory to compile the circuit.");
+    } else if (prog.cyclic) {
+        display_error("Logic loop detected, rewriting needs a combinational circuit.");
+    } else if (aig_from_program(&aig, &prog, input_index, num_inputs, output_index, num_outputs,
+                                lit_of_gate) != 0 ||
+               (kept = aig_rewrite_netlist(&aig, &rewritten, rewritten_inputs, rewritten_outputs,
+                                           &stats)) < 0 ||
+               sim_compile(&rewritten_prog, &rewritten) != 0) {
+        display_error("Not enough memory to rewrite the circuit.");
+    } else {
+        printf("\nRewritten Circuit:\n");
+        printf("  AND nodes:   %d -> %d (%d cuts rewritten)\n", stats.and_before, stats.and_after, stats.rewrites);
+        printf("  AND depth:   %d -> %d\n", stats.depth_before, stats.depth_after);
+        printf("  Logic gates: %d -> %d\n", current_circuit.gate_count - num_inputs - num_outputs,
+               rewritten.gate_count - num_inputs - num_outputs);
+        if (!kept) printf("  Rewriting saves no gates once lowered, the graph is lowered as it was.\n");
+
+        Circuit rebuilt = {0};
+        if (equiv_check(&prog, input_index, output_index, &rewritten_prog, rewritten_inputs, rewritten_outputs,
+                        num_inputs, num_outputs, EQUIV_RANDOM_VECTORS, &result, counterexample) != 0) {
+            display_error("Not enough memory to verify the rewritten circuit.");
+        } else if (!result.equivalent) {
+            display_error("Rewritten circuit is not equivalent, keeping the original.");
+        } else {
+            if (result.symbolic) {
+                printf("Verified equivalent: proven by %s.\n", equiv_method_name(result.method));
+            } else {
+                printf("Verified equivalent: %s%lld%s vectors agree on every output.\n",
+                       result.exhaustive ? "all " : "", result.vectors_checked, result.exhaustive ? "" : " random");
+            }
+            if (replace && rewritten.gate_count > current_circuit.gate_count) {
+                display_error("Rewritten circuit has more gates, keeping the original.");
+            } else if (replace && circuit_from_netlist(&rewritten, &rewritten_prog, rewritten_inputs,
+                                                rewritten_outputs, &rebuilt) != 0) {
+                display_error("Not enough memory to rebuild the circuit.");
+                circuit_free(&rebuilt);
+            } else if (replace) {
+                circuit_free(&current_circuit);
+                current_circuit = rebuilt;
+                next_gate_id = current_circuit.gate_count + 1;
+                next_wire_id = current_circuit.wire_count + 1;
+                rebuild_wire_order();
+                save_action("Rewrite circuit");
+                printf("Circuit replaced by its rewritten form.\n");
+            }
+        }
+    }
+
+    aig_free(&aig);
+    sim_free_program(&rewritten_prog);
+    sim_netlist_free(&rewritten);
+    sim_free_program(&prog);
+    sim_netlist_free(&net);
+    arena_release(&scratch, mark);
+}
+
+// Cover the rewritten and-inverter graph of the circuit with k-input lookup
+// tables and report the mapping. Random vectors are then simulated on both the
+// compiled gates and the LUT network, checking that they agree and timing both.
+void map_to_luts(int k) {
+    if (k < 2 || k > LUT_MAX_INPUTS) {
+        display_error("LUT size must be between 2 and 6.");
+        return;
+    }
+    int num_inputs = current_circuit.input_count;
+    int num_outputs = current_circuit.output_count;
+    int* input_index;
+    int* output_index;
+    int* gate_inputs;
+    int* gate_outputs;
+
+    ArenaMark mark = arena_mark(&scratch);
+    SimNetlist net = {0};
+    SimProgram prog = {0};
+    SimNetlist gates = {0};
+    SimProgram gate_prog = {0};
+    Aig aig = {0};
+    LutNetwork luts = {0};
+    int* lit_of_gate = arena_alloc(&scratch, current_circuit.gate_count + 1, sizeof(int));
+    unsigned char* vectors = malloc((size_t)LUT_CHECK_VECTORS * (num_inputs + num_outputs) + 1);
+    unsigned char* gate_values = NULL;
+    unsigned char* lut_values = NULL;
+    if (!vectors || !lit_of_gate || port_indices(&input_index, &output_index) != 0 ||
+        port_indices(&gate_inputs, &gate_outputs) != 0 ||
+        build_sim_netlist(&current_circuit, &gate_slots, &net) != 0 || sim_compile(&prog, &net) != 0 ||
+        aig_init(&aig) != 0) {
+        display_error("Not enough memory to compile the circuit.");
+    } else if (prog.cyclic) {
+        display_error("Logic loop detected, LUT mapping needs a combinational circuit.");
+    } else if (aig_from_program(&aig, &prog, input_index, num_inputs, output_index, num_outputs,
+                                lit_of_gate) != 0 ||
+               aig_rewrite(&aig, NULL) != 0 || lut_map(&luts, &aig, k) != 0 ||
+               compile_structural(&current_circuit, &gate_slots, &gates, &gate_prog, gate_inputs,
+                                  gate_outputs) != 0 ||
+               !(gate_values = calloc(gate_prog.gate_count + 1, 1)) ||
+               !(lut_values = calloc(luts.signal_count, 1))) {
+        display_error("Not enough memory to map the circuit.");
+    } else {
+        int by_size[LUT_MAX_INPUTS + 1] = {0};
+        for (int l = 0; l < luts.lut_count; l++) {
+            by_size[luts.fanin_count[l]]++;
+        }
+        printf("\nLUT Mapping:\n");
+        printf("  %d AND nodes -> %d LUTs of up to %d inputs\n", aig.and_count, luts.lut_count, k);
+        for (int size = 1; size <= k; size++) {
+            if (by_size[size]) printf("    %d-input LUTs: %d\n", size, by_size[size]);
+        }
+        // OUTPUT gates add a level of copies on top of the logic
+        printf("  Logic levels: %d of gates -> %d of LUTs\n", gate_prog.max_level - 1, luts.depth);
+        printf("  Evaluation steps per vector: %d gates -> %d LUTs\n", gate_prog.instr_count, luts.lut_count);
+
+        // Inputs of every vector, followed by the outputs the gates compute
+        unsigned char* outputs = vectors + (size_t)LUT_CHECK_VECTORS * num_inputs;
+        srand((unsigned)time(NULL));
+        for (long long i = 0; i < (long long)LUT_CHECK_VECTORS * num_inputs; i++) {
+            vectors[i] = (unsigned char)(rand() & 1);
+        }
+        clock_t start = clock();
+        for (int v = 0; v < LUT_CHECK_VECTORS; v++) {
+            for (int i = 0; i < num_inputs; i++) {
+                gate_values[gate_inputs[i]] = vectors[(size_t)v * num_inputs + i];
+            }
+            sim_run(&gate_prog, gate_values);
+            for (int o = 0; o < num_outputs; o++) {
+                outputs[(size_t)v * num_outputs + o] = gate_values[gate_outputs[o]];
+            }
+        }
+        double gate_time = (double)(clock() - start) / CLOCKS_PER_SEC;
+        int mismatch_vector = -1, mismatch_output = 0;
+        start = clock();
+        for (int v = 0; v < LUT_CHECK_VECTORS; v++) {
+            for (int i = 0; i < num_inputs; i++) {
+                lut_values[1 + i] = vectors[(size_t)v * num_inputs + i];
+            }
+            lut_run(&luts, lut_values);
+            for (int o = 0; o < num_outputs && mismatch_vector < 0; o++) {
+                if (LUT_OUTPUT(&luts, lut_values, o) != outputs[(size_t)v * num_outputs + o]) {
+                    mismatch_vector = v;
+                    mismatch_output = o;
+                }
+            }
+        }
+        double lut_time = (double)(clock() - start) / CLOCKS_PER_SEC;
+        printf("  Time per vector: %.3f us on gates, %.3f us on LUTs\n",
+               gate_time * 1e6 / LUT_CHECK_VECTORS, lut_time * 1e6 / LUT_CHECK_VECTORS);
+        if (mismatch_vector < 0) {
+            printf("LUT network agrees with the gates on %d random vectors.\n", LUT_CHECK_VECTORS);
+        } else {
+            printf("LUT network differs from the gates on output O%d for inputs ", mismatch_output + 1);
+            for (int i = 0; i < num_inputs; i++) {
+                printf("I%d=%d ", i + 1, vectors[(size_t)mismatch_vector * num_inputs + i]);
+            }
+            printf("\n");
+        }
     }
+
+    free(vectors);
+    free(gate_values);
+    free(lut_values);
+    lut_free(&luts);
+    aig_free(&aig);
+    sim_free_program(&gate_prog);
+    sim_netlist_free(&gates);
+    sim_free_program(&prog);
+    sim_netlist_free(&net);
+    arena_release(&scratch, mark);
 }
 
 // Toggle an input value
@@ -642,14 +1741,12 @@ void toggle_input(int input_index) {
         return;
     }
     
-    int gate_id = current_circuit.input_gates[input_index];
-    for (int i = 0; i < current_circuit.gate_count; i++) {
-        if (current_circuit.gates[i].id == gate_id) {
-            current_circuit.gates[i].output = !current_circuit.gates[i].output;
-            printf("Toggled input %d to %d\n", input_index + 1, current_circuit.gates[i].output);
-            save_action("Toggle input");
-            return;
-        }
+    Gate* gate = find_gate(current_circuit.input_gates[input_index]);
+    if (gate) {
+        gate->output = !gate->output;
+        printf("Toggled input %d to %d\n", input_index + 1, gate->output);
+        save_action("Toggle input");
+        return;
     }
     
     display_error("Input gate not found.");
@@ -660,37 +1757,109 @@ void display_error(const char* message) {
     printf("ERROR: %s\n", message);
 }
 
-// Detect logic loops in the circuit (basic implementation)
+// Report every logic loop of the circuit: each group of gates that feed each
+// other (strongly connected components of the compiled netlist) or a gate wired
+// to itself, with the ids of its gates. Returns the number of loops.
 int detect_loops() {
-    // This is a simplified implementation
-    // A full implementation would use graph cycle detection algorithms
-    
-    for (int i = 0; i < current_circuit.wire_count; i++) {
-        Wire wire = current_circuit.wires[i];
-        
-        // Check if a gate connects to itself
-        if (wire.from_gate == wire.to_gate) {
-            display_error("Logic loop detected: gate connected to itself.");
-            return 1;
+    SimNetlist net = {0};
+    SimProgram prog = {0};
+    if (build_sim_netlist(&current_circuit, &gate_slots, &net) != 0 || sim_compile(&prog, &net) != 0) {
+        display_error("Not enough memory to check for logic loops.");
+        sim_free_program(&prog);
+        sim_netlist_free(&net);
+        return 0;
+    }
+
+    for (int l = 0; l < prog.loop_count; l++) {
+        ArenaMark mark = arena_mark(&scratch);
+        size_t size = 32 + 12 * (size_t)(prog.loop_end[l] - prog.loop_begin[l]);
+        char* message = arena_alloc(&scratch, size, 1);
+        if (!message) {
+            display_error("Logic loop detected.");
+            continue;
         }
-        
-        // Check for circular dependencies (simplified)
-        for (int j = 0; j < current_circuit.wire_count; j++) {
-            if (i != j && current_circuit.wires[j].from_gate == wire.to_gate && 
-                current_circuit.wires[j].to_gate == wire.from_gate) {
-                display_error("Logic loop detected: circular connection between gates.");
-                return 1;
-            }
+        int length = snprintf(message, size, "Logic loop detected through gates");
+        for (int i = prog.loop_begin[l]; i < prog.loop_end[l]; i++) {
+            length += snprintf(message + length, size - length, " %d",
+                               current_circuit.gates[prog.code[i].out].id);
         }
+        display_error(message);
+        arena_release(&scratch, mark);
+    }
+    int loops = prog.loop_count;
+    sim_free_program(&prog);
+    sim_netlist_free(&net);
+    return loops;
+}
+
+// Evaluate a circuit with logic loops. The gates keep their outputs from the
+// last evaluation as their state, so a latch holds its value; loops that never
+// settle are reported with the gates that keep toggling.
+void evaluate_feedback_circuit() {
+    ArenaMark mark = arena_mark(&scratch);
+    SimNetlist net = {0};
+    SimProgram prog = {0};
+    unsigned char* values = arena_alloc(&scratch, current_circuit.gate_count + 1, 1);
+    unsigned char* oscillating = arena_alloc(&scratch, current_circuit.gate_count + 1, 1);
+    if (!values || !oscillating ||
+        build_sim_netlist(&current_circuit, &gate_slots, &net) != 0 || sim_compile(&prog, &net) != 0) {
+        display_error("Not enough memory to evaluate the circuit.");
+        sim_free_program(&prog);
+        sim_netlist_free(&net);
+        arena_release(&scratch, mark);
+        return;
+    }
+
+    for (int i = 0; i < current_circuit.gate_count; i++) {
+        values[i] = (unsigned char)(current_circuit.gates[i].output != 0);
+    }
+    int unsettled = sim_run_loops(&prog, values, MAX_SETTLE_DELTAS, oscillating);
+    if (unsettled < 0) {
+        display_error("Not enough memory to evaluate the circuit.");
+    } else {
+        for (int i = 0; i < current_circuit.gate_count; i++) {
+            if (current_circuit.gates[i].type != GATE_INPUT) current_circuit.gates[i].output = values[i];
+        }
+    }
+    size_t size = 48 + 12 * (size_t)current_circuit.gate_count;
+    char* message = unsettled > 0 ? arena_alloc(&scratch, size, 1) : NULL;
+    if (message) {
+        int length = snprintf(message, size, "Logic loop does not settle");
+        int found = 0;
+        for (int i = 0; i < current_circuit.gate_count; i++) {
+            if (!oscillating[i]) continue;
+            length += snprintf(message + length, size - length, "%s %d",
+                               found++ ? "" : ", oscillating or racing gates:", current_circuit.gates[i].id);
+        }
+        display_error(message);
+    } else if (unsettled > 0) {
+        display_error("Logic loop does not settle.");
+    }
+    sim_free_program(&prog);
+    sim_netlist_free(&net);
+    arena_release(&scratch, mark);
+    if (unsettled >= 0) printf("Circuit evaluation completed.\n");
+}
+
+// Drop the oldest undo actions beyond MAX_UNDO_ACTIONS, each holds a whole circuit
+static void trim_undo_stack() {
+    while (undo_count > MAX_UNDO_ACTIONS) {
+        Action* oldest = undo_stack;
+        while (oldest->prev) oldest = oldest->prev;
+        if (oldest->next) oldest->next->prev = NULL;
+        free_action(oldest);
+        undo_count--;
     }
-    
-    return 0;
 }
 
 // Save current state to undo stack
 void save_action(const char* description) {
-    Action* new_action = (Action*)malloc(sizeof(Action));
-    new_action->circuit = current_circuit;
+    Action* new_action = (Action*)calloc(1, sizeof(Action));
+    if (!new_action || circuit_copy(&new_action->circuit, &current_circuit) != 0) {
+        free(new_action);
+        display_error("Not enough memory to save the action for undo.");
+        return;
+    }
     strcpy(new_action->description, description);
     new_action->next = NULL;
     new_action->prev = NULL;
@@ -700,12 +1869,14 @@ void save_action(const char* description) {
         new_action->prev = undo_stack;
     }
     undo_stack = new_action;
+    undo_count++;
+    trim_undo_stack();
     
     // Clear redo stack when new action is performed
     while (redo_stack) {
         Action* temp = redo_stack;
         redo_stack = redo_stack->next;
-        free(temp);
+        free_action(temp);
     }
 }
 
@@ -716,8 +1887,12 @@ void undo() {
         return;
     }
     
-    // Save current state to redo stack
+    // Save current state to redo stack, the action takes over its arrays
     Action* redo_action = (Action*)malloc(sizeof(Action));
+    if (!redo_action) {
+        display_error("Not enough memory to undo.");
+        return;
+    }
     redo_action->circuit = current_circuit;
     strcpy(redo_action->description, "Redo point");
     redo_action->next = redo_stack;
@@ -725,12 +1900,14 @@ void undo() {
     if (redo_stack) redo_stack->prev = redo_action;
     redo_stack = redo_action;
     
-    // Restore previous state
+    // Restore previous state, the circuit takes over the action's arrays
     current_circuit = undo_stack->circuit;
+    rebuild_wire_order();
     Action* temp = undo_stack;
     undo_stack = undo_stack->prev;
     if (undo_stack) undo_stack->next = NULL;
     free(temp);
+    undo_count--;
     
     printf("Undo completed: %s\n", redo_action->description);
 }
@@ -742,21 +1919,28 @@ void redo() {
         return;
     }
     
-    // Save current state to undo stack
+    // Save current state to undo stack, the action takes over its arrays
     Action* undo_action = (Action*)malloc(sizeof(Action));
+    if (!undo_action) {
+        display_error("Not enough memory to redo.");
+        return;
+    }
     undo_action->circuit = current_circuit;
     strcpy(undo_action->description, "Undo point");
     undo_action->next = NULL;
     undo_action->prev = undo_stack;
     if (undo_stack) undo_stack->next = undo_action;
     undo_stack = undo_action;
+    undo_count++;
     
-    // Restore next state
+    // Restore next state, the circuit takes over the action's arrays
     current_circuit = redo_stack->circuit;
+    rebuild_wire_order();
     Action* temp = redo_stack;
     redo_stack = redo_stack->next;
     if (redo_stack) redo_stack->prev = NULL;
     free(temp);
+    trim_undo_stack();
     
     printf("Redo completed.\n");
 }
@@ -769,21 +1953,77 @@ void save_circuit(const char* filename) {
         return;
     }
     
-    fwrite(&current_circuit, sizeof(Circuit), 1, file);
-    fclose(file);
+    // A tag and the counts, then the arrays
+    int counts[4] = {
+        current_circuit.gate_count, current_circuit.wire_count,
+        current_circuit.input_count, current_circuit.output_count
+    };
+    fwrite(CIRCUIT_FILE_TAG, 4, 1, file);
+    fwrite(counts, sizeof(counts), 1, file);
+    fwrite(current_circuit.gates, sizeof(Gate), current_circuit.gate_count, file);
+    fwrite(current_circuit.wires, sizeof(Wire), current_circuit.wire_count, file);
+    fwrite(current_circuit.input_gates, sizeof(int), current_circuit.input_count, file);
+    fwrite(current_circuit.output_gates, sizeof(int), current_circuit.output_count, file);
+    int failed = ferror(file);
+    if (fclose(file) != 0 || failed) {
+        display_error("Cannot write the circuit file.");
+        return;
+    }
     printf("Circuit saved to %s\n", filename);
 }
 
+// Bytes a circuit holds in its arrays, at the capacity reserved
+static size_t circuit_bytes(const Circuit* circuit) {
+    return (size_t)circuit->gate_capacity * sizeof(Gate) + (size_t)circuit->wire_capacity * sizeof(Wire) +
+           (size_t)(circuit->input_capacity + circuit->output_capacity) * sizeof(int);
+}
+
+// Report what the circuit takes per gate and per wire: the records at the
+// capacity reserved, the gate index, the gate order and the evaluation cache,
+// then the copies kept for undo, so the memory of larger designs can be estimated
+void report_memory() {
+    size_t gate_records = (size_t)current_circuit.gate_capacity * sizeof(Gate) +
+                          (size_t)(current_circuit.input_capacity + current_circuit.output_capacity) * sizeof(int);
+    size_t gate_index = (size_t)gate_slots.id_capacity * sizeof(int) +
+                        (size_t)gate_slots.slot_capacity * (sizeof(int) + sizeof(uint32_t));
+    size_t gate_order = topo_reserved(&wire_order) - topo_edges_reserved(&wire_order) +
+                        (size_t)order_cycle_capacity * sizeof(int);
+    size_t gate_cache = (size_t)eval_stamp_capacity * sizeof(unsigned int) + (size_t)eval_input_capacity * sizeof(int[2]);
+    size_t wire_records = (size_t)current_circuit.wire_capacity * sizeof(Wire);
+    size_t wire_order_bytes = topo_edges_reserved(&wire_order);
+    int gates = current_circuit.gate_count > 0 ? current_circuit.gate_count : 1;
+    int wires = current_circuit.wire_count > 0 ? current_circuit.wire_count : 1;
+
+    size_t history = 0;
+    int actions = 0;
+    for (const Action* action = undo_stack; action; action = action->prev, actions++) {
+        history += sizeof(Action) + circuit_bytes(&action->circuit);
+    }
+    for (const Action* action = redo_stack; action; action = action->next, actions++) {
+        history += sizeof(Action) + circuit_bytes(&action->circuit);
+    }
+
+    printf("\nMemory: %d gates, %d wires\n", current_circuit.gate_count, current_circuit.wire_count);
+    printf("  per gate: %zu bytes (%zu record, %zu index, %zu order, %zu evaluation cache)\n",
+           (gate_records + gate_index + gate_order + gate_cache) / gates, gate_records / gates,
+           gate_index / gates, gate_order / gates, gate_cache / gates);
+    printf("  per wire: %zu bytes (%zu record, %zu order)\n",
+           (wire_records + wire_order_bytes) / wires, wire_records / wires, wire_order_bytes / wires);
+    printf("  undo and redo: %d copies of the circuit, %zu KB\n", actions, history / 1024);
+    printf("  scratch: %zu KB\n", arena_reserved(&scratch) / 1024);
+    AllocationCounters heap = allocation_counters();
+    printf("  heap: %ld arena blocks, %ld array grows, %zu KB\n", heap.arena_blocks, heap.array_grows, heap.bytes / 1024);
+}
+
 // Load circuit from file
 void load_circuit(const char* filename) {
-    FILE* file = fopen(filename, "rb");
-    if (!file) {
+    Circuit loaded = {0};
+    if (read_circuit(filename, &loaded) != 0) {
         display_error("Cannot open file for reading.");
         return;
     }
-    
-    fread(&current_circuit, sizeof(Circuit), 1, file);
-    fclose(file);
+    circuit_free(&current_circuit);
+    current_circuit = loaded;
     
     // Update next IDs
     next_gate_id = 0;
@@ -798,6 +2038,7 @@ void load_circuit(const char* filename) {
             next_wire_id = current_circuit.wires[i].id + 1;
         }
     }
+    rebuild_wire_order();
     
     printf("Circuit loaded from %s\n", filename);
 }
@@ -938,6 +2179,82 @@ int main() {
                 printf("Workspace cleared.\n");
                 break;
                 
+            case 14: {
+                // Fault simulation
+                char filename[100];
+                printf("Enter test vector file (or 'random'): ");
+                scanf("%s", filename);
+                if (strcmp(filename, "random") == 0) {
+                    long long count;
+                    printf("Enter number of random vectors: ");
+                    scanf("%lld", &count);
+                    if (count > 0) {
+                        fault_simulation(NULL, count);
+                    } else {
+                        display_error("Invalid vector count.");
+                    }
+                } else {
+                    fault_simulation(filename, 0);
+                }
+                break;
+            }
+                
+            case 15: {
+                // Equivalence check
+                char file_a[100], file_b[100];
+                int mode;
+                printf("Enter reference circuit file: ");
+                scanf("%s", file_a);
+                printf("Enter circuit file to compare: ");
+                scanf("%s", file_b);
+                printf("Match inputs/outputs by 1=order, 2=label: ");
+                scanf("%d", &mode);
+                equivalence_check(file_a, file_b, mode == 2);
+                break;
+            }
+                
+            case 16:
+                // Output satisfiability
+                output_satisfiability();
+                break;
+                
+            case 17: {
+                // Minimize circuit
+                int replace;
+                printf("Replace the circuit with its minimized form? (1=yes, 0=no): ");
+                scanf("%d", &replace);
+                minimize_circuit(replace == 1);
+                break;
+            }
+                
+            case 18:
+                // Find duplicate logic
+                find_duplicate_logic();
+                break;
+                
+            case 19: {
+                // Rewrite circuit
+                int replace;
+                printf("Replace the circuit with its rewritten form? (1=yes, 0=no): ");
+                scanf("%d", &replace);
+                rewrite_circuit(replace == 1);
+                break;
+            }
+                
+            case 20: {
+                // Map to LUTs
+                int k;
+                printf("Enter LUT size (2-%d): ", LUT_MAX_INPUTS);
+                scanf("%d", &k);
+                map_to_luts(k);
+                break;
+            }
+                
+            case 21:
+                // Memory usage
+                report_memory();
+                break;
+                
             case 0:
                 printf("Exiting...\n");
                 break;
@@ -0,0 +1,279 @@
+#include <stdlib.h>
+#include <string.h>
+#include "equiv.h"
+#include "bdd.h"
+#include "sat.h"
+#include "aig.h"
+
+// Function to advance a xorshift64* generator, good enough for test vectors
+static uint64_t next_random(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+// Function to merge both circuits into one AIG over shared inputs and compile
+// it. Logic the circuits have in common is built once, and outputs that hash to
+// the same literal are proven equal without evaluating anything. Outputs of a
+// are merged outputs 0 .. num_outputs-1, those of b follow.
+static int equiv_merge(const SimProgram* a, const int* a_inputs, const int* a_outputs,
+                       const SimProgram* b, const int* b_inputs, const int* b_outputs,
+                       int num_inputs, int num_outputs, SimNetlist* net, SimProgram* merged,
+                       int* inputs, int* outputs, int* proven) {
+    Aig aig;
+    if (aig_init(&aig) != 0) return -1;
+    int gate_count = a->gate_count > b->gate_count ? a->gate_count : b->gate_count;
+    int* lits = malloc((gate_count + 1) * sizeof(int));
+    int status = -1;
+    if (lits &&
+        aig_from_program(&aig, a, a_inputs, num_inputs, a_outputs, num_outputs, lits) == 0 &&
+        aig_from_program(&aig, b, b_inputs, num_inputs, b_outputs, num_outputs, lits) == 0 &&
+        aig_to_netlist(&aig, net, inputs, outputs) == 0 && sim_compile(merged, net) == 0) {
+        status = 0;
+        *proven = 1;
+        for (int o = 0; o < num_outputs; o++) {
+            if (aig.outputs[o] != aig.outputs[num_outputs + o]) *proven = 0;
+        }
+    }
+    free(lits);
+    aig_free(&aig);
+    return status;
+}
+
+// Function to decide equivalence on the BDDs of the merged circuit, returns -1
+// if they grow too large. A differing output yields its counterexample from the
+// XOR of both BDDs.
+static int equiv_check_bdd(const SimProgram* merged, const int* inputs, const int* outputs,
+                           int num_inputs, int num_outputs, EquivResult* result, unsigned char* counterexample) {
+    BddManager m;
+    if (bdd_init(&m, num_inputs, EQUIV_BDD_MAX_NODES) != 0) return -1;
+    int* out = malloc(2 * num_outputs * sizeof(int));
+    unsigned char* assignment = malloc(num_inputs + 1);
+    int status = -1;
+    if (out && assignment &&
+        bdd_build_outputs(&m, merged, inputs, num_inputs, outputs, 2 * num_outputs, out) == 0) {
+        status = 0;
+        result->exhaustive = 1;
+        result->symbolic = 1;
+        result->method = EQUIV_BY_BDD;
+        for (int o = 0; o < num_outputs && result->equivalent; o++) {
+            int out_a = out[o], out_b = out[num_outputs + o];
+            if (out_a == out_b) continue;
+            int diff = bdd_apply(&m, SIM_XOR, out_a, out_b);
+            if (diff == BDD_ERROR || !bdd_pick_sat(&m, diff, assignment)) {
+                status = -1;
+                break;
+            }
+            result->equivalent = 0;
+            result->output = o;
+            result->value_a = bdd_eval(&m, out_a, assignment);
+            result->value_b = bdd_eval(&m, out_b, assignment);
+            if (counterexample) memcpy(counterexample, assignment, num_inputs);
+        }
+    }
+    free(out);
+    free(assignment);
+    bdd_free(&m);
+    return status;
+}
+
+// Function to decide equivalence with a miter on the merged circuit: each output
+// pair is asked "can these differ?" as an assumption on its XOR, so learnt
+// clauses carry over from one output to the next.
+// Returns -1 if the conflict budget runs out.
+static int equiv_check_sat(const SimProgram* merged, const int* inputs, const int* outputs,
+                           int num_inputs, int num_outputs, EquivResult* result, unsigned char* counterexample) {
+    SatSolver solver;
+    sat_init(&solver);
+    int* vars = malloc((merged->gate_count + 1) * sizeof(int));
+    int status = -1;
+    if (vars && sat_encode_program(&solver, merged, inputs, NULL, num_inputs, vars) == 0) status = 0;
+
+    long long budget = EQUIV_SAT_MAX_CONFLICTS;
+    for (int o = 0; o < num_outputs && status == 0 && result->equivalent; o++) {
+        int var_a = vars[outputs[o]], var_b = vars[outputs[num_outputs + o]];
+        int diff = sat_encode_xor(&solver, var_a, var_b);
+        int assumption = SAT_LIT(diff, 0);
+        long long before = solver.conflicts;
+        int answer = diff < 0 ? SAT_UNKNOWN : sat_solve(&solver, &assumption, 1, budget);
+        budget -= solver.conflicts - before;
+        if (answer == SAT_UNKNOWN || budget <= 0) {
+            status = -1;
+        } else if (answer == SAT_SAT) {
+            result->equivalent = 0;
+            result->output = o;
+            result->value_a = sat_model_value(&solver, var_a);
+            result->value_b = sat_model_value(&solver, var_b);
+            for (int i = 0; counterexample && i < num_inputs; i++) {
+                counterexample[i] = (unsigned char)sat_model_value(&solver, vars[inputs[i]]);
+            }
+        }
+    }
+    if (status == 0) {
+        result->exhaustive = 1;
+        result->symbolic = 1;
+        result->method = EQUIV_BY_SAT;
+    }
+
+    free(vars);
+    sat_free(&solver);
+    return status;
+}
+
+// Function to compare both circuits block by block on total vectors, counting
+// or random. Both scratch buffers are allocated once up front, each block only
+// rewrites the input words in place.
+static int equiv_check_vectors(const SimProgram* a, const int* a_inputs, const int* a_outputs,
+                               const SimProgram* b, const int* b_inputs, const int* b_outputs,
+                               int num_inputs, int num_outputs, long long total, uint64_t seed,
+                               EquivResult* result, unsigned char* counterexample) {
+    memset(result, 0, sizeof(EquivResult));
+    result->equivalent = 1;
+    result->output = -1;
+    result->exhaustive = num_inputs <= EQUIV_EXHAUSTIVE_MAX_INPUTS;
+
+    uint64_t* va = malloc((size_t)(a->gate_count + 1) * BITSIM_BLOCK_WORDS * sizeof(uint64_t));
+    uint64_t* vb = malloc((size_t)(b->gate_count + 1) * BITSIM_BLOCK_WORDS * sizeof(uint64_t));
+    if (!va || !vb) {
+        free(va);
+        free(vb);
+        return -1;
+    }
+
+    long long total_words = (total + 63) / 64;
+
+    for (long long first = 0; first < total_words && result->equivalent; first += BITSIM_BLOCK_WORDS) {
+        int block_words = total_words - first < BITSIM_BLOCK_WORDS ? (int)(total_words - first) : BITSIM_BLOCK_WORDS;
+        for (int i = 0; i < num_inputs; i++) {
+            uint64_t* in_a = va + (size_t)a_inputs[i] * block_words;
+            uint64_t* in_b = vb + (size_t)b_inputs[i] * block_words;
+            for (int w = 0; w < block_words; w++) {
+                in_a[w] = result->exhaustive ? bitsim_input_pattern(i, num_inputs, first + w) : next_random(&seed);
+                in_b[w] = in_a[w];
+            }
+        }
+        bitsim_run_wide(a, va, block_words);
+        bitsim_run_wide(b, vb, block_words);
+
+        for (int w = 0; w < block_words && result->equivalent; w++) {
+            long long left = total - (first + w) * 64;
+            uint64_t valid = left >= 64 ? ~0ULL : ((1ULL << left) - 1);
+            uint64_t diff = 0;
+            for (int o = 0; o < num_outputs; o++) {
+                diff |= va[(size_t)a_outputs[o] * block_words + w] ^ vb[(size_t)b_outputs[o] * block_words + w];
+            }
+            diff &= valid;
+            if (!diff) continue;
+
+            // Recover the earliest failing vector from the input words of this block
+            int bit = __builtin_ctzll(diff);
+            result->equivalent = 0;
+            result->vectors_checked = (first + w) * 64 + bit + 1;
+            for (int o = 0; o < num_outputs && result->output < 0; o++) {
+                int out_a = (int)((va[(size_t)a_outputs[o] * block_words + w] >> bit) & 1);
+                int out_b = (int)((vb[(size_t)b_outputs[o] * block_words + w] >> bit) & 1);
+                if (out_a != out_b) {
+                    result->output = o;
+                    result->value_a = out_a;
+                    result->value_b = out_b;
+                }
+            }
+            for (int i = 0; counterexample && i < num_inputs; i++) {
+                counterexample[i] = (unsigned char)((va[(size_t)a_inputs[i] * block_words + w] >> bit) & 1);
+            }
+        }
+    }
+    if (result->equivalent) result->vectors_checked = total;
+
+    free(va);
+    free(vb);
+    return 0;
+}
+
+// Function to compare circuits too wide to enumerate: a random screen first,
+// then a BDD and a SAT proof on the merged circuit, random vectors last
+static int equiv_check_wide(const SimProgram* a, const int* a_inputs, const int* a_outputs,
+                            const SimProgram* b, const int* b_inputs, const int* b_outputs,
+                            const SimProgram* merged, const int* inputs, const int* outputs,
+                            int num_inputs, int num_outputs, long long random_vectors,
+                            EquivResult* result, unsigned char* counterexample) {
+    // Most differences show up on a few random vectors, long before a proof would
+    if (equiv_check_vectors(a, a_inputs, a_outputs, b, b_inputs, b_outputs, num_inputs,
+                            num_outputs, EQUIV_SCREEN_VECTORS, 0x2545F4914F6CDD1DULL,
+                            result, counterexample) != 0) {
+        return -1;
+    }
+    if (!result->equivalent) return 0;
+
+    memset(result, 0, sizeof(EquivResult));
+    result->equivalent = 1;
+    result->output = -1;
+    if (equiv_check_bdd(merged, inputs, outputs, num_inputs, num_outputs, result, counterexample) == 0) {
+        return 0;
+    }
+    memset(result, 0, sizeof(EquivResult));
+    result->equivalent = 1;
+    result->output = -1;
+    if (equiv_check_sat(merged, inputs, outputs, num_inputs, num_outputs, result, counterexample) == 0) {
+        return 0;
+    }
+    return equiv_check_vectors(a, a_inputs, a_outputs, b, b_inputs, b_outputs, num_inputs,
+                               num_outputs, random_vectors, 0x9E3779B97F4A7C15ULL,
+                               result, counterexample);
+}
+
+// Function to compare both circuits, cheapest method first
+int equiv_check(const SimProgram* a, const int* a_inputs, const int* a_outputs,
+                const SimProgram* b, const int* b_inputs, const int* b_outputs,
+                int num_inputs, int num_outputs, long long random_vectors,
+                EquivResult* result, unsigned char* counterexample) {
+    memset(result, 0, sizeof(EquivResult));
+    result->equivalent = 1;
+    result->output = -1;
+    if (a->cyclic || b->cyclic) return -1;
+
+    SimNetlist net = {0};
+    SimProgram merged = {0};
+    int* inputs = malloc((num_inputs + 1) * sizeof(int));
+    int* outputs = malloc((2 * num_outputs + 1) * sizeof(int));
+    int proven = 0;
+    int status;
+    // The merge is only a shortcut: when it fails (out of memory, AIG too large)
+    // the circuits are still compared on vectors
+    int merged_ok = inputs && outputs &&
+                    equiv_merge(a, a_inputs, a_outputs, b, b_inputs, b_outputs, num_inputs, num_outputs,
+                                &net, &merged, inputs, outputs, &proven) == 0;
+    if (merged_ok && proven) {
+        result->exhaustive = 1;
+        result->symbolic = 1;
+        result->method = EQUIV_BY_STRUCTURE;
+        status = 0;
+    } else if (num_inputs <= EQUIV_EXHAUSTIVE_MAX_INPUTS) {
+        status = equiv_check_vectors(a, a_inputs, a_outputs, b, b_inputs, b_outputs, num_inputs,
+                                     num_outputs, 1LL << num_inputs, 0, result, counterexample);
+    } else if (merged_ok) {
+        status = equiv_check_wide(a, a_inputs, a_outputs, b, b_inputs, b_outputs, &merged, inputs,
+                                  outputs, num_inputs, num_outputs, random_vectors, result, counterexample);
+    } else {
+        status = equiv_check_vectors(a, a_inputs, a_outputs, b, b_inputs, b_outputs, num_inputs,
+                                     num_outputs, random_vectors, 0x9E3779B97F4A7C15ULL,
+                                     result, counterexample);
+    }
+    free(inputs);
+    free(outputs);
+    sim_free_program(&merged);
+    sim_netlist_free(&net);
+    return status;
+}
+
+const char* equiv_method_name(int method) {
+    switch (method) {
+        case EQUIV_BY_STRUCTURE: return "structural hashing";
+        case EQUIV_BY_BDD:       return "BDDs";
+        case EQUIV_BY_SAT:       return "SAT";
+        default:                 return "test vectors";
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef EQUIV_H
+#define EQUIV_H
+
+#include <stdint.h>
+#include "bitsim.h"
+
+// Circuits with up to this many inputs are compared on every input combination
+#define EQUIV_EXHAUSTIVE_MAX_INPUTS TRUTH_TABLE_MAX_INPUTS
+
+// Default vector count for random comparison of wider circuits
+#define EQUIV_RANDOM_VECTORS (1LL << 22)
+
+// Random vectors tried on wide circuits before attempting a proof
+#define EQUIV_SCREEN_VECTORS (1LL << 16)
+
+// Node limit for the BDD proof, and conflict limit for the SAT proof tried
+// when the BDDs grow too large, before falling back to random vectors
+#define EQUIV_BDD_MAX_NODES (1 << 21)
+#define EQUIV_SAT_MAX_CONFLICTS 200000
+
+// What decided an EquivResult
+#define EQUIV_BY_VECTORS 0
+#define EQUIV_BY_STRUCTURE 1    // both circuits hash to the same AIG outputs
+#define EQUIV_BY_BDD 2
+#define EQUIV_BY_SAT 3
+
+typedef struct {
+    int equivalent;             // 1 if no vector told the circuits apart
+    int exhaustive;             // 1 if every input combination was checked
+    int symbolic;               // 1 if decided without vectors
+    int method;                 // EQUIV_BY_*
+    long long vectors_checked;
+    int output;                 // first differing output, -1 if equivalent
+    int value_a;                // its value in each circuit for the counterexample
+    int value_b;
+} EquivResult;
+
+// Compare two compiled circuits whose ports are already matched: input i of a
+// drives the same signal as input i of b, output o of a must equal output o of b.
+// Compares 512 vectors per pass and stops at the first counterexample, whose input
+// values are written to counterexample (num_inputs entries, may be NULL).
+// Both circuits are first merged into one AIG; if every output pair hashes to the
+// same literal they are equivalent without any evaluation. If the merge fails,
+// the vector stages below still run, without the BDD and SAT proofs.
+// Beyond EQUIV_EXHAUSTIVE_MAX_INPUTS inputs EQUIV_SCREEN_VECTORS random vectors
+// are tried next. If they agree, the merged circuit is built as BDDs, where equal
+// functions have equal nodes. If that exceeds EQUIV_BDD_MAX_NODES, a SAT miter
+// (outputs XORed pairwise) is solved next, and only if that runs out of conflicts
+// are random_vectors random vectors compared.
+// Returns 0 when the comparison ran, -1 for cyclic circuits or out of memory.
+int equiv_check(const SimProgram* a, const int* a_inputs, const int* a_outputs,
+                const SimProgram* b, const int* b_inputs, const int* b_outputs,
+                int num_inputs, int num_outputs, long long random_vectors,
+                EquivResult* result, unsigned char* counterexample);
+
+// Name of an EQUIV_BY_* method for messages, e.g. "proven by SAT"
+const char* equiv_method_name(int method);
+
+#endif
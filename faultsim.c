@@ -0,0 +1,170 @@
+#include <stdlib.h>
+#include <string.h>
+#include "faultsim.h"
+#include "bitsim.h"
+
+// Function to list both stuck-at faults of every gate output and connected or
+// floating input pin, in gate order
+int faultsim_enumerate(const SimNetlist* net, const SimProgram* prog, FaultList* list) {
+    memset(list, 0, sizeof(FaultList));
+    int n = net->gate_count;
+    int* pins = calloc(n + 1, sizeof(int));
+    if (!pins) return -1;
+    for (int i = 0; i < prog->instr_count; i++) {
+        int op = prog->code[i].op;
+        pins[prog->code[i].out] = (op == SIM_NOT || op == SIM_OUTPUT) ? 1 : 2;
+    }
+
+    int capacity = 0;
+    for (int g = 0; g < n; g++) {
+        if (net->types[g] != SIM_UNUSED) capacity += 2 * (1 + pins[g]);
+    }
+    list->faults = malloc((capacity + 1) * sizeof(Fault));
+    if (!list->faults) {
+        free(pins);
+        return -1;
+    }
+    for (int g = 0; g < n; g++) {
+        if (net->types[g] == SIM_UNUSED) continue;
+        for (int pin = FAULT_OUTPUT; pin < pins[g]; pin++) {
+            for (int v = 0; v <= 1; v++) {
+                Fault* f = &list->faults[list->count++];
+                f->gate = g;
+                f->pin = pin;
+                f->stuck_at = v;
+                f->detected_by = -1;
+            }
+        }
+    }
+    free(pins);
+    return 0;
+}
+
+// Scratch state shared by every fault of a faultsim_run call
+typedef struct {
+    const SimProgram* prog;
+    int* position;          // instruction index of every gate, -1 for sources
+    int* last_reader;       // last instruction reading a gate, -1 if none
+    const uint64_t* good;   // fault-free values of the current 64 vectors
+    uint64_t* faulty;       // equal to good between faults
+    int* touched;           // gates whose faulty value differs from good
+} FaultSim;
+
+// Function to simulate one fault on top of the fault-free values, returns the
+// mask of vectors whose outputs differ. Only gates reading a differing value are
+// re-evaluated, and the scan stops after the last reader of any differing gate.
+static uint64_t simulate_fault(FaultSim* fs, const Fault* f, const int* output_gates, int num_outputs) {
+    const SimProgram* prog = fs->prog;
+    const uint64_t* good = fs->good;
+    uint64_t* faulty = fs->faulty;
+    uint64_t stuck = f->stuck_at ? ~0ULL : 0;
+    int touched = 0;
+
+    uint64_t value = stuck;
+    if (f->pin != FAULT_OUTPUT) {
+        // The faulty pin only affects its own gate, evaluate it once
+        const SimInstr* ins = &prog->code[fs->position[f->gate]];
+        uint64_t a = f->pin == 0 ? stuck : good[ins->in0];
+        uint64_t b = f->pin == 1 ? stuck : good[ins->in1];
+        value = bitsim_eval_word(ins->op, a, b);
+    }
+    if (value == good[f->gate]) return 0;  // not excited by any vector
+    faulty[f->gate] = value;
+    fs->touched[touched++] = f->gate;
+
+    int horizon = fs->last_reader[f->gate];
+    for (int i = fs->position[f->gate] + 1; i <= horizon; i++) {
+        const SimInstr* ins = &prog->code[i];
+        if (faulty[ins->in0] == good[ins->in0] && faulty[ins->in1] == good[ins->in1]) continue;
+        uint64_t r = bitsim_eval_word(ins->op, faulty[ins->in0], faulty[ins->in1]);
+        if (r == good[ins->out]) continue;
+        faulty[ins->out] = r;
+        fs->touched[touched++] = ins->out;
+        if (fs->last_reader[ins->out] > horizon) horizon = fs->last_reader[ins->out];
+    }
+
+    uint64_t diff = 0;
+    for (int o = 0; o < num_outputs; o++) {
+        diff |= faulty[output_gates[o]] ^ good[output_gates[o]];
+    }
+    while (touched > 0) {
+        int g = fs->touched[--touched];
+        faulty[g] = good[g];
+    }
+    return diff;
+}
+
+// Function to grade a vector set: fault-free simulation once per 64 vectors,
+// then every still-undetected fault against the same 64 vectors
+int faultsim_run(const SimProgram* prog, const int* input_gates, int num_inputs,
+                 const int* output_gates, int num_outputs,
+                 const uint64_t* vectors, long long num_vectors, FaultList* list) {
+    if (prog->cyclic) return -1;
+    int n = prog->gate_count;
+    long long words = (num_vectors + 63) / 64;
+    uint64_t* good = malloc((n + 1) * sizeof(uint64_t));
+    FaultSim fs;
+    fs.prog = prog;
+    fs.good = good;
+    fs.faulty = malloc((n + 1) * sizeof(uint64_t));
+    fs.position = malloc((n + 1) * sizeof(int));
+    fs.last_reader = malloc((n + 1) * sizeof(int));
+    fs.touched = malloc((n + 1) * sizeof(int));
+    if (!good || !fs.faulty || !fs.position || !fs.last_reader || !fs.touched) {
+        free(good);
+        free(fs.faulty);
+        free(fs.position);
+        free(fs.last_reader);
+        free(fs.touched);
+        return -1;
+    }
+
+    for (int g = 0; g <= n; g++) {
+        fs.position[g] = -1;
+        fs.last_reader[g] = -1;
+    }
+    for (int i = 0; i < prog->instr_count; i++) {
+        const SimInstr* ins = &prog->code[i];
+        fs.position[ins->out] = i;
+        fs.last_reader[ins->in0] = i;
+        fs.last_reader[ins->in1] = i;
+    }
+
+    for (long long w = 0; w < words && list->detected < list->count; w++) {
+        long long left = num_vectors - w * 64;
+        uint64_t valid = left >= 64 ? ~0ULL : ((1ULL << left) - 1);
+
+        memset(good, 0, (n + 1) * sizeof(uint64_t));
+        for (int i = 0; i < num_inputs; i++) {
+            good[input_gates[i]] = vectors[i * words + w];
+        }
+        bitsim_run(prog, good);
+        memcpy(fs.faulty, good, (n + 1) * sizeof(uint64_t));
+
+        for (int k = 0; k < list->count; k++) {
+            Fault* f = &list->faults[k];
+            if (f->detected_by >= 0) continue;
+            uint64_t diff = simulate_fault(&fs, f, output_gates, num_outputs) & valid;
+            if (diff) {
+                f->detected_by = w * 64 + __builtin_ctzll(diff);
+                list->detected++;
+            }
+        }
+    }
+
+    free(good);
+    free(fs.faulty);
+    free(fs.position);
+    free(fs.last_reader);
+    free(fs.touched);
+    return 0;
+}
+
+double faultsim_coverage(const FaultList* list) {
+    return list->count ? 100.0 * list->detected / list->count : 100.0;
+}
+
+void fault_list_free(FaultList* list) {
+    free(list->faults);
+    memset(list, 0, sizeof(FaultList));
+}
@@ -0,0 +1,40 @@
+#ifndef FAULTSIM_H
+#define FAULTSIM_H
+
+#include <stdint.h>
+#include "simulator.h"
+
+// Pin value of a fault on the gate's output rather than one of its inputs
+#define FAULT_OUTPUT -1
+
+// Single stuck-at fault: gate output or input pin permanently at stuck_at
+typedef struct {
+    int gate;
+    int pin;                    // FAULT_OUTPUT or input pin index
+    int stuck_at;               // 0 or 1
+    long long detected_by;      // first vector that detects it, -1 if undetected
+} Fault;
+
+typedef struct {
+    Fault* faults;
+    int count;
+    int detected;
+} FaultList;
+
+// Enumerate stuck-at-0 and stuck-at-1 on every gate output and every input pin
+int faultsim_enumerate(const SimNetlist* net, const SimProgram* prog, FaultList* list);
+
+// Apply num_vectors test vectors to the circuit and mark the faults they detect.
+// Input i of vector v is bit (v % 64) of vectors[i * ((num_vectors + 63) / 64) + v / 64].
+// Faults are simulated one at a time against 64 vectors per word; detected faults
+// are dropped, so later words only simulate what is still undetected.
+// Can be called again with another vector set to accumulate coverage.
+int faultsim_run(const SimProgram* prog, const int* input_gates, int num_inputs,
+                 const int* output_gates, int num_outputs,
+                 const uint64_t* vectors, long long num_vectors, FaultList* list);
+
+// Detected faults as a percentage of all faults
+double faultsim_coverage(const FaultList* list);
+void fault_list_free(FaultList* list);
+
+#endif
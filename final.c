@@ -1,3 +1,5 @@
+// Build: gcc final.c truth_table.c logicgates.c arena.c handle.c netindex.c topo.c simulator.c bitsim.c ttpool.c codegen.c equiv.c bdd.c sat.c minimize.c aig.c rewrite.c simopt.c -o sim $(pkg-config --cflags --libs sdl3) -lm -lpthread -ldl
+
 #include <SDL3/SDL.h>
 #include <stdio.h>
 #include <stdbool.h>
@@ -6,6 +8,12 @@
 #include "logicgates.h"
 #include <stdlib.h>
 #include "truth_table.h"
+#include "simulator.h"
+#include "simopt.h"
+#include "arena.h"
+#include "handle.h"
+#include "netindex.h"
+#include "topo.h"
 
 // Fullscreen dimensions
 #define WINDOW_WIDTH 1400
@@ -16,12 +24,11 @@
 #define PIN_LENGTH 20
 #define PIN_RADIUS 8
 #define PALETTE_WIDTH 200
-#define MAX_GATES 50
-#define MAX_WIRES 100
 #define BUTTON_WIDTH 180
 #define BUTTON_HEIGHT 40
 #define BUTTON_X (WINDOW_WIDTH - BUTTON_WIDTH - 20)  // 20px from right edge
 #define BUTTON_Y 20
+#define MAX_SETTLE_DELTAS 100  // delta cycles a feedback loop gets to settle or repeat a state
 
 typedef struct {
     const char* name;
@@ -36,7 +43,7 @@ typedef struct {
     int drag_offset_y;
     bool in_palette;
     int id;
-    int* input_values;
+    int input_values[SIM_MAX_PINS];     // kept in the record, no gate has more pins
     int output_value;
     int gate_type;
 } LogicGate;
@@ -49,6 +56,24 @@ typedef struct {
     SDL_Color color;
 } Wire;
 
+// Slot in the gates array of every workspace gate, by id
+static HandleTable gate_slots;
+
+// Slot by id of the gates a netlist is built from, indexed again for every
+// build: build_sim_netlist is also given circuits other than the workspace,
+// such as the other side of an equivalence check, whose ids gate_slots does not know
+static HandleTable netlist_slots;
+
+// Function to index the ids of the gates passed in, returns -1 when out of memory
+static int index_gate_ids(const LogicGate* gates, int gate_count) {
+    handle_clear(&netlist_slots);
+    for (int i = 0; i < gate_count; i++) {
+        if (gates[i].in_palette || gates[i].id < 0) continue;
+        if (handle_bind(&netlist_slots, gates[i].id, i) != 0) return -1;
+    }
+    return 0;
+}
+
 void draw_text(SDL_Renderer* renderer, const char* text, float x, float y, SDL_Color color) {
     SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
     
@@ -217,11 +242,12 @@ void draw_pins(SDL_Renderer* renderer, LogicGate gate) {
     }
 }
 
-void draw_logic_gate(SDL_Renderer* renderer, LogicGate gate) {
+// Function to draw a gate showing value, the value the simulation gave it
+void draw_logic_gate(SDL_Renderer* renderer, LogicGate gate, int value) {
     SDL_Color draw_color = gate.is_selected ? gate.selected_color : gate.color;
     
     if (!gate.in_palette && (gate.gate_type == 6 || gate.gate_type == 7)) {
-        if (gate.output_value == 1) {
+        if (value == 1) {
             draw_color = (SDL_Color){0, 200, 0, 255};
         } else {
             draw_color = (SDL_Color){200, 0, 0, 255};
@@ -254,7 +280,7 @@ void draw_logic_gate(SDL_Renderer* renderer, LogicGate gate) {
     
     if (!gate.in_palette && (gate.gate_type == 6 || gate.gate_type == 7)) {
         char value_str[2];
-        sprintf(value_str, "%d", gate.output_value);
+        sprintf(value_str, "%d", value);
         SDL_Color value_color = {255, 255, 255, 255};
         draw_text(renderer, value_str, gate.rect.x + 10, gate.rect.y + 10, value_color);
     }
@@ -264,14 +290,10 @@ void draw_wires(SDL_Renderer* renderer, Wire* wires, int wire_count, LogicGate*
     for (int i = 0; i < wire_count; i++) {
         Wire wire = wires[i];
         
-        LogicGate* from_gate = NULL;
-        LogicGate* to_gate = NULL;
-        
-        for (int j = 0; j < gate_count; j++) {
-            if (gates[j].id == wire.from_gate_id) from_gate = &gates[j];
-            if (gates[j].id == wire.to_gate_id) to_gate = &gates[j];
-            if (from_gate && to_gate) break;
-        }
+        int from = handle_slot(&gate_slots, wire.from_gate_id);
+        int to = handle_slot(&gate_slots, wire.to_gate_id);
+        LogicGate* from_gate = from >= 0 && from < gate_count ? &gates[from] : NULL;
+        LogicGate* to_gate = to >= 0 && to < gate_count ? &gates[to] : NULL;
         
         if (from_gate && to_gate) {
             float from_x, from_y, to_x, to_y;
@@ -332,20 +354,129 @@ void compute_gate_output(LogicGate* gate) {
     }
 }
 
-void propagate_signals(void* gates_ptr, int gate_count, void* wires_ptr, int wire_count) {
-    LogicGate* gates = (LogicGate*)gates_ptr;
-    Wire* wires = (Wire*)wires_ptr;
-    
-    // Reset all gate values (except INPUT gates)
+// Simulation store of the fallback propagation: the few bytes per gate that a
+// sweep reads and writes, kept apart from the editor's LogicGate records so a
+// sweep streams a byte per gate instead of whole records. Types and the fan-in
+// by pin are rebuilt when the topology version they were built for is out of
+// date; values are loaded from the gates and written back once per call.
+typedef struct {
+    int count;
+    int capacity;
+    signed char* types;     // SIM_ gate type, SIM_UNUSED for gates never evaluated
+    unsigned char* values;  // output of every gate, 0 or 1
+} GateStore;
+
+static GateStore gate_store;
+static NetIndex wire_index;
+
+// Value of every gate as the editor draws it, a byte per gate. The event-driven
+// engine writes here rather than into the LogicGate records, and rendering
+// reads it, so keeping the screen up to date streams a byte per gate.
+static unsigned char* shown_values = NULL;
+static int shown_count = 0;
+static int shown_capacity = 0;
+static int indexed_version = -1;
+static int indexed_wire_count = -1;
+static const void* indexed_wires = NULL;
+
+// Function to size the store for gate_count gates, keeping nothing
+static int reserve_gate_store(GateStore* store, int gate_count) {
+    if (gate_count > store->capacity) {
+        int capacity = store->capacity < 64 ? 64 : store->capacity * 2;
+        if (capacity < gate_count) capacity = gate_count;
+        free(store->types);
+        free(store->values);
+        store->types = malloc(capacity * sizeof(signed char));
+        store->values = malloc(capacity * sizeof(unsigned char));
+        if (!store->types || !store->values) {
+            free(store->types);
+            free(store->values);
+            *store = (GateStore){0};
+            return -1;
+        }
+        store->capacity = capacity;
+    }
+    store->count = gate_count;
+    return 0;
+}
+
+// Function to size the shown values for gate_count gates, new gates show 0
+static int reserve_shown_values(int gate_count) {
+    if (array_reserve((void**)&shown_values, &shown_capacity, gate_count, sizeof(unsigned char)) != 0) return -1;
+    if (gate_count > shown_count) memset(shown_values + shown_count, 0, gate_count - shown_count);
+    shown_count = gate_count;
+    return 0;
+}
+
+// Function to rebuild the store's gate types and the fan-in index from the
+// editor's gates and wires. Wires to a pin the gate does not have are left out.
+static int build_gate_store(LogicGate* gates, int gate_count, Wire* wires, int wire_count) {
+    if (reserve_gate_store(&gate_store, gate_count) != 0) return -1;
     for (int i = 0; i < gate_count; i++) {
-        if (!gates[i].in_palette && gates[i].gate_type != 6) { // Not palette and not INPUT
-            gates[i].output_value = 0;
-            if (gates[i].input_values) {
-                for (int j = 0; j < gates[i].inputs; j++) {
-                    gates[i].input_values[j] = 0;
-                }
-            }
+        int type = gates[i].in_palette ? SIM_UNUSED : gates[i].gate_type;
+        int needed = type == SIM_INPUT ? 0 : (type == SIM_NOT || type == SIM_OUTPUT) ? 1 : 2;
+        // compute_gate_output leaves a gate short of pins at its reset value
+        if (type < SIM_AND || type > SIM_OUTPUT || gates[i].inputs < needed) {
+            type = SIM_UNUSED;
         }
+        gate_store.types[i] = (signed char)type;
+    }
+
+    int* from = malloc((wire_count + 1) * sizeof(int));
+    int* to = malloc((wire_count + 1) * sizeof(int));
+    int* pin = malloc((wire_count + 1) * sizeof(int));
+    int built = from && to && pin && index_gate_ids(gates, gate_count) == 0;
+    for (int w = 0; built && w < wire_count; w++) {
+        from[w] = handle_slot(&netlist_slots, wires[w].from_gate_id);
+        to[w] = handle_slot(&netlist_slots, wires[w].to_gate_id);
+        pin[w] = wires[w].to_pin_index;
+        if (to[w] >= 0 && to[w] < gate_count &&
+            (pin[w] >= gates[to[w]].inputs || pin[w] >= SIM_MAX_PINS)) {
+            pin[w] = -1;
+        }
+    }
+    built = built && netindex_build(&wire_index, gate_count, from, to, pin, wire_count) == 0;
+    free(from);
+    free(to);
+    free(pin);
+    return built ? 0 : -1;
+}
+
+// Function to evaluate one gate of the store from the values on its pins
+static unsigned char store_gate_output(int type, int in0, int in1) {
+    switch (type) {
+        case SIM_AND: return (unsigned char)AND(in0, in1);
+        case SIM_OR: return (unsigned char)OR(in0, in1);
+        case SIM_NOT: return (unsigned char)NOT(in0);
+        case SIM_NAND: return (unsigned char)NAND(in0, in1);
+        case SIM_NOR: return (unsigned char)NOR(in0, in1);
+        case SIM_XOR: return (unsigned char)XOR(in0, in1);
+        case SIM_OUTPUT: return (unsigned char)in0;
+        default: return 0;
+    }
+}
+
+// Fixed-point propagation over the editor's wires, the fallback when the
+// circuit cannot be compiled. Each sweep reads every gate's own inputs from
+// wire_index, in pin order, and recomputes the gate in gate_store.
+static void propagate_signals_iterative(LogicGate* gates, int gate_count, Wire* wires, int wire_count, int version) {
+    if (indexed_version != version || gate_store.count != gate_count ||
+        indexed_wire_count != wire_count || indexed_wires != wires) {
+        if (build_gate_store(gates, gate_count, wires, wire_count) != 0) {
+            indexed_version = -1;
+            printf("Warning: not enough memory to propagate signals\n");
+            return;
+        }
+        indexed_version = version;
+        indexed_wire_count = wire_count;
+        indexed_wires = wires;
+    }
+    
+    // Every gate but the INPUT gates starts from 0
+    const signed char* types = gate_store.types;
+    unsigned char* values = gate_store.values;
+    for (int i = 0; i < gate_count; i++) {
+        values[i] = types[i] == SIM_INPUT ? (unsigned char)(gates[i].output_value != 0) : 0;
     }
     
     bool changed;
@@ -356,38 +487,17 @@ void propagate_signals(void* gates_ptr, int gate_count, void* wires_ptr, int wir
         changed = false;
         iterations++;
         
-        // Propagate signals through wires
-        for (int w = 0; w < wire_count; w++) {
-            Wire wire = wires[w];
-            
-            LogicGate* from_gate = NULL;
-            LogicGate* to_gate = NULL;
-            for (int i = 0; i < gate_count; i++) {
-                if (gates[i].id == wire.from_gate_id) from_gate = &gates[i];
-                if (gates[i].id == wire.to_gate_id) to_gate = &gates[i];
-                if (from_gate && to_gate) break;
-            }
-            
-            if (from_gate && to_gate && to_gate->input_values && 
-                wire.to_pin_index < to_gate->inputs) {
-                
-                int old_value = to_gate->input_values[wire.to_pin_index];
-                to_gate->input_values[wire.to_pin_index] = from_gate->output_value;
-                
-                if (old_value != to_gate->input_values[wire.to_pin_index]) {
-                    changed = true;
-                }
-            }
-        }
-        
-        // Compute gate outputs
+        // Later wires win when several drive the same pin
         for (int i = 0; i < gate_count; i++) {
-            if (!gates[i].in_palette) {
-                int old_output = gates[i].output_value;
-                compute_gate_output(&gates[i]);
-                if (old_output != gates[i].output_value) {
-                    changed = true;
-                }
+            if (types[i] == SIM_UNUSED || types[i] == SIM_INPUT) continue;
+            int in[SIM_MAX_PINS] = {0};
+            for (int k = wire_index.fanin_start[i]; k < wire_index.fanin_start[i + 1]; k++) {
+                in[wire_index.fanin_pin[k]] = values[wire_index.fanin[k]];
+            }
+            unsigned char output = store_gate_output(types[i], in[0], in[1]);
+            if (output != values[i]) {
+                values[i] = output;
+                changed = true;
             }
         }
         
@@ -396,6 +506,332 @@ void propagate_signals(void* gates_ptr, int gate_count, void* wires_ptr, int wir
     if (iterations >= max_iterations) {
         printf("Warning: Signal propagation reached maximum iterations\n");
     }
+
+    // Write the outputs and the values on every input pin back to the editor
+    for (int i = 0; i < gate_count; i++) {
+        if (gates[i].in_palette || types[i] == SIM_INPUT) continue;
+        gates[i].output_value = values[i];
+        for (int j = 0; j < gates[i].inputs && j < SIM_MAX_PINS; j++) {
+            gates[i].input_values[j] = 0;
+        }
+        for (int k = wire_index.fanin_start[i]; k < wire_index.fanin_start[i + 1]; k++) {
+            gates[i].input_values[wire_index.fanin_pin[k]] = values[wire_index.fanin[k]];
+        }
+    }
+}
+
+// Compiled evaluation program, rebuilt only when the circuit topology changes.
+// The program runs on the optimized netlist, sim_netlist keeps the editor's wiring.
+static SimNetlist sim_netlist;
+static SimOptimized sim_optimized;
+static SimProgram sim_program;
+static unsigned char* sim_values = NULL;
+static unsigned char* sim_oscillating = NULL;   // per gate, set by sim_run_loops
+static int topology_version = 0;
+static int compiled_version = -1;
+static int compiled_gate_count = -1;
+static int compiled_wire_count = -1;
+static const void* compiled_wires = NULL;
+static int reported_version = -1;
+
+// Function to print the gates of every feedback loop of a compiled program,
+// once per topology change
+static void report_feedback(const SimProgram* prog, const LogicGate* gates) {
+    for (int l = 0; l < prog->loop_count; l++) {
+        printf("Feedback loop %d of %d: gates", l + 1, prog->loop_count);
+        for (int i = prog->loop_begin[l]; i < prog->loop_end[l]; i++) {
+            printf(" %d", gates[prog->code[i].out].id);
+        }
+        printf("\n");
+    }
+}
+
+// Function to print the gates found toggling in a feedback loop that never settles
+static void report_oscillation(const LogicGate* gates, int gate_count, const unsigned char* oscillating) {
+    int found = 0;
+    for (int i = 0; i < gate_count; i++) {
+        if (!oscillating[i]) continue;
+        if (!found++) printf("Warning: feedback loop oscillates or races through gates");
+        printf(" %d", gates[i].id);
+    }
+    if (found) printf("\n");
+}
+
+// Topological order of the workspace gates by id, extended wire by wire
+static TopoOrder wire_order;
+
+// Path of the feedback loop a new wire closes
+static int* order_cycle = NULL;
+static int order_cycle_capacity = 0;
+
+// Function to add a new wire to the gate order. A wire that closes a feedback
+// loop is flagged with the loop it closes; it is kept, loops are simulated.
+static void order_new_wire(const Wire* wire) {
+    int size = wire->from_gate_id > wire->to_gate_id ? wire->from_gate_id + 1 : wire->to_gate_id + 1;
+    int length = 0;
+    // A path visits every gate at most once. The buffer is kept between wires,
+    // clearing one as large as the circuit for every wire would cost more than the wire
+    if (topo_reserve(&wire_order, size) != 0 ||
+        array_reserve((void**)&order_cycle, &order_cycle_capacity, wire_order.node_count, sizeof(int)) != 0 ||
+        topo_add_edge(&wire_order, wire->from_gate_id, wire->to_gate_id, order_cycle, &length) != 1) {
+        return;
+    }
+    printf("Wire from gate %d to gate %d closes a feedback loop: gates", wire->from_gate_id, wire->to_gate_id);
+    for (int i = 0; i < length; i++) {
+        printf(" %d ->", order_cycle[i]);
+    }
+    printf(" %d\n", order_cycle[0]);
+}
+
+// Function to tell the simulator that gates or wires were added or removed
+void mark_topology_changed(void) {
+    topology_version++;
+}
+
+// Function to translate the editor's gates and wires into a dense netlist
+int build_sim_netlist(void* gates_ptr, int gate_count, void* wires_ptr, int wire_count, SimNetlist* net) {
+    LogicGate* gates = (LogicGate*)gates_ptr;
+    Wire* wires = (Wire*)wires_ptr;
+    sim_netlist_free(net);
+    if (sim_netlist_init(net, gate_count) != 0 || index_gate_ids(gates, gate_count) != 0) {
+        sim_netlist_free(net);
+        return -1;
+    }
+
+    for (int i = 0; i < gate_count; i++) {
+        if (!gates[i].in_palette) net->types[i] = gates[i].gate_type;
+    }
+
+    // Later wires win when several drive the same pin, as in the old sweep
+    for (int w = 0; w < wire_count; w++) {
+        int from = handle_slot(&netlist_slots, wires[w].from_gate_id);
+        int to = handle_slot(&netlist_slots, wires[w].to_gate_id);
+        if (from < 0 || to < 0) continue;
+        if (wires[w].to_pin_index >= gates[to].inputs || wires[w].to_pin_index >= SIM_MAX_PINS) continue;
+        net->fanin[to * SIM_MAX_PINS + wires[w].to_pin_index] = from;
+    }
+    return 0;
+}
+
+void propagate_signals(void* gates_ptr, int gate_count, void* wires_ptr, int wire_count) {
+    LogicGate* gates = (LogicGate*)gates_ptr;
+    Wire* wires = (Wire*)wires_ptr;
+
+    if (compiled_version != topology_version || compiled_gate_count != gate_count ||
+        compiled_wire_count != wire_count || compiled_wires != wires_ptr) {
+        free(sim_values);
+        free(sim_oscillating);
+        sim_values = malloc((gate_count + 1) * sizeof(unsigned char));
+        sim_oscillating = malloc((gate_count + 1) * sizeof(unsigned char));
+        simopt_free(&sim_optimized);
+        // Every placed gate is drawn, so logic feeding no OUTPUT gate is kept
+        if (!sim_values || !sim_oscillating || build_sim_netlist(gates, gate_count, wires, wire_count, &sim_netlist) != 0 ||
+            simopt_run(&sim_optimized, &sim_netlist, 0) != 0 ||
+            sim_compile(&sim_program, &sim_optimized.net) != 0) {
+            compiled_version = -1;
+            propagate_signals_iterative(gates, gate_count, wires, wire_count, topology_version);
+            return;
+        }
+        compiled_version = topology_version;
+        compiled_gate_count = gate_count;
+        compiled_wire_count = wire_count;
+        compiled_wires = wires_ptr;
+    }
+
+    // One pass in level order settles everything outside the feedback loops,
+    // only the loops run delta cycles, from the values already on screen. Folded
+    // gates read their value from the gate or constant they were folded into.
+    for (int i = 0; i < gate_count; i++) {
+        sim_values[i] = (unsigned char)(gates[i].output_value != 0);
+    }
+    if (sim_program.cyclic) {
+        int unsettled = sim_run_loops(&sim_program, sim_values, MAX_SETTLE_DELTAS, sim_oscillating);
+        if (unsettled > 0 && reported_version != compiled_version) {
+            printf("Warning: %d of %d feedback loops do not settle\n", unsettled, sim_program.loop_count);
+            report_oscillation(gates, gate_count, sim_oscillating);
+            reported_version = compiled_version;
+        }
+    } else {
+        sim_run(&sim_program, sim_values);
+    }
+
+    for (int i = 0; i < gate_count; i++) {
+        if (gates[i].in_palette) continue;
+        gates[i].output_value = simopt_value(&sim_optimized, sim_values, i);
+        for (int j = 0; j < gates[i].inputs && j < SIM_MAX_PINS; j++) {
+            int src = sim_netlist.fanin[i * SIM_MAX_PINS + j];
+            gates[i].input_values[j] = src >= 0 ? simopt_value(&sim_optimized, sim_values, src) : 0;
+        }
+    }
+}
+
+// Event-driven engine that keeps the workspace gates up to date between edits.
+// It runs on the optimized netlist, editor_netlist keeps the editor's wiring.
+static SimNetlist editor_netlist;
+static SimOptimized editor_optimized;
+static SimProgram editor_program;
+static SimEngine editor_engine;
+static int engine_version = -1;
+static int engine_gate_count = -1;
+static int settle_budget = 0;     // evaluations per frame: every gate once, loops MAX_SETTLE_DELTAS times
+
+// Function to copy a gate's engine value to the values the editor shows
+static void show_gate(int g) {
+    shown_values[g] = (unsigned char)simopt_value(&editor_optimized, editor_engine.values, g);
+}
+
+// Function to report an oscillating loop once per topology change. The engine
+// stops a few periods into the oscillation and carries on with it next frame.
+static void warn_oscillation(const LogicGate* gates, int gate_count) {
+    if (editor_engine.oscillating_count > 0 && reported_version != topology_version) {
+        report_oscillation(gates, gate_count, editor_engine.oscillating_flag);
+        reported_version = topology_version;
+    }
+}
+
+// Function to tell the engine that an INPUT gate was toggled in the editor
+void input_gate_changed(int gate_index, int value) {
+    if (engine_version == topology_version) {
+        sim_engine_set_value(&editor_engine, gate_index, value);
+    }
+}
+
+// Function to update the values shown for the workspace gates, only evaluating
+// gates downstream of a change. An idle circuit costs no evaluations at all.
+// The LogicGate records are left alone, except when the engine cannot be built
+// and propagate_signals stands in for it.
+void update_signals(LogicGate* gates, int gate_count, Wire* wires, int wire_count) {
+    if (reserve_shown_values(gate_count) != 0) {
+        printf("Warning: not enough memory to show signal values\n");
+        return;
+    }
+    if (engine_version != topology_version || engine_gate_count != gate_count) {
+        SimOptimized old_optimized = editor_optimized;
+        editor_optimized = (SimOptimized){0};
+        // Every placed gate is drawn, so logic feeding no OUTPUT gate is kept
+        if (build_sim_netlist(gates, gate_count, wires, wire_count, &editor_netlist) != 0 ||
+            simopt_run(&editor_optimized, &editor_netlist, 0) != 0 ||
+            sim_compile(&editor_program, &editor_optimized.net) != 0 ||
+            sim_engine_init(&editor_engine, &editor_optimized.net, &editor_program) != 0) {
+            simopt_free(&old_optimized);
+            engine_version = -1;
+            propagate_signals((void*)gates, gate_count, (void*)wires, wire_count);
+            for (int i = 0; i < gate_count; i++) {
+                shown_values[i] = (unsigned char)(gates[i].output_value != 0);
+            }
+            return;
+        }
+
+        // Keep the values already on screen and only re-evaluate gates whose wiring changed
+        const SimNetlist* net = &editor_optimized.net;
+        const SimNetlist* old_net = &old_optimized.net;
+        for (int i = 0; i < gate_count; i++) {
+            if (net->types[i] != SIM_INPUT) {
+                editor_engine.values[i] = shown_values[i];
+            }
+        }
+        for (int i = 0; i < gate_count; i++) {
+            int rewired = i >= old_net->gate_count || old_net->types[i] != net->types[i];
+            for (int p = 0; p < SIM_MAX_PINS && !rewired; p++) {
+                rewired = old_net->fanin[i * SIM_MAX_PINS + p] != net->fanin[i * SIM_MAX_PINS + p];
+            }
+            if (rewired) sim_engine_schedule(&editor_engine, i);
+            if (net->types[i] == SIM_INPUT) {
+                sim_engine_set_value(&editor_engine, i, gates[i].output_value);
+            }
+        }
+        simopt_free(&old_optimized);
+        engine_version = topology_version;
+        engine_gate_count = gate_count;
+
+        // Only gates inside feedback loops can need more than one evaluation
+        settle_budget = gate_count;
+        for (int l = 0; l < editor_program.loop_count; l++) {
+            settle_budget += MAX_SETTLE_DELTAS * (editor_program.loop_end[l] - editor_program.loop_begin[l]);
+        }
+        report_feedback(&editor_program, gates);
+
+        sim_engine_settle(&editor_engine, settle_budget);
+        warn_oscillation(gates, gate_count);
+        for (int i = 0; i < gate_count; i++) {
+            show_gate(i);
+        }
+        sim_engine_clear_changes(&editor_engine);
+        return;
+    }
+
+    // An INPUT gate driving nothing changes without scheduling anything
+    if (editor_engine.pending == 0 && editor_engine.changed_count == 0) return;
+    if (editor_engine.pending > 0) {
+        sim_engine_settle(&editor_engine, settle_budget);
+        warn_oscillation(gates, gate_count);
+    }
+
+    // Refresh only the gates whose value lives in a changed slot: the gate of
+    // the slot and the gates folded onto it. Pin values are not shown, so the
+    // fan-out needs no refresh unless its own slot changed.
+    for (int c = 0; c < editor_engine.changed_count; c++) {
+        int slot = editor_engine.changed[c];
+        for (int k = editor_optimized.shown_start[slot]; k < editor_optimized.shown_start[slot + 1]; k++) {
+            show_gate(editor_optimized.shown[k]);
+        }
+    }
+    sim_engine_clear_changes(&editor_engine);
+}
+
+// Function to print what the editor holds per gate and per wire: the records,
+// the tables indexing them and the gate order, at the capacity reserved, so the
+// memory a larger design needs can be estimated. The heap calls made so far
+// show whether editing still allocates once the arrays have grown.
+static void report_memory(int gate_count, int gate_capacity, int wire_count, int wire_capacity) {
+    size_t pins = (size_t)gate_capacity * SIM_MAX_PINS * sizeof(int);
+    size_t gate_records = (size_t)gate_capacity * sizeof(LogicGate) - pins;
+    size_t gate_index = (size_t)(gate_slots.id_capacity + netlist_slots.id_capacity) * sizeof(int) +
+                        (size_t)(gate_slots.slot_capacity + netlist_slots.slot_capacity) * (sizeof(int) + sizeof(uint32_t)) +
+                        (size_t)gate_store.capacity * 2 + (size_t)shown_capacity +
+                        (size_t)wire_index.node_capacity * 2 * sizeof(int);
+    size_t gate_order = topo_reserved(&wire_order) - topo_edges_reserved(&wire_order) +
+                        (size_t)order_cycle_capacity * sizeof(int);
+    size_t wire_records = (size_t)wire_capacity * sizeof(Wire);
+    size_t wire_fanin = (size_t)wire_index.edge_capacity * 4 * sizeof(int);
+    size_t wire_order_bytes = topo_edges_reserved(&wire_order);
+    int gates_counted = gate_count > 0 ? gate_count : 1;
+    int wires_counted = wire_count > 0 ? wire_count : 1;
+
+    printf("Memory: %d gates, %d wires\n", gate_count, wire_count);
+    printf("  per gate: %zu bytes (%zu record, %zu pins, %zu index, %zu order)\n",
+           (gate_records + pins + gate_index + gate_order) / gates_counted, gate_records / gates_counted,
+           pins / gates_counted, gate_index / gates_counted, gate_order / gates_counted);
+    printf("  per wire: %zu bytes (%zu record, %zu fan-in index, %zu order)\n",
+           (wire_records + wire_fanin + wire_order_bytes) / wires_counted, wire_records / wires_counted,
+           wire_fanin / wires_counted, wire_order_bytes / wires_counted);
+    AllocationCounters heap = allocation_counters();
+    printf("  heap: %ld arena blocks, %ld array grows, %zu KB\n", heap.arena_blocks, heap.array_grows, heap.bytes / 1024);
+}
+
+// Function to replace a copy of a circuit by the gates and wires given, for the
+// reference the workspace is checked against. Returns -1 when out of memory,
+// leaving the copy empty.
+static int copy_circuit(LogicGate** gates_copy, int* gate_copy_count, Wire** wires_copy, int* wire_copy_count,
+                        const LogicGate* gates, int gate_count, const Wire* wires, int wire_count) {
+    free(*gates_copy);
+    free(*wires_copy);
+    *gates_copy = malloc((gate_count + 1) * sizeof(LogicGate));
+    *wires_copy = malloc((wire_count + 1) * sizeof(Wire));
+    if (!*gates_copy || !*wires_copy) {
+        free(*gates_copy);
+        free(*wires_copy);
+        *gates_copy = NULL;
+        *wires_copy = NULL;
+        *gate_copy_count = 0;
+        *wire_copy_count = 0;
+        return -1;
+    }
+    memcpy(*gates_copy, gates, gate_count * sizeof(LogicGate));
+    memcpy(*wires_copy, wires, wire_count * sizeof(Wire));
+    *gate_copy_count = gate_count;
+    *wire_copy_count = wire_count;
+    return 0;
 }
 
 void draw_palette(SDL_Renderer* renderer) {
@@ -411,8 +847,14 @@ void draw_palette(SDL_Renderer* renderer) {
     SDL_RenderLine(renderer, 10, 40, PALETTE_WIDTH - 10, 40);
 }
 
-int create_gate_in_workspace(LogicGate* gates, int* gate_count, const char* name, SDL_Color color, SDL_Color selected_color, int inputs, int outputs, float x, float y, int id) {
-    if (*gate_count >= MAX_GATES) return -1;
+// Function to append a gate to the growable gates array, returns its index or -1
+// when out of memory or when the gate has more pins than a record holds
+int create_gate_in_workspace(LogicGate** gates_ptr, int* gate_count, int* gate_capacity, const char* name, SDL_Color color, SDL_Color selected_color, int inputs, int outputs, float x, float y, int id) {
+    if (inputs > SIM_MAX_PINS || array_reserve((void**)gates_ptr, gate_capacity, *gate_count + 1, sizeof(LogicGate)) != 0 ||
+        handle_bind(&gate_slots, id, *gate_count) != 0) {
+        return -1;
+    }
+    LogicGate* gates = *gates_ptr;
     
     int gate_type = 0;
     if (strcmp(name, "AND") == 0) gate_type = 0;
@@ -436,18 +878,11 @@ int create_gate_in_workspace(LogicGate* gates, int* gate_count, const char* name
         0, 0,
         false,
         id,
-        NULL,
+        {0},
         0,
         gate_type
     };
     
-    if (inputs > 0) {
-        gates[*gate_count].input_values = malloc(inputs * sizeof(int));
-        for (int i = 0; i < inputs; i++) {
-            gates[*gate_count].input_values[i] = 0;
-        }
-    }
-    
     return (*gate_count)++;
 }
 
@@ -512,6 +947,12 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
+    // Pick the widest gate kernels for this CPU and check them against the scalar gates
+    if (logic_kernels_self_test() != 0) {
+        printf("Warning: gate kernels failed the self-test\n");
+    }
+    printf("Gate kernels: %s\n", logic_kernels_isa());
+    
     // Create fullscreen window
     SDL_Window* window = SDL_CreateWindow("Logic Circuit Simulator - Fullscreen Mode!",
                                          WINDOW_WIDTH, WINDOW_HEIGHT,
@@ -530,10 +971,13 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
-    LogicGate gates[MAX_GATES];
+    // Gates and wires grow as needed, gates are found by id through gate_slots
+    LogicGate* gates = NULL;
     int gate_count = 0;
-    Wire wires[MAX_WIRES];
+    int gate_capacity = 0;
+    Wire* wires = NULL;
     int wire_count = 0;
+    int wire_capacity = 0;
     int next_gate_id = 1;
     
     LogicGate palette_gates[] = {
@@ -555,7 +999,15 @@ int main(int argc, char* argv[]) {
          {100, 150, 100, 255}, {150, 200, 150, 255}, 1, 0, false, false, 0, 0, true, 0}
     };
     
-    for (int i = 0; i < sizeof(palette_gates) / sizeof(palette_gates[0]); i++) {
+    int palette_count = sizeof(palette_gates) / sizeof(palette_gates[0]);
+    if (array_reserve((void**)&gates, &gate_capacity, palette_count, sizeof(LogicGate)) != 0) {
+        printf("Not enough memory for the gate palette!\n");
+        SDL_DestroyRenderer(renderer);
+        SDL_DestroyWindow(window);
+        SDL_Quit();
+        return 1;
+    }
+    for (int i = 0; i < palette_count; i++) {
         gates[gate_count++] = palette_gates[i];
     }
     
@@ -570,6 +1022,12 @@ int main(int argc, char* argv[]) {
     LogicGate new_gate_template;
     int selected_palette_index = -1;
     
+    // Copy of the workspace kept with R, E checks the workspace against it
+    LogicGate* reference_gates = NULL;
+    int reference_gate_count = 0;
+    Wire* reference_wires = NULL;
+    int reference_wire_count = 0;
+    
     while (running) {
         while (SDL_PollEvent(&event)) {
             if (event.type == SDL_EVENT_QUIT) {
@@ -624,7 +1082,9 @@ int main(int argc, char* argv[]) {
                                     int pin_index;
                                     if (is_point_near_pin(gates[i], mouse_x, mouse_y, &is_output, &pin_index)) {
                                         if (!is_output) {
-                                            if (wire_count < MAX_WIRES) {
+                                            if (array_reserve((void**)&wires, &wire_capacity, wire_count + 1, sizeof(Wire)) != 0) {
+                                                printf("Not enough memory for another wire!\n");
+                                            } else {
                                                 wires[wire_count++] = (Wire){
                                                     source_gate_id,
                                                     source_pin_index,
@@ -632,6 +1092,8 @@ int main(int argc, char* argv[]) {
                                                     pin_index,
                                                     {0, 0, 0, 255}
                                                 };
+                                                order_new_wire(&wires[wire_count - 1]);
+                                                mark_topology_changed();
                                             }
                                             wiring_mode = false;
                                             break;
@@ -650,6 +1112,7 @@ int main(int argc, char* argv[]) {
                                         mouse_y <= gates[i].rect.y + gates[i].rect.h) {
                                         
                                         gates[i].output_value = !gates[i].output_value;
+                                        input_gate_changed(i, gates[i].output_value);
                                         input_gate_clicked = true;
                                         printf("INPUT gate %d toggled to: %d\n", gates[i].id, gates[i].output_value);
                                         break;
@@ -708,7 +1171,7 @@ int main(int argc, char* argv[]) {
                 if (event.button.button == SDL_BUTTON_LEFT) {
                     if (creating_new_gate) {
                         if (event.button.x > PALETTE_WIDTH) {
-                            create_gate_in_workspace(gates, &gate_count, 
+                            if (create_gate_in_workspace(&gates, &gate_count, &gate_capacity,
                                                    new_gate_template.name,
                                                    new_gate_template.color,
                                                    new_gate_template.selected_color,
@@ -716,7 +1179,10 @@ int main(int argc, char* argv[]) {
                                                    new_gate_template.outputs,
                                                    new_gate_template.rect.x,
                                                    new_gate_template.rect.y,
-                                                   new_gate_template.id);
+                                                   new_gate_template.id) < 0) {
+                                printf("Not enough memory for another gate!\n");
+                            }
+                            mark_topology_changed();
                         }
                         creating_new_gate = false;
                         if (selected_palette_index != -1) {
@@ -730,6 +1196,27 @@ int main(int argc, char* argv[]) {
                     }
                 }
             }
+            else if (event.type == SDL_EVENT_KEY_DOWN) {
+                if (event.key.key == SDLK_M) {
+                    report_memory(gate_count, gate_capacity, wire_count, wire_capacity);
+                }
+                else if (event.key.key == SDLK_R) {
+                    if (copy_circuit(&reference_gates, &reference_gate_count, &reference_wires, &reference_wire_count,
+                                     gates, gate_count, wires, wire_count) != 0) {
+                        printf("Not enough memory to keep the reference circuit!\n");
+                    } else {
+                        printf("Kept the circuit as the reference, press E to check the workspace against it\n");
+                    }
+                }
+                else if (event.key.key == SDLK_E) {
+                    if (reference_gate_count == 0) {
+                        printf("No reference circuit, press R to keep the current one first\n");
+                    } else {
+                        check_equivalence((void*)reference_gates, reference_gate_count, (void*)reference_wires, reference_wire_count,
+                                          (void*)gates, gate_count, (void*)wires, wire_count);
+                    }
+                }
+            }
             else if (event.type == SDL_EVENT_MOUSE_MOTION) {
                 if (wiring_mode) {
                     temp_wire_end_x = event.motion.x;
@@ -749,8 +1236,8 @@ int main(int argc, char* argv[]) {
             }
         }
         
-        // CRITICAL: Call signal propagation
-        propagate_signals((void*)gates, gate_count, (void*)wires, wire_count);
+        // Only gates downstream of a toggle or an edit are re-evaluated
+        update_signals(gates, gate_count, wires, wire_count);
         
         SDL_SetRenderDrawColor(renderer, 240, 240, 240, 255);
         SDL_RenderClear(renderer);
@@ -761,30 +1248,28 @@ int main(int argc, char* argv[]) {
         
         for (int i = 0; i < gate_count; i++) {
             if (gates[i].in_palette) {
-                draw_logic_gate(renderer, gates[i]);
+                draw_logic_gate(renderer, gates[i], 0);
             }
         }
         
         for (int i = 0; i < gate_count; i++) {
             if (!gates[i].in_palette) {
-                draw_logic_gate(renderer, gates[i]);
+                draw_logic_gate(renderer, gates[i], i < shown_count ? shown_values[i] : gates[i].output_value);
             }
         }
         
         if (creating_new_gate) {
-            draw_logic_gate(renderer, new_gate_template);
+            draw_logic_gate(renderer, new_gate_template, new_gate_template.output_value);
         }
         
         if (wiring_mode) {
             SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255);
-            for (int i = 0; i < gate_count; i++) {
-                if (gates[i].id == source_gate_id) {
-                    float start_x, start_y;
-                    get_pin_position(gates[i], true, source_pin_index, &start_x, &start_y);
-                    start_x += PIN_LENGTH;
-                    SDL_RenderLine(renderer, start_x, start_y, temp_wire_end_x, temp_wire_end_y);
-                    break;
-                }
+            int source = handle_slot(&gate_slots, source_gate_id);
+            if (source >= 0 && source < gate_count) {
+                float start_x, start_y;
+                get_pin_position(gates[source], true, source_pin_index, &start_x, &start_y);
+                start_x += PIN_LENGTH;
+                SDL_RenderLine(renderer, start_x, start_y, temp_wire_end_x, temp_wire_end_y);
             }
         }
         
@@ -792,6 +1277,12 @@ int main(int argc, char* argv[]) {
         SDL_Delay(16);
     }
     
+    free(gates);
+    free(wires);
+    free(order_cycle);
+    free(shown_values);
+    free(reference_gates);
+    free(reference_wires);
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
     SDL_Quit();
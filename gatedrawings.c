@@ -4,6 +4,8 @@
 #include <string.h>
 #include <math.h>
 #include "logicgates.h"
+#include "simulator.h"
+#include "simopt.h"
 #include <stdlib.h>
 
 #define WINDOW_WIDTH 1400
@@ -16,6 +18,7 @@
 #define PALETTE_WIDTH 200
 #define MAX_GATES 50
 #define MAX_WIRES 100
+#define MAX_SETTLE_DELTAS 100  // delta cycles a feedback loop gets to settle or repeat a state
 
 typedef struct {
     const char* name;
@@ -30,7 +33,7 @@ typedef struct {
     int drag_offset_y;
     bool in_palette;
     int id;               // Unique identifier for each gate
-    int* input_values;    // Array to store input values (0 or 1)
+    int input_values[SIM_MAX_PINS]; // Values on the input pins (0 or 1), no gate has more
     int output_value;     // Current output value (0 or 1)
     int gate_type;        // 0=AND, 1=OR, 2=NOT, 3=NAND, 4=NOR, 5=XOR, 6=INPUT, 7=OUTPUT // from the enum we have created
 } LogicGate;
@@ -327,17 +330,16 @@ void compute_gate_output(LogicGate* gate) {
 }
 
 
-// Function to propagate signals through all wires and update all gates
-void propagate_signals(LogicGate* gates, int gate_count, Wire* wires, int wire_count) {
+// Fixed-point propagation over the editor's wires, the fallback when the
+// circuit cannot be compiled
+static void propagate_signals_iterative(LogicGate* gates, int gate_count, Wire* wires, int wire_count) {
     // First reset all non-INPUT gate outputs to 0
     for (int i = 0; i < gate_count; i++) {
         if (!gates[i].in_palette && gates[i].gate_type != 6) { // Not INPUT gates
             gates[i].output_value = 0;
             // Also reset input values to 0 for safety
-            if (gates[i].input_values) {
-                for (int j = 0; j < gates[i].inputs; j++) {
-                    gates[i].input_values[j] = 0;
-                }
+            for (int j = 0; j < gates[i].inputs && j < SIM_MAX_PINS; j++) {
+                gates[i].input_values[j] = 0;
             }
         }
     }
@@ -364,8 +366,8 @@ void propagate_signals(LogicGate* gates, int gate_count, Wire* wires, int wire_c
                 if (from_gate && to_gate) break;
             }
             
-            if (from_gate && to_gate && to_gate->input_values && 
-                wire.to_pin_index < to_gate->inputs) {
+            if (from_gate && to_gate && 
+                wire.to_pin_index < to_gate->inputs && wire.to_pin_index < SIM_MAX_PINS) {
                 
                 // Copy output to input
                 int old_value = to_gate->input_values[wire.to_pin_index];
@@ -395,6 +397,123 @@ void propagate_signals(LogicGate* gates, int gate_count, Wire* wires, int wire_c
     }
 }
 
+// Compiled evaluation program, rebuilt only when the circuit topology changes.
+// The program runs on the optimized netlist, sim_netlist keeps the editor's wiring.
+static SimNetlist sim_netlist;
+static SimOptimized sim_optimized;
+static SimProgram sim_program;
+static unsigned char* sim_values = NULL;
+static unsigned char* sim_oscillating = NULL;   // per gate, set by sim_run_loops
+static int topology_version = 0;
+static int compiled_version = -1;
+static int compiled_gate_count = -1;
+static int compiled_wire_count = -1;
+static int reported_version = -1;
+
+// Function to tell the simulator that gates or wires were added or removed
+void mark_topology_changed(void) {
+    topology_version++;
+}
+
+// Function to translate the editor's gates and wires into a dense netlist
+static int build_netlist(LogicGate* gates, int gate_count, Wire* wires, int wire_count, SimNetlist* net) {
+    sim_netlist_free(net);
+    if (sim_netlist_init(net, gate_count) != 0) return -1;
+
+    // Gate ids are small and increasing, so a direct id -> index table is enough
+    int max_id = 0;
+    for (int i = 0; i < gate_count; i++) {
+        if (gates[i].id > max_id) max_id = gates[i].id;
+    }
+    int* index_of = malloc((max_id + 1) * sizeof(int));
+    if (!index_of) return -1;
+    for (int id = 0; id <= max_id; id++) {
+        index_of[id] = -1;
+    }
+    for (int i = 0; i < gate_count; i++) {
+        if (!gates[i].in_palette) {
+            net->types[i] = gates[i].gate_type;
+            index_of[gates[i].id] = i;
+        }
+    }
+
+    // Later wires win when several drive the same pin, as in the old sweep
+    for (int w = 0; w < wire_count; w++) {
+        if (wires[w].from_gate_id < 0 || wires[w].from_gate_id > max_id ||
+            wires[w].to_gate_id < 0 || wires[w].to_gate_id > max_id) continue;
+        int from = index_of[wires[w].from_gate_id];
+        int to = index_of[wires[w].to_gate_id];
+        if (from < 0 || to < 0) continue;
+        if (wires[w].to_pin_index >= gates[to].inputs || wires[w].to_pin_index >= SIM_MAX_PINS) continue;
+        net->fanin[to * SIM_MAX_PINS + wires[w].to_pin_index] = from;
+    }
+
+    free(index_of);
+    return 0;
+}
+
+// Function to propagate signals through all wires and update all gates
+void propagate_signals(LogicGate* gates, int gate_count, Wire* wires, int wire_count) {
+    if (compiled_version != topology_version || compiled_gate_count != gate_count ||
+        compiled_wire_count != wire_count) {
+        free(sim_values);
+        free(sim_oscillating);
+        sim_values = malloc((gate_count + 1) * sizeof(unsigned char));
+        sim_oscillating = malloc((gate_count + 1) * sizeof(unsigned char));
+        simopt_free(&sim_optimized);
+        // Every placed gate is drawn, so logic feeding no OUTPUT gate is kept
+        if (!sim_values || !sim_oscillating || build_netlist(gates, gate_count, wires, wire_count, &sim_netlist) != 0 ||
+            simopt_run(&sim_optimized, &sim_netlist, 0) != 0 ||
+            sim_compile(&sim_program, &sim_optimized.net) != 0) {
+            compiled_version = -1;
+            propagate_signals_iterative(gates, gate_count, wires, wire_count);
+            return;
+        }
+        compiled_version = topology_version;
+        compiled_gate_count = gate_count;
+        compiled_wire_count = wire_count;
+        for (int l = 0; l < sim_program.loop_count; l++) {
+            printf("Feedback loop %d of %d: gates", l + 1, sim_program.loop_count);
+            for (int i = sim_program.loop_begin[l]; i < sim_program.loop_end[l]; i++) {
+                printf(" %d", gates[sim_program.code[i].out].id);
+            }
+            printf("\n");
+        }
+    }
+
+    // One pass in level order settles everything outside the feedback loops,
+    // only the loops run delta cycles, from the values already on screen. Folded
+    // gates read their value from the gate or constant they were folded into.
+    for (int i = 0; i < gate_count; i++) {
+        sim_values[i] = (unsigned char)(gates[i].output_value != 0);
+    }
+    if (sim_program.cyclic) {
+        int unsettled = sim_run_loops(&sim_program, sim_values, MAX_SETTLE_DELTAS, sim_oscillating);
+        if (unsettled > 0 && reported_version != compiled_version) {
+            printf("Warning: %d of %d feedback loops do not settle\n", unsettled, sim_program.loop_count);
+            int found = 0;
+            for (int i = 0; i < gate_count; i++) {
+                if (!sim_oscillating[i]) continue;
+                if (!found++) printf("Oscillating or racing gates:");
+                printf(" %d", gates[i].id);
+            }
+            if (found) printf("\n");
+            reported_version = compiled_version;
+        }
+    } else {
+        sim_run(&sim_program, sim_values);
+    }
+
+    for (int i = 0; i < gate_count; i++) {
+        if (gates[i].in_palette) continue;
+        gates[i].output_value = simopt_value(&sim_optimized, sim_values, i);
+        for (int j = 0; j < gates[i].inputs && j < SIM_MAX_PINS; j++) {
+            int src = sim_netlist.fanin[i * SIM_MAX_PINS + j];
+            gates[i].input_values[j] = src >= 0 ? simopt_value(&sim_optimized, sim_values, src) : 0;
+        }
+    }
+}
+
 // Function to draw the palette
 void draw_palette(SDL_Renderer* renderer) {
     SDL_SetRenderDrawColor(renderer, 220, 220, 220, 255);
@@ -411,7 +530,7 @@ void draw_palette(SDL_Renderer* renderer) {
 
 // Function to create a new gate in workspace
 int create_gate_in_workspace(LogicGate* gates, int* gate_count, const char* name, SDL_Color color, SDL_Color selected_color, int inputs, int outputs, float x, float y, int id) {
-    if (*gate_count >= MAX_GATES) return -1;
+    if (*gate_count >= MAX_GATES || inputs > SIM_MAX_PINS) return -1;
     
     // Determine gate_type based on name
     int gate_type = 0;
@@ -437,19 +556,11 @@ int create_gate_in_workspace(LogicGate* gates, int* gate_count, const char* name
         false,
         id,
         // ADD THESE NEW INITIALIZATIONS:
-        NULL,    // input_values (we'll allocate next)
+        {0},     // input_values, all inputs start at 0
         0,       // output_value
         gate_type // gate_type
     };
     
-    // Allocate memory for input_values array if needed
-    if (inputs > 0) {
-        gates[*gate_count].input_values = malloc(inputs * sizeof(int));
-        for (int i = 0; i < inputs; i++) {
-            gates[*gate_count].input_values[i] = 0; // Initialize all inputs to 0
-        }
-    }
-    
     return (*gate_count)++;
 }
 
@@ -622,6 +733,7 @@ int main(int argc, char* argv[]) {
                                                 pin_index,
                                                 {0, 0, 0, 255}  // Black wire
                                             };
+                                            mark_topology_changed();
                                         }
                                         wiring_mode = false;
                                         break;
@@ -712,6 +824,7 @@ int main(int argc, char* argv[]) {
                                                new_gate_template.rect.x,
                                                new_gate_template.rect.y,
                                                new_gate_template.id);
+                        mark_topology_changed();
                     }
                     creating_new_gate = false;
                     if (selected_palette_index != -1) {
@@ -0,0 +1,100 @@
+#include <stdlib.h>
+#include <string.h>
+#include "handle.h"
+
+void handle_init(HandleTable* t) {
+    memset(t, 0, sizeof(HandleTable));
+}
+
+void handle_free(HandleTable* t) {
+    free(t->slot_of);
+    free(t->id_of);
+    free(t->generation);
+    handle_init(t);
+}
+
+// Function to step a slot's generation, skipping 0 so no handle is ever 0
+static void next_generation(HandleTable* t, int slot) {
+    if (++t->generation[slot] == 0) t->generation[slot] = 1;
+}
+
+void handle_clear(HandleTable* t) {
+    for (int id = 0; id < t->id_capacity; id++) {
+        t->slot_of[id] = -1;
+    }
+    for (int slot = 0; slot < t->slot_capacity; slot++) {
+        if (t->id_of[slot] >= 0) next_generation(t, slot);
+        t->id_of[slot] = -1;
+    }
+}
+
+// Function to make the tables cover an id and a slot, new entries start empty
+static int reserve(HandleTable* t, int id, int slot) {
+    if (id >= t->id_capacity) {
+        int capacity = t->id_capacity < 64 ? 64 : t->id_capacity * 2;
+        if (capacity <= id) capacity = id + 1;
+        int* slot_of = realloc(t->slot_of, capacity * sizeof(int));
+        if (!slot_of) return -1;
+        for (int i = t->id_capacity; i < capacity; i++) {
+            slot_of[i] = -1;
+        }
+        t->slot_of = slot_of;
+        t->id_capacity = capacity;
+    }
+    if (slot >= t->slot_capacity) {
+        int capacity = t->slot_capacity < 64 ? 64 : t->slot_capacity * 2;
+        if (capacity <= slot) capacity = slot + 1;
+        int* id_of = realloc(t->id_of, capacity * sizeof(int));
+        if (!id_of) return -1;
+        t->id_of = id_of;
+        uint32_t* generation = realloc(t->generation, capacity * sizeof(uint32_t));
+        if (!generation) return -1;
+        t->generation = generation;
+        for (int i = t->slot_capacity; i < capacity; i++) {
+            id_of[i] = -1;
+            generation[i] = 1;
+        }
+        t->slot_capacity = capacity;
+    }
+    return 0;
+}
+
+int handle_bind(HandleTable* t, int id, int slot) {
+    if (id < 0 || slot < 0 || reserve(t, id, slot) != 0) return -1;
+    if (t->id_of[slot] == id) return 0;
+
+    int previous = t->id_of[slot];
+    if (previous >= 0 && t->slot_of[previous] == slot) t->slot_of[previous] = -1;
+    int moved_from = t->slot_of[id];
+    if (moved_from >= 0 && t->id_of[moved_from] == id) {
+        t->id_of[moved_from] = -1;
+        next_generation(t, moved_from);
+    }
+    t->id_of[slot] = id;
+    t->slot_of[id] = slot;
+    next_generation(t, slot);
+    return 0;
+}
+
+void handle_release(HandleTable* t, int slot) {
+    if (slot < 0 || slot >= t->slot_capacity || t->id_of[slot] < 0) return;
+    int id = t->id_of[slot];
+    if (t->slot_of[id] == slot) t->slot_of[id] = -1;
+    t->id_of[slot] = -1;
+    next_generation(t, slot);
+}
+
+int handle_slot(const HandleTable* t, int id) {
+    return id >= 0 && id < t->id_capacity ? t->slot_of[id] : -1;
+}
+
+Handle handle_of(const HandleTable* t, int slot) {
+    if (slot < 0 || slot >= t->slot_capacity || t->id_of[slot] < 0) return 0;
+    return (Handle)t->generation[slot] << 32 | (uint32_t)slot;
+}
+
+int handle_resolve(const HandleTable* t, Handle h) {
+    int slot = (int)(uint32_t)h;
+    if (h == 0 || slot < 0 || slot >= t->slot_capacity || t->id_of[slot] < 0) return -1;
+    return t->generation[slot] == (uint32_t)(h >> 32) ? slot : -1;
+}
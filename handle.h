@@ -0,0 +1,44 @@
+#ifndef HANDLE_H
+#define HANDLE_H
+
+#include <stdint.h>
+
+// Map from item ids to slots of a packed item array. Ids are small and never
+// reused, so they index a table directly; every lookup is O(1). Each slot also
+// has a generation that changes whenever the slot gets a different item, so a
+// handle (slot and generation) taken earlier can be checked before it is used.
+// A zero-initialized HandleTable is empty.
+typedef struct {
+    int id_capacity;
+    int* slot_of;           // id -> slot, -1 when the id has no slot
+    int slot_capacity;
+    int* id_of;             // slot -> id, -1 when the slot is free
+    uint32_t* generation;   // per slot, starts at 1 so no handle is 0
+} HandleTable;
+
+typedef uint64_t Handle;    // generation << 32 | slot, 0 is never valid
+
+void handle_init(HandleTable* t);
+void handle_free(HandleTable* t);
+
+// Forget every item, outstanding handles turn stale
+void handle_clear(HandleTable* t);
+
+// Record that item id lives in slot. A different item leaving the slot, or
+// the id leaving another slot, makes the handles to that slot stale.
+// Returns 0 on success, -1 when out of memory or given a negative id or slot.
+int handle_bind(HandleTable* t, int id, int slot);
+
+// Record that slot is empty, for the last slot of an array that shrank
+void handle_release(HandleTable* t, int slot);
+
+// Slot of an id, -1 if it has none
+int handle_slot(const HandleTable* t, int id);
+
+// Handle to the item in a slot, 0 for a free slot
+Handle handle_of(const HandleTable* t, int slot);
+
+// Slot a handle refers to, -1 if its item has since moved or gone
+int handle_resolve(const HandleTable* t, Handle h);
+
+#endif
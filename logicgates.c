@@ -1,6 +1,13 @@
 #include <stdio.h>
+#include <string.h>
+#include <pthread.h>
 #include "logicgates.h"
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define LOGIC_X86 1
+#endif
+
 // Gate functions 
 int AND(int a, int b) {
     return (a && b);
@@ -26,6 +33,214 @@ int XOR(int a, int b) {
     return (a && !b) || (!a && b);  // Logical XOR
 }
 
+// Array-wide gate kernels over packed words (64 signals per word), see LogicKernelSet
+#define SCALAR_KERNEL(name, expr) \
+static void name(uint64_t* dst, const uint64_t* a, const uint64_t* b, size_t nwords) { \
+    for (size_t i = 0; i < nwords; i++) { \
+        uint64_t x = a[i], y = b[i]; \
+        (void)y; \
+        dst[i] = (expr); \
+    } \
+}
+
+SCALAR_KERNEL(scalar_and_n, x & y)
+SCALAR_KERNEL(scalar_or_n, x | y)
+SCALAR_KERNEL(scalar_not_n, ~x)
+SCALAR_KERNEL(scalar_nand_n, ~(x & y))
+SCALAR_KERNEL(scalar_nor_n, ~(x | y))
+SCALAR_KERNEL(scalar_xor_n, x ^ y)
+
+static const LogicKernelSet scalar_kernels = {
+    "portable", { scalar_and_n, scalar_or_n, scalar_not_n, scalar_nand_n, scalar_nor_n, scalar_xor_n }
+};
+
+#ifdef LOGIC_X86
+// Vector body plus a scalar tail, WORDS is the number of uint64_t per register
+#define VECTOR_KERNEL(name, isa, vtype, WORDS, load, store, ones_init, vexpr, sexpr) \
+static __attribute__((target(isa))) void name(uint64_t* dst, const uint64_t* a, const uint64_t* b, size_t nwords) { \
+    const vtype ones = ones_init; \
+    (void)ones; \
+    size_t i = 0; \
+    for (; i + WORDS <= nwords; i += WORDS) { \
+        vtype x = load((const void*)(a + i)); \
+        vtype y = load((const void*)(b + i)); \
+        (void)y; \
+        store((void*)(dst + i), vexpr); \
+    } \
+    for (; i < nwords; i++) { \
+        uint64_t x = a[i], y = b[i]; \
+        (void)y; \
+        dst[i] = (sexpr); \
+    } \
+}
+
+#define SSE2_LOAD(p) _mm_loadu_si128((const __m128i*)(p))
+#define SSE2_STORE(p, v) _mm_storeu_si128((__m128i*)(p), v)
+#define SSE2_KERNEL(name, vexpr, sexpr) \
+    VECTOR_KERNEL(name, "sse2", __m128i, 2, SSE2_LOAD, SSE2_STORE, _mm_set1_epi32(-1), vexpr, sexpr)
+
+SSE2_KERNEL(sse2_and_n, _mm_and_si128(x, y), x & y)
+SSE2_KERNEL(sse2_or_n, _mm_or_si128(x, y), x | y)
+SSE2_KERNEL(sse2_not_n, _mm_xor_si128(x, ones), ~x)
+SSE2_KERNEL(sse2_nand_n, _mm_xor_si128(_mm_and_si128(x, y), ones), ~(x & y))
+SSE2_KERNEL(sse2_nor_n, _mm_xor_si128(_mm_or_si128(x, y), ones), ~(x | y))
+SSE2_KERNEL(sse2_xor_n, _mm_xor_si128(x, y), x ^ y)
+
+#define AVX2_LOAD(p) _mm256_loadu_si256((const __m256i*)(p))
+#define AVX2_STORE(p, v) _mm256_storeu_si256((__m256i*)(p), v)
+#define AVX2_KERNEL(name, vexpr, sexpr) \
+    VECTOR_KERNEL(name, "avx2", __m256i, 4, AVX2_LOAD, AVX2_STORE, _mm256_set1_epi32(-1), vexpr, sexpr)
+
+AVX2_KERNEL(avx2_and_n, _mm256_and_si256(x, y), x & y)
+AVX2_KERNEL(avx2_or_n, _mm256_or_si256(x, y), x | y)
+AVX2_KERNEL(avx2_not_n, _mm256_xor_si256(x, ones), ~x)
+AVX2_KERNEL(avx2_nand_n, _mm256_xor_si256(_mm256_and_si256(x, y), ones), ~(x & y))
+AVX2_KERNEL(avx2_nor_n, _mm256_xor_si256(_mm256_or_si256(x, y), ones), ~(x | y))
+AVX2_KERNEL(avx2_xor_n, _mm256_xor_si256(x, y), x ^ y)
+
+#define AVX512_LOAD(p) _mm512_loadu_si512(p)
+#define AVX512_STORE(p, v) _mm512_storeu_si512(p, v)
+#define AVX512_KERNEL(name, vexpr, sexpr) \
+    VECTOR_KERNEL(name, "avx512f", __m512i, 8, AVX512_LOAD, AVX512_STORE, _mm512_set1_epi32(-1), vexpr, sexpr)
+
+AVX512_KERNEL(avx512_and_n, _mm512_and_si512(x, y), x & y)
+AVX512_KERNEL(avx512_or_n, _mm512_or_si512(x, y), x | y)
+AVX512_KERNEL(avx512_not_n, _mm512_xor_si512(x, ones), ~x)
+AVX512_KERNEL(avx512_nand_n, _mm512_xor_si512(_mm512_and_si512(x, y), ones), ~(x & y))
+AVX512_KERNEL(avx512_nor_n, _mm512_xor_si512(_mm512_or_si512(x, y), ones), ~(x | y))
+AVX512_KERNEL(avx512_xor_n, _mm512_xor_si512(x, y), x ^ y)
+
+static const LogicKernelSet sse2_kernels = {
+    "SSE2", { sse2_and_n, sse2_or_n, sse2_not_n, sse2_nand_n, sse2_nor_n, sse2_xor_n }
+};
+static const LogicKernelSet avx2_kernels = {
+    "AVX2", { avx2_and_n, avx2_or_n, avx2_not_n, avx2_nand_n, avx2_nor_n, avx2_xor_n }
+};
+static const LogicKernelSet avx512_kernels = {
+    "AVX-512", { avx512_and_n, avx512_or_n, avx512_not_n, avx512_nand_n, avx512_nor_n, avx512_xor_n }
+};
+#endif
+
+static const LogicKernelSet* active_kernels = NULL;
+static pthread_once_t kernels_once = PTHREAD_ONCE_INIT;
+
+static int check_kernel_set(const LogicKernelSet* set);
+
+// Function to pick the widest kernel set the CPU supports (CPUID) that also passes
+// the self-test. The choice is published with a single store inside pthread_once,
+// so no caller ever sees a set being replaced or a set that failed.
+static void pick_kernels(void) {
+    const LogicKernelSet* set = &scalar_kernels;
+#ifdef LOGIC_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && check_kernel_set(&avx512_kernels) == 0) set = &avx512_kernels;
+    else if (__builtin_cpu_supports("avx2") && check_kernel_set(&avx2_kernels) == 0) set = &avx2_kernels;
+    else if (__builtin_cpu_supports("sse2") && check_kernel_set(&sse2_kernels) == 0) set = &sse2_kernels;
+#endif
+    active_kernels = set;
+}
+
+// Function to pick the kernel set once; safe to call from several threads at once
+void logic_kernels_init(void) {
+    pthread_once(&kernels_once, pick_kernels);
+}
+
+const LogicKernelSet* logic_kernels(void) {
+    pthread_once(&kernels_once, pick_kernels);
+    return active_kernels;
+}
+
+const char* logic_kernels_isa(void) {
+    return logic_kernels()->isa;
+}
+
+void logic_and_n(uint64_t* dst, const uint64_t* a, const uint64_t* b, size_t nwords) {
+    logic_kernels()->op[LOGIC_OP_AND](dst, a, b, nwords);
+}
+
+void logic_or_n(uint64_t* dst, const uint64_t* a, const uint64_t* b, size_t nwords) {
+    logic_kernels()->op[LOGIC_OP_OR](dst, a, b, nwords);
+}
+
+void logic_not_n(uint64_t* dst, const uint64_t* a, size_t nwords) {
+    logic_kernels()->op[LOGIC_OP_NOT](dst, a, a, nwords);
+}
+
+void logic_nand_n(uint64_t* dst, const uint64_t* a, const uint64_t* b, size_t nwords) {
+    logic_kernels()->op[LOGIC_OP_NAND](dst, a, b, nwords);
+}
+
+void logic_nor_n(uint64_t* dst, const uint64_t* a, const uint64_t* b, size_t nwords) {
+    logic_kernels()->op[LOGIC_OP_NOR](dst, a, b, nwords);
+}
+
+void logic_xor_n(uint64_t* dst, const uint64_t* a, const uint64_t* b, size_t nwords) {
+    logic_kernels()->op[LOGIC_OP_XOR](dst, a, b, nwords);
+}
+
+// Function to check one kernel set bit-for-bit against the scalar gate functions
+static int check_kernel_set(const LogicKernelSet* set) {
+    enum { WORDS = 37 };   // odd length so every vector tail is exercised
+    uint64_t a[WORDS + 1], b[WORDS + 1], dst[WORDS + 1];
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    int failures = 0;
+
+    for (int i = 0; i <= WORDS; i++) {
+        seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+        a[i] = seed;
+        seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+        b[i] = seed;
+    }
+
+    for (int op = 0; op < 6; op++) {
+        // Offset by one word as well, so unaligned loads are covered
+        for (int offset = 0; offset <= 1; offset++) {
+            memset(dst, 0, sizeof(dst));
+            set->op[op](dst + offset, a + offset, b + offset, WORDS - offset);
+            for (int w = offset; w < WORDS; w++) {
+                for (int bit = 0; bit < 64; bit++) {
+                    int x = (int)((a[w] >> bit) & 1);
+                    int y = (int)((b[w] >> bit) & 1);
+                    int expected;
+                    switch (op) {
+                        case 0: expected = AND(x, y); break;
+                        case 1: expected = OR(x, y); break;
+                        case 2: expected = NOT(x); break;
+                        case 3: expected = NAND(x, y); break;
+                        case 4: expected = NOR(x, y); break;
+                        default: expected = XOR(x, y); break;
+                    }
+                    if ((int)((dst[w] >> bit) & 1) != expected) {
+                        failures++;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+    if (failures) {
+        printf("Kernel self-test: %s kernels disagree with the scalar gates (%d words)\n", set->isa, failures);
+    }
+    return failures;
+}
+
+// Function to self-test every kernel set this CPU can run, returns number of bad words.
+// Only reports: dispatch already skipped any set that failed when it was picked.
+int logic_kernels_self_test(void) {
+    int failures = check_kernel_set(&scalar_kernels);
+#ifdef LOGIC_X86
+    const LogicKernelSet* sets[3] = { &sse2_kernels, &avx2_kernels, &avx512_kernels };
+    int supported[3] = {
+        __builtin_cpu_supports("sse2"), __builtin_cpu_supports("avx2"), __builtin_cpu_supports("avx512f")
+    };
+    for (int i = 0; i < 3; i++) {
+        if (!supported[i]) continue;
+        failures += check_kernel_set(sets[i]);
+    }
+#endif
+    return failures;
+}
+
 // Function to validate binary input
 int is_binary(int x) {
     return (x == 0 || x == 1);
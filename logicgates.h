@@ -1,6 +1,9 @@
 #ifndef LOGICGATES_H
 #define LOGICGATES_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 // Gate function declarations
 int AND(int a, int b);
 int OR(int a, int b);
@@ -9,6 +12,33 @@ int NAND(int a, int b);
 int NOR(int a, int b);
 int XOR(int a, int b);
 
+// Array-wide gate functions over packed words, 64 signals per uint64_t.
+// The widest kernel set the CPU supports (AVX-512, AVX2, SSE2 or portable) is picked once.
+void logic_and_n(uint64_t* dst, const uint64_t* a, const uint64_t* b, size_t nwords);
+void logic_or_n(uint64_t* dst, const uint64_t* a, const uint64_t* b, size_t nwords);
+void logic_not_n(uint64_t* dst, const uint64_t* a, size_t nwords);
+void logic_nand_n(uint64_t* dst, const uint64_t* a, const uint64_t* b, size_t nwords);
+void logic_nor_n(uint64_t* dst, const uint64_t* a, const uint64_t* b, size_t nwords);
+void logic_xor_n(uint64_t* dst, const uint64_t* a, const uint64_t* b, size_t nwords);
+
+// One kernel set: every kernel has the same shape so NOT can share the table (it ignores b)
+typedef void (*LogicKernel)(uint64_t* dst, const uint64_t* a, const uint64_t* b, size_t nwords);
+
+enum { LOGIC_OP_AND, LOGIC_OP_OR, LOGIC_OP_NOT, LOGIC_OP_NAND, LOGIC_OP_NOR, LOGIC_OP_XOR };
+
+typedef struct {
+    const char* isa;
+    LogicKernel op[6];   // indexed by LOGIC_OP_*, the get_gate_name order
+} LogicKernelSet;
+
+// Kernel dispatch and self-test (returns the number of words that disagree with AND/OR/...).
+// logic_kernels_init is thread-safe; call it before starting threads that use the kernels.
+// Hot loops fetch the set once with logic_kernels and call its kernels directly.
+void logic_kernels_init(void);
+const LogicKernelSet* logic_kernels(void);
+const char* logic_kernels_isa(void);
+int logic_kernels_self_test(void);
+
 // Input validation function
 int is_binary(int x);
 
@@ -0,0 +1,410 @@
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "lutmap.h"
+
+// Truth tables of the LUT fanins over 64 rows, fanin j is row bit j
+static const uint64_t fanin_table[LUT_MAX_INPUTS] = {
+    0xAAAAAAAAAAAAAAAAULL, 0xCCCCCCCCCCCCCCCCULL, 0xF0F0F0F0F0F0F0F0ULL,
+    0xFF00FF00FF00FF00ULL, 0xFFFF0000FFFF0000ULL, 0xFFFFFFFF00000000ULL
+};
+
+typedef struct {
+    int leaves[LUT_MAX_INPUTS];     // nodes, ascending
+    int size;
+    unsigned sign;                  // bit (leaf % 32) of every leaf, for quick subset tests
+    int depth;
+    float flow;
+} LutCut;
+
+typedef struct {
+    const Aig* aig;
+    int k;
+    int area_mode;          // order cuts by area flow instead of depth
+    LutCut* cuts;           // 1 + LUT_PRIORITY_CUTS per node, the node itself first
+    int* cut_count;
+    int* arrival;           // LUT levels up to the node through its best cut
+    float* flow;            // area flow of the best cut shared among the readers
+    float* refs;            // estimated readers of the node in the mapping
+    int* required;          // latest level the node may arrive at, INT_MAX if free
+    int* mapped;            // readers of the node in the current mapping
+} Mapper;
+
+static LutCut* node_cuts(const Mapper* m, int node) {
+    return &m->cuts[(size_t)node * (1 + LUT_PRIORITY_CUTS)];
+}
+
+static int is_and(const Aig* aig, int node) {
+    return node > 0 && aig->fanin0[node] >= 0;
+}
+
+// Function to merge the sorted leaves of two cuts. Returns 0 when there are more than k.
+static int cut_merge(const LutCut* a, const LutCut* b, int k, LutCut* cut) {
+    int i = 0, j = 0, size = 0;
+    while (i < a->size || j < b->size) {
+        int leaf;
+        if (j == b->size || (i < a->size && a->leaves[i] < b->leaves[j])) leaf = a->leaves[i++];
+        else if (i == a->size || b->leaves[j] < a->leaves[i]) leaf = b->leaves[j++];
+        else {
+            leaf = a->leaves[i++];
+            j++;
+        }
+        if (size == k) return 0;
+        cut->leaves[size++] = leaf;
+    }
+    cut->size = size;
+    cut->sign = a->sign | b->sign;
+    return 1;
+}
+
+// Function to test whether every leaf of small is a leaf of big
+static int cut_subset(const LutCut* small, const LutCut* big) {
+    if ((small->sign & big->sign) != small->sign || small->size > big->size) return 0;
+    int j = 0;
+    for (int i = 0; i < small->size; i++) {
+        while (j < big->size && big->leaves[j] < small->leaves[i]) j++;
+        if (j == big->size || big->leaves[j] != small->leaves[i]) return 0;
+    }
+    return 1;
+}
+
+// Function to compute the level and area flow of a cut from its leaves
+static void cut_cost(const Mapper* m, LutCut* cut) {
+    cut->depth = 0;
+    cut->flow = 1.0f;
+    for (int i = 0; i < cut->size; i++) {
+        int leaf = cut->leaves[i];
+        if (m->arrival[leaf] > cut->depth) cut->depth = m->arrival[leaf];
+        cut->flow += m->flow[leaf];
+    }
+    cut->depth++;
+}
+
+// Function to order two cuts: fewer levels first when mapping for depth, less
+// area flow first when recovering area
+static int cut_better(const Mapper* m, const LutCut* a, const LutCut* b) {
+    if (m->area_mode) {
+        if (a->flow != b->flow) return a->flow < b->flow;
+        if (a->depth != b->depth) return a->depth < b->depth;
+    } else {
+        if (a->depth != b->depth) return a->depth < b->depth;
+        if (a->flow != b->flow) return a->flow < b->flow;
+    }
+    return a->size < b->size;
+}
+
+// Function to insert a cut into the sorted priority list behind the node's own
+// cut. Cuts whose leaves include another kept cut's leaves are dropped.
+static int cut_insert(const Mapper* m, LutCut* cuts, int count, const LutCut* cut) {
+    for (int i = 1; i < count; i++) {
+        if (cut_subset(&cuts[i], cut)) return count;
+    }
+    int kept = 1;
+    for (int i = 1; i < count; i++) {
+        if (!cut_subset(cut, &cuts[i])) cuts[kept++] = cuts[i];
+    }
+    int pos = kept;
+    while (pos > 1 && cut_better(m, cut, &cuts[pos - 1])) pos--;
+    if (pos > LUT_PRIORITY_CUTS) return kept;
+    if (kept == 1 + LUT_PRIORITY_CUTS) kept--;
+    memmove(&cuts[pos + 1], &cuts[pos], (kept - pos) * sizeof(LutCut));
+    cuts[pos] = *cut;
+    return kept + 1;
+}
+
+// Function to enumerate the priority cuts of a node from those of its fanins and
+// pick the best. When recovering area, the previous best cut stays a candidate
+// and cuts that would arrive after the required level are skipped.
+static void map_node(Mapper* m, int node) {
+    const Aig* aig = m->aig;
+    LutCut* cuts = node_cuts(m, node);
+    int count = 1;
+    if (m->area_mode) {
+        LutCut previous = cuts[1];
+        cut_cost(m, &previous);
+        count = cut_insert(m, cuts, count, &previous);
+    }
+
+    int a = AIG_NODE(aig->fanin0[node]), b = AIG_NODE(aig->fanin1[node]);
+    const LutCut* cuts_a = node_cuts(m, a);
+    const LutCut* cuts_b = node_cuts(m, b);
+    for (int i = 0; i < m->cut_count[a]; i++) {
+        for (int j = 0; j < m->cut_count[b]; j++) {
+            LutCut cut;
+            if (!cut_merge(&cuts_a[i], &cuts_b[j], m->k, &cut)) continue;
+            cut_cost(m, &cut);
+            if (m->area_mode && cut.depth > m->required[node]) continue;
+            count = cut_insert(m, cuts, count, &cut);
+        }
+    }
+    m->cut_count[node] = count;
+    m->arrival[node] = cuts[1].depth;
+    m->flow[node] = cuts[1].flow / m->refs[node];
+}
+
+// Function to count the readers of every node in the mapping given by the best
+// cuts, and set required levels so no output arrives later than it does now.
+// Returns the depth of the mapping.
+static int map_select(Mapper* m) {
+    const Aig* aig = m->aig;
+    int depth = 0;
+    memset(m->mapped, 0, aig->node_count * sizeof(int));
+    for (int v = 0; v < aig->node_count; v++) m->required[v] = INT_MAX;
+    for (int o = 0; o < aig->output_count; o++) {
+        int node = AIG_NODE(aig->outputs[o]);
+        m->mapped[node]++;
+        if (m->arrival[node] > depth) depth = m->arrival[node];
+    }
+    for (int o = 0; o < aig->output_count; o++) {
+        m->required[AIG_NODE(aig->outputs[o])] = depth;
+    }
+    for (int v = aig->node_count - 1; v > 0; v--) {
+        if (!m->mapped[v] || !is_and(aig, v)) continue;
+        const LutCut* best = &node_cuts(m, v)[1];
+        for (int i = 0; i < best->size; i++) {
+            int leaf = best->leaves[i];
+            m->mapped[leaf]++;
+            if (m->required[v] - 1 < m->required[leaf]) m->required[leaf] = m->required[v] - 1;
+        }
+    }
+    return depth;
+}
+
+// Function to compute a cut's truth table by simulating the cone between the
+// leaves and the root; value / stamp are per-node scratch arrays
+static uint64_t cone_table(const Aig* aig, int root, const LutCut* cut, uint64_t* value, int* stamp,
+                           int* stack) {
+    for (int i = 0; i < cut->size; i++) {
+        value[cut->leaves[i]] = fanin_table[i];
+        stamp[cut->leaves[i]] = root;
+    }
+    int top = 0;
+    stack[top++] = root;
+    while (top > 0) {
+        int v = stack[top - 1];
+        if (stamp[v] == root) {
+            top--;
+            continue;
+        }
+        int a = AIG_NODE(aig->fanin0[v]), b = AIG_NODE(aig->fanin1[v]);
+        if (stamp[a] != root) {
+            stack[top++] = a;
+            continue;
+        }
+        if (stamp[b] != root) {
+            stack[top++] = b;
+            continue;
+        }
+        uint64_t va = value[a] ^ (AIG_IS_COMPLEMENT(aig->fanin0[v]) ? ~0ULL : 0);
+        uint64_t vb = value[b] ^ (AIG_IS_COMPLEMENT(aig->fanin1[v]) ? ~0ULL : 0);
+        value[v] = va & vb;
+        stamp[v] = root;
+        top--;
+    }
+    return value[root];
+}
+
+// Function to turn the chosen cuts into the LUT network
+static int map_build(const Mapper* m, LutNetwork* net, int depth) {
+    const Aig* aig = m->aig;
+    int* signal = malloc(aig->node_count * sizeof(int));
+    uint64_t* value = malloc(aig->node_count * sizeof(uint64_t));
+    int* stamp = malloc(aig->node_count * sizeof(int));
+    int* stack = malloc(aig->node_count * sizeof(int));
+    int luts = 0;
+    for (int v = 1; v < aig->node_count; v++) {
+        if (m->mapped[v] && is_and(aig, v)) luts++;
+    }
+    memset(net, 0, sizeof(LutNetwork));
+    net->input_count = aig->input_count;
+    net->lut_count = luts;
+    net->signal_count = 1 + aig->input_count + luts;
+    net->depth = depth;
+    net->output_count = aig->output_count;
+    net->fanin = malloc(((size_t)luts * LUT_MAX_INPUTS + 1) * sizeof(int));
+    net->fanin_count = malloc(luts + 1);
+    net->table = malloc((luts + 1) * sizeof(uint64_t));
+    net->outputs = malloc((aig->output_count + 1) * sizeof(int));
+    if (!signal || !value || !stamp || !stack || !net->fanin || !net->fanin_count || !net->table ||
+        !net->outputs) {
+        free(signal);
+        free(value);
+        free(stamp);
+        free(stack);
+        lut_free(net);
+        return -1;
+    }
+
+    for (int v = 0; v < aig->node_count; v++) stamp[v] = -1;
+    signal[0] = 0;
+    for (int i = 0; i < aig->input_count; i++) {
+        signal[aig->inputs[i]] = 1 + i;
+    }
+    int l = 0;
+    for (int v = 1; v < aig->node_count; v++) {
+        if (!m->mapped[v] || !is_and(aig, v)) continue;
+        const LutCut* best = &node_cuts(m, v)[1];
+        for (int i = 0; i < best->size; i++) {
+            net->fanin[l * LUT_MAX_INPUTS + i] = signal[best->leaves[i]];
+        }
+        net->fanin_count[l] = (unsigned char)best->size;
+        net->table[l] = cone_table(aig, v, best, value, stamp, stack);
+        signal[v] = 1 + aig->input_count + l;
+        l++;
+    }
+    for (int o = 0; o < aig->output_count; o++) {
+        int lit = aig->outputs[o];
+        net->outputs[o] = 2 * signal[AIG_NODE(lit)] + AIG_IS_COMPLEMENT(lit);
+    }
+    free(signal);
+    free(value);
+    free(stamp);
+    free(stack);
+    return 0;
+}
+
+int lut_map(LutNetwork* net, const Aig* aig, int k) {
+    memset(net, 0, sizeof(LutNetwork));
+    if (k < 2 || k > LUT_MAX_INPUTS) return -1;
+    int n = aig->node_count;
+    Mapper m = {0};
+    m.aig = aig;
+    m.k = k;
+    m.cuts = malloc((size_t)n * (1 + LUT_PRIORITY_CUTS) * sizeof(LutCut));
+    m.cut_count = malloc(n * sizeof(int));
+    m.arrival = calloc(n, sizeof(int));
+    m.flow = calloc(n, sizeof(float));
+    m.refs = malloc(n * sizeof(float));
+    m.required = malloc(n * sizeof(int));
+    m.mapped = malloc(n * sizeof(int));
+    int status = -1;
+    if (m.cuts && m.cut_count && m.arrival && m.flow && m.refs && m.required && m.mapped) {
+        // Readers in the graph estimate the readers in the mapping at first
+        for (int v = 0; v < n; v++) m.refs[v] = 0;
+        for (int v = 1; v < n; v++) {
+            if (!is_and(aig, v)) continue;
+            m.refs[AIG_NODE(aig->fanin0[v])] += 1;
+            m.refs[AIG_NODE(aig->fanin1[v])] += 1;
+        }
+        for (int o = 0; o < aig->output_count; o++) {
+            m.refs[AIG_NODE(aig->outputs[o])] += 1;
+        }
+        for (int v = 0; v < n; v++) {
+            LutCut* self = node_cuts(&m, v);
+            self->size = v ? 1 : 0;
+            self->leaves[0] = v;
+            self->sign = v ? 1u << (v % 32) : 0;
+            m.cut_count[v] = 1;
+            if (m.refs[v] < 1) m.refs[v] = 1;
+        }
+
+        for (m.area_mode = 0; m.area_mode <= 1; m.area_mode++) {
+            for (int v = 1; v < n; v++) {
+                if (is_and(aig, v)) map_node(&m, v);
+            }
+            int depth = map_select(&m);
+            // Blend in the readers the mapping actually has
+            for (int v = 0; v < n; v++) {
+                float refs = (m.refs[v] + (m.mapped[v] ? m.mapped[v] : 1)) / 2;
+                m.refs[v] = refs < 1 ? 1 : refs;
+            }
+            if (m.area_mode == 1) status = map_build(&m, net, depth);
+        }
+    }
+    free(m.cuts);
+    free(m.cut_count);
+    free(m.arrival);
+    free(m.flow);
+    free(m.refs);
+    free(m.required);
+    free(m.mapped);
+    return status;
+}
+
+void lut_free(LutNetwork* net) {
+    free(net->fanin);
+    free(net->fanin_count);
+    free(net->table);
+    free(net->outputs);
+    memset(net, 0, sizeof(LutNetwork));
+}
+
+void lut_run(const LutNetwork* net, unsigned char* values) {
+    values[0] = 0;
+    int first = 1 + net->input_count;
+    for (int l = 0; l < net->lut_count; l++) {
+        const int* fanin = &net->fanin[l * LUT_MAX_INPUTS];
+        int index = 0;
+        for (int j = 0; j < net->fanin_count[l]; j++) {
+            index |= values[fanin[j]] << j;
+        }
+        values[first + l] = (unsigned char)((net->table[l] >> index) & 1);
+    }
+}
+
+void lut_run_words(const LutNetwork* net, uint64_t* values, int nwords) {
+    memset(values, 0, nwords * sizeof(uint64_t));
+    int first = 1 + net->input_count;
+    uint64_t mux[1 << (LUT_MAX_INPUTS - 1)];
+    for (int l = 0; l < net->lut_count; l++) {
+        const int* fanin = &net->fanin[l * LUT_MAX_INPUTS];
+        int size = net->fanin_count[l];
+        uint64_t table = net->table[l];
+        uint64_t* dst = values + (size_t)(first + l) * nwords;
+        for (int w = 0; w < nwords; w++) {
+            // The first fanin picks 0, !x, x or 1 for each pair of table bits,
+            // every further fanin halves the words left
+            uint64_t x = values[(size_t)fanin[0] * nwords + w];
+            uint64_t pick[4] = {0, ~x, x, ~0ULL};
+            int count = 1 << (size - 1);
+            for (int i = 0; i < count; i++) {
+                mux[i] = pick[(table >> (2 * i)) & 3];
+            }
+            for (int j = 1; j < size; j++) {
+                x = values[(size_t)fanin[j] * nwords + w];
+                count >>= 1;
+                for (int i = 0; i < count; i++) {
+                    mux[i] = mux[2 * i] ^ ((mux[2 * i] ^ mux[2 * i + 1]) & x);
+                }
+            }
+            dst[w] = mux[0];
+        }
+    }
+}
+
+int lut_truth_table(const LutNetwork* net, TruthTable* table) {
+    int num_inputs = net->input_count;
+    if (truth_table_alloc(table, num_inputs, net->output_count) != 0) {
+        truth_table_free(table);
+        return -1;
+    }
+    uint64_t* scratch = malloc((size_t)net->signal_count * BITSIM_BLOCK_WORDS * sizeof(uint64_t));
+    if (!scratch) {
+        truth_table_free(table);
+        return -1;
+    }
+
+    // Tables smaller than one word only keep their valid rows
+    uint64_t tail_mask = table->num_rows >= 64 ? ~0ULL : ((1ULL << table->num_rows) - 1);
+    for (long long first = 0; first < table->words_per_output; first += BITSIM_BLOCK_WORDS) {
+        long long left = table->words_per_output - first;
+        int block_words = left < BITSIM_BLOCK_WORDS ? (int)left : BITSIM_BLOCK_WORDS;
+        for (int i = 0; i < num_inputs; i++) {
+            uint64_t* in = scratch + (size_t)(1 + i) * block_words;
+            for (int w = 0; w < block_words; w++) {
+                in[w] = bitsim_input_pattern(i, num_inputs, first + w);
+            }
+        }
+        lut_run_words(net, scratch, block_words);
+        for (int o = 0; o < net->output_count; o++) {
+            uint64_t* dst = table->bits + o * table->words_per_output + first;
+            const uint64_t* src = scratch + (size_t)(net->outputs[o] >> 1) * block_words;
+            uint64_t invert = (net->outputs[o] & 1) ? ~0ULL : 0;
+            for (int w = 0; w < block_words; w++) {
+                dst[w] = (src[w] ^ invert) & tail_mask;
+            }
+        }
+    }
+    free(scratch);
+    return 0;
+}
@@ -0,0 +1,49 @@
+#ifndef LUTMAP_H
+#define LUTMAP_H
+
+#include <stdint.h>
+#include "aig.h"
+#include "bitsim.h"
+
+// Largest LUT the mapper builds, its truth table fills one 64-bit word
+#define LUT_MAX_INPUTS 6
+
+// Cuts kept per node while mapping, besides the node itself
+#define LUT_PRIORITY_CUTS 8
+
+// Network of k-input lookup tables. Signal 0 is the constant 0, signals
+// 1 .. input_count the inputs, then one signal per LUT in topological order.
+typedef struct {
+    int input_count;
+    int lut_count;
+    int signal_count;
+    int* fanin;                 // LUT_MAX_INPUTS signals per LUT, fanin_count used
+    unsigned char* fanin_count;
+    uint64_t* table;            // bit i is the value when fanin j carries bit j of i
+    int depth;                  // LUTs on the longest input-to-output path
+    int output_count;
+    int* outputs;               // 2 * signal + complement
+} LutNetwork;
+
+// Cover the graph with LUTs of up to k inputs (2 <= k <= LUT_MAX_INPUTS). Priority
+// cuts are chosen for the fewest LUT levels first, then re-chosen by area flow
+// wherever that keeps the depth. Input i and output o of the graph become input
+// i and output o of the network. Returns 0 on success, -1 when out of memory.
+int lut_map(LutNetwork* net, const Aig* aig, int k);
+void lut_free(LutNetwork* net);
+
+// Evaluate one vector: values holds signal_count entries, the caller fills the
+// inputs, signal 0 and the LUTs are written. Each LUT is one table lookup.
+void lut_run(const LutNetwork* net, unsigned char* values);
+
+// Evaluate nwords * 64 vectors, signal s in values[s * nwords .. + nwords).
+// Each LUT reduces its table to a word through a multiplexer tree on its fanins.
+void lut_run_words(const LutNetwork* net, uint64_t* values, int nwords);
+
+// Value of output o after lut_run
+#define LUT_OUTPUT(net, values, o) ((values)[(net)->outputs[o] >> 1] ^ ((net)->outputs[o] & 1))
+
+// Full truth table of the network, BITSIM_BLOCK_WORDS words of rows per pass
+int lut_truth_table(const LutNetwork* net, TruthTable* table);
+
+#endif
@@ -0,0 +1,913 @@
+#include <stdlib.h>
+#include <string.h>
+#include "minimize.h"
+
+// Cubes in a cover before expansion stops scanning it for cubes to swallow
+#define MINIMIZE_EXPAND_SCAN 4096
+
+// Reduce / expand / irredundant rounds of the heuristic loop
+#define MINIMIZE_MAX_PASSES 8
+
+// Row visits allowed when counting which primes cover each minterm
+#define MINIMIZE_MAX_PRIME_ROWS (1LL << 26)
+
+// Words of column bitsets allowed for the branch-and-bound covering matrix
+#define MINIMIZE_MAX_MATRIX_WORDS (1LL << 22)
+
+// Cover cost: fewer cubes first, then fewer literals
+#define MINIMIZE_CUBE_WEIGHT (1LL << 32)
+
+// Within-word masks of the rows whose bit b (b < 6) is 0
+static const uint64_t low_half[6] = {
+    0x5555555555555555ULL, 0x3333333333333333ULL, 0x0F0F0F0F0F0F0F0FULL,
+    0x00FF00FF00FF00FFULL, 0x0000FFFF0000FFFFULL, 0x00000000FFFFFFFFULL
+};
+
+static uint32_t full_mask(int n) {
+    return n >= 32 ? 0xFFFFFFFFu : (1u << n) - 1;
+}
+
+static int cube_literals(const SopCube* cube) {
+    return __builtin_popcount(cube->care);
+}
+
+// Function to append a cube to a cover
+static int cover_add(SopCover* cover, uint32_t care, uint32_t value) {
+    if (cover->count == cover->capacity) {
+        int capacity = cover->capacity ? cover->capacity * 2 : 16;
+        SopCube* cubes = realloc(cover->cubes, capacity * sizeof(SopCube));
+        if (!cubes) return -1;
+        cover->cubes = cubes;
+        cover->capacity = capacity;
+    }
+    cover->cubes[cover->count].care = care;
+    cover->cubes[cover->count].value = value & care;
+    cover->count++;
+    return 0;
+}
+
+void sop_cover_free(SopCover* cover) {
+    free(cover->cubes);
+    cover->cubes = NULL;
+    cover->count = 0;
+    cover->capacity = 0;
+}
+
+int sop_literal_count(const SopCover* cover) {
+    int literals = 0;
+    for (int i = 0; i < cover->count; i++) {
+        literals += cube_literals(&cover->cubes[i]);
+    }
+    return literals;
+}
+
+// Function to compute dst(r) = src(r) & src(r ^ (1 << bit)): the rows that stay
+// set when row bit `bit` becomes a don't-care
+static void and_neighbour(uint64_t* dst, const uint64_t* src, long long words, int bit) {
+    if (bit >= 6) {
+        long long k = 1LL << (bit - 6);
+        for (long long w = 0; w < words; w++) {
+            dst[w] = src[w] & src[w ^ k];
+        }
+    } else {
+        int shift = 1 << bit;
+        uint64_t m = low_half[bit];
+        for (long long w = 0; w < words; w++) {
+            uint64_t x = src[w];
+            dst[w] = x & (((x >> shift) & m) | ((x & m) << shift));
+        }
+    }
+}
+
+// Function to build the mask of the rows of a cube inside one 64-row word
+static uint64_t cube_low_mask(uint32_t care, uint32_t value, int n) {
+    uint64_t mask = n >= 6 ? ~0ULL : ((1ULL << (1 << n)) - 1);
+    for (int b = 0; b < 6 && b < n; b++) {
+        if (!((care >> b) & 1)) continue;
+        mask &= ((value >> b) & 1) ? ~low_half[b] : low_half[b];
+    }
+    return mask;
+}
+
+// Function to test that every row of a cube is set in a truth-table bitset.
+// The words of the cube are the submasks of its don't-care bits above bit 5.
+static int cube_in_set(const uint64_t* f, int n, uint32_t care, uint32_t value) {
+    uint64_t low = cube_low_mask(care, value, n);
+    uint32_t dash = (~care & full_mask(n)) >> 6;
+    uint32_t base = (value & care) >> 6;
+    uint32_t s = 0;
+    do {
+        if ((f[base | s] & low) != low) return 0;
+        s = (s - dash) & dash;
+    } while (s);
+    return 1;
+}
+
+// Function to clear every row of a cube in a bitset
+static void cube_clear(uint64_t* f, int n, uint32_t care, uint32_t value) {
+    uint64_t low = cube_low_mask(care, value, n);
+    uint32_t dash = (~care & full_mask(n)) >> 6;
+    uint32_t base = (value & care) >> 6;
+    uint32_t s = 0;
+    do {
+        f[base | s] &= ~low;
+        s = (s - dash) & dash;
+    } while (s);
+}
+
+// Function to order cubes by literal count, then by their rows
+static int compare_cubes(const void* a, const void* b) {
+    const SopCube* x = (const SopCube*)a;
+    const SopCube* y = (const SopCube*)b;
+    int lx = cube_literals(x), ly = cube_literals(y);
+    if (lx != ly) return lx - ly;
+    if (x->care != y->care) return x->care > y->care ? -1 : 1;
+    if (x->value != y->value) return x->value > y->value ? -1 : 1;
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Exact minimization: all primes from the bitset, then a minimum cover
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    int n;
+    long long words;
+    uint64_t* buffers;      // per depth, one neighbour bitset per variable
+    SopCube* primes;
+    int count;
+    int overflow;
+} PrimeSearch;
+
+// Function to collect the primes whose don't-care set is exactly `dash`.
+// f holds the rows r whose whole cube (r with the dash bits free) is in the
+// ON-set; such a cube is prime when no further bit can be freed. Children add
+// one dash bit above the highest one, so every dash set is visited once, and
+// empty bitsets cut off all their supersets.
+static void collect_primes(PrimeSearch* ps, const uint64_t* f, uint32_t dash, int depth) {
+    int n = ps->n;
+    long long words = ps->words;
+    uint64_t* children = ps->buffers + (size_t)depth * n * words;
+    uint32_t nonempty = 0;
+    for (int v = 0; v < n; v++) {
+        if ((dash >> v) & 1) continue;
+        uint64_t* child = children + (size_t)v * words;
+        and_neighbour(child, f, words, v);
+        for (long long w = 0; w < words; w++) {
+            if (child[w]) {
+                nonempty |= 1u << v;
+                break;
+            }
+        }
+    }
+
+    // Each cube is reported at its row with all dash bits 0
+    uint64_t low = cube_low_mask(dash, 0, n);
+    uint32_t high_dash = dash >> 6;
+    uint32_t care = full_mask(n) & ~dash;
+    for (long long w = 0; w < words && !ps->overflow; w++) {
+        if (w & high_dash) continue;
+        uint64_t x = f[w] & low;
+        for (int v = 0; v < n && x; v++) {
+            if ((nonempty >> v) & 1) x &= ~children[(size_t)v * words + w];
+        }
+        while (x) {
+            if (ps->count == MINIMIZE_MAX_PRIMES) {
+                ps->overflow = 1;
+                break;
+            }
+            ps->primes[ps->count].care = care;
+            ps->primes[ps->count].value = (uint32_t)(w * 64 + __builtin_ctzll(x));
+            ps->count++;
+            x &= x - 1;
+        }
+    }
+
+    int top = dash ? 31 - __builtin_clz(dash) : -1;
+    for (int v = top + 1; v < n && !ps->overflow; v++) {
+        if ((nonempty >> v) & 1) {
+            collect_primes(ps, children + (size_t)v * words, dash | (1u << v), depth + 1);
+        }
+    }
+}
+
+typedef struct {
+    int rows;
+    int cols;
+    long long row_words;
+    uint64_t* col_bits;     // rows covered by each column
+    long long* col_cost;
+    int* row_start;         // columns covering row r: row_cols[row_start[r] .. row_start[r + 1])
+    int* row_cols;
+    uint64_t* covered;      // one bitset per search depth
+    int max_depth;
+    unsigned char* used;
+    int* stack;
+    int* best;
+    int best_count;
+    long long best_cost;
+    long long work;
+} CoverSearch;
+
+// Function to search covers of the rows left after the essential primes.
+// The bound adds, for a set of rows that share no column, the cheapest
+// column of each: every cover needs one distinct column per such row.
+static void search_cover(CoverSearch* cs, int depth, long long cost) {
+    uint64_t* covered = cs->covered + (size_t)depth * cs->row_words;
+    memset(cs->used, 0, cs->cols);
+    long long bound = 0;
+    int branch_row = -1;
+    int branch_width = 0;
+    for (int r = 0; r < cs->rows; r++) {
+        if ((covered[r / 64] >> (r % 64)) & 1) continue;
+        int width = cs->row_start[r + 1] - cs->row_start[r];
+        if (branch_row < 0 || width < branch_width) {
+            branch_row = r;
+            branch_width = width;
+        }
+        int independent = 1;
+        long long cheapest = -1;
+        for (int k = cs->row_start[r]; k < cs->row_start[r + 1]; k++) {
+            int c = cs->row_cols[k];
+            if (cs->used[c]) independent = 0;
+            if (cheapest < 0 || cs->col_cost[c] < cheapest) cheapest = cs->col_cost[c];
+        }
+        if (!independent) continue;
+        bound += cheapest;
+        for (int k = cs->row_start[r]; k < cs->row_start[r + 1]; k++) {
+            cs->used[cs->row_cols[k]] = 1;
+        }
+    }
+    if (cost + bound >= cs->best_cost) return;
+    if (branch_row < 0) {
+        memcpy(cs->best, cs->stack, depth * sizeof(int));
+        cs->best_count = depth;
+        cs->best_cost = cost;
+        return;
+    }
+    cs->work += cs->rows + cs->cols + cs->row_start[cs->rows];
+    if (depth >= cs->max_depth || cs->work > MINIMIZE_MAX_SEARCH_WORK) return;
+
+    uint64_t* next = covered + cs->row_words;
+    for (int k = cs->row_start[branch_row]; k < cs->row_start[branch_row + 1]; k++) {
+        int c = cs->row_cols[k];
+        const uint64_t* bits = cs->col_bits + (size_t)c * cs->row_words;
+        for (long long w = 0; w < cs->row_words; w++) {
+            next[w] = covered[w] | bits[w];
+        }
+        cs->stack[depth] = c;
+        search_cover(cs, depth + 1, cost + cs->col_cost[c]);
+        if (cs->work > MINIMIZE_MAX_SEARCH_WORK) return;
+    }
+}
+
+// Function to pick a minimum set of primes covering every ON row: essential
+// primes first, then branch and bound on what is left, seeded with a greedy
+// cover. Returns 1 if the problem is too large for this method.
+static int cover_primes(int n, const SopCube* primes, int count, SopCover* cover) {
+    long long rows = 1LL << n;
+    long long visits = 0;
+    for (int p = 0; p < count; p++) {
+        visits += 1LL << (n - cube_literals(&primes[p]));
+    }
+    if (visits > MINIMIZE_MAX_PRIME_ROWS) return 1;
+
+    int* coverers = calloc(rows, sizeof(int));
+    int* owner = malloc(rows * sizeof(int));
+    int* row_id = malloc(rows * sizeof(int));
+    unsigned char* chosen = calloc(count + 1, 1);
+    if (!coverers || !owner || !row_id || !chosen) {
+        free(coverers);
+        free(owner);
+        free(row_id);
+        free(chosen);
+        return -1;
+    }
+    uint32_t full = full_mask(n);
+    for (int p = 0; p < count; p++) {
+        uint32_t dash = ~primes[p].care & full;
+        uint32_t s = 0;
+        do {
+            uint32_t r = primes[p].value | s;
+            coverers[r]++;
+            owner[r] = p;
+            s = (s - dash) & dash;
+        } while (s);
+    }
+
+    // Essential primes: the only cover of some row
+    for (long long r = 0; r < rows; r++) {
+        if (coverers[r] == 1) chosen[owner[r]] = 1;
+    }
+    for (long long r = 0; r < rows; r++) {
+        row_id[r] = -1;
+    }
+    int* essential_covered = owner;     // reused: 1 when an essential prime covers the row
+    memset(essential_covered, 0, rows * sizeof(int));
+    for (int p = 0; p < count; p++) {
+        if (!chosen[p]) continue;
+        if (cover_add(cover, primes[p].care, primes[p].value) != 0) {
+            free(coverers);
+            free(owner);
+            free(row_id);
+            free(chosen);
+            return -1;
+        }
+        uint32_t dash = ~primes[p].care & full;
+        uint32_t s = 0;
+        do {
+            essential_covered[primes[p].value | s] = 1;
+            s = (s - dash) & dash;
+        } while (s);
+    }
+    int left = 0;
+    for (long long r = 0; r < rows; r++) {
+        if (coverers[r] > 0 && !essential_covered[r]) row_id[r] = left++;
+    }
+    free(coverers);
+    free(owner);
+    if (left == 0) {
+        free(row_id);
+        free(chosen);
+        cover->exact = 1;
+        return 0;
+    }
+
+    // Covering matrix over the rows still open and the primes touching them
+    CoverSearch cs = {0};
+    cs.rows = left;
+    cs.row_words = (left + 63) / 64;
+    int* col_prime = malloc(count * sizeof(int));
+    if (!col_prime) {
+        free(row_id);
+        free(chosen);
+        return -1;
+    }
+    for (int p = 0; p < count; p++) {
+        if (chosen[p]) continue;
+        uint32_t dash = ~primes[p].care & full;
+        uint32_t s = 0;
+        do {
+            if (row_id[primes[p].value | s] >= 0) {
+                col_prime[cs.cols++] = p;
+                break;
+            }
+            s = (s - dash) & dash;
+        } while (s);
+    }
+    free(chosen);
+    if ((long long)cs.cols * cs.row_words > MINIMIZE_MAX_MATRIX_WORDS) {
+        free(col_prime);
+        free(row_id);
+        return 1;
+    }
+
+    cs.col_bits = calloc((size_t)cs.cols * cs.row_words, sizeof(uint64_t));
+    cs.col_cost = malloc(cs.cols * sizeof(long long));
+    cs.row_start = calloc(left + 2, sizeof(int));
+    cs.used = malloc(cs.cols + 1);
+    cs.stack = malloc((left + 1) * sizeof(int));
+    cs.best = malloc((left + 1) * sizeof(int));
+    uint64_t* uncovered = malloc(cs.row_words * sizeof(uint64_t));
+    if (!cs.col_bits || !cs.col_cost || !cs.row_start || !cs.used || !cs.stack || !cs.best || !uncovered) {
+        free(cs.col_bits);
+        free(cs.col_cost);
+        free(cs.row_start);
+        free(cs.used);
+        free(cs.stack);
+        free(cs.best);
+        free(uncovered);
+        free(col_prime);
+        free(row_id);
+        return -1;
+    }
+    long long entries = 0;
+    for (int c = 0; c < cs.cols; c++) {
+        const SopCube* prime = &primes[col_prime[c]];
+        uint64_t* bits = cs.col_bits + (size_t)c * cs.row_words;
+        cs.col_cost[c] = MINIMIZE_CUBE_WEIGHT + cube_literals(prime);
+        uint32_t dash = ~prime->care & full;
+        uint32_t s = 0;
+        do {
+            int id = row_id[prime->value | s];
+            if (id >= 0) {
+                bits[id / 64] |= 1ULL << (id % 64);
+                cs.row_start[id + 1]++;
+                entries++;
+            }
+            s = (s - dash) & dash;
+        } while (s);
+    }
+    free(row_id);
+    for (int r = 0; r < left; r++) {
+        cs.row_start[r + 1] += cs.row_start[r];
+    }
+    cs.row_cols = malloc((entries + 1) * sizeof(int));
+    int* fill = malloc((left + 1) * sizeof(int));
+    if (!cs.row_cols || !fill) {
+        free(cs.row_cols);
+        free(fill);
+        free(cs.col_bits);
+        free(cs.col_cost);
+        free(cs.row_start);
+        free(cs.used);
+        free(cs.stack);
+        free(cs.best);
+        free(uncovered);
+        free(col_prime);
+        return -1;
+    }
+    memcpy(fill, cs.row_start, left * sizeof(int));
+    for (int c = 0; c < cs.cols; c++) {
+        const uint64_t* bits = cs.col_bits + (size_t)c * cs.row_words;
+        for (long long w = 0; w < cs.row_words; w++) {
+            uint64_t x = bits[w];
+            while (x) {
+                int r = (int)(w * 64 + __builtin_ctzll(x));
+                cs.row_cols[fill[r]++] = c;
+                x &= x - 1;
+            }
+        }
+    }
+    free(fill);
+
+    // Greedy cover first: it bounds both the cost and the depth of the search
+    for (long long w = 0; w < cs.row_words; w++) {
+        uncovered[w] = ~0ULL;
+    }
+    if (left % 64) uncovered[cs.row_words - 1] = (1ULL << (left % 64)) - 1;
+    cs.best_cost = 0;
+    for (;;) {
+        int pick = -1;
+        int pick_gain = 0;
+        for (int c = 0; c < cs.cols; c++) {
+            const uint64_t* bits = cs.col_bits + (size_t)c * cs.row_words;
+            int gain = 0;
+            for (long long w = 0; w < cs.row_words; w++) {
+                gain += __builtin_popcountll(bits[w] & uncovered[w]);
+            }
+            if (gain > pick_gain || (gain == pick_gain && gain > 0 && cs.col_cost[c] < cs.col_cost[pick])) {
+                pick = c;
+                pick_gain = gain;
+            }
+        }
+        if (pick < 0) break;
+        const uint64_t* bits = cs.col_bits + (size_t)pick * cs.row_words;
+        for (long long w = 0; w < cs.row_words; w++) {
+            uncovered[w] &= ~bits[w];
+        }
+        cs.best[cs.best_count++] = pick;
+        cs.best_cost += cs.col_cost[pick];
+    }
+    free(uncovered);
+
+    cs.max_depth = cs.best_count;
+    cs.covered = calloc((size_t)(cs.max_depth + 1) * cs.row_words, sizeof(uint64_t));
+    if (cs.covered) {
+        search_cover(&cs, 0, 0);
+        cover->exact = cs.work <= MINIMIZE_MAX_SEARCH_WORK;
+    }
+
+    int result = 0;
+    for (int k = 0; k < cs.best_count && result == 0; k++) {
+        const SopCube* prime = &primes[col_prime[cs.best[k]]];
+        result = cover_add(cover, prime->care, prime->value);
+    }
+    free(cs.covered);
+    free(cs.row_cols);
+    free(cs.col_bits);
+    free(cs.col_cost);
+    free(cs.row_start);
+    free(cs.used);
+    free(cs.stack);
+    free(cs.best);
+    free(col_prime);
+    return result;
+}
+
+// Function to minimize exactly, returns 1 when there are too many primes
+static int minimize_exact(const uint64_t* f, int n, long long words, SopCover* cover) {
+    PrimeSearch ps = {0};
+    ps.n = n;
+    ps.words = words;
+    ps.buffers = malloc((size_t)n * n * words * sizeof(uint64_t));
+    ps.primes = malloc(MINIMIZE_MAX_PRIMES * sizeof(SopCube));
+    if (!ps.buffers || !ps.primes) {
+        free(ps.buffers);
+        free(ps.primes);
+        return -1;
+    }
+    collect_primes(&ps, f, 0, 0);
+    free(ps.buffers);
+    int result = ps.overflow ? 1 : cover_primes(n, ps.primes, ps.count, cover);
+    free(ps.primes);
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// Heuristic minimization: Espresso's expand / irredundant / reduce loop.
+// The ON-set bitset decides which cubes are implicants, containment questions
+// between cubes are answered by cofactoring the cover (no bitsets needed).
+// ---------------------------------------------------------------------------
+
+// Function to cofactor a cover by a cube: drop the cubes disjoint from it and
+// free the variables it fixes. Cube `skip` is left out (-1 = none).
+static int cofactor(const SopCube* in, int count, uint32_t care, uint32_t value, int skip, SopCube* out) {
+    int k = 0;
+    for (int i = 0; i < count; i++) {
+        if (i == skip || ((in[i].care & care) & (in[i].value ^ value))) continue;
+        out[k].care = in[i].care & ~care;
+        out[k].value = in[i].value & ~care;
+        k++;
+    }
+    return k;
+}
+
+// Function to find the variable among `mask` that appears in the most cubes
+static int most_frequent_var(const SopCube* cubes, int count, uint32_t mask) {
+    int frequency[32] = {0};
+    for (int i = 0; i < count; i++) {
+        uint32_t x = cubes[i].care & mask;
+        while (x) {
+            frequency[__builtin_ctz(x)]++;
+            x &= x - 1;
+        }
+    }
+    int var = __builtin_ctz(mask);
+    for (int v = 0; v < 32; v++) {
+        if (frequency[v] > frequency[var]) var = v;
+    }
+    return var;
+}
+
+// Function to test whether a cover contains every row. Out of memory answers
+// "no", which only makes the callers keep a cube.
+static int tautology(const SopCube* cubes, int count) {
+    if (count == 0) return 0;
+    uint32_t positive = 0, negative = 0;
+    for (int i = 0; i < count; i++) {
+        if (cubes[i].care == 0) return 1;
+        positive |= cubes[i].care & cubes[i].value;
+        negative |= cubes[i].care & ~cubes[i].value;
+    }
+    // A unate cover is a tautology only through a universal cube
+    uint32_t binate = positive & negative;
+    if (!binate) return 0;
+
+    SopCube* half = malloc(count * sizeof(SopCube));
+    if (!half) return 0;
+    uint32_t bit = 1u << most_frequent_var(cubes, count, binate);
+    int result = tautology(half, cofactor(cubes, count, bit, bit, -1, half)) &&
+                 tautology(half, cofactor(cubes, count, bit, 0, -1, half));
+    free(half);
+    return result;
+}
+
+// Function to find the smallest cube containing the complement of a cover.
+// Returns 0 when the complement is empty.
+static int complement_supercube(const SopCube* cubes, int count, SopCube* result) {
+    result->care = 0;
+    result->value = 0;
+    if (count == 0) return 1;
+    uint32_t used = 0;
+    for (int i = 0; i < count; i++) {
+        if (cubes[i].care == 0) return 0;
+        used |= cubes[i].care;
+    }
+    if (count == 1) {
+        // The complement of a cube is one cube per literal, their supercube is
+        // the whole space unless there is a single literal
+        if (cube_literals(&cubes[0]) == 1) {
+            result->care = cubes[0].care;
+            result->value = ~cubes[0].value & cubes[0].care;
+        }
+        return 1;
+    }
+
+    SopCube* half = malloc(count * sizeof(SopCube));
+    if (!half) return 1;
+    uint32_t bit = 1u << most_frequent_var(cubes, count, used);
+    SopCube part[2];
+    int found[2];
+    for (int side = 0; side < 2; side++) {
+        int k = cofactor(cubes, count, bit, side ? bit : 0, -1, half);
+        found[side] = complement_supercube(half, k, &part[side]);
+        part[side].care |= bit;
+        part[side].value |= side ? bit : 0;
+    }
+    free(half);
+    if (!found[0] && !found[1]) return 0;
+    if (!found[0] || !found[1]) {
+        *result = found[0] ? part[0] : part[1];
+        return 1;
+    }
+    result->care = part[0].care & part[1].care & ~(part[0].value ^ part[1].value);
+    result->value = part[0].value & result->care;
+    return 1;
+}
+
+// Function to raise literals of a cube while it stays inside the ON-set,
+// preferring the literal whose removal swallows the most other cubes
+static void expand_cube(const uint64_t* f, int n, const SopCube* cubes, int count, int self, SopCube* c) {
+    uint32_t candidates = c->care;
+    while (candidates) {
+        // A literal that cannot be raised now cannot be raised from a larger cube either
+        uint32_t raisable = 0;
+        for (uint32_t x = candidates; x; x &= x - 1) {
+            uint32_t bit = x & -x;
+            if (cube_in_set(f, n, c->care, c->value ^ bit)) raisable |= bit;
+        }
+        candidates = raisable;
+        if (!candidates) break;
+
+        uint32_t pick = candidates & -candidates;
+        if (count <= MINIMIZE_EXPAND_SCAN) {
+            int best = -1;
+            for (uint32_t x = candidates; x; x &= x - 1) {
+                uint32_t bit = x & -x;
+                uint32_t care = c->care & ~bit;
+                int swallowed = 0;
+                for (int j = 0; j < count; j++) {
+                    if (j != self && (cubes[j].care & care) == care && ((cubes[j].value ^ c->value) & care) == 0) {
+                        swallowed++;
+                    }
+                }
+                if (swallowed > best) {
+                    best = swallowed;
+                    pick = bit;
+                }
+            }
+        }
+        c->care &= ~pick;
+        c->value &= ~pick;
+        candidates &= ~pick;
+    }
+}
+
+// Function to drop cubes contained in another cube of the cover
+static void remove_contained(SopCover* cover) {
+    int k = 0;
+    for (int i = 0; i < cover->count; i++) {
+        const SopCube* c = &cover->cubes[i];
+        int contained = 0;
+        for (int j = 0; j < cover->count && !contained; j++) {
+            const SopCube* d = &cover->cubes[j];
+            if (j == i || (d->care & c->care) != d->care || ((c->value ^ d->value) & d->care)) continue;
+            // Equal cubes: keep the first one
+            contained = d->care != c->care || j < i;
+        }
+        if (!contained) cover->cubes[k++] = *c;
+    }
+    cover->count = k;
+}
+
+// Function to drop cubes covered by the rest of the cover, smallest cubes first
+static void irredundant(SopCover* cover, SopCube* scratch) {
+    qsort(cover->cubes, cover->count, sizeof(SopCube), compare_cubes);
+    for (int i = cover->count - 1; i >= 0; i--) {
+        const SopCube* c = &cover->cubes[i];
+        int k = cofactor(cover->cubes, cover->count, c->care, c->value, i, scratch);
+        if (tautology(scratch, k)) {
+            memmove(&cover->cubes[i], &cover->cubes[i + 1], (cover->count - i - 1) * sizeof(SopCube));
+            cover->count--;
+        }
+    }
+}
+
+// Function to shrink each cube, largest first, to the smallest cube holding
+// the rows no other cube covers. This gives expand room to find new primes.
+static void reduce(SopCover* cover, SopCube* scratch) {
+    qsort(cover->cubes, cover->count, sizeof(SopCube), compare_cubes);
+    for (int i = 0; i < cover->count; i++) {
+        SopCube* c = &cover->cubes[i];
+        int k = cofactor(cover->cubes, cover->count, c->care, c->value, i, scratch);
+        SopCube rest;
+        if (!complement_supercube(scratch, k, &rest)) {
+            memmove(&cover->cubes[i], &cover->cubes[i + 1], (cover->count - i - 1) * sizeof(SopCube));
+            cover->count--;
+            i--;
+            continue;
+        }
+        c->care |= rest.care;
+        c->value |= rest.value;
+    }
+}
+
+static long long cover_cost(const SopCover* cover) {
+    return cover->count * MINIMIZE_CUBE_WEIGHT + sop_literal_count(cover);
+}
+
+static int espresso(const uint64_t* f, int n, long long words, SopCover* cover) {
+    // Start from primes grown out of the first ON row not covered yet
+    uint64_t* remaining = malloc(words * sizeof(uint64_t));
+    if (!remaining) return -1;
+    memcpy(remaining, f, words * sizeof(uint64_t));
+    uint32_t full = full_mask(n);
+    for (long long w = 0; w < words; w++) {
+        while (remaining[w]) {
+            SopCube c;
+            c.care = full;
+            c.value = (uint32_t)(w * 64 + __builtin_ctzll(remaining[w]));
+            expand_cube(f, n, cover->cubes, cover->count, -1, &c);
+            if (cover_add(cover, c.care, c.value) != 0) {
+                free(remaining);
+                return -1;
+            }
+            cube_clear(remaining, n, c.care, c.value);
+        }
+    }
+    free(remaining);
+
+    SopCube* scratch = malloc((cover->count + 1) * sizeof(SopCube));
+    SopCover best = {0};
+    best.cubes = malloc((cover->count + 1) * sizeof(SopCube));
+    if (!scratch || !best.cubes) {
+        free(scratch);
+        free(best.cubes);
+        return -1;
+    }
+    best.capacity = cover->count + 1;
+    irredundant(cover, scratch);
+    for (int pass = 0; pass < MINIMIZE_MAX_PASSES; pass++) {
+        best.count = cover->count;
+        memcpy(best.cubes, cover->cubes, cover->count * sizeof(SopCube));
+        reduce(cover, scratch);
+        for (int i = 0; i < cover->count; i++) {
+            expand_cube(f, n, cover->cubes, cover->count, i, &cover->cubes[i]);
+        }
+        remove_contained(cover);
+        irredundant(cover, scratch);
+        if (cover_cost(cover) >= cover_cost(&best)) break;
+    }
+    // Reduce never grows the cover, so the last round fits in the same memory
+    if (cover_cost(&best) < cover_cost(cover)) {
+        cover->count = best.count;
+        memcpy(cover->cubes, best.cubes, best.count * sizeof(SopCube));
+    }
+    free(best.cubes);
+    free(scratch);
+    return 0;
+}
+
+int sop_minimize(const TruthTable* table, int output, SopCover* cover) {
+    int n = table->num_inputs;
+    long long words = table->words_per_output;
+    const uint64_t* f = table->bits + output * words;
+    memset(cover, 0, sizeof(SopCover));
+    cover->num_inputs = n;
+
+    // Constants need no search
+    uint64_t last = table->num_rows % 64 ? (1ULL << (table->num_rows % 64)) - 1 : ~0ULL;
+    int zeros = 1, ones = 1;
+    for (long long w = 0; w < words; w++) {
+        uint64_t valid = w == words - 1 ? last : ~0ULL;
+        if (f[w] & valid) zeros = 0;
+        if ((f[w] & valid) != valid) ones = 0;
+    }
+    if (zeros || ones) {
+        cover->exact = 1;
+        return ones ? cover_add(cover, 0, 0) : 0;
+    }
+
+    if (n <= MINIMIZE_EXACT_MAX_INPUTS) {
+        int result = minimize_exact(f, n, words, cover);
+        if (result <= 0) {
+            qsort(cover->cubes, cover->count, sizeof(SopCube), compare_cubes);
+            return result;
+        }
+        cover->count = 0;
+        cover->exact = 0;
+    }
+    if (espresso(f, n, words, cover) != 0) return -1;
+    qsort(cover->cubes, cover->count, sizeof(SopCube), compare_cubes);
+    return 0;
+}
+
+void sop_print(const SopCover* cover, FILE* out, int max_terms) {
+    if (cover->count == 0) {
+        fprintf(out, "0");
+        return;
+    }
+    for (int j = 0; j < cover->count; j++) {
+        const SopCube* c = &cover->cubes[j];
+        if (j > 0) fprintf(out, " + ");
+        if (j == max_terms) {
+            fprintf(out, "...");
+            return;
+        }
+        if (c->care == 0) {
+            fprintf(out, "1");
+            continue;
+        }
+        int first = 1;
+        for (int i = 0; i < cover->num_inputs; i++) {
+            uint32_t bit = 1u << (cover->num_inputs - 1 - i);
+            if (!(c->care & bit)) continue;
+            fprintf(out, "%sI%d%s", first ? "" : " ", i + 1, (c->value & bit) ? "" : "'");
+            first = 0;
+        }
+    }
+}
+
+// Function to combine signals pairwise into a balanced tree of one gate type
+static int build_tree(SimNetlist* net, int* gate_count, int op, int* terms, int count) {
+    while (count > 1) {
+        int k = 0;
+        for (int i = 0; i + 1 < count; i += 2) {
+            int g = (*gate_count)++;
+            net->types[g] = op;
+            net->fanin[g * SIM_MAX_PINS] = terms[i];
+            net->fanin[g * SIM_MAX_PINS + 1] = terms[i + 1];
+            terms[k++] = g;
+        }
+        if (count % 2) terms[k++] = terms[count - 1];
+        count = k;
+    }
+    return terms[0];
+}
+
+int sop_build_netlist(const SopCover* covers, int num_outputs, SimNetlist* net,
+                      int* input_gates, int* output_gates) {
+    int n = num_outputs > 0 ? covers[0].num_inputs : 0;
+    int total_cubes = 0, max_cubes = 0;
+    int bound = 2 * n + 1 + num_outputs;
+    for (int o = 0; o < num_outputs; o++) {
+        total_cubes += covers[o].count;
+        if (covers[o].count > max_cubes) max_cubes = covers[o].count;
+        bound += covers[o].count + sop_literal_count(&covers[o]);
+    }
+    if (sim_netlist_init(net, bound) != 0) return -1;
+    int* inverter = malloc((n + 1) * sizeof(int));
+    int* literals = malloc((n + 1) * sizeof(int));
+    int* products = malloc((max_cubes + 1) * sizeof(int));
+    int* roots = malloc((num_outputs + 1) * sizeof(int));
+    SopCube* built = malloc((total_cubes + 1) * sizeof(SopCube));
+    int* built_gate = malloc((total_cubes + 1) * sizeof(int));
+    if (!inverter || !literals || !products || !roots || !built || !built_gate) {
+        free(inverter);
+        free(literals);
+        free(products);
+        free(roots);
+        free(built);
+        free(built_gate);
+        sim_netlist_free(net);
+        return -1;
+    }
+
+    int gates = 0;
+    int built_count = 0;
+    int constant_one = -1;
+    for (int i = 0; i < n; i++) {
+        net->types[gates] = SIM_INPUT;
+        input_gates[i] = gates++;
+        inverter[i] = -1;
+    }
+    for (int o = 0; o < num_outputs; o++) {
+        for (int j = 0; j < covers[o].count; j++) {
+            const SopCube* c = &covers[o].cubes[j];
+            int g = -1;
+            for (int k = 0; k < built_count && g < 0; k++) {
+                if (built[k].care == c->care && built[k].value == c->value) g = built_gate[k];
+            }
+            if (g < 0 && c->care == 0) {
+                // NOT of an unconnected pin reads the constant-0 slot
+                if (constant_one < 0) {
+                    net->types[gates] = SIM_NOT;
+                    constant_one = gates++;
+                }
+                g = constant_one;
+            } else if (g < 0) {
+                int count = 0;
+                for (int i = 0; i < n; i++) {
+                    uint32_t bit = 1u << (n - 1 - i);
+                    if (!(c->care & bit)) continue;
+                    if (!(c->value & bit) && inverter[i] < 0) {
+                        net->types[gates] = SIM_NOT;
+                        net->fanin[gates * SIM_MAX_PINS] = input_gates[i];
+                        inverter[i] = gates++;
+                    }
+                    literals[count++] = (c->value & bit) ? input_gates[i] : inverter[i];
+                }
+                g = build_tree(net, &gates, SIM_AND, literals, count);
+                built[built_count] = *c;
+                built_gate[built_count++] = g;
+            }
+            products[j] = g;
+        }
+        roots[o] = covers[o].count ? build_tree(net, &gates, SIM_OR, products, covers[o].count) : -1;
+    }
+    for (int o = 0; o < num_outputs; o++) {
+        net->types[gates] = SIM_OUTPUT;
+        net->fanin[gates * SIM_MAX_PINS] = roots[o];
+        output_gates[o] = gates++;
+    }
+    net->gate_count = gates;
+
+    free(inverter);
+    free(literals);
+    free(products);
+    free(roots);
+    free(built);
+    free(built_gate);
+    return 0;
+}
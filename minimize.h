@@ -0,0 +1,51 @@
+#ifndef MINIMIZE_H
+#define MINIMIZE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "simulator.h"
+#include "bitsim.h"
+
+// Outputs with up to this many inputs get every prime implicant and an exact cover,
+// wider ones (or ones with too many primes) go through the Espresso-style loop
+#define MINIMIZE_EXACT_MAX_INPUTS 16
+#define MINIMIZE_MAX_PRIMES (1 << 16)
+
+// Matrix entries the branch-and-bound search of the covering problem may visit
+// before the best cover found so far is kept
+#define MINIMIZE_MAX_SEARCH_WORK (1LL << 24)
+
+// Product term over truth-table row bits: input i is row bit (num_inputs - 1 - i).
+// A row r lies in the cube when (r & care) == value.
+typedef struct {
+    uint32_t care;
+    uint32_t value;
+} SopCube;
+
+// Sum of products, no cubes = constant 0, one cube with care 0 = constant 1
+typedef struct {
+    int num_inputs;
+    int count;
+    int capacity;
+    SopCube* cubes;
+    int exact;          // 1 if the cover is known to have the fewest cubes
+} SopCover;
+
+// Minimize one output of a truth table into a cover of prime, irredundant cubes.
+// Returns 0 on success, -1 when out of memory.
+int sop_minimize(const TruthTable* table, int output, SopCover* cover);
+void sop_cover_free(SopCover* cover);
+int sop_literal_count(const SopCover* cover);
+
+// Print as "I1 I3' + I2", with "0" and "1" for the constants, at most
+// max_terms terms followed by "+ ..." when there are more
+void sop_print(const SopCover* cover, FILE* out, int max_terms);
+
+// Instantiate the covers of all outputs as NOT gates and trees of two-input AND
+// and OR gates. Inverted inputs and identical product terms are shared between
+// outputs. Gates 0 .. num_inputs-1 are the INPUT gates, the OUTPUT gates come last.
+// input_gates / output_gates receive the gate indices in port order.
+int sop_build_netlist(const SopCover* covers, int num_outputs, SimNetlist* net,
+                      int* input_gates, int* output_gates);
+
+#endif
@@ -0,0 +1,105 @@
+#include <stdlib.h>
+#include <string.h>
+#include "netindex.h"
+
+void netindex_init(NetIndex* n) {
+    memset(n, 0, sizeof(NetIndex));
+}
+
+void netindex_free(NetIndex* n) {
+    free(n->fanin_start);
+    free(n->fanin);
+    free(n->fanin_pin);
+    free(n->fanin_wire);
+    free(n->fanout_start);
+    free(n->fanout);
+    netindex_init(n);
+}
+
+// Function to resize an array, keeping its contents. On failure the old array stays.
+static int grow(void** array, int count, size_t size) {
+    void* bigger = realloc(*array, count * size);
+    if (!bigger) return -1;
+    *array = bigger;
+    return 0;
+}
+
+// Function to make room for node_count gates and edge_count wires. Arrays only
+// grow, so rebuilding after every edit stops allocating once the circuit is built.
+static int reserve(NetIndex* n, int node_count, int edge_count) {
+    if (node_count + 2 > n->node_capacity) {
+        int capacity = n->node_capacity < 16 ? 16 : n->node_capacity * 2;
+        if (capacity < node_count + 2) capacity = node_count + 2;
+        if (grow((void**)&n->fanin_start, capacity, sizeof(int)) != 0 ||
+            grow((void**)&n->fanout_start, capacity, sizeof(int)) != 0) {
+            return -1;
+        }
+        n->node_capacity = capacity;
+    }
+    if (edge_count > n->edge_capacity) {
+        int capacity = n->edge_capacity < 16 ? 16 : n->edge_capacity * 2;
+        if (capacity < edge_count) capacity = edge_count;
+        if (grow((void**)&n->fanin, capacity, sizeof(int)) != 0 ||
+            grow((void**)&n->fanin_pin, capacity, sizeof(int)) != 0 ||
+            grow((void**)&n->fanin_wire, capacity, sizeof(int)) != 0 ||
+            grow((void**)&n->fanout, capacity, sizeof(int)) != 0) {
+            return -1;
+        }
+        n->edge_capacity = capacity;
+    }
+    return 0;
+}
+
+int netindex_build(NetIndex* n, int node_count, const int* from, const int* to, const int* pin, int edge_count) {
+    if (node_count < 0 || reserve(n, node_count, edge_count) != 0) {
+        netindex_free(n);
+        return -1;
+    }
+    n->node_count = node_count;
+    n->edge_count = 0;
+
+    // Count the wires into and out of every gate two places ahead, sum the
+    // counts so a gate's range starts one place ahead, then fill each range
+    // using that place as the cursor; it ends up at the start of the next range
+    for (int v = 0; v < node_count + 2; v++) {
+        n->fanin_start[v] = 0;
+        n->fanout_start[v] = 0;
+    }
+    for (int i = 0; i < edge_count; i++) {
+        if (from[i] < 0 || from[i] >= node_count || to[i] < 0 || to[i] >= node_count || pin[i] < 0) continue;
+        n->fanin_start[to[i] + 2]++;
+        n->fanout_start[from[i] + 2]++;
+        n->edge_count++;
+    }
+    for (int v = 0; v < node_count; v++) {
+        n->fanin_start[v + 2] += n->fanin_start[v + 1];
+        n->fanout_start[v + 2] += n->fanout_start[v + 1];
+    }
+    for (int i = 0; i < edge_count; i++) {
+        if (from[i] < 0 || from[i] >= node_count || to[i] < 0 || to[i] >= node_count || pin[i] < 0) continue;
+        int k = n->fanin_start[to[i] + 1]++;
+        n->fanin[k] = from[i];
+        n->fanin_pin[k] = pin[i];
+        n->fanin_wire[k] = i;
+        n->fanout[n->fanout_start[from[i] + 1]++] = to[i];
+    }
+
+    // A gate has a handful of inputs, an insertion sort puts them in pin order
+    // and keeps wires on the same pin in wire order
+    for (int v = 0; v < node_count; v++) {
+        for (int k = n->fanin_start[v] + 1; k < n->fanin_start[v + 1]; k++) {
+            int driver = n->fanin[k], p = n->fanin_pin[k], wire = n->fanin_wire[k];
+            int j = k - 1;
+            while (j >= n->fanin_start[v] && n->fanin_pin[j] > p) {
+                n->fanin[j + 1] = n->fanin[j];
+                n->fanin_pin[j + 1] = n->fanin_pin[j];
+                n->fanin_wire[j + 1] = n->fanin_wire[j];
+                j--;
+            }
+            n->fanin[j + 1] = driver;
+            n->fanin_pin[j + 1] = p;
+            n->fanin_wire[j + 1] = wire;
+        }
+    }
+    return 0;
+}
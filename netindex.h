@@ -0,0 +1,30 @@
+#ifndef NETINDEX_H
+#define NETINDEX_H
+
+// Fan-in and fan-out of every gate of a netlist in compressed sparse row form.
+// Both are built in one pass over the wire list whenever the wiring changes, so
+// a simulation pass reads each gate's own inputs from one contiguous range
+// instead of searching the wires. A zero-initialized NetIndex is empty.
+typedef struct {
+    int node_count;
+    int edge_count;         // wires kept, the ones with an endpoint out of range are dropped
+    int node_capacity;
+    int edge_capacity;
+    int* fanin_start;       // fan-in of gate g is fanin[fanin_start[g] .. fanin_start[g + 1])
+    int* fanin;             // driving gate, ordered by pin then by wire
+    int* fanin_pin;         // pin of the reading gate it drives
+    int* fanin_wire;        // position of the wire in the list it was built from
+    int* fanout_start;      // fan-out of gate g is fanout[fanout_start[g] .. fanout_start[g + 1])
+    int* fanout;            // reading gate, in wire order
+} NetIndex;
+
+void netindex_init(NetIndex* n);
+void netindex_free(NetIndex* n);
+
+// Replace the index by gates 0 .. node_count - 1 and the wires from[i] -> to[i]
+// driving input pin[i] of to[i]. Wires with a gate or pin out of range (such as
+// -1 for a gate that does not exist) are left out. Returns 0 on success, -1 when
+// out of memory, leaving the index empty.
+int netindex_build(NetIndex* n, int node_count, const int* from, const int* to, const int* pin, int edge_count);
+
+#endif
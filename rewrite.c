@@ -0,0 +1,564 @@
+#include <stdlib.h>
+#include <string.h>
+#include "rewrite.h"
+
+// Truth tables of the cut leaves over 16 rows, leaf i is row bit i
+static const unsigned leaf_table[REWRITE_CUT_SIZE] = {0xAAAA, 0xCCCC, 0xF0F0, 0xFF00};
+#define TABLE_ONES 0xFFFFu
+
+// How the structure of a 4-input function is built
+enum { SYNTH_CONST, SYNTH_LEAF, SYNTH_SHANNON, SYNTH_AND, SYNTH_OR, SYNTH_XOR };
+
+// Per truth table: AND nodes of the smallest structure found (0xFF = not computed
+// yet) and how it is built, the kind in the high nibble and the leaf it splits on,
+// or the leaves of the first part of a decomposition, in the low nibble
+static unsigned char synth_cost[1 << 16];
+static unsigned char synth_choice[1 << 16];
+static int synth_ready = 0;
+
+typedef struct {
+    unsigned short table;
+    unsigned char size;
+    int leaves[REWRITE_CUT_SIZE];   // nodes, ascending
+} RwCut;
+
+typedef struct {
+    Aig* aig;
+    int size;               // entries of the per-node arrays
+    int* repl;              // literal a node was replaced by, its own literal otherwise
+    int* refs;              // readers among the live nodes, outputs included
+    int* cut_count;         // -1 until the cuts are computed
+    RwCut* cuts;            // REWRITE_MAX_CUTS per node, the node itself first
+    int dry;                // count the nodes a structure needs instead of adding them
+    int added;
+    int next_virtual;       // node a dry run pretends to add next
+} Rewriter;
+
+static unsigned cofactor0(unsigned f, int v) {
+    unsigned low = f & ~leaf_table[v] & TABLE_ONES;
+    return low | (low << (1 << v));
+}
+
+static unsigned cofactor1(unsigned f, int v) {
+    unsigned high = f & leaf_table[v];
+    return high | (high >> (1 << v));
+}
+
+static int table_support(unsigned f) {
+    int support = 0;
+    for (int v = 0; v < REWRITE_CUT_SIZE; v++) {
+        if (cofactor0(f, v) != cofactor1(f, v)) support |= 1 << v;
+    }
+    return support;
+}
+
+// Function to remove the leaves in set: OR (exists) or AND (for all) of the
+// cofactors, or the cofactor where they are all 0
+static unsigned quantify(unsigned f, int set, int how) {
+    for (int v = 0; v < REWRITE_CUT_SIZE; v++) {
+        if (!(set >> v & 1)) continue;
+        unsigned f0 = cofactor0(f, v), f1 = cofactor1(f, v);
+        f = how == SYNTH_AND ? f0 | f1 : how == SYNTH_OR ? f0 & f1 : f0;
+    }
+    return f;
+}
+
+// Function to split f over disjoint leaf sets into g(part) op h(rest). Returns 1
+// when f decomposes that way.
+static int decompose(unsigned f, int part, int rest, int how, unsigned* g, unsigned* h) {
+    *g = quantify(f, rest, how);
+    *h = quantify(f, part, how);
+    if (how == SYNTH_AND) return (*g & *h) == f;
+    if (how == SYNTH_OR) return (*g | *h) == f;
+    // g ^ h(0) and g(0) ^ h differ from g ^ h by f(0)
+    if (f & 1) *h ^= TABLE_ONES;
+    return (*g ^ *h) == f;
+}
+
+// Function to find the smallest structure of a function: a constant or a leaf,
+// a disjoint-support AND, OR or XOR of smaller functions, or a Shannon split on
+// one leaf where constant and complementary cofactors save the multiplexer.
+// Output polarity is free. Results are memoized over all 65536 functions.
+static int synth(unsigned f) {
+    if (!synth_ready) {
+        memset(synth_cost, 0xFF, sizeof(synth_cost));
+        synth_ready = 1;
+    }
+    if (synth_cost[f] != 0xFF) return synth_cost[f];
+
+    int support = table_support(f);
+    int best = 0xFF, choice = 0;
+    if (support == 0) {
+        best = 0;
+        choice = SYNTH_CONST << 4;
+    }
+    for (int v = 0; v < REWRITE_CUT_SIZE && best; v++) {
+        if (f == leaf_table[v] || f == (~leaf_table[v] & TABLE_ONES)) {
+            best = 0;
+            choice = SYNTH_LEAF << 4 | v;
+        }
+    }
+    for (int v = 0; v < REWRITE_CUT_SIZE && best; v++) {
+        if (!(support >> v & 1)) continue;
+        unsigned f0 = cofactor0(f, v), f1 = cofactor1(f, v);
+        int cost;
+        if (f0 == 0 || f0 == TABLE_ONES) cost = 1 + synth(f1);
+        else if (f1 == 0 || f1 == TABLE_ONES) cost = 1 + synth(f0);
+        else if (f1 == (~f0 & TABLE_ONES)) cost = 3 + synth(f0);
+        else cost = 3 + synth(f0) + synth(f1);
+        if (cost < best) {
+            best = cost;
+            choice = SYNTH_SHANNON << 4 | v;
+        }
+    }
+    // The first part holds the lowest leaf, so each split is tried once
+    int lowest = support & -support;
+    for (int part = (support - 1) & support; part && best; part = (part - 1) & support) {
+        if (!(part & lowest)) continue;
+        for (int how = SYNTH_AND; how <= SYNTH_XOR; how++) {
+            unsigned g, h;
+            if (!decompose(f, part, support & ~part, how, &g, &h)) continue;
+            int cost = (how == SYNTH_XOR ? 3 : 1) + synth(g) + synth(h);
+            if (cost < best) {
+                best = cost;
+                choice = how << 4 | part;
+            }
+        }
+    }
+    synth_cost[f] = (unsigned char)best;
+    synth_choice[f] = (unsigned char)choice;
+    return best;
+}
+
+// Function to grow the per-node arrays to hold at least size nodes
+static int rw_grow(Rewriter* rw, int size) {
+    if (size <= rw->size) return 0;
+    if (size < 2 * rw->size) size = 2 * rw->size;
+    int* repl = realloc(rw->repl, size * sizeof(int));
+    if (repl) rw->repl = repl;
+    int* refs = realloc(rw->refs, size * sizeof(int));
+    if (refs) rw->refs = refs;
+    int* cut_count = realloc(rw->cut_count, size * sizeof(int));
+    if (cut_count) rw->cut_count = cut_count;
+    RwCut* cuts = realloc(rw->cuts, (size_t)size * REWRITE_MAX_CUTS * sizeof(RwCut));
+    if (cuts) rw->cuts = cuts;
+    if (!repl || !refs || !cut_count || !cuts) return -1;
+    for (int v = rw->size; v < size; v++) {
+        rw->repl[v] = AIG_LIT(v, 0);
+        rw->refs[v] = 0;
+        rw->cut_count[v] = -1;
+    }
+    rw->size = size;
+    return 0;
+}
+
+static void rw_free(Rewriter* rw) {
+    free(rw->repl);
+    free(rw->refs);
+    free(rw->cut_count);
+    free(rw->cuts);
+    memset(rw, 0, sizeof(Rewriter));
+}
+
+// Function to set up a rewriter; reader counts only include nodes the outputs
+// depend on, so dead logic is never rewritten
+static int rw_init(Rewriter* rw, Aig* aig) {
+    memset(rw, 0, sizeof(Rewriter));
+    rw->aig = aig;
+    if (rw_grow(rw, aig->node_count + aig->node_count / 2 + 16) != 0) {
+        rw_free(rw);
+        return -1;
+    }
+    for (int o = 0; o < aig->output_count; o++) {
+        rw->refs[AIG_NODE(aig->outputs[o])]++;
+    }
+    for (int v = aig->node_count - 1; v > 0; v--) {
+        if (rw->refs[v] == 0 || aig->fanin0[v] < 0) continue;
+        rw->refs[AIG_NODE(aig->fanin0[v])]++;
+        rw->refs[AIG_NODE(aig->fanin1[v])]++;
+    }
+    return 0;
+}
+
+// Function to follow replacements; literals of nodes a dry run made up stay as they are
+static int rw_resolve(const Rewriter* rw, int lit) {
+    for (;;) {
+        int node = AIG_NODE(lit);
+        if (node >= rw->size || rw->repl[node] == AIG_LIT(node, 0)) return lit;
+        lit = rw->repl[node] ^ AIG_IS_COMPLEMENT(lit);
+    }
+}
+
+static int rw_is_and(const Rewriter* rw, int node) {
+    return node < rw->aig->node_count && rw->aig->fanin0[node] >= 0;
+}
+
+// Function to drop the node's reads of its fanins. Returns the AND nodes that
+// lost their last reader, recursively.
+static int rw_deref(Rewriter* rw, int node) {
+    int freed = 0;
+    for (int k = 0; k < 2; k++) {
+        int child = AIG_NODE(rw_resolve(rw, k ? rw->aig->fanin1[node] : rw->aig->fanin0[node]));
+        if (--rw->refs[child] == 0 && rw_is_and(rw, child)) freed += 1 + rw_deref(rw, child);
+    }
+    return freed;
+}
+
+// Function to undo rw_deref
+static void rw_ref(Rewriter* rw, int node) {
+    for (int k = 0; k < 2; k++) {
+        int child = AIG_NODE(rw_resolve(rw, k ? rw->aig->fanin1[node] : rw->aig->fanin0[node]));
+        if (rw->refs[child]++ == 0 && rw_is_and(rw, child)) rw_ref(rw, child);
+    }
+}
+
+// Function to AND two literals. A dry run only looks the node up and counts it
+// when it is missing or nothing reads it yet.
+static int rw_and(Rewriter* rw, int a, int b) {
+    if (a < 0 || b < 0) return -1;
+    if (!rw->dry) {
+        int lit = aig_and(rw->aig, a, b);
+        if (lit < 0 || rw_grow(rw, rw->aig->node_count) != 0) return -1;
+        return rw_resolve(rw, lit);
+    }
+    int lit = aig_lookup(rw->aig, a, b);
+    if (lit < 0) {
+        rw->added++;
+        return AIG_LIT(rw->next_virtual++, 0);
+    }
+    lit = rw_resolve(rw, lit);
+    if (rw_is_and(rw, AIG_NODE(lit)) && rw->refs[AIG_NODE(lit)] == 0) rw->added++;
+    return lit;
+}
+
+static int rw_or(Rewriter* rw, int a, int b) {
+    int lit = rw_and(rw, AIG_NOT(a), AIG_NOT(b));
+    return lit < 0 ? -1 : AIG_NOT(lit);
+}
+
+static int rw_xor(Rewriter* rw, int a, int b) {
+    return rw_or(rw, rw_and(rw, a, AIG_NOT(b)), rw_and(rw, AIG_NOT(a), b));
+}
+
+// Function to build the structure synth chose for f over the leaf literals
+static int rw_build(Rewriter* rw, unsigned f, const int* leaves) {
+    synth(f);
+    int kind = synth_choice[f] >> 4, param = synth_choice[f] & 15;
+    if (kind == SYNTH_CONST) return f ? AIG_TRUE : AIG_FALSE;
+    if (kind == SYNTH_LEAF) return f == leaf_table[param] ? leaves[param] : AIG_NOT(leaves[param]);
+    if (kind == SYNTH_SHANNON) {
+        unsigned f0 = cofactor0(f, param), f1 = cofactor1(f, param);
+        int x = leaves[param];
+        if (f0 == 0) return rw_and(rw, x, rw_build(rw, f1, leaves));
+        if (f0 == TABLE_ONES) return rw_or(rw, AIG_NOT(x), rw_build(rw, f1, leaves));
+        if (f1 == 0) return rw_and(rw, AIG_NOT(x), rw_build(rw, f0, leaves));
+        if (f1 == TABLE_ONES) return rw_or(rw, x, rw_build(rw, f0, leaves));
+        if (f1 == (~f0 & TABLE_ONES)) return rw_xor(rw, x, rw_build(rw, f0, leaves));
+        int high = rw_and(rw, x, rw_build(rw, f1, leaves));
+        return rw_or(rw, high, rw_and(rw, AIG_NOT(x), rw_build(rw, f0, leaves)));
+    }
+    unsigned g, h;
+    decompose(f, param, table_support(f) & ~param, kind, &g, &h);
+    int a = rw_build(rw, g, leaves);
+    int b = rw_build(rw, h, leaves);
+    if (kind == SYNTH_AND) return rw_and(rw, a, b);
+    if (kind == SYNTH_OR) return rw_or(rw, a, b);
+    return rw_xor(rw, a, b);
+}
+
+// Function to test whether every leaf of small is a leaf of big
+static int cut_subset(const RwCut* small, const RwCut* big) {
+    int j = 0;
+    for (int i = 0; i < small->size; i++) {
+        while (j < big->size && big->leaves[j] < small->leaves[i]) j++;
+        if (j == big->size || big->leaves[j] != small->leaves[i]) return 0;
+    }
+    return 1;
+}
+
+// Function to merge the sorted leaves of two cuts. Returns 0 when there are too many.
+static int cut_merge(const RwCut* a, const RwCut* b, RwCut* cut) {
+    int i = 0, j = 0, size = 0;
+    while (i < a->size || j < b->size) {
+        int leaf;
+        if (j == b->size || (i < a->size && a->leaves[i] < b->leaves[j])) leaf = a->leaves[i++];
+        else if (i == a->size || b->leaves[j] < a->leaves[i]) leaf = b->leaves[j++];
+        else {
+            leaf = a->leaves[i++];
+            j++;
+        }
+        if (size == REWRITE_CUT_SIZE) return 0;
+        cut->leaves[size++] = leaf;
+    }
+    cut->size = (unsigned char)size;
+    return 1;
+}
+
+// Function to express a fanin cut's truth table over the leaves of a larger cut
+static unsigned cut_stretch(const RwCut* sub, const RwCut* cut) {
+    int pos[REWRITE_CUT_SIZE];
+    for (int i = 0, j = 0; i < sub->size; i++) {
+        while (cut->leaves[j] != sub->leaves[i]) j++;
+        pos[i] = j;
+    }
+    unsigned table = 0;
+    for (int row = 0; row < 16; row++) {
+        int sub_row = 0;
+        for (int i = 0; i < sub->size; i++) {
+            if (row >> pos[i] & 1) sub_row |= 1 << i;
+        }
+        if (sub->table >> sub_row & 1) table |= 1u << row;
+    }
+    return table;
+}
+
+// Function to add a cut to a node's list. Cuts with a subset of another's leaves
+// win over it, and a full list only takes a cut smaller than its largest one.
+static int cut_add(RwCut* cuts, int count, const RwCut* cut) {
+    for (int i = 1; i < count; i++) {
+        if (cut_subset(&cuts[i], cut)) return count;
+    }
+    int kept = 1;
+    for (int i = 1; i < count; i++) {
+        if (!cut_subset(cut, &cuts[i])) cuts[kept++] = cuts[i];
+    }
+    if (kept < REWRITE_MAX_CUTS) {
+        cuts[kept] = *cut;
+        return kept + 1;
+    }
+    int largest = 1;
+    for (int i = 2; i < kept; i++) {
+        if (cuts[i].size > cuts[largest].size) largest = i;
+    }
+    if (cuts[largest].size > cut->size) cuts[largest] = *cut;
+    return kept;
+}
+
+// Function to compute a node's cuts from the cuts of its current fanins
+static void rw_cuts(Rewriter* rw, int node) {
+    if (rw->cut_count[node] >= 0) return;
+    RwCut* cuts = &rw->cuts[(size_t)node * REWRITE_MAX_CUTS];
+    int count = 1;
+    cuts[0].size = node ? 1 : 0;
+    cuts[0].leaves[0] = node;
+    cuts[0].table = node ? leaf_table[0] : 0;
+    if (rw_is_and(rw, node)) {
+        int a = rw_resolve(rw, rw->aig->fanin0[node]);
+        int b = rw_resolve(rw, rw->aig->fanin1[node]);
+        rw_cuts(rw, AIG_NODE(a));
+        rw_cuts(rw, AIG_NODE(b));
+        const RwCut* cuts_a = &rw->cuts[(size_t)AIG_NODE(a) * REWRITE_MAX_CUTS];
+        const RwCut* cuts_b = &rw->cuts[(size_t)AIG_NODE(b) * REWRITE_MAX_CUTS];
+        for (int i = 0; i < rw->cut_count[AIG_NODE(a)]; i++) {
+            for (int j = 0; j < rw->cut_count[AIG_NODE(b)]; j++) {
+                RwCut cut;
+                if (!cut_merge(&cuts_a[i], &cuts_b[j], &cut)) continue;
+                unsigned table_a = cut_stretch(&cuts_a[i], &cut) ^ (AIG_IS_COMPLEMENT(a) ? TABLE_ONES : 0);
+                unsigned table_b = cut_stretch(&cuts_b[j], &cut) ^ (AIG_IS_COMPLEMENT(b) ? TABLE_ONES : 0);
+                cut.table = (unsigned short)(table_a & table_b);
+                count = cut_add(cuts, count, &cut);
+            }
+        }
+    }
+    rw->cut_count[node] = count;
+}
+
+// Function to weigh replacing a node by the structure of one of its cuts: the
+// nodes only the node's logic down to the leaves uses, minus the nodes the
+// structure would add. leaf_lits receives the current literals of the leaves.
+static int rw_gain(Rewriter* rw, int node, const RwCut* cut, int* leaf_lits) {
+    for (int i = 0; i < cut->size; i++) {
+        leaf_lits[i] = rw_resolve(rw, AIG_LIT(cut->leaves[i], 0));
+        rw->refs[AIG_NODE(leaf_lits[i])]++;
+    }
+    int freed = 1 + rw_deref(rw, node);
+    int readers = rw->refs[node];
+    rw->refs[node] = 0;
+    rw->dry = 1;
+    rw->added = 0;
+    rw->next_virtual = rw->aig->node_count;
+    rw_build(rw, cut->table, leaf_lits);
+    rw->dry = 0;
+    rw->refs[node] = readers;
+    rw_ref(rw, node);
+    for (int i = 0; i < cut->size; i++) {
+        rw->refs[AIG_NODE(leaf_lits[i])]--;
+    }
+    return freed - rw->added;
+}
+
+// Function to move a node's readers to lit and release its logic
+static void rw_replace(Rewriter* rw, int node, int lit) {
+    int target = AIG_NODE(lit);
+    for (int k = 0; k < rw->refs[node]; k++) {
+        if (rw->refs[target]++ == 0 && rw_is_and(rw, target)) rw_ref(rw, target);
+    }
+    rw->refs[node] = 0;
+    rw_deref(rw, node);
+    rw->repl[node] = lit;
+}
+
+// Function to rewrite every live AND node of the graph once, in topological order.
+// The three nodes of an XOR are kept: they lower to a single gate, which no
+// structure with fewer nodes beats.
+static int rw_pass(Rewriter* rw, int* rewrites) {
+    int node_count = rw->aig->node_count;
+    unsigned char* in_xor = calloc(node_count, 1);
+    if (!in_xor) return -1;
+    for (int node = 1; node < node_count; node++) {
+        int l1, l2;
+        if (rw_is_and(rw, node) && rw->refs[node] > 0 && aig_match_xor(rw->aig, rw->refs, node, &l1, &l2)) {
+            in_xor[node] = 1;
+            in_xor[AIG_NODE(rw->aig->fanin0[node])] = 1;
+            in_xor[AIG_NODE(rw->aig->fanin1[node])] = 1;
+        }
+    }
+    for (int node = 1; node < node_count; node++) {
+        if (!rw_is_and(rw, node) || rw->refs[node] == 0 || in_xor[node]) continue;
+        rw_cuts(rw, node);
+        int leaves[REWRITE_MAX_CUTS][REWRITE_CUT_SIZE];
+        int best = -1, best_gain = 0;
+        for (int c = 1; c < rw->cut_count[node]; c++) {
+            int gain = rw_gain(rw, node, &rw->cuts[(size_t)node * REWRITE_MAX_CUTS + c], leaves[c]);
+            if (gain > best_gain) {
+                best = c;
+                best_gain = gain;
+            }
+        }
+        if (best < 0) continue;
+
+        // Building may move the cut array
+        unsigned table = rw->cuts[(size_t)node * REWRITE_MAX_CUTS + best].table;
+        int lit = rw_build(rw, table, leaves[best]);
+        if (lit < 0) {
+            free(in_xor);
+            return -1;
+        }
+        if (AIG_NODE(lit) == node) continue;
+        rw_replace(rw, node, lit);
+        (*rewrites)++;
+    }
+    free(in_xor);
+    return 0;
+}
+
+// Function to rebuild the graph from its outputs with replacements applied,
+// leaving out dead nodes and renumbering the rest in topological order
+static int rw_compact(Rewriter* rw) {
+    Aig* old = rw->aig;
+    Aig fresh;
+    int* map = malloc(old->node_count * sizeof(int));
+    int* stack = malloc(old->node_count * sizeof(int));
+    if (!map || !stack || aig_init(&fresh) != 0) {
+        free(map);
+        free(stack);
+        return -1;
+    }
+    for (int v = 0; v < old->node_count; v++) map[v] = -1;
+    map[0] = AIG_FALSE;
+    int status = 0;
+    for (int i = 0; i < old->input_count && status == 0; i++) {
+        int node = aig_add_input(&fresh);
+        if (node < 0) {
+            status = -1;
+            break;
+        }
+        fresh.origin[node] = old->origin[old->inputs[i]];
+        map[old->inputs[i]] = AIG_LIT(node, 0);
+    }
+
+    for (int o = 0; o < old->output_count && status == 0; o++) {
+        int out = rw_resolve(rw, old->outputs[o]);
+        int top = 0;
+        if (map[AIG_NODE(out)] < 0) stack[top++] = AIG_NODE(out);
+        while (top > 0) {
+            int v = stack[top - 1];
+            int a = rw_resolve(rw, old->fanin0[v]), b = rw_resolve(rw, old->fanin1[v]);
+            if (map[AIG_NODE(a)] < 0) {
+                stack[top++] = AIG_NODE(a);
+                continue;
+            }
+            if (map[AIG_NODE(b)] < 0) {
+                stack[top++] = AIG_NODE(b);
+                continue;
+            }
+            top--;
+            fresh.current_origin = old->origin[v];
+            map[v] = aig_and(&fresh, map[AIG_NODE(a)] ^ AIG_IS_COMPLEMENT(a),
+                             map[AIG_NODE(b)] ^ AIG_IS_COMPLEMENT(b));
+            if (map[v] < 0) {
+                status = -1;
+                break;
+            }
+        }
+        if (status == 0 && aig_add_output(&fresh, map[AIG_NODE(out)] ^ AIG_IS_COMPLEMENT(out)) < 0) {
+            status = -1;
+        }
+    }
+    free(map);
+    free(stack);
+    if (status != 0) {
+        aig_free(&fresh);
+        return -1;
+    }
+    aig_free(old);
+    *old = fresh;
+    return 0;
+}
+
+int aig_rewrite(Aig* aig, AigRewriteStats* stats) {
+    AigRewriteStats local;
+    if (!stats) stats = &local;
+    memset(stats, 0, sizeof(AigRewriteStats));
+
+    Rewriter rw;
+    if (rw_init(&rw, aig) != 0) return -1;
+    int status = rw_compact(&rw);
+    rw_free(&rw);
+    if (status != 0) return -1;
+    stats->and_before = aig->and_count;
+    stats->depth_before = aig_depth(aig);
+
+    for (int pass = 0; pass < REWRITE_MAX_PASSES; pass++) {
+        int before = aig->and_count;
+        int rewrites = 0;
+        if (rw_init(&rw, aig) != 0) return -1;
+        status = rw_pass(&rw, &rewrites);
+        if (status == 0) status = rw_compact(&rw);
+        rw_free(&rw);
+        if (status != 0) return -1;
+        stats->rewrites += rewrites;
+        if (aig->and_count >= before) break;
+    }
+    stats->and_after = aig->and_count;
+    stats->depth_after = aig_depth(aig);
+    return 0;
+}
+
+int aig_rewrite_netlist(Aig* aig, SimNetlist* net, int* input_gates, int* output_gates,
+                        AigRewriteStats* stats) {
+    SimNetlist rewritten = {0};
+    int* rewritten_inputs = malloc((aig->input_count + 1) * sizeof(int));
+    int* rewritten_outputs = malloc((aig->output_count + 1) * sizeof(int));
+    int status = -1;
+    if (rewritten_inputs && rewritten_outputs &&
+        aig_to_netlist(aig, net, input_gates, output_gates) == 0 &&
+        aig_rewrite(aig, stats) == 0 &&
+        aig_to_netlist(aig, &rewritten, rewritten_inputs, rewritten_outputs) == 0) {
+        status = 0;
+        if (rewritten.gate_count < net->gate_count) {
+            sim_netlist_free(net);
+            *net = rewritten;
+            rewritten.types = NULL;
+            rewritten.fanin = NULL;
+            if (aig->input_count > 0) memcpy(input_gates, rewritten_inputs, aig->input_count * sizeof(int));
+            if (aig->output_count > 0) memcpy(output_gates, rewritten_outputs, aig->output_count * sizeof(int));
+            status = 1;
+        }
+    }
+    if (status < 0) sim_netlist_free(net);
+    sim_netlist_free(&rewritten);
+    free(rewritten_inputs);
+    free(rewritten_outputs);
+    return status;
+}
@@ -0,0 +1,39 @@
+#ifndef REWRITE_H
+#define REWRITE_H
+
+#include "aig.h"
+
+// Leaves per cut and cuts kept per node (the node itself included)
+#define REWRITE_CUT_SIZE 4
+#define REWRITE_MAX_CUTS 8
+
+// Passes over the graph, stopping early once a pass saves nothing
+#define REWRITE_MAX_PASSES 4
+
+typedef struct {
+    int and_before;     // AND nodes in the cone of the outputs
+    int and_after;
+    int depth_before;   // longest input-to-output chain of AND nodes
+    int depth_after;
+    int rewrites;       // cuts replaced by a smaller structure
+} AigRewriteStats;
+
+// Rewrite the graph for size. Every AND node's cuts of up to four leaves are
+// resynthesized from their truth table; a cut is replaced when the new structure,
+// counting the nodes it can share with the rest of the graph, is smaller than
+// the logic only that node uses. The graph is rebuilt afterwards in topological
+// order with the cone of the outputs only; inputs and outputs keep their order
+// and AND nodes their origin. stats may be NULL. Returns 0 on success, -1 when out
+// of memory (the outputs then still compute the same functions).
+int aig_rewrite(Aig* aig, AigRewriteStats* stats);
+
+// Rewrite the graph and lower it into an empty netlist as aig_to_netlist does,
+// keeping the rewrite only when its netlist has fewer gates than the graph
+// lowered as it was: fewer AND nodes do not always mean fewer gates. The graph
+// is left rewritten either way. stats may be NULL. Returns 1 when the rewritten
+// netlist was kept, 0 when the original one was, -1 when out of memory (the
+// netlist is then left empty).
+int aig_rewrite_netlist(Aig* aig, SimNetlist* net, int* input_gates, int* output_gates,
+                        AigRewriteStats* stats);
+
+#endif
@@ -0,0 +1,636 @@
+#include <stdlib.h>
+#include <string.h>
+#include "sat.h"
+
+#define CLAUSE_HEADER 3         // size, learnt flag, LBD
+#define CLAUSE_SIZE(s, c) ((s)->arena.data[(c)])
+#define CLAUSE_LEARNT(s, c) ((s)->arena.data[(c) + 1])
+#define CLAUSE_LBD(s, c) ((s)->arena.data[(c) + 2])
+#define CLAUSE_LITS(s, c) (&(s)->arena.data[(c) + CLAUSE_HEADER])
+
+#define VAR_DECAY 0.95
+#define RESTART_BASE 100
+#define LEARNT_START 2000
+#define LEARNT_GROWTH 300
+#define LBD_KEEP 2              // learnt clauses with LBD <= this are never deleted
+
+// Function to append to a vector, sets out_of_memory and drops the value on failure
+static void vec_push(SatSolver* s, SatVec* v, int x) {
+    if (v->size == v->capacity) {
+        int capacity = v->capacity ? v->capacity * 2 : 8;
+        int* data = realloc(v->data, capacity * sizeof(int));
+        if (!data) {
+            s->out_of_memory = 1;
+            return;
+        }
+        v->data = data;
+        v->capacity = capacity;
+    }
+    v->data[v->size++] = x;
+}
+
+int sat_init(SatSolver* s) {
+    memset(s, 0, sizeof(SatSolver));
+    s->ok = 1;
+    s->var_inc = 1.0;
+    return 0;
+}
+
+void sat_free(SatSolver* s) {
+    for (int i = 0; i < 2 * s->capacity; i++) {
+        free(s->watches[i].data);
+    }
+    free(s->watches);
+    free(s->arena.data);
+    free(s->value);
+    free(s->phase);
+    free(s->model);
+    free(s->level);
+    free(s->reason);
+    free(s->seen);
+    free(s->activity);
+    free(s->heap);
+    free(s->heap_pos);
+    free(s->trail.data);
+    free(s->trail_lim.data);
+    free(s->learnts.data);
+    free(s->level_stamp);
+    memset(s, 0, sizeof(SatSolver));
+}
+
+static int lit_value(const SatSolver* s, int lit) {
+    int v = s->value[SAT_VAR(lit)];
+    return v < 0 ? -1 : v ^ (lit & 1);
+}
+
+static int decision_level(const SatSolver* s) {
+    return s->trail_lim.size;
+}
+
+// VSIDS heap ordered by activity, heap[0] is the most active variable
+static void heap_up(SatSolver* s, int i) {
+    int var = s->heap[i];
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (s->activity[s->heap[parent]] >= s->activity[var]) break;
+        s->heap[i] = s->heap[parent];
+        s->heap_pos[s->heap[i]] = i;
+        i = parent;
+    }
+    s->heap[i] = var;
+    s->heap_pos[var] = i;
+}
+
+static void heap_down(SatSolver* s, int i) {
+    int var = s->heap[i];
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= s->heap_size) break;
+        if (child + 1 < s->heap_size && s->activity[s->heap[child + 1]] > s->activity[s->heap[child]]) child++;
+        if (s->activity[s->heap[child]] <= s->activity[var]) break;
+        s->heap[i] = s->heap[child];
+        s->heap_pos[s->heap[i]] = i;
+        i = child;
+    }
+    s->heap[i] = var;
+    s->heap_pos[var] = i;
+}
+
+static void heap_insert(SatSolver* s, int var) {
+    if (s->heap_pos[var] >= 0) return;
+    s->heap[s->heap_size] = var;
+    s->heap_pos[var] = s->heap_size++;
+    heap_up(s, s->heap_pos[var]);
+}
+
+static int heap_pop(SatSolver* s) {
+    int var = s->heap[0];
+    s->heap_pos[var] = -1;
+    if (--s->heap_size > 0) {
+        s->heap[0] = s->heap[s->heap_size];
+        s->heap_pos[s->heap[0]] = 0;
+        heap_down(s, 0);
+    }
+    return var;
+}
+
+static void bump_var(SatSolver* s, int var) {
+    if ((s->activity[var] += s->var_inc) > 1e100) {
+        for (int v = 0; v < s->num_vars; v++) {
+            s->activity[v] *= 1e-100;
+        }
+        s->var_inc *= 1e-100;
+    }
+    if (s->heap_pos[var] >= 0) heap_up(s, s->heap_pos[var]);
+}
+
+// Function to grow every per-variable array to hold at least `needed` variables
+static int reserve_vars(SatSolver* s, int needed) {
+    if (needed <= s->capacity) return 0;
+    int capacity = s->capacity ? s->capacity : 64;
+    while (capacity < needed) capacity *= 2;
+
+#define GROW(field) do { \
+        void* p = realloc(s->field, capacity * sizeof(*s->field)); \
+        if (!p) return -1; \
+        s->field = p; \
+    } while (0)
+    GROW(value);
+    GROW(phase);
+    GROW(model);
+    GROW(level);
+    GROW(reason);
+    GROW(seen);
+    GROW(activity);
+    GROW(heap);
+    GROW(heap_pos);
+    GROW(level_stamp);
+#undef GROW
+    SatVec* watches = realloc(s->watches, 2 * capacity * sizeof(SatVec));
+    if (!watches) return -1;
+    memset(watches + 2 * s->capacity, 0, 2 * (capacity - s->capacity) * sizeof(SatVec));
+    s->watches = watches;
+    s->capacity = capacity;
+    return 0;
+}
+
+int sat_new_var(SatSolver* s) {
+    if (reserve_vars(s, s->num_vars + 1) != 0) {
+        s->out_of_memory = 1;
+        return -1;
+    }
+    int var = s->num_vars++;
+    s->value[var] = -1;
+    s->phase[var] = 0;
+    s->model[var] = 0;
+    s->level[var] = 0;
+    s->reason[var] = -1;
+    s->seen[var] = 0;
+    s->activity[var] = 0.0;
+    s->heap_pos[var] = -1;
+    s->level_stamp[var] = 0;
+    heap_insert(s, var);
+    return var;
+}
+
+static void enqueue(SatSolver* s, int lit, int reason) {
+    int var = SAT_VAR(lit);
+    s->value[var] = (signed char)!(lit & 1);
+    s->level[var] = decision_level(s);
+    s->reason[var] = reason;
+    vec_push(s, &s->trail, lit);
+}
+
+static void watch_clause(SatSolver* s, int c) {
+    int* lits = CLAUSE_LITS(s, c);
+    vec_push(s, &s->watches[lits[0]], c);
+    vec_push(s, &s->watches[lits[0]], lits[1]);
+    vec_push(s, &s->watches[lits[1]], c);
+    vec_push(s, &s->watches[lits[1]], lits[0]);
+}
+
+// Function to store a clause in the arena, returns its reference
+static int store_clause(SatSolver* s, const int* lits, int count, int learnt, int lbd) {
+    int c = s->arena.size;
+    vec_push(s, &s->arena, count);
+    vec_push(s, &s->arena, learnt);
+    vec_push(s, &s->arena, lbd);
+    for (int i = 0; i < count; i++) {
+        vec_push(s, &s->arena, lits[i]);
+    }
+    return c;
+}
+
+// Function to propagate the trail with two watched literals per clause.
+// Watches of literal l hold clauses where l is lits[0] or lits[1]; each entry
+// carries a blocker literal whose truth lets the clause be skipped unread.
+// Returns the conflicting clause or -1.
+static int propagate(SatSolver* s) {
+    int conflict = -1;
+    while (s->qhead < s->trail.size && conflict < 0) {
+        int false_lit = SAT_NEG(s->trail.data[s->qhead++]);
+        SatVec* ws = &s->watches[false_lit];
+        int i = 0, j = 0;
+        s->propagations++;
+        while (i < ws->size) {
+            int c = ws->data[i];
+            int blocker = ws->data[i + 1];
+            i += 2;
+            if (lit_value(s, blocker) == 1) {
+                ws->data[j++] = c;
+                ws->data[j++] = blocker;
+                continue;
+            }
+
+            int* lits = CLAUSE_LITS(s, c);
+            if (lits[0] == false_lit) {
+                lits[0] = lits[1];
+                lits[1] = false_lit;
+            }
+            int first = lits[0];
+            if (first != blocker && lit_value(s, first) == 1) {
+                ws->data[j++] = c;
+                ws->data[j++] = first;
+                continue;
+            }
+
+            // Look for a new literal to watch instead of false_lit
+            int size = CLAUSE_SIZE(s, c);
+            int moved = 0;
+            for (int k = 2; k < size; k++) {
+                if (lit_value(s, lits[k]) != 0) {
+                    lits[1] = lits[k];
+                    lits[k] = false_lit;
+                    vec_push(s, &s->watches[lits[1]], c);
+                    vec_push(s, &s->watches[lits[1]], first);
+                    moved = 1;
+                    break;
+                }
+            }
+            if (moved) continue;
+
+            ws->data[j++] = c;
+            ws->data[j++] = first;
+            if (lit_value(s, first) == 0) {
+                conflict = c;
+                while (i < ws->size) {
+                    ws->data[j++] = ws->data[i++];
+                }
+            } else {
+                enqueue(s, first, c);
+            }
+        }
+        ws->size = j;
+    }
+    return conflict;
+}
+
+static void cancel_until(SatSolver* s, int level) {
+    if (decision_level(s) <= level) return;
+    for (int i = s->trail.size - 1; i >= s->trail_lim.data[level]; i--) {
+        int var = SAT_VAR(s->trail.data[i]);
+        s->phase[var] = s->value[var];
+        s->value[var] = -1;
+        s->reason[var] = -1;
+        heap_insert(s, var);
+    }
+    s->trail.size = s->trail_lim.data[level];
+    s->qhead = s->trail.size;
+    s->trail_lim.size = level;
+}
+
+// Function to check whether a literal of the learnt clause is implied by the
+// others: every literal of its reason is already in the clause or fixed at level 0
+static int literal_redundant(SatSolver* s, int lit) {
+    int c = s->reason[SAT_VAR(lit)];
+    if (c < 0) return 0;
+    int* lits = CLAUSE_LITS(s, c);
+    for (int k = 1; k < CLAUSE_SIZE(s, c); k++) {
+        int var = SAT_VAR(lits[k]);
+        if (!s->seen[var] && s->level[var] > 0) return 0;
+    }
+    return 1;
+}
+
+// Function to derive the first-UIP clause from a conflict into `learnt`,
+// learnt->data[0] is the asserting literal, returns the backjump level
+static int analyze(SatSolver* s, int conflict, SatVec* learnt, int* lbd) {
+    int pending = 0;
+    int lit = -1;
+    int index = s->trail.size - 1;
+    learnt->size = 0;
+    vec_push(s, learnt, -1);
+
+    do {
+        int* lits = CLAUSE_LITS(s, conflict);
+        for (int k = lit == -1 ? 0 : 1; k < CLAUSE_SIZE(s, conflict); k++) {
+            int var = SAT_VAR(lits[k]);
+            if (s->seen[var] || s->level[var] == 0) continue;
+            s->seen[var] = 1;
+            bump_var(s, var);
+            if (s->level[var] >= decision_level(s)) {
+                pending++;
+            } else {
+                vec_push(s, learnt, lits[k]);
+            }
+        }
+        while (!s->seen[SAT_VAR(s->trail.data[index])]) index--;
+        lit = s->trail.data[index--];
+        conflict = s->reason[SAT_VAR(lit)];
+        s->seen[SAT_VAR(lit)] = 0;
+        pending--;
+    } while (pending > 0);
+    learnt->data[0] = SAT_NEG(lit);
+
+    // Drop literals implied by the rest of the clause. Dropped literals keep their
+    // mark until every literal was checked, they still count as part of the clause.
+    for (int k = 1; k < learnt->size; k++) {
+        if (literal_redundant(s, learnt->data[k])) learnt->data[k] = -1 - learnt->data[k];
+    }
+    int kept = 1;
+    for (int k = 1; k < learnt->size; k++) {
+        int dropped = learnt->data[k] < 0;
+        int l = dropped ? -1 - learnt->data[k] : learnt->data[k];
+        s->seen[SAT_VAR(l)] = 0;
+        if (!dropped) learnt->data[kept++] = l;
+    }
+    learnt->size = kept;
+
+    // Backjump to the second highest level, its literal becomes the second watch
+    int backjump = 0;
+    for (int k = 1; k < learnt->size; k++) {
+        if (s->level[SAT_VAR(learnt->data[k])] > backjump) {
+            backjump = s->level[SAT_VAR(learnt->data[k])];
+            int swap = learnt->data[1];
+            learnt->data[1] = learnt->data[k];
+            learnt->data[k] = swap;
+        }
+    }
+
+    // Literal block distance: number of distinct decision levels in the clause
+    s->stamp++;
+    *lbd = 0;
+    for (int k = 0; k < learnt->size; k++) {
+        int level = s->level[SAT_VAR(learnt->data[k])];
+        if (s->level_stamp[level] != s->stamp) {
+            s->level_stamp[level] = s->stamp;
+            (*lbd)++;
+        }
+    }
+    return backjump;
+}
+
+typedef struct {
+    int lbd;
+    int clause;
+} LearntRank;
+
+static int compare_rank(const void* a, const void* b) {
+    return ((const LearntRank*)b)->lbd - ((const LearntRank*)a)->lbd;
+}
+
+// Function to delete the worse half of the learnt clauses (highest LBD first) and
+// compact the arena. Runs at decision level 0 only, where no learnt clause is a
+// reason that conflict analysis will read again.
+static void reduce_learnts(SatSolver* s) {
+    int count = s->learnts.size;
+    LearntRank* ranks = malloc((count + 1) * sizeof(LearntRank));
+    if (!ranks) return;
+    for (int i = 0; i < count; i++) {
+        ranks[i].clause = s->learnts.data[i];
+        ranks[i].lbd = CLAUSE_LBD(s, ranks[i].clause);
+    }
+    qsort(ranks, count, sizeof(LearntRank), compare_rank);
+    for (int i = 0; i < count / 2 && ranks[i].lbd > LBD_KEEP; i++) {
+        CLAUSE_LEARNT(s, ranks[i].clause) = -1;  // deleted
+    }
+    free(ranks);
+
+    // Copy surviving clauses into a fresh arena and rebuild every watch list
+    SatVec arena = {0};
+    SatVec old = s->arena;
+    s->arena = arena;
+    s->learnts.size = 0;
+    for (int i = 0; i < 2 * s->num_vars; i++) {
+        s->watches[i].size = 0;
+    }
+    for (int c = 0; c < old.size; c += CLAUSE_HEADER + old.data[c]) {
+        if (old.data[c + 1] < 0) continue;
+        int copy = store_clause(s, &old.data[c + CLAUSE_HEADER], old.data[c], old.data[c + 1], old.data[c + 2]);
+        watch_clause(s, copy);
+        if (old.data[c + 1]) vec_push(s, &s->learnts, copy);
+    }
+    free(old.data);
+    for (int i = 0; i < s->trail.size; i++) {
+        s->reason[SAT_VAR(s->trail.data[i])] = -1;
+    }
+}
+
+int sat_add_clause(SatSolver* s, const int* lits, int count) {
+    if (!s->ok) return -1;
+    cancel_until(s, 0);
+
+    // Drop false and duplicate literals, skip satisfied and tautological clauses
+    int* clause = malloc((count + 1) * sizeof(int));
+    if (!clause) {
+        s->out_of_memory = 1;
+        return -1;
+    }
+    int size = 0;
+    for (int i = 0; i < count; i++) {
+        int value = lit_value(s, lits[i]);
+        int duplicate = 0;
+        for (int k = 0; k < size; k++) {
+            if (clause[k] == SAT_NEG(lits[i])) value = 1;
+            if (clause[k] == lits[i]) duplicate = 1;
+        }
+        if (value == 1) {
+            free(clause);
+            return 0;
+        }
+        if (value != 0 && !duplicate) clause[size++] = lits[i];
+    }
+
+    if (size == 0) {
+        s->ok = 0;
+    } else if (size == 1) {
+        enqueue(s, clause[0], -1);
+        if (propagate(s) >= 0) s->ok = 0;
+    } else {
+        watch_clause(s, store_clause(s, clause, size, 0, 0));
+    }
+    free(clause);
+    return s->ok ? 0 : -1;
+}
+
+// Function to compute the Luby restart sequence 1 1 2 1 1 2 4 ...
+static long long luby(long long i) {
+    long long size = 1, power = 0;
+    while (size < i + 1) {
+        power++;
+        size = 2 * size + 1;
+    }
+    while (size - 1 != i) {
+        size = (size - 1) / 2;
+        power--;
+        i %= size;
+    }
+    return 1LL << power;
+}
+
+int sat_solve(SatSolver* s, const int* assumptions, int num_assumptions, long long max_conflicts) {
+    if (!s->ok) return SAT_UNSAT;
+    cancel_until(s, 0);
+    if (propagate(s) >= 0) {
+        s->ok = 0;
+        return SAT_UNSAT;
+    }
+
+    SatVec learnt = {0};
+    long long restarts = 0;
+    long long restart_at = s->conflicts + RESTART_BASE * luby(restarts);
+    long long budget_end = max_conflicts > 0 ? s->conflicts + max_conflicts : -1;
+    int max_learnts = LEARNT_START + s->learnts.size;
+    int result = SAT_UNKNOWN;
+
+    while (result == SAT_UNKNOWN && !s->out_of_memory) {
+        int conflict = propagate(s);
+        if (conflict >= 0) {
+            s->conflicts++;
+            if (decision_level(s) == 0) {
+                s->ok = 0;
+                result = SAT_UNSAT;
+                break;
+            }
+            int lbd;
+            int backjump = analyze(s, conflict, &learnt, &lbd);
+            cancel_until(s, backjump);
+            if (learnt.size == 1) {
+                enqueue(s, learnt.data[0], -1);
+            } else {
+                int c = store_clause(s, learnt.data, learnt.size, 1, lbd);
+                watch_clause(s, c);
+                vec_push(s, &s->learnts, c);
+                enqueue(s, learnt.data[0], c);
+            }
+            s->var_inc /= VAR_DECAY;
+            continue;
+        }
+
+        if (budget_end >= 0 && s->conflicts >= budget_end) break;
+        if (s->conflicts >= restart_at) {
+            cancel_until(s, 0);
+            restart_at = s->conflicts + RESTART_BASE * luby(++restarts);
+            if (s->learnts.size > max_learnts) {
+                reduce_learnts(s);
+                max_learnts += LEARNT_GROWTH;
+            }
+            continue;
+        }
+
+        // Assumptions are decided first, one level each
+        int next = -1;
+        while (decision_level(s) < num_assumptions) {
+            int lit = assumptions[decision_level(s)];
+            int value = lit_value(s, lit);
+            if (value == 1) {
+                vec_push(s, &s->trail_lim, s->trail.size);  // already true, empty level
+            } else if (value == 0) {
+                result = SAT_UNSAT;                         // contradicts earlier ones
+                break;
+            } else {
+                next = lit;
+                break;
+            }
+        }
+        if (result != SAT_UNKNOWN) break;
+
+        while (next < 0 && s->heap_size > 0) {
+            int var = heap_pop(s);
+            if (s->value[var] < 0) next = SAT_LIT(var, !s->phase[var]);
+        }
+        if (next < 0) {
+            memcpy(s->model, s->value, s->num_vars);
+            result = SAT_SAT;
+            break;
+        }
+        s->decisions++;
+        vec_push(s, &s->trail_lim, s->trail.size);
+        enqueue(s, next, -1);
+    }
+
+    free(learnt.data);
+    cancel_until(s, 0);
+    return s->out_of_memory ? SAT_UNKNOWN : result;
+}
+
+int sat_model_value(const SatSolver* s, int var) {
+    return s->model[var] > 0;
+}
+
+static void add3(SatSolver* s, int a, int b, int c) {
+    int lits[3] = {a, b, c};
+    sat_add_clause(s, lits, c < 0 ? (b < 0 ? 1 : 2) : 3);
+}
+
+int sat_encode_xor(SatSolver* s, int a, int b) {
+    int z = sat_new_var(s);
+    if (z < 0) return -1;
+    int za = SAT_LIT(a, 0), zb = SAT_LIT(b, 0), zz = SAT_LIT(z, 0);
+    add3(s, SAT_NEG(zz), za, zb);
+    add3(s, SAT_NEG(zz), SAT_NEG(za), SAT_NEG(zb));
+    add3(s, zz, SAT_NEG(za), zb);
+    add3(s, zz, za, SAT_NEG(zb));
+    return z;
+}
+
+// Function to emit the Tseitin clauses of every gate, z is the gate's output
+// literal and a, b the literals of its two pins
+int sat_encode_program(SatSolver* s, const SimProgram* prog, const int* input_gates,
+                       const int* input_vars, int num_inputs, int* var_of_gate) {
+    if (prog->cyclic) return -1;
+    int n = prog->gate_count;
+    for (int g = 0; g <= n; g++) {
+        var_of_gate[g] = -1;
+    }
+    for (int i = 0; i < num_inputs; i++) {
+        var_of_gate[input_gates[i]] = input_vars ? input_vars[i] : sat_new_var(s);
+    }
+
+    // Unconnected pins and unlisted sources read the constant 0
+    int zero = sat_new_var(s);
+    add3(s, SAT_LIT(zero, 1), -1, -1);
+    for (int g = 0; g <= n; g++) {
+        if (var_of_gate[g] < 0) var_of_gate[g] = zero;
+    }
+
+    for (int i = 0; i < prog->instr_count; i++) {
+        const SimInstr* ins = &prog->code[i];
+        int var = sat_new_var(s);
+        if (var < 0) return -1;
+        var_of_gate[ins->out] = var;
+        int z = SAT_LIT(var, 0);
+        int a = SAT_LIT(var_of_gate[ins->in0], 0);
+        int b = SAT_LIT(var_of_gate[ins->in1], 0);
+        switch (ins->op) {
+            case SIM_AND:
+                add3(s, SAT_NEG(z), a, -1);
+                add3(s, SAT_NEG(z), b, -1);
+                add3(s, z, SAT_NEG(a), SAT_NEG(b));
+                break;
+            case SIM_OR:
+                add3(s, z, SAT_NEG(a), -1);
+                add3(s, z, SAT_NEG(b), -1);
+                add3(s, SAT_NEG(z), a, b);
+                break;
+            case SIM_NAND:
+                add3(s, z, a, -1);
+                add3(s, z, b, -1);
+                add3(s, SAT_NEG(z), SAT_NEG(a), SAT_NEG(b));
+                break;
+            case SIM_NOR:
+                add3(s, SAT_NEG(z), SAT_NEG(a), -1);
+                add3(s, SAT_NEG(z), SAT_NEG(b), -1);
+                add3(s, z, a, b);
+                break;
+            case SIM_XOR:
+                add3(s, SAT_NEG(z), a, b);
+                add3(s, SAT_NEG(z), SAT_NEG(a), SAT_NEG(b));
+                add3(s, z, SAT_NEG(a), b);
+                add3(s, z, a, SAT_NEG(b));
+                break;
+            case SIM_NOT:
+                add3(s, z, a, -1);
+                add3(s, SAT_NEG(z), SAT_NEG(a), -1);
+                break;
+            case SIM_OUTPUT:
+                add3(s, z, SAT_NEG(a), -1);
+                add3(s, SAT_NEG(z), a, -1);
+                break;
+            default:
+                add3(s, SAT_NEG(z), -1, -1);
+                break;
+        }
+    }
+    return s->out_of_memory ? -1 : 0;
+}
@@ -0,0 +1,80 @@
+#ifndef SAT_H
+#define SAT_H
+
+#include "simulator.h"
+
+// Results of sat_solve
+#define SAT_SAT 1
+#define SAT_UNSAT 0
+#define SAT_UNKNOWN -1      // conflict budget exhausted or out of memory
+
+// Literals are 2 * var for the positive and 2 * var + 1 for the negative phase
+#define SAT_LIT(var, negative) (2 * (var) + ((negative) ? 1 : 0))
+#define SAT_NEG(lit) ((lit) ^ 1)
+#define SAT_VAR(lit) ((lit) >> 1)
+
+// Growable int array used for clauses, watch lists and the trail
+typedef struct {
+    int* data;
+    int size;
+    int capacity;
+} SatVec;
+
+// CDCL solver: two watched literals per clause, VSIDS branching with phase saving,
+// first-UIP learning with clause minimization, Luby restarts and LBD-based
+// deletion of learnt clauses. Learnt clauses survive between sat_solve calls,
+// so repeated queries under different assumptions reuse them.
+typedef struct {
+    int num_vars;
+    int ok;                 // 0 once the clauses alone are unsatisfiable
+    int out_of_memory;
+    SatVec arena;           // clauses: size, learnt flag, LBD, then the literals
+    SatVec* watches;        // per literal: (clause, blocker) pairs of clauses watching it
+    signed char* value;     // per variable: -1 unassigned, 0 false, 1 true
+    signed char* phase;     // last value, reused when branching
+    signed char* model;     // assignment of the last SAT answer
+    int* level;
+    int* reason;            // clause that implied the variable, -1 for decisions
+    unsigned char* seen;
+    double* activity;
+    double var_inc;
+    int* heap;              // binary max-heap of variables by activity
+    int* heap_pos;          // -1 when not in the heap
+    int heap_size;
+    SatVec trail;
+    SatVec trail_lim;       // trail size at the start of each decision level
+    int qhead;
+    SatVec learnts;
+    int* level_stamp;
+    int stamp;
+    long long conflicts;
+    long long decisions;
+    long long propagations;
+    int capacity;           // variables allocated in the per-variable arrays
+} SatSolver;
+
+int sat_init(SatSolver* s);
+void sat_free(SatSolver* s);
+int sat_new_var(SatSolver* s);
+
+// Add a clause between solves, returns -1 if the formula became unsatisfiable
+int sat_add_clause(SatSolver* s, const int* lits, int count);
+
+// Solve under the given assumption literals (may be NULL), with at most
+// max_conflicts conflicts (0 = no limit)
+int sat_solve(SatSolver* s, const int* assumptions, int num_assumptions, long long max_conflicts);
+
+// Value of a variable in the last SAT answer
+int sat_model_value(const SatSolver* s, int var);
+
+// Tseitin encoding of a compiled circuit: one variable per gate, three clauses per
+// two-input gate (four for XOR). input_vars gives existing variables for the INPUT
+// gates (NULL = fresh ones), so two circuits can share their inputs.
+// var_of_gate receives gate_count + 1 entries. Returns -1 for cyclic circuits.
+int sat_encode_program(SatSolver* s, const SimProgram* prog, const int* input_gates,
+                       const int* input_vars, int num_inputs, int* var_of_gate);
+
+// New variable constrained to a XOR b
+int sat_encode_xor(SatSolver* s, int a, int b);
+
+#endif
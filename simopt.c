@@ -0,0 +1,183 @@
+#include <stdlib.h>
+#include <string.h>
+#include "simopt.h"
+
+void simopt_free(SimOptimized* opt) {
+    sim_netlist_free(&opt->net);
+    free(opt->source);
+    free(opt->invert);
+    free(opt->shown_start);
+    free(opt->shown);
+    memset(opt, 0, sizeof(SimOptimized));
+}
+
+int simopt_prune(SimNetlist* net) {
+    SimOptimized opt;
+    if (simopt_run(&opt, net, 1) != 0) return -1;
+    sim_netlist_free(net);
+    *net = opt.net;
+    opt.net.types = NULL;
+    opt.net.fanin = NULL;
+    simopt_free(&opt);
+    return 0;
+}
+
+int simopt_value(const SimOptimized* opt, const unsigned char* values, int gate) {
+    return values[opt->source[gate]] ^ opt->invert[gate];
+}
+
+// Function to fold a gate whose pins carry root_a ^ inv_a and root_b ^ inv_b,
+// where root n is the constant 0. Returns 1 and the signal the gate equals when
+// it needs no logic of its own, 0 when it has to be evaluated.
+static int fold_gate(int type, int n, int root_a, int inv_a, int root_b, int inv_b, int* root, int* inv) {
+    int invert_output = 0;
+    int controlling;
+    switch (type) {
+        case SIM_NOT:
+            *root = root_a;
+            *inv = !inv_a;
+            return 1;
+        case SIM_XOR:
+            if (root_a == n || root_b == n || root_a == root_b) {
+                *root = root_a == n ? root_b : root_b == n ? root_a : n;
+                *inv = inv_a ^ inv_b;
+                return 1;
+            }
+            return 0;
+        case SIM_NAND: invert_output = 1; controlling = 0; break;
+        case SIM_AND:  controlling = 0; break;
+        case SIM_NOR:  invert_output = 1; controlling = 1; break;
+        case SIM_OR:   controlling = 1; break;
+        default:       return 0;
+    }
+
+    // A controlling constant or x against !x decides the gate, a non-controlling
+    // constant or x against x passes the other pin through
+    if ((root_a == n && inv_a == controlling) || (root_b == n && inv_b == controlling) ||
+        (root_a == root_b && inv_a != inv_b)) {
+        *root = n;
+        *inv = controlling ^ invert_output;
+        return 1;
+    }
+    if (root_a == n || root_a == root_b) {
+        *root = root_b;
+        *inv = inv_b ^ invert_output;
+        return 1;
+    }
+    if (root_b == n) {
+        *root = root_a;
+        *inv = inv_a ^ invert_output;
+        return 1;
+    }
+    return 0;
+}
+
+// Function to optimize a netlist for simulation. Gates are visited in level
+// order and resolved to a root signal and a polarity; a gate that equals an
+// existing signal drops out, the first gate that needs the inverse of a root
+// becomes the NOT gate every later reader of that inverse shares, so chains of
+// inverters collapse. With drop_dead, a sweep back from the OUTPUT gates then
+// drops the rest.
+int simopt_run(SimOptimized* opt, const SimNetlist* net, int drop_dead) {
+    int n = net->gate_count;
+    memset(opt, 0, sizeof(SimOptimized));
+    SimProgram prog = {0};
+    int* inverse_of = malloc((n + 1) * sizeof(int));
+    int* stack = malloc((n + 1) * sizeof(int));
+    unsigned char* live = calloc(n + 1, sizeof(unsigned char));
+    opt->source = malloc((n + 1) * sizeof(int));
+    opt->invert = calloc(n + 1, sizeof(unsigned char));
+    opt->shown_start = calloc(n + 2, sizeof(int));
+    opt->shown = malloc((n + 1) * sizeof(int));
+    if (!inverse_of || !stack || !live || !opt->source || !opt->invert || !opt->shown_start || !opt->shown ||
+        sim_netlist_init(&opt->net, n) != 0 || sim_compile(&prog, net) != 0) {
+        free(inverse_of);
+        free(stack);
+        free(live);
+        simopt_free(opt);
+        return -1;
+    }
+    memcpy(opt->net.types, net->types, n * sizeof(int));
+    memcpy(opt->net.fanin, net->fanin, n * SIM_MAX_PINS * sizeof(int));
+    for (int g = 0; g <= n; g++) {
+        opt->source[g] = g;
+        inverse_of[g] = -1;
+    }
+
+    // Folding needs every driver resolved first, so gates inside feedback loops
+    // are kept and only have their pins moved to the roots of their drivers
+    for (int i = 0; i < prog.instr_count; i++) {
+        const SimInstr* ins = &prog.code[i];
+        int g = ins->out;
+        int* pins = &opt->net.fanin[g * SIM_MAX_PINS];
+        int root_a = opt->source[ins->in0], inv_a = opt->invert[ins->in0];
+        int root_b = opt->source[ins->in1], inv_b = opt->invert[ins->in1];
+        int root, inv;
+        if (ins->op == SIM_OUTPUT || prog.loop_of[g] >= 0 ||
+            !fold_gate(ins->op, n, root_a, inv_a, root_b, inv_b, &root, &inv)) {
+            pins[0] = inv_a ? inverse_of[root_a] : root_a == n ? -1 : root_a;
+            pins[1] = ins->op == SIM_OUTPUT ? -1 : inv_b ? inverse_of[root_b] : root_b == n ? -1 : root_b;
+            continue;
+        }
+
+        opt->source[g] = root;
+        opt->invert[g] = (unsigned char)inv;
+        if (ins->op != SIM_NOT) {
+            if (root == n) opt->constant_gates++;
+            else opt->collapsed_gates++;
+        }
+        if (inv && inverse_of[root] < 0) {
+            inverse_of[root] = g;
+            opt->net.types[g] = SIM_NOT;
+            pins[0] = root == n ? -1 : root;
+            pins[1] = -1;
+        } else {
+            opt->net.types[g] = SIM_UNUSED;
+            if (ins->op == SIM_NOT) opt->collapsed_gates++;
+        }
+    }
+
+    // Gates by the slot holding their value: count two places ahead, sum, then
+    // fill using the place one ahead as the cursor
+    for (int g = 0; g < n; g++) {
+        if (opt->source[g] < n) opt->shown_start[opt->source[g] + 2]++;
+    }
+    for (int s = 0; s < n; s++) {
+        opt->shown_start[s + 2] += opt->shown_start[s + 1];
+    }
+    for (int g = 0; g < n; g++) {
+        if (opt->source[g] < n) opt->shown[opt->shown_start[opt->source[g] + 1]++] = g;
+    }
+
+    // Keep only the fan-in cones of the OUTPUT gates
+    int top = 0;
+    for (int g = 0; drop_dead && g < n; g++) {
+        if (opt->net.types[g] == SIM_OUTPUT) {
+            live[g] = 1;
+            stack[top++] = g;
+        }
+    }
+    while (top > 0) {
+        int g = stack[--top];
+        int used_pins = opt->net.types[g] == SIM_NOT || opt->net.types[g] == SIM_OUTPUT ? 1 : SIM_MAX_PINS;
+        for (int p = 0; p < used_pins; p++) {
+            int src = opt->net.fanin[g * SIM_MAX_PINS + p];
+            if (src >= 0 && !live[src] && opt->net.types[src] != SIM_UNUSED) {
+                live[src] = 1;
+                stack[top++] = src;
+            }
+        }
+    }
+    for (int g = 0; drop_dead && g < n; g++) {
+        int type = opt->net.types[g];
+        if (live[g] || type == SIM_UNUSED || type == SIM_INPUT) continue;
+        opt->net.types[g] = SIM_UNUSED;
+        opt->dead_gates++;
+    }
+
+    sim_free_program(&prog);
+    free(inverse_of);
+    free(stack);
+    free(live);
+    return 0;
+}
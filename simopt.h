@@ -0,0 +1,44 @@
+#ifndef SIMOPT_H
+#define SIMOPT_H
+
+#include "simulator.h"
+
+// Simulation netlist derived from the editor's netlist by constant propagation,
+// double-inversion collapse and, for callers that only read OUTPUT gates,
+// removal of logic outside every OUTPUT cone.
+// Every gate keeps its index, so value arrays, engines and the editor's gate
+// arrays still line up: gates that fold away become SIM_UNUSED and read their
+// value from another slot instead of being evaluated.
+typedef struct {
+    SimNetlist net;
+    int* source;            // per gate: slot holding its value, gate_count = constant 0
+    unsigned char* invert;  // 1 if the gate is the inverse of its source
+    int constant_gates;     // folded to 0 or 1
+    int collapsed_gates;    // equal to another gate or its inverse
+    int dead_gates;         // outside every OUTPUT cone, never evaluated
+    // Gates whose value lives in slot s: shown[shown_start[s] .. shown_start[s + 1]),
+    // so a caller refreshes only the gates a changed slot reaches. Gates folded
+    // to a constant are in no list.
+    int* shown_start;
+    int* shown;
+} SimOptimized;
+
+// Optimize a netlist. Unconnected pins read constant 0, INPUT and OUTPUT gates
+// are always kept. Gates inside feedback loops are never folded away. With
+// drop_dead set, gates outside every OUTPUT cone are no longer evaluated; an
+// editor that shows every gate passes 0. Returns 0 on success, -1 when out of memory.
+int simopt_run(SimOptimized* opt, const SimNetlist* net, int drop_dead);
+void simopt_free(SimOptimized* opt);
+
+// Replace a netlist by its optimized form with drop_dead set, for callers that
+// only read INPUT and OUTPUT gates (truth tables, equivalence, compiled code):
+// OUTPUT gates compute what they did, every other gate may be unused. Gate
+// indices do not change. Returns 0 on success, -1 when out of memory (the
+// netlist is then unchanged).
+int simopt_prune(SimNetlist* net);
+
+// Value of a gate after the optimized netlist was simulated into values
+// (gate_count + 1 entries). Dead gates read whatever their slot last held.
+int simopt_value(const SimOptimized* opt, const unsigned char* values, int gate);
+
+#endif
@@ -0,0 +1,805 @@
+#include <stdlib.h>
+#include <string.h>
+#include "simulator.h"
+
+// Function to allocate an empty netlist with every pin unconnected
+int sim_netlist_init(SimNetlist* net, int gate_count) {
+    net->gate_count = gate_count;
+    net->types = malloc((gate_count + 1) * sizeof(int));
+    net->fanin = malloc((gate_count + 1) * SIM_MAX_PINS * sizeof(int));
+    if (!net->types || !net->fanin) {
+        sim_netlist_free(net);
+        return -1;
+    }
+    for (int i = 0; i < gate_count; i++) {
+        net->types[i] = SIM_UNUSED;
+    }
+    for (int i = 0; i < gate_count * SIM_MAX_PINS; i++) {
+        net->fanin[i] = -1;
+    }
+    return 0;
+}
+
+void sim_netlist_free(SimNetlist* net) {
+    free(net->types);
+    free(net->fanin);
+    net->types = NULL;
+    net->fanin = NULL;
+    net->gate_count = 0;
+}
+
+// Function to evaluate one gate from its two input values
+int sim_eval_gate(int type, int a, int b) {
+    switch (type) {
+        case SIM_AND:    return a & b;
+        case SIM_OR:     return a | b;
+        case SIM_NOT:    return !a;
+        case SIM_NAND:   return !(a & b);
+        case SIM_NOR:    return !(a | b);
+        case SIM_XOR:    return a ^ b;
+        case SIM_OUTPUT: return a;
+        default:         return 0;
+    }
+}
+
+void sim_free_program(SimProgram* prog) {
+    free(prog->code);
+    free(prog->level);
+    free(prog->loop_of);
+    free(prog->loop_begin);
+    free(prog->loop_end);
+    free(prog->loop_fanout_start);
+    free(prog->loop_fanout);
+    free(prog->bytecode);
+    memset(prog, 0, sizeof(SimProgram));
+}
+
+// Function to encode the instruction list as compact register bytecode:
+// 3 words for two-input gates, 2 for NOT and OUTPUT, operands are signal indices
+static int emit_bytecode(SimProgram* prog) {
+    prog->bytecode = malloc((prog->instr_count * 3 + 1) * sizeof(uint32_t));
+    if (!prog->bytecode) return -1;
+
+    uint32_t* pc = prog->bytecode;
+    for (int i = 0; i < prog->instr_count; i++) {
+        const SimInstr* ins = &prog->code[i];
+        uint32_t out = (uint32_t)ins->out << SIM_BC_SHIFT;
+        switch (ins->op) {
+            case SIM_AND:
+            case SIM_OR:
+            case SIM_NAND:
+            case SIM_NOR:
+            case SIM_XOR:
+                *pc++ = out | (uint32_t)ins->op;
+                *pc++ = (uint32_t)ins->in0;
+                *pc++ = (uint32_t)ins->in1;
+                break;
+            case SIM_NOT:
+                *pc++ = out | SIM_NOT;
+                *pc++ = (uint32_t)ins->in0;
+                break;
+            case SIM_OUTPUT:
+                *pc++ = out | SIM_BC_COPY;
+                *pc++ = (uint32_t)ins->in0;
+                break;
+            default:
+                // Unknown types evaluate to 0, copy the constant slot
+                *pc++ = out | SIM_BC_COPY;
+                *pc++ = (uint32_t)prog->gate_count;
+                break;
+        }
+    }
+    *pc++ = SIM_BC_HALT;
+    prog->bytecode_length = (int)(pc - prog->bytecode);
+    return 0;
+}
+
+// Driver of pin p of gate g in the evaluation graph, -1 if none. INPUT gates
+// are never evaluated and NOT / OUTPUT only read pin 0, other pins do not count.
+static int live_fanin(const SimNetlist* net, int g, int p) {
+    int type = net->types[g];
+    if (type == SIM_UNUSED || type == SIM_INPUT) return -1;
+    if (p > 0 && (type == SIM_NOT || type == SIM_OUTPUT)) return -1;
+    int src = net->fanin[g * SIM_MAX_PINS + p];
+    return (src >= 0 && net->types[src] != SIM_UNUSED) ? src : -1;
+}
+
+// Function to split the live gates into strongly connected components with an
+// iterative Tarjan search over the fan-in pins, so deep chains cannot overflow
+// the stack. comp receives the component of every live gate (-1 for unused
+// ones), members lists the gates of component c in
+// members[member_start[c] .. member_start[c + 1]). Returns the component
+// count, -1 when out of memory.
+static int find_components(const SimNetlist* net, int* comp, int* members, int* member_start) {
+    int n = net->gate_count;
+    int* index = malloc((n + 1) * sizeof(int));
+    int* low = malloc((n + 1) * sizeof(int));
+    int* stack = malloc((n + 1) * sizeof(int));
+    int* call = malloc((n + 1) * sizeof(int));
+    unsigned char* next_pin = calloc(n + 1, sizeof(unsigned char));
+    if (!index || !low || !stack || !call || !next_pin) {
+        free(index);
+        free(low);
+        free(stack);
+        free(call);
+        free(next_pin);
+        return -1;
+    }
+
+    for (int g = 0; g < n; g++) {
+        index[g] = -1;
+        comp[g] = -1;
+    }
+    int counter = 0, top = 0, count = 0, filled = 0;
+    for (int root = 0; root < n; root++) {
+        if (net->types[root] == SIM_UNUSED || index[root] >= 0) continue;
+        int depth = 0;
+        index[root] = low[root] = counter++;
+        stack[top++] = root;
+        call[depth++] = root;
+        while (depth > 0) {
+            int g = call[depth - 1];
+            if (next_pin[g] < SIM_MAX_PINS) {
+                int src = live_fanin(net, g, next_pin[g]++);
+                if (src < 0) continue;
+                if (index[src] < 0) {
+                    index[src] = low[src] = counter++;
+                    stack[top++] = src;
+                    call[depth++] = src;
+                } else if (comp[src] < 0 && index[src] < low[g]) {
+                    // Still on the stack: src belongs to the component being built
+                    low[g] = index[src];
+                }
+                continue;
+            }
+            depth--;
+            if (depth > 0 && low[g] < low[call[depth - 1]]) low[call[depth - 1]] = low[g];
+            if (low[g] != index[g]) continue;
+
+            // g roots a component, everything above it on the stack belongs to it
+            member_start[count] = filled;
+            int w;
+            do {
+                w = stack[--top];
+                comp[w] = count;
+                members[filled++] = w;
+            } while (w != g);
+            count++;
+        }
+    }
+    member_start[count] = filled;
+
+    free(index);
+    free(low);
+    free(stack);
+    free(call);
+    free(next_pin);
+    return count;
+}
+
+// Function to levelize the netlist and emit one instruction per evaluated gate.
+// Feedback is found first: every strongly connected component of more than one
+// gate (or a gate reading itself) is a loop and is levelized as a single node,
+// its gates sharing one level and a contiguous run of instructions. The
+// components are then ordered with Kahn's algorithm, so one pass in level order
+// settles everything outside the loops and each loop sees its drivers settled.
+int sim_compile(SimProgram* prog, const SimNetlist* net) {
+    int n = net->gate_count;
+    sim_free_program(prog);
+    prog->gate_count = n;
+    prog->code = malloc((n + 1) * sizeof(SimInstr));
+    prog->level = calloc(n + 1, sizeof(int));
+    prog->loop_of = malloc((n + 1) * sizeof(int));
+
+    int* comp = malloc((n + 1) * sizeof(int));
+    int* members = malloc((n + 1) * sizeof(int));
+    int* member_start = malloc((n + 2) * sizeof(int));
+    int* pending = calloc(n + 1, sizeof(int));        // unresolved fan-in per component
+    int* comp_level = calloc(n + 1, sizeof(int));
+    int* fanout_start = calloc(n + 2, sizeof(int));
+    int* fanout = malloc((n * SIM_MAX_PINS + 1) * sizeof(int));
+    int* queue = malloc((n + 1) * sizeof(int));
+    int* level_count = NULL;
+    int comps = -1;
+
+    if (prog->code && prog->level && prog->loop_of && comp && members && member_start &&
+        pending && comp_level && fanout_start && fanout && queue) {
+        comps = find_components(net, comp, members, member_start);
+    }
+    if (comps < 0) {
+        free(comp);
+        free(members);
+        free(member_start);
+        free(pending);
+        free(comp_level);
+        free(fanout_start);
+        free(fanout);
+        free(queue);
+        sim_free_program(prog);
+        return -1;
+    }
+
+    // Count fan-out between components, then fill the fan-out lists.
+    // A pin inside a component of one gate is a gate reading itself.
+    for (int g = 0; g < n; g++) {
+        prog->loop_of[g] = -1;
+        if (net->types[g] != SIM_UNUSED && member_start[comp[g] + 1] - member_start[comp[g]] > 1) {
+            prog->loop_of[g] = comp[g];
+        }
+        for (int p = 0; p < SIM_MAX_PINS; p++) {
+            int src = live_fanin(net, g, p);
+            if (src < 0) continue;
+            if (comp[src] == comp[g]) {
+                prog->loop_of[g] = comp[g];
+                continue;
+            }
+            fanout_start[src + 1]++;
+            pending[comp[g]]++;
+        }
+    }
+    for (int g = 0; g < n; g++) {
+        fanout_start[g + 1] += fanout_start[g];
+    }
+    int* fill = queue;  // borrow the queue as a write cursor while filling
+    memcpy(fill, fanout_start, n * sizeof(int));
+    for (int g = 0; g < n; g++) {
+        for (int p = 0; p < SIM_MAX_PINS; p++) {
+            int src = live_fanin(net, g, p);
+            if (src >= 0 && comp[src] != comp[g]) fanout[fill[src]++] = g;
+        }
+    }
+
+    // Topological sweep over the components, a component's level is one more
+    // than its deepest driver. Sources are queued in gate order.
+    int head = 0, tail = 0;
+    for (int g = 0; g < n; g++) {
+        if (net->types[g] == SIM_UNUSED || pending[comp[g]] != 0) continue;
+        pending[comp[g]] = -1;
+        queue[tail++] = comp[g];
+    }
+    while (head < tail) {
+        int c = queue[head++];
+        if (comp_level[c] > prog->max_level) prog->max_level = comp_level[c];
+        for (int m = member_start[c]; m < member_start[c + 1]; m++) {
+            int g = members[m];
+            prog->level[g] = comp_level[c];
+            for (int k = fanout_start[g]; k < fanout_start[g + 1]; k++) {
+                int dst = comp[fanout[k]];
+                if (comp_level[c] + 1 > comp_level[dst]) comp_level[dst] = comp_level[c] + 1;
+                if (--pending[dst] == 0) queue[tail++] = dst;
+            }
+        }
+    }
+
+    // Emit instructions bucketed by level (counting sort keeps it linear and
+    // keeps the gates of a loop next to each other)
+    level_count = calloc(prog->max_level + 2, sizeof(int));
+    if (!level_count) {
+        free(comp);
+        free(members);
+        free(member_start);
+        free(pending);
+        free(comp_level);
+        free(fanout_start);
+        free(fanout);
+        free(queue);
+        sim_free_program(prog);
+        return -1;
+    }
+    for (int i = 0; i < tail; i++) {
+        for (int m = member_start[queue[i]]; m < member_start[queue[i] + 1]; m++) {
+            int g = members[m];
+            if (net->types[g] != SIM_INPUT) level_count[prog->level[g] + 1]++;
+        }
+    }
+    for (int l = 0; l <= prog->max_level; l++) {
+        level_count[l + 1] += level_count[l];
+    }
+    prog->instr_count = level_count[prog->max_level + 1];
+    for (int i = 0; i < tail; i++) {
+        for (int m = member_start[queue[i]]; m < member_start[queue[i] + 1]; m++) {
+            int g = members[m];
+            if (net->types[g] == SIM_INPUT) continue;
+            int in0 = net->fanin[g * SIM_MAX_PINS];
+            int in1 = net->fanin[g * SIM_MAX_PINS + 1];
+            SimInstr* ins = &prog->code[level_count[prog->level[g]]++];
+            ins->op = net->types[g];
+            ins->out = g;
+            ins->in0 = (in0 >= 0 && net->types[in0] != SIM_UNUSED) ? in0 : n;
+            ins->in1 = (in1 >= 0 && net->types[in1] != SIM_UNUSED) ? in1 : n;
+        }
+    }
+
+    // Number the loops in program order and record their instruction runs
+    for (int i = 0; i < prog->instr_count; i++) {
+        int c = prog->loop_of[prog->code[i].out];
+        if (c >= 0 && (i == 0 || prog->loop_of[prog->code[i - 1].out] != c)) prog->loop_count++;
+    }
+    prog->cyclic = prog->loop_count > 0;
+    prog->loop_begin = malloc((prog->loop_count + 1) * sizeof(int));
+    prog->loop_end = malloc((prog->loop_count + 1) * sizeof(int));
+    int loops = 0;
+    if (prog->loop_begin && prog->loop_end) {
+        for (int c = 0; c < comps; c++) {
+            comp_level[c] = -1;   // reused as component -> loop number
+        }
+        for (int i = 0; i < prog->instr_count; i++) {
+            int g = prog->code[i].out;
+            int c = prog->loop_of[g];
+            if (c < 0) continue;
+            if (comp_level[c] < 0) {
+                comp_level[c] = loops;
+                prog->loop_begin[loops++] = i;
+            }
+            prog->loop_of[g] = comp_level[c];
+            prog->loop_end[comp_level[c]] = i + 1;
+        }
+    }
+
+    // Fan-out inside each loop, as instruction indices, for the delta cycles
+    prog->loop_fanout_start = calloc(prog->instr_count + 2, sizeof(int));
+    prog->loop_fanout = malloc((prog->instr_count * SIM_MAX_PINS + 1) * sizeof(int));
+    if (prog->loop_fanout_start && prog->loop_fanout) {
+        int* instr_of = queue;  // the queue is done with, reused as gate -> instruction
+        for (int i = 0; i < prog->instr_count; i++) {
+            instr_of[prog->code[i].out] = i;
+        }
+        for (int pass = 0; pass < 2; pass++) {
+            for (int i = 0; i < prog->instr_count; i++) {
+                const SimInstr* ins = &prog->code[i];
+                int l = prog->loop_of[ins->out];
+                if (l < 0) continue;
+                int pins = ins->op == SIM_NOT || ins->op == SIM_OUTPUT ? 1 : 2;
+                for (int p = 0; p < pins; p++) {
+                    int src = p == 0 ? ins->in0 : ins->in1;
+                    if (src == n || prog->loop_of[src] != l) continue;
+                    if (pass == 0) prog->loop_fanout_start[instr_of[src] + 2]++;
+                    else prog->loop_fanout[prog->loop_fanout_start[instr_of[src] + 1]++] = i;
+                }
+            }
+            if (pass == 0) {
+                for (int i = 0; i < prog->instr_count; i++) {
+                    prog->loop_fanout_start[i + 2] += prog->loop_fanout_start[i + 1];
+                }
+            }
+        }
+    }
+
+    free(level_count);
+    free(comp);
+    free(members);
+    free(member_start);
+    free(pending);
+    free(comp_level);
+    free(fanout_start);
+    free(fanout);
+    free(queue);
+    if (!prog->loop_begin || !prog->loop_end || !prog->loop_fanout_start || !prog->loop_fanout ||
+        emit_bytecode(prog) != 0) {
+        sim_free_program(prog);
+        return -1;
+    }
+    return 0;
+}
+
+// Function to run the compiled program once over a value array.
+// With GCC/Clang every handler jumps straight to the next one through a label
+// table (computed goto), so there is no shared switch branch to mispredict.
+void sim_run(const SimProgram* prog, unsigned char* values) {
+    const uint32_t* pc = prog->bytecode;
+    uint32_t word;
+
+    values[prog->gate_count] = 0;
+#if defined(__GNUC__)
+    static void* const dispatch[8] = {
+        &&op_and, &&op_or, &&op_not, &&op_nand, &&op_nor, &&op_xor, &&op_copy, &&op_halt
+    };
+#define NEXT() do { word = *pc++; goto *dispatch[word & 7]; } while (0)
+#define OUT values[word >> SIM_BC_SHIFT]
+    NEXT();
+op_and:  OUT = values[pc[0]] & values[pc[1]];    pc += 2; NEXT();
+op_or:   OUT = values[pc[0]] | values[pc[1]];    pc += 2; NEXT();
+op_not:  OUT = !values[pc[0]];                   pc += 1; NEXT();
+op_nand: OUT = !(values[pc[0]] & values[pc[1]]); pc += 2; NEXT();
+op_nor:  OUT = !(values[pc[0]] | values[pc[1]]); pc += 2; NEXT();
+op_xor:  OUT = values[pc[0]] ^ values[pc[1]];    pc += 2; NEXT();
+op_copy: OUT = values[pc[0]];                    pc += 1; NEXT();
+op_halt: return;
+#undef OUT
+#undef NEXT
+#else
+    for (;;) {
+        word = *pc++;
+        unsigned char* out = &values[word >> SIM_BC_SHIFT];
+        switch (word & 7) {
+            case SIM_AND:     *out = values[pc[0]] & values[pc[1]];    pc += 2; break;
+            case SIM_OR:      *out = values[pc[0]] | values[pc[1]];    pc += 2; break;
+            case SIM_NOT:     *out = !values[pc[0]];                   pc += 1; break;
+            case SIM_NAND:    *out = !(values[pc[0]] & values[pc[1]]); pc += 2; break;
+            case SIM_NOR:     *out = !(values[pc[0]] | values[pc[1]]); pc += 2; break;
+            case SIM_XOR:     *out = values[pc[0]] ^ values[pc[1]];    pc += 2; break;
+            case SIM_BC_COPY: *out = values[pc[0]];                    pc += 1; break;
+            default:          return;
+        }
+    }
+#endif
+}
+
+// Function to give a gate a fixed pseudo-random 64-bit key (splitmix64). XOR-ing
+// the keys of the gates that toggle keeps a hash of the state up to date.
+static uint64_t gate_key(int g) {
+    uint64_t x = (uint64_t)g + 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// Repeated state detection over delta cycles (Brent's algorithm): the hash is
+// compared with one saved hash, saved again after each power of two cycles, so
+// a cycle is found within two of its periods in constant memory
+typedef struct {
+    uint64_t saved;
+    int power;
+    int length;
+} RepeatCheck;
+
+static void repeat_reset(RepeatCheck* check, uint64_t hash) {
+    check->saved = hash;
+    check->power = 1;
+    check->length = 0;
+}
+
+// Function to record the hash after a delta cycle, returns the period once a state repeats
+static int repeat_step(RepeatCheck* check, uint64_t hash) {
+    check->length++;
+    if (hash == check->saved) return check->length;
+    if (check->length == check->power) {
+        check->saved = hash;
+        check->power *= 2;
+        check->length = 0;
+    }
+    return 0;
+}
+
+// Instructions of one loop queued for the current and the next delta cycle,
+// queued is indexed from the loop's first instruction
+typedef struct {
+    int base;
+    int count;
+    int next_count;
+    int* current;
+    int* next;
+    int* changed;
+    unsigned char* queued;
+    uint64_t hash;
+} DeltaQueue;
+
+// Function to flip a loop gate and queue the instructions of the loop that read it
+static void loop_toggle(const SimProgram* prog, unsigned char* values, DeltaQueue* q, int k, unsigned char* toggled) {
+    int g = prog->code[k].out;
+    values[g] = !values[g];
+    q->hash ^= gate_key(g);
+    if (toggled) toggled[g] = 1;
+    for (int f = prog->loop_fanout_start[k]; f < prog->loop_fanout_start[k + 1]; f++) {
+        int j = prog->loop_fanout[f];
+        if (!q->queued[j - q->base]) {
+            q->queued[j - q->base] = 1;
+            q->next[q->next_count++] = j;
+        }
+    }
+}
+
+// Function to run one delta cycle of a loop: the queued instructions read the
+// values from before the cycle, then every change is applied
+static void loop_delta(const SimProgram* prog, unsigned char* values, DeltaQueue* q, unsigned char* toggled) {
+    int changes = 0;
+    q->next_count = 0;
+    for (int i = 0; i < q->count; i++) {
+        int k = q->current[i];
+        const SimInstr* ins = &prog->code[k];
+        q->queued[k - q->base] = 0;
+        if (sim_eval_gate(ins->op, values[ins->in0], values[ins->in1]) == values[ins->out]) continue;
+        q->changed[changes++] = k;
+    }
+    for (int i = 0; i < changes; i++) {
+        loop_toggle(prog, values, q, q->changed[i], toggled);
+    }
+    int* swap = q->current;
+    q->current = q->next;
+    q->next = swap;
+    q->count = q->next_count;
+}
+
+// Function to run a program with feedback loops: gates outside the loops are
+// evaluated once in level order. Each loop starts from the values its gates
+// already hold with one delta cycle over all of them, after that only gates
+// whose inputs changed in the previous cycle are evaluated. A repeated state
+// means the loop oscillates, or races: both sides of a latch that power up or
+// are released together keep toggling, and nothing but gate order would pick a
+// winner. Either way the loop is left unsettled. Returns the number of loops
+// left unsettled.
+int sim_run_loops(const SimProgram* prog, unsigned char* values, int max_deltas, unsigned char* oscillating) {
+    const SimInstr* code = prog->code;
+    int unsettled = 0;
+    int i = 0;
+
+    int longest = 0;
+    for (int l = 0; l < prog->loop_count; l++) {
+        if (prog->loop_end[l] - prog->loop_begin[l] > longest) longest = prog->loop_end[l] - prog->loop_begin[l];
+    }
+    DeltaQueue q = {0};
+    q.current = malloc((longest + 1) * sizeof(int));
+    q.next = malloc((longest + 1) * sizeof(int));
+    q.changed = malloc((longest + 1) * sizeof(int));
+    q.queued = calloc(longest + 1, sizeof(unsigned char));
+    if (!q.current || !q.next || !q.changed || !q.queued) {
+        free(q.current);
+        free(q.next);
+        free(q.changed);
+        free(q.queued);
+        return -1;
+    }
+    if (oscillating) memset(oscillating, 0, prog->gate_count);
+
+    values[prog->gate_count] = 0;
+    for (int l = 0; l <= prog->loop_count; l++) {
+        int end = l < prog->loop_count ? prog->loop_begin[l] : prog->instr_count;
+        for (; i < end; i++) {
+            values[code[i].out] = (unsigned char)sim_eval_gate(code[i].op, values[code[i].in0], values[code[i].in1]);
+        }
+        if (l == prog->loop_count) break;
+
+        q.base = prog->loop_begin[l];
+        q.count = 0;
+        q.hash = 0;   // relative to the starting state, a repeat shows all the same
+        for (int k = prog->loop_begin[l]; k < prog->loop_end[l]; k++) {
+            q.queued[k - q.base] = 1;
+            q.current[q.count++] = k;
+        }
+        RepeatCheck check;
+        repeat_reset(&check, q.hash);
+        for (int delta = 0; delta < max_deltas && q.count > 0; delta++) {
+            loop_delta(prog, values, &q, NULL);
+            int period = q.count > 0 ? repeat_step(&check, q.hash) : 0;
+            if (period == 0) continue;
+            // One more period shows which gates keep toggling
+            for (int p = 0; p < period; p++) {
+                loop_delta(prog, values, &q, oscillating);
+            }
+            break;
+        }
+        if (q.count > 0) {
+            unsettled++;
+            for (int k = 0; k < q.count; k++) {
+                q.queued[q.current[k] - q.base] = 0;
+            }
+        }
+        i = prog->loop_end[l];
+    }
+
+    free(q.current);
+    free(q.next);
+    free(q.changed);
+    free(q.queued);
+    return unsettled;
+}
+
+void sim_engine_free(SimEngine* eng) {
+    free(eng->types);
+    free(eng->in);
+    free(eng->level);
+    free(eng->fanout_start);
+    free(eng->fanout);
+    free(eng->values);
+    free(eng->queued);
+    free(eng->next_queued);
+    free(eng->bucket_head);
+    free(eng->bucket_tail);
+    free(eng->changed_flag);
+    free(eng->changed);
+    free(eng->delta_changes);
+    free(eng->oscillating_flag);
+    free(eng->oscillating);
+    memset(eng, 0, sizeof(SimEngine));
+}
+
+// Function to build the fan-out lists and empty queue for an engine
+int sim_engine_init(SimEngine* eng, const SimNetlist* net, const SimProgram* prog) {
+    int n = net->gate_count;
+    sim_engine_free(eng);
+    eng->gate_count = n;
+    eng->cyclic = prog->cyclic;
+    eng->max_level = prog->cyclic ? 0 : prog->max_level;
+
+    eng->types = malloc((n + 1) * sizeof(int));
+    eng->in = malloc((n * SIM_MAX_PINS + 1) * sizeof(int));
+    eng->level = calloc(n + 1, sizeof(int));
+    eng->fanout_start = calloc(n + 2, sizeof(int));
+    eng->fanout = malloc((n * SIM_MAX_PINS + 1) * sizeof(int));
+    eng->values = calloc(n + 1, sizeof(unsigned char));
+    eng->queued = calloc(n + 1, sizeof(unsigned char));
+    eng->next_queued = malloc((n + 1) * sizeof(int));
+    eng->bucket_head = malloc((eng->max_level + 1) * sizeof(int));
+    eng->bucket_tail = malloc((eng->max_level + 1) * sizeof(int));
+    eng->changed_flag = calloc(n + 1, sizeof(unsigned char));
+    eng->changed = malloc((n + 1) * sizeof(int));
+    eng->delta_changes = malloc((n + 1) * sizeof(int));
+    eng->oscillating_flag = calloc(n + 1, sizeof(unsigned char));
+    eng->oscillating = malloc((n + 1) * sizeof(int));
+    if (!eng->types || !eng->in || !eng->level || !eng->fanout_start || !eng->fanout ||
+        !eng->values || !eng->queued || !eng->next_queued || !eng->bucket_head ||
+        !eng->bucket_tail || !eng->changed_flag || !eng->changed || !eng->delta_changes ||
+        !eng->oscillating_flag || !eng->oscillating) {
+        sim_engine_free(eng);
+        return -1;
+    }
+
+    for (int g = 0; g < n; g++) {
+        eng->types[g] = net->types[g];
+        if (!prog->cyclic) eng->level[g] = prog->level[g];
+        for (int p = 0; p < SIM_MAX_PINS; p++) {
+            int src = net->fanin[g * SIM_MAX_PINS + p];
+            int live = net->types[g] != SIM_UNUSED && src >= 0 && net->types[src] != SIM_UNUSED;
+            eng->in[g * SIM_MAX_PINS + p] = live ? src : n;
+            if (live) eng->fanout_start[src + 1]++;
+        }
+    }
+    for (int g = 0; g < n; g++) {
+        eng->fanout_start[g + 1] += eng->fanout_start[g];
+    }
+    int* fill = eng->next_queued;  // borrowed as a write cursor, reset below
+    memcpy(fill, eng->fanout_start, n * sizeof(int));
+    for (int g = 0; g < n; g++) {
+        for (int p = 0; p < SIM_MAX_PINS; p++) {
+            int src = eng->in[g * SIM_MAX_PINS + p];
+            if (src < n) eng->fanout[fill[src]++] = g;
+        }
+    }
+
+    for (int g = 0; g < n; g++) {
+        eng->next_queued[g] = -1;
+    }
+    for (int l = 0; l <= eng->max_level; l++) {
+        eng->bucket_head[l] = -1;
+        eng->bucket_tail[l] = -1;
+    }
+    eng->lowest_level = eng->max_level + 1;
+    return 0;
+}
+
+// Function to queue a gate for re-evaluation (no-op if already queued)
+void sim_engine_schedule(SimEngine* eng, int gate) {
+    if (gate < 0 || gate >= eng->gate_count || eng->queued[gate]) return;
+    int t = eng->types[gate];
+    if (t == SIM_UNUSED || t == SIM_INPUT) return;
+
+    int l = eng->level[gate];
+    eng->queued[gate] = 1;
+    eng->next_queued[gate] = -1;
+    if (eng->bucket_tail[l] < 0) eng->bucket_head[l] = gate;
+    else eng->next_queued[eng->bucket_tail[l]] = gate;
+    eng->bucket_tail[l] = gate;
+    if (l < eng->lowest_level) eng->lowest_level = l;
+    eng->pending++;
+}
+
+void sim_engine_schedule_all(SimEngine* eng) {
+    for (int g = 0; g < eng->gate_count; g++) {
+        sim_engine_schedule(eng, g);
+    }
+}
+
+static void note_change(SimEngine* eng, int gate) {
+    if (!eng->changed_flag[gate]) {
+        eng->changed_flag[gate] = 1;
+        eng->changed[eng->changed_count++] = gate;
+    }
+}
+
+// Function to force a gate value (INPUT toggles) and schedule its fan-out
+void sim_engine_set_value(SimEngine* eng, int gate, int value) {
+    if (gate < 0 || gate >= eng->gate_count) return;
+    value = value != 0;
+    if (eng->values[gate] == value) return;
+    eng->values[gate] = (unsigned char)value;
+    note_change(eng, gate);
+    for (int k = eng->fanout_start[gate]; k < eng->fanout_start[gate + 1]; k++) {
+        sim_engine_schedule(eng, eng->fanout[k]);
+    }
+}
+
+// Function to take the first gate off the lowest non-empty level
+static int pop_queued(SimEngine* eng) {
+    while (eng->bucket_head[eng->lowest_level] < 0) eng->lowest_level++;
+    int l = eng->lowest_level;
+    int g = eng->bucket_head[l];
+    eng->bucket_head[l] = eng->next_queued[g];
+    if (eng->bucket_head[l] < 0) eng->bucket_tail[l] = -1;
+    eng->queued[g] = 0;
+    eng->pending--;
+    return g;
+}
+
+// Function to store a new gate value and schedule its fan-out
+static void apply_change(SimEngine* eng, int g, int value) {
+    eng->values[g] = (unsigned char)value;
+    note_change(eng, g);
+    for (int k = eng->fanout_start[g]; k < eng->fanout_start[g + 1]; k++) {
+        sim_engine_schedule(eng, eng->fanout[k]);
+    }
+}
+
+// Function to drain the queue of a cyclic engine in delta cycles. A repeated
+// state, from an oscillation or a race between gates changing together, stops
+// the settle after one more period, recording the gates that toggle in it.
+// The loop keeps its events for the next call.
+static int settle_deltas(SimEngine* eng, int max_evaluations) {
+    int done = 0;
+    uint64_t hash = 0;   // relative to the starting state, a repeat shows all the same
+    RepeatCheck check;
+    repeat_reset(&check, hash);
+    int marking = 0;
+
+    for (int i = 0; i < eng->oscillating_count; i++) {
+        eng->oscillating_flag[eng->oscillating[i]] = 0;
+    }
+    eng->oscillating_count = 0;
+    while (eng->pending > 0 && done < max_evaluations) {
+        // The gates queued now form this cycle, the ones they schedule the next
+        int count = eng->pending;
+        int changes = 0;
+        for (int i = 0; i < count; i++) {
+            int g = pop_queued(eng);
+            const int* in = &eng->in[g * SIM_MAX_PINS];
+            int value = sim_eval_gate(eng->types[g], eng->values[in[0]], eng->values[in[1]]);
+            done++;
+            if (value == eng->values[g]) continue;
+            hash ^= gate_key(g);
+            eng->delta_changes[changes++] = g;
+        }
+        for (int i = 0; i < changes; i++) {
+            int g = eng->delta_changes[i];
+            apply_change(eng, g, !eng->values[g]);
+            if (marking && !eng->oscillating_flag[g]) {
+                eng->oscillating_flag[g] = 1;
+                eng->oscillating[eng->oscillating_count++] = g;
+            }
+        }
+
+        if (marking) {
+            if (--marking == 0) break;
+            continue;
+        }
+        int period = eng->pending > 0 ? repeat_step(&check, hash) : 0;
+        if (period > 0) marking = period;
+    }
+    if (eng->pending == 0) eng->lowest_level = eng->max_level + 1;
+    eng->evaluations += done;
+    return done;
+}
+
+// Function to drain the change queue in level order, returns evaluations done.
+// In acyclic circuits each queued gate is evaluated once; max_evaluations bounds
+// the work on feedback loops, leftover events stay queued for the next call.
+int sim_engine_settle(SimEngine* eng, int max_evaluations) {
+    if (eng->cyclic) return settle_deltas(eng, max_evaluations);
+
+    int done = 0;
+    while (eng->pending > 0 && done < max_evaluations) {
+        int g = pop_queued(eng);
+        const int* in = &eng->in[g * SIM_MAX_PINS];
+        int value = sim_eval_gate(eng->types[g], eng->values[in[0]], eng->values[in[1]]);
+        done++;
+        if (value != eng->values[g]) apply_change(eng, g, value);
+    }
+    if (eng->pending == 0) eng->lowest_level = eng->max_level + 1;
+    eng->evaluations += done;
+    return done;
+}
+
+void sim_engine_clear_changes(SimEngine* eng) {
+    for (int i = 0; i < eng->changed_count; i++) {
+        eng->changed_flag[eng->changed[i]] = 0;
+    }
+    eng->changed_count = 0;
+}
@@ -0,0 +1,132 @@
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include <stdint.h>
+
+// Gate types understood by the simulation engine (same numbering as final.c)
+#define SIM_AND     0
+#define SIM_OR      1
+#define SIM_NOT     2
+#define SIM_NAND    3
+#define SIM_NOR     4
+#define SIM_XOR     5
+#define SIM_INPUT   6
+#define SIM_OUTPUT  7
+#define SIM_UNUSED  -1   // palette entries and empty slots, never evaluated
+
+#define SIM_MAX_PINS 2
+
+// Flat description of a circuit: gates are addressed by dense index,
+// fanin[g * SIM_MAX_PINS + pin] is the driving gate index or -1 if unconnected
+typedef struct {
+    int gate_count;
+    int* types;
+    int* fanin;
+} SimNetlist;
+
+// One step of the evaluation program: value[out] = op(value[in0], value[in1])
+typedef struct {
+    int op;
+    int out;
+    int in0;
+    int in1;
+} SimInstr;
+
+// Bytecode opcodes, AND..XOR keep the SIM_ numbering
+#define SIM_BC_COPY   6   // one operand, used for OUTPUT gates
+#define SIM_BC_HALT   7
+#define SIM_BC_SHIFT  3
+
+// Levelized evaluation program compiled from a SimNetlist.
+// Unconnected pins read from the constant-0 slot at index gate_count,
+// so value arrays passed to sim_run need gate_count + 1 entries.
+typedef struct {
+    int gate_count;
+    int instr_count;
+    SimInstr* code;     // ordered by level, each evaluated gate appears once
+    int* level;         // per gate logic level, sources are level 0
+    int max_level;
+    int cyclic;         // non-zero if the netlist has a combinational loop
+    // Feedback loops (strongly connected gates, or a gate reading itself) are
+    // levelized as one node: loop l is the run code[loop_begin[l] .. loop_end[l])
+    // and needs iterating, everything else settles in a single pass
+    int loop_count;
+    int* loop_begin;
+    int* loop_end;
+    int* loop_of;       // per gate loop number, -1 outside every loop
+    // Fan-out inside the loops: instruction k feeds the instructions
+    // loop_fanout[loop_fanout_start[k] .. loop_fanout_start[k + 1]) of its own loop
+    int* loop_fanout_start;
+    int* loop_fanout;
+    // Register bytecode for sim_run: a header word (out << SIM_BC_SHIFT | opcode)
+    // followed by one operand word per input pin, terminated by SIM_BC_HALT
+    uint32_t* bytecode;
+    int bytecode_length;
+    // Native evaluator loaded by codegen.c, NULL while interpreting.
+    // Same layout as bitsim_run_wide: gate g uses values[g * nwords .. + nwords).
+    void (*native_eval)(uint64_t* values, int nwords);
+} SimProgram;
+
+// Event-driven engine: per-gate fan-out lists and a level-bucketed change queue.
+// Only gates downstream of a change are evaluated, an idle circuit costs nothing.
+// Cyclic netlists put every gate on level 0 and run the queue in delta cycles:
+// the gates queued at the start of a cycle all read the values from before it,
+// so an oscillating loop cannot starve the gates it drives and is recognized
+// by its state hash repeating.
+typedef struct {
+    int gate_count;
+    int max_level;
+    int cyclic;
+    int* types;
+    int* in;              // gate_count * SIM_MAX_PINS, unconnected pins read slot gate_count
+    int* level;
+    int* fanout_start;    // fan-out of gate g is fanout[fanout_start[g] .. fanout_start[g + 1])
+    int* fanout;
+    unsigned char* values;
+    unsigned char* queued;
+    int* next_queued;     // intrusive per-level lists threaded through the gates
+    int* bucket_head;
+    int* bucket_tail;
+    int lowest_level;
+    int pending;
+    unsigned char* changed_flag;
+    int* changed;         // gates whose value changed since the last sim_engine_clear_changes
+    int changed_count;
+    long evaluations;     // total gate evaluations, for diagnostics
+    int* delta_changes;   // changes of the current delta cycle, applied together
+    unsigned char* oscillating_flag;
+    int* oscillating;     // gates the last sim_engine_settle found oscillating
+    int oscillating_count;
+} SimEngine;
+
+// Netlist helpers
+int sim_netlist_init(SimNetlist* net, int gate_count);
+void sim_netlist_free(SimNetlist* net);
+
+// Compile a netlist into a levelized program, returns 0 on success
+int sim_compile(SimProgram* prog, const SimNetlist* net);
+void sim_free_program(SimProgram* prog);
+
+// Evaluate every gate exactly once in level order (feedback loops get one sweep).
+// Runs the bytecode with computed-goto dispatch where the compiler supports it.
+void sim_run(const SimProgram* prog, unsigned char* values);
+
+// Evaluate a program with feedback loops: one pass outside the loops, each loop
+// runs delta cycles until stable, until its state repeats (it oscillates, or its
+// gates race) or for max_deltas cycles. oscillating (gate_count entries, may be
+// NULL) flags the gates that keep toggling. Returns the loops left unsettled, -1 when out of memory.
+int sim_run_loops(const SimProgram* prog, unsigned char* values, int max_deltas, unsigned char* oscillating);
+
+// Event-driven engine, values start at 0 for every gate
+int sim_engine_init(SimEngine* eng, const SimNetlist* net, const SimProgram* prog);
+void sim_engine_free(SimEngine* eng);
+void sim_engine_schedule(SimEngine* eng, int gate);
+void sim_engine_schedule_all(SimEngine* eng);
+void sim_engine_set_value(SimEngine* eng, int gate, int value);
+int sim_engine_settle(SimEngine* eng, int max_evaluations);
+void sim_engine_clear_changes(SimEngine* eng);
+
+// Single gate evaluation shared by all engines
+int sim_eval_gate(int type, int a, int b);
+
+#endif
@@ -1,5 +1,5 @@
 // Digital Logic Circuit Simulator (SDL3, fullscreen, ASCII-only)
-// Build: gcc testt.c -o sim $(pkg-config --cflags --libs sdl3) -lm
+// Build: gcc testt.c arena.c handle.c netindex.c -o sim $(pkg-config --cflags --libs sdl3) -lm
 
 #include <SDL3/SDL.h>
 #include <SDL3/SDL_main.h>
@@ -8,14 +8,16 @@
 #include <string.h>
 #include <stdbool.h>
 #include <math.h>
+#include "arena.h"
+#include "handle.h"
+#include "netindex.h"
 
 /* Limits and layout */
-#define MAX_COMPONENTS 100
-#define MAX_WIRES 200
 #define MAX_UNDO_STACK 50
 #define COMPONENT_SIZE 60
 #define GRID_SIZE 20
 #define WIRE_CLICK_TOLERANCE 5
+#define MAX_LOOP_DELTAS 100
 
 /* Component types */
 typedef enum {
@@ -94,18 +96,21 @@ typedef struct {
     int screen_w;
     int screen_h;
 
-    Component components[MAX_COMPONENTS];
+    Component* components;         /* grows as components are added */
     int component_count;
+    int component_capacity;
+    HandleTable component_slots;   /* component id -> index in components */
     int next_component_id;
 
-    Wire wires[MAX_WIRES];
+    Wire* wires;
     int wire_count;
+    int wire_capacity;
     int next_wire_id;
 
     ToolMode current_tool;
     ComponentType selected_gate_type;
 
-    int dragging_component_id;
+    Handle dragging_component;     /* 0 when not dragging */
     float drag_dx, drag_dy;
 
     bool wiring_in_progress;
@@ -117,6 +122,23 @@ typedef struct {
     UndoAction redo_stack[MAX_UNDO_STACK];
     int redo_count;
 
+    /* Evaluation schedule, rebuilt when components or wires change: blocks are
+       strongly connected groups of components in driver-before-reader order,
+       eval_order[block_start[b] .. block_start[b + 1]) holds component indices.
+       The arrays live in schedule_arena, emptied by every rebuild; scratch holds
+       the working space of one rebuild or one loop settling */
+    bool topology_dirty;
+    NetIndex net;                  /* fan-in by input pin and fan-out, by component index */
+    Arena schedule_arena;
+    Arena scratch;
+    int* block_of;
+    int* eval_order;
+    int* order_position;           /* inverse of eval_order */
+    int* block_start;
+    bool* block_is_loop;
+    int block_count;
+    int loop_count;
+
     bool running;
     bool simulation_running;
     char error_message[256];
@@ -156,6 +178,7 @@ static void redo(AppState* app);
 
 /* Simulation */
 static int eval_gate(ComponentType t, int in1, int in2);
+static void build_schedule(AppState* app);
 static void simulate(AppState* app);
 
 /* Implementation */
@@ -246,10 +269,17 @@ static void app_init(AppState* app) {
     app->current_tool = TOOL_SELECT;
     app->selected_gate_type = COMP_AND;
     app->simulation_running = true;
+    app->topology_dirty = true;
     app->running = true;
 }
 
 static void app_cleanup(AppState* app) {
+    free(app->components);
+    free(app->wires);
+    handle_free(&app->component_slots);
+    netindex_free(&app->net);
+    arena_free(&app->schedule_arena);
+    arena_free(&app->scratch);
     if (app->renderer) SDL_DestroyRenderer(app->renderer);
     if (app->window) SDL_DestroyWindow(app->window);
     SDL_Quit();
@@ -260,10 +290,32 @@ static void cleanup_app(AppState* app) {
 }
 
 static Component* get_component_by_id(AppState* app, int id) {
-    for (int i = 0; i < app->component_count; i++) {
-        if (app->components[i].id == id) return &app->components[i];
+    int i = handle_slot(&app->component_slots, id);
+    return i >= 0 && i < app->component_count ? &app->components[i] : NULL;
+}
+
+/* Components stay packed in creation order; these two keep component_slots
+   in step with every insertion and removal */
+static bool append_component(AppState* app, const Component* c) {
+    if (array_reserve((void**)&app->components, &app->component_capacity, app->component_count + 1, sizeof(Component)) != 0 ||
+        handle_bind(&app->component_slots, c->id, app->component_count) != 0) return false;
+    app->components[app->component_count++] = *c;
+    return true;
+}
+
+static void remove_component_at(AppState* app, int i) {
+    for (int j = i; j < app->component_count - 1; j++) {
+        app->components[j] = app->components[j + 1];
+        handle_bind(&app->component_slots, app->components[j].id, j);
     }
-    return NULL;
+    app->component_count--;
+    handle_release(&app->component_slots, app->component_count);
+}
+
+static bool append_wire(AppState* app, const Wire* w) {
+    if (array_reserve((void**)&app->wires, &app->wire_capacity, app->wire_count + 1, sizeof(Wire)) != 0) return false;
+    app->wires[app->wire_count++] = *w;
+    return true;
 }
 
 static Wire* get_wire_by_id(AppState* app, int id) {
@@ -315,63 +367,57 @@ static Wire* hit_wire(AppState* app, float x, float y) {
 }
 
 static int add_component(AppState* app, ComponentType type, float x, float y) {
-    if (app->component_count >= MAX_COMPONENTS) {
-        set_error(app, "Component limit reached");
+    Component c;
+    SDL_zero(c);
+    c.id = app->next_component_id;
+    c.type = type;
+    c.x = x;
+    c.y = y;
+    c.output_value = -1;
+    c.input_state = false;
+    c.inputs[0] = -1;
+    c.inputs[1] = -1;
+    label_for(type, c.label, sizeof(c.label));
+    if (!append_component(app, &c)) {
+        set_error(app, "Out of memory");
         return -1;
     }
-    Component* c = &app->components[app->component_count++];
-    SDL_zero(*c);
-    c->id = app->next_component_id++;
-    c->type = type;
-    c->x = x;
-    c->y = y;
-    c->output_value = -1;
-    c->input_state = false;
-    c->inputs[0] = -1;
-    c->inputs[1] = -1;
-    label_for(type, c->label, sizeof(c->label));
+    app->next_component_id++;
+    app->topology_dirty = true;
 
     UndoAction a;
     SDL_zero(a);
     a.type = ACTION_ADD_COMPONENT;
-    a.component = *c;
+    a.component = c;
     push_undo(app, &a);
-    return c->id;
+    return c.id;
 }
 
 static void delete_component(AppState* app, int id) {
-    for (int i = 0; i < app->component_count; i++) {
-        if (app->components[i].id == id) {
-            UndoAction a;
-            SDL_zero(a);
-            a.type = ACTION_DELETE_COMPONENT;
-            a.component = app->components[i];
-            push_undo(app, &a);
+    int i = handle_slot(&app->component_slots, id);
+    if (i < 0 || i >= app->component_count) return;
 
-            /* remove wires attached */
-            for (int w = app->wire_count - 1; w >= 0; w--) {
-                if (app->wires[w].start.component_id == id ||
-                    app->wires[w].end.component_id == id) {
-                    for (int k = w; k < app->wire_count - 1; k++) {
-                        app->wires[k] = app->wires[k + 1];
-                    }
-                    app->wire_count--;
-                }
-            }
-            for (int j = i; j < app->component_count - 1; j++) {
-                app->components[j] = app->components[j + 1];
+    UndoAction a;
+    SDL_zero(a);
+    a.type = ACTION_DELETE_COMPONENT;
+    a.component = app->components[i];
+    push_undo(app, &a);
+
+    /* remove wires attached */
+    for (int w = app->wire_count - 1; w >= 0; w--) {
+        if (app->wires[w].start.component_id == id ||
+            app->wires[w].end.component_id == id) {
+            for (int k = w; k < app->wire_count - 1; k++) {
+                app->wires[k] = app->wires[k + 1];
             }
-            app->component_count--;
-            return;
+            app->wire_count--;
         }
     }
+    remove_component_at(app, i);
+    app->topology_dirty = true;
 }
 
 static int add_wire(AppState* app, ConnectionPoint s, ConnectionPoint e) {
-    if (app->wire_count >= MAX_WIRES) {
-        set_error(app, "Wire limit reached");
-        return -1;
-    }
     Component* sc = get_component_by_id(app, s.component_id);
     Component* ec = get_component_by_id(app, e.component_id);
     if (!sc || !ec) return -1;
@@ -380,20 +426,41 @@ static int add_wire(AppState* app, ConnectionPoint s, ConnectionPoint e) {
         return -1;
     }
 
-    Wire* w = &app->wires[app->wire_count++];
-    SDL_zero(*w);
-    w->id = app->next_wire_id++;
-    w->start = s;
-    w->end = e;
-    w->is_valid = true;
-    w->value = -1;
+    Wire w;
+    SDL_zero(w);
+    w.id = app->next_wire_id;
+    w.start = s;
+    w.end = e;
+    w.is_valid = true;
+    w.value = -1;
+    if (!append_wire(app, &w)) {
+        set_error(app, "Out of memory");
+        return -1;
+    }
+    app->next_wire_id++;
+    app->topology_dirty = true;
 
     UndoAction a;
     SDL_zero(a);
     a.type = ACTION_ADD_WIRE;
-    a.wire = *w;
+    a.wire = w;
     push_undo(app, &a);
-    return w->id;
+    return w.id;
+}
+
+/* First input pin of a component no wire ends on, -1 if all are taken */
+static int free_input_pin(AppState* app, const Component* c) {
+    int pins = c->type == COMP_INPUT_TOGGLE ? 0 :
+               (c->type == COMP_NOT || c->type == COMP_OUTPUT_LED) ? 1 : 2;
+    bool used[2] = {false, false};
+    for (int w = 0; w < app->wire_count; w++) {
+        int p = app->wires[w].end.pin_index;
+        if (app->wires[w].end.component_id == c->id && p >= 0 && p < 2) used[p] = true;
+    }
+    for (int p = 0; p < pins; p++) {
+        if (!used[p]) return p;
+    }
+    return -1;
 }
 
 static void delete_wire(AppState* app, int id) {
@@ -406,6 +473,7 @@ static void delete_wire(AppState* app, int id) {
             push_undo(app, &a);
             for (int j = i; j < app->wire_count - 1; j++) app->wires[j] = app->wires[j + 1];
             app->wire_count--;
+            app->topology_dirty = true;
             return;
         }
     }
@@ -425,20 +493,15 @@ static void undo(AppState* app) {
     if (app->undo_count <= 0) return;
     UndoAction a = app->undo_stack[--app->undo_count];
     app->redo_stack[app->redo_count++] = a;
+    if (a.type != ACTION_MOVE_COMPONENT) app->topology_dirty = true;
 
     switch (a.type) {
         case ACTION_ADD_COMPONENT: {
-            int id = a.component.id;
-            for (int i = 0; i < app->component_count; i++) {
-                if (app->components[i].id == id) {
-                    for (int j = i; j < app->component_count - 1; j++) app->components[j] = app->components[j + 1];
-                    app->component_count--;
-                    break;
-                }
-            }
+            int i = handle_slot(&app->component_slots, a.component.id);
+            if (i >= 0 && i < app->component_count) remove_component_at(app, i);
         } break;
         case ACTION_DELETE_COMPONENT: {
-            if (app->component_count < MAX_COMPONENTS) app->components[app->component_count++] = a.component;
+            append_component(app, &a.component);
         } break;
         case ACTION_ADD_WIRE: {
             int id = a.wire.id;
@@ -451,7 +514,7 @@ static void undo(AppState* app) {
             }
         } break;
         case ACTION_DELETE_WIRE: {
-            if (app->wire_count < MAX_WIRES) app->wires[app->wire_count++] = a.wire;
+            append_wire(app, &a.wire);
         } break;
         case ACTION_MOVE_COMPONENT: {
             Component* c = get_component_by_id(app, a.component.id);
@@ -464,23 +527,18 @@ static void undo(AppState* app) {
 static void redo(AppState* app) {
     if (app->redo_count <= 0) return;
     UndoAction a = app->redo_stack[--app->redo_count];
+    if (a.type != ACTION_MOVE_COMPONENT) app->topology_dirty = true;
 
     switch (a.type) {
         case ACTION_ADD_COMPONENT: {
-            if (app->component_count < MAX_COMPONENTS) app->components[app->component_count++] = a.component;
+            append_component(app, &a.component);
         } break;
         case ACTION_DELETE_COMPONENT: {
-            int id = a.component.id;
-            for (int i = 0; i < app->component_count; i++) {
-                if (app->components[i].id == id) {
-                    for (int j = i; j < app->component_count - 1; j++) app->components[j] = app->components[j + 1];
-                    app->component_count--;
-                    break;
-                }
-            }
+            int i = handle_slot(&app->component_slots, a.component.id);
+            if (i >= 0 && i < app->component_count) remove_component_at(app, i);
         } break;
         case ACTION_ADD_WIRE: {
-            if (app->wire_count < MAX_WIRES) app->wires[app->wire_count++] = a.wire;
+            append_wire(app, &a.wire);
         } break;
         case ACTION_DELETE_WIRE: {
             int id = a.wire.id;
@@ -500,36 +558,249 @@ static void redo(AppState* app) {
     }
 }
 
+/* Tarjan's strongly connected components over the input wires, iterative so
+   the search needs no recursion. Blocks come out with every driver's block
+   first; a block of several components, or a component wired to itself, is a
+   feedback loop that simulate settles in delta cycles. The loops are reported once here. */
+static void build_schedule(AppState* app) {
+    int n = app->component_count;
+    int counter = 0, top = 0, filled = 0;
+    ArenaMark empty = {NULL, 0};
+    ArenaMark mark = arena_mark(&app->scratch);
+    arena_release(&app->schedule_arena, empty);
+    app->block_count = 0;
+    app->loop_count = 0;
+
+    int* index = arena_alloc(&app->scratch, n, sizeof(int));
+    int* low = arena_alloc(&app->scratch, n, sizeof(int));
+    int* stack = arena_alloc(&app->scratch, n, sizeof(int));
+    int* call = arena_alloc(&app->scratch, n, sizeof(int));
+    int* next_input = arena_alloc(&app->scratch, n, sizeof(int));
+    int* from = arena_alloc(&app->scratch, app->wire_count, sizeof(int));
+    int* to = arena_alloc(&app->scratch, app->wire_count, sizeof(int));
+    int* pin = arena_alloc(&app->scratch, app->wire_count, sizeof(int));
+    app->block_of = arena_alloc(&app->schedule_arena, n, sizeof(int));
+    app->eval_order = arena_alloc(&app->schedule_arena, n, sizeof(int));
+    app->order_position = arena_alloc(&app->schedule_arena, n, sizeof(int));
+    app->block_start = arena_alloc(&app->schedule_arena, n + 1, sizeof(int));
+    app->block_is_loop = arena_alloc(&app->schedule_arena, n, sizeof(bool));
+    int* block_of = app->block_of;
+    if (!index || !low || !stack || !call || !next_input || !from || !to || !pin || !block_of ||
+        !app->eval_order || !app->order_position || !app->block_start || !app->block_is_loop) {
+        set_error(app, "Out of memory");
+        arena_release(&app->scratch, mark);
+        return;
+    }
+
+    /* Each wire drives the input pin it ends on; a missing component maps to -1
+       and the wire is left out of the index */
+    for (int w = 0; w < app->wire_count; w++) {
+        from[w] = handle_slot(&app->component_slots, app->wires[w].start.component_id);
+        to[w] = handle_slot(&app->component_slots, app->wires[w].end.component_id);
+        pin[w] = app->wires[w].end.pin_index;
+    }
+    if (netindex_build(&app->net, n, from, to, pin, app->wire_count) != 0) {
+        set_error(app, "Out of memory");
+        arena_release(&app->scratch, mark);
+        return;
+    }
+    for (int i = 0; i < n; i++) {
+        index[i] = -1;
+        block_of[i] = -1;
+        /* Toggles ignore their inputs, so they close no loop */
+        next_input[i] = app->components[i].type == COMP_INPUT_TOGGLE ?
+                        app->net.fanin_start[i + 1] : app->net.fanin_start[i];
+    }
+
+    int loop_components = 0;
+    for (int root = 0; root < n; root++) {
+        if (index[root] >= 0) continue;
+        int depth = 0;
+        index[root] = low[root] = counter++;
+        stack[top++] = root;
+        call[depth++] = root;
+        while (depth > 0) {
+            int c = call[depth - 1];
+            if (next_input[c] < app->net.fanin_start[c + 1]) {
+                int src = app->net.fanin[next_input[c]++];
+                if (index[src] < 0) {
+                    index[src] = low[src] = counter++;
+                    stack[top++] = src;
+                    call[depth++] = src;
+                } else if (block_of[src] < 0 && index[src] < low[c]) {
+                    low[c] = index[src];
+                }
+                continue;
+            }
+            depth--;
+            if (depth > 0 && low[c] < low[call[depth - 1]]) low[call[depth - 1]] = low[c];
+            if (low[c] != index[c]) continue;
+
+            int b = app->block_count++;
+            int m;
+            app->block_start[b] = filled;
+            do {
+                m = stack[--top];
+                block_of[m] = b;
+                app->order_position[m] = filled;
+                app->eval_order[filled++] = m;
+            } while (m != c);
+            app->block_is_loop[b] = filled - app->block_start[b] > 1;
+            for (int k = app->net.fanin_start[c]; k < app->net.fanin_start[c + 1]; k++) {
+                if (app->net.fanin[k] == c && app->components[c].type != COMP_INPUT_TOGGLE) app->block_is_loop[b] = true;
+            }
+            if (app->block_is_loop[b]) {
+                app->loop_count++;
+                loop_components += filled - app->block_start[b];
+            }
+        }
+    }
+    app->block_start[app->block_count] = filled;
+    app->topology_dirty = false;
+    arena_release(&app->scratch, mark);
+
+    if (app->loop_count > 0) {
+        char msg[128];
+        SDL_snprintf(msg, sizeof(msg), "Feedback: %d loop(s) through %d components",
+                     app->loop_count, loop_components);
+        set_error(app, msg);
+    }
+}
+
+/* Evaluate one component from the current outputs of its drivers, read in pin
+   order; of several wires on one pin the last one added wins */
+static int eval_component(AppState* app, int i) {
+    Component* c = &app->components[i];
+    int in[2] = {-1, -1};
+    for (int k = app->net.fanin_start[i]; k < app->net.fanin_start[i + 1]; k++) {
+        int p = app->net.fanin_pin[k];
+        if (p < 2) in[p] = app->components[app->net.fanin[k]].output_value;
+    }
+    if (c->type == COMP_OUTPUT_LED) return in[0];
+    return eval_gate(c->type, in[0], in[1]);
+}
+
+/* Fixed pseudo-random key per component and value (splitmix64); XOR-ing keys
+   out and in as outputs change keeps a hash of a loop's state */
+static Uint64 state_key(int i, int value) {
+    Uint64 x = (Uint64)(i * 3 + value + 1) + 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+/* Set a loop component's output and queue the components of block b reading
+   it; queued is indexed by position in the block */
+static void loop_apply(AppState* app, int b, int i, int value, Uint64* hash,
+                       bool* queued, int* next, int* next_count) {
+    Component* c = &app->components[i];
+    *hash ^= state_key(i, c->output_value) ^ state_key(i, value);
+    c->output_value = value;
+    for (int k = app->net.fanout_start[i]; k < app->net.fanout_start[i + 1]; k++) {
+        int r = app->net.fanout[k];
+        if (app->block_of[r] != b) continue;
+        int slot = app->order_position[r] - app->block_start[b];
+        if (!queued[slot]) {
+            queued[slot] = true;
+            next[(*next_count)++] = r;
+        }
+    }
+}
+
+/* Settle feedback loop b in delta cycles: the components queued for a cycle
+   all read the outputs from before it, then the changes are applied and queue
+   the readers for the next one. Loops keep their outputs between frames, so a
+   latch holds its state. A repeated state hash (checked Brent-style against one
+   saved hash) means the loop oscillates, or races: both sides of a latch that
+   power up or are released together keep toggling, and only the component
+   order would pick a winner. The components toggling over one more period are
+   reported either way. */
+static void settle_loop(AppState* app, int b) {
+    int first = app->block_start[b], size = app->block_start[b + 1] - first;
+    ArenaMark mark = arena_mark(&app->scratch);
+    int* queue = arena_alloc(&app->scratch, size, sizeof(int));
+    int* next = arena_alloc(&app->scratch, size, sizeof(int));
+    int* changed = arena_alloc(&app->scratch, size, sizeof(int));
+    int* value = arena_alloc(&app->scratch, size, sizeof(int));
+    bool* queued = arena_alloc(&app->scratch, size, sizeof(bool));
+    bool* toggled = arena_alloc(&app->scratch, size, sizeof(bool));
+    if (!queue || !next || !changed || !value || !queued || !toggled) {
+        set_error(app, "Out of memory");
+        arena_release(&app->scratch, mark);
+        return;
+    }
+    int count = 0;
+    Uint64 hash = 0, saved = 0;
+    int power = 1, length = 0, marking = 0;
+    bool oscillates = false;
+
+    /* An unknown output would lock the loop at unknown, loops power up at 0 */
+    for (int k = first; k < first + size; k++) {
+        int i = app->eval_order[k];
+        if (app->components[i].output_value == -1) app->components[i].output_value = 0;
+        queued[k - first] = true;
+        queue[count++] = i;
+    }
+    for (int delta = 0; delta < MAX_LOOP_DELTAS && count > 0; delta++) {
+        int changes = 0, next_count = 0;
+        for (int q = 0; q < count; q++) {
+            int i = queue[q];
+            queued[app->order_position[i] - first] = false;
+            int v = eval_component(app, i);
+            if (v == app->components[i].output_value) continue;
+            changed[changes] = i;
+            value[changes++] = v;
+        }
+        for (int k = 0; k < changes; k++) {
+            loop_apply(app, b, changed[k], value[k], &hash, queued, next, &next_count);
+            if (marking) toggled[app->order_position[changed[k]] - first] = true;
+        }
+        SDL_memcpy(queue, next, next_count * sizeof(int));
+        count = next_count;
+
+        if (marking) {
+            oscillates = --marking == 0;
+            if (oscillates) break;
+            continue;
+        }
+        if (count == 0) break;
+        length++;
+        if (hash == saved) {
+            marking = length;
+        } else if (length == power) {
+            saved = hash;
+            power *= 2;
+            length = 0;
+        }
+    }
+
+    if (oscillates) {
+        char msg[256];
+        int used = SDL_snprintf(msg, sizeof(msg), "Oscillating or racing:");
+        for (int i = 0; i < app->component_count && used < (int)sizeof(msg); i++) {
+            if (app->block_of[i] == b && toggled[app->order_position[i] - first]) used += SDL_snprintf(msg + used, sizeof(msg) - used, " %d", app->components[i].id);
+        }
+        set_error(app, msg);
+    }
+    arena_release(&app->scratch, mark);
+}
+
 static void simulate(AppState* app) {
-    for (int i = 0; i < app->component_count; i++) app->components[i].output_value = -1;
+    if (app->topology_dirty) build_schedule(app);
 
     for (int i = 0; i < app->component_count; i++) {
         Component* c = &app->components[i];
         if (c->type == COMP_INPUT_TOGGLE) c->output_value = c->input_state ? 1 : 0;
     }
 
-    for (int iter = 0; iter < 16; iter++) {
-        bool changed = false;
-        for (int i = 0; i < app->component_count; i++) {
-            Component* c = &app->components[i];
-            if (c->type == COMP_INPUT_TOGGLE) continue;
-
-            int in0 = -1, in1 = -1;
-            for (int w = 0; w < app->wire_count; w++) {
-                Wire* wire = &app->wires[w];
-                if (wire->end.component_id == c->id) {
-                    Component* src = get_component_by_id(app, wire->start.component_id);
-                    if (!src) continue;
-                    if (in0 == -1) in0 = src->output_value;
-                    else in1 = src->output_value;
-                }
-            }
-            int old = c->output_value;
-            if (c->type == COMP_OUTPUT_LED) c->output_value = in0;
-            else c->output_value = eval_gate(c->type, in0, in1);
-            if (old != c->output_value) changed = true;
+    /* Blocks come drivers first: the others are evaluated once, loops settle */
+    for (int b = 0; b < app->block_count; b++) {
+        if (app->block_is_loop[b]) {
+            settle_loop(app, b);
+            continue;
         }
-        if (!changed) break;
+        int i = app->eval_order[app->block_start[b]];
+        if (app->components[i].type != COMP_INPUT_TOGGLE) app->components[i].output_value = eval_component(app, i);
     }
 
     for (int w = 0; w < app->wire_count; w++) {
@@ -539,6 +810,30 @@ static void simulate(AppState* app) {
     }
 }
 
+/* Log the bytes held per component and per wire at the capacity reserved:
+   records, id table, net index and schedule, so larger designs can be sized */
+static void report_memory(AppState* app) {
+    size_t component_records = (size_t)app->component_capacity * sizeof(Component);
+    size_t component_index = (size_t)app->component_slots.id_capacity * sizeof(int) +
+                             (size_t)app->component_slots.slot_capacity * (sizeof(int) + sizeof(uint32_t)) +
+                             (size_t)app->net.node_capacity * 2 * sizeof(int);
+    size_t schedule = arena_reserved(&app->schedule_arena);
+    size_t wire_records = (size_t)app->wire_capacity * sizeof(Wire);
+    size_t wire_index = (size_t)app->net.edge_capacity * 4 * sizeof(int);
+    int components = app->component_count > 0 ? app->component_count : 1;
+    int wires = app->wire_count > 0 ? app->wire_count : 1;
+
+    SDL_Log("Memory: %d components, %d wires\n", app->component_count, app->wire_count);
+    SDL_Log("  per component: %zu bytes (%zu record, %zu index, %zu schedule)\n",
+            (component_records + component_index + schedule) / components, component_records / components,
+            component_index / components, schedule / components);
+    SDL_Log("  per wire: %zu bytes (%zu record, %zu index)\n",
+            (wire_records + wire_index) / wires, wire_records / wires, wire_index / wires);
+    SDL_Log("  scratch: %zu KB\n", arena_reserved(&app->scratch) / 1024);
+    AllocationCounters heap = allocation_counters();
+    SDL_Log("  heap: %ld arena blocks, %ld array grows, %zu KB\n", heap.arena_blocks, heap.array_grows, heap.bytes / 1024);
+}
+
 /* Input handling */
 static void app_events(AppState* app) {
     SDL_Event ev;
@@ -555,6 +850,7 @@ static void app_events(AppState* app) {
             else if (k == SDLK_S) app->current_tool = TOOL_SELECT;
             else if (k == SDLK_W) app->current_tool = TOOL_WIRE;
             else if (k == SDLK_D) app->current_tool = TOOL_DELETE;
+            else if (k == SDLK_M) report_memory(app);
             else if (k == SDLK_1) { app->current_tool = TOOL_ADD_GATE; app->selected_gate_type = COMP_AND; }
             else if (k == SDLK_2) { app->current_tool = TOOL_ADD_GATE; app->selected_gate_type = COMP_OR; }
             else if (k == SDLK_3) { app->current_tool = TOOL_ADD_GATE; app->selected_gate_type = COMP_NOT; }
@@ -576,7 +872,7 @@ static void app_events(AppState* app) {
                 if (c) {
                     if (c->type == COMP_INPUT_TOGGLE) c->input_state = !c->input_state;
                     else {
-                        app->dragging_component_id = c->id;
+                        app->dragging_component = handle_of(&app->component_slots, (int)(c - app->components));
                         app->drag_dx = mx - c->x;
                         app->drag_dy = my - c->y;
                     }
@@ -591,8 +887,9 @@ static void app_events(AppState* app) {
                     } else {
                         ConnectionPoint endp;
                         endp.component_id = c->id;
-                        endp.pin_index = 0; /* to input 0 (simplified) */
-                        add_wire(app, app->wire_start, endp);
+                        endp.pin_index = free_input_pin(app, c); /* inputs fill in pin order */
+                        if (endp.pin_index < 0) set_error(app, "No free input");
+                        else add_wire(app, app->wire_start, endp);
                         app->wiring_in_progress = false;
                     }
                 } else if (app->wiring_in_progress) {
@@ -609,31 +906,29 @@ static void app_events(AppState* app) {
         }
 
         else if (ev.type == SDL_EVENT_MOUSE_BUTTON_UP && ev.button.button == SDL_BUTTON_LEFT) {
-            if (app->dragging_component_id != -1) {
-                Component* c = get_component_by_id(app, app->dragging_component_id);
-                if (c) {
-                    UndoAction a;
-                    SDL_zero(a);
-                    a.type = ACTION_MOVE_COMPONENT;
-                    a.component = *c;
-                    a.old_x = c->x; a.old_y = c->y; /* best-effort: ideally store old at down */
-                    a.new_x = c->x; a.new_y = c->y;
-                    push_undo(app, &a);
-                }
+            int i = handle_resolve(&app->component_slots, app->dragging_component);
+            if (i >= 0 && i < app->component_count) {
+                Component* c = &app->components[i];
+                UndoAction a;
+                SDL_zero(a);
+                a.type = ACTION_MOVE_COMPONENT;
+                a.component = *c;
+                a.old_x = c->x; a.old_y = c->y; /* best-effort: ideally store old at down */
+                a.new_x = c->x; a.new_y = c->y;
+                push_undo(app, &a);
             }
-            app->dragging_component_id = -1;
+            app->dragging_component = 0;
         }
 
         else if (ev.type == SDL_EVENT_MOUSE_MOTION) {
             float mx = (float)ev.motion.x;
             float my = (float)ev.motion.y;
 
-            if (app->dragging_component_id != -1) {
-                Component* c = get_component_by_id(app, app->dragging_component_id);
-                if (c) {
-                    c->x = mx - app->drag_dx;
-                    c->y = my - app->drag_dy;
-                }
+            int i = handle_resolve(&app->component_slots, app->dragging_component);
+            if (i >= 0 && i < app->component_count) {
+                Component* c = &app->components[i];
+                c->x = mx - app->drag_dx;
+                c->y = my - app->drag_dy;
             }
             if (app->wiring_in_progress) {
                 app->wire_temp_x = mx;
@@ -0,0 +1,357 @@
+#include <stdlib.h>
+#include <string.h>
+#include "topo.h"
+
+void topo_init(TopoOrder* t) {
+    memset(t, 0, sizeof(TopoOrder));
+    t->first_feedback = -1;
+    t->free_edge = -1;
+}
+
+void topo_free(TopoOrder* t) {
+    free(t->order);
+    free(t->position);
+    free(t->first_out);
+    free(t->first_in);
+    free(t->edge_from);
+    free(t->edge_to);
+    free(t->next_out);
+    free(t->next_in);
+    free(t->mark);
+    free(t->stack);
+    free(t->parent);
+    free(t->found);
+    free(t->keys);
+    topo_init(t);
+}
+
+// Function to resize an array, keeping its contents. On failure the old array stays.
+static int grow(void** array, int count, size_t size) {
+    void* bigger = realloc(*array, count * size);
+    if (!bigger) return -1;
+    *array = bigger;
+    return 0;
+}
+
+int topo_reserve(TopoOrder* t, int node_count) {
+    if (t->node_capacity == 0) {
+        // A zeroed order has no edges yet, start its lists empty
+        t->first_feedback = -1;
+        t->free_edge = -1;
+    }
+    if (node_count > t->node_capacity) {
+        int capacity = t->node_capacity < 16 ? 16 : t->node_capacity * 2;
+        if (capacity < node_count) capacity = node_count;
+        if (grow((void**)&t->order, capacity, sizeof(int)) != 0 ||
+            grow((void**)&t->position, capacity, sizeof(int)) != 0 ||
+            grow((void**)&t->first_out, capacity, sizeof(int)) != 0 ||
+            grow((void**)&t->first_in, capacity, sizeof(int)) != 0 ||
+            grow((void**)&t->mark, capacity, sizeof(unsigned char)) != 0 ||
+            grow((void**)&t->stack, capacity, sizeof(int)) != 0 ||
+            grow((void**)&t->parent, capacity, sizeof(int)) != 0 ||
+            grow((void**)&t->found, capacity, sizeof(int)) != 0 ||
+            grow((void**)&t->keys, capacity, sizeof(uint64_t)) != 0) {
+            return -1;
+        }
+        t->node_capacity = capacity;
+    }
+    for (int v = t->node_count; v < node_count; v++) {
+        t->order[v] = v;
+        t->position[v] = v;
+        t->first_out[v] = -1;
+        t->first_in[v] = -1;
+        t->mark[v] = 0;
+    }
+    if (node_count > t->node_count) t->node_count = node_count;
+    return 0;
+}
+
+// Function to take an edge slot from the free list, or a new one
+static int new_edge(TopoOrder* t, int from, int to) {
+    int e = t->free_edge;
+    if (e >= 0) {
+        t->free_edge = t->next_out[e];
+    } else {
+        // With no free slot every slot below edge_count is in use
+        if (t->edge_count == t->edge_capacity) {
+            int capacity = t->edge_capacity < 16 ? 16 : t->edge_capacity * 2;
+            if (grow((void**)&t->edge_from, capacity, sizeof(int)) != 0 ||
+                grow((void**)&t->edge_to, capacity, sizeof(int)) != 0 ||
+                grow((void**)&t->next_out, capacity, sizeof(int)) != 0 ||
+                grow((void**)&t->next_in, capacity, sizeof(int)) != 0) {
+                return -1;
+            }
+            t->edge_capacity = capacity;
+        }
+        e = t->edge_count;
+    }
+    t->edge_from[e] = from;
+    t->edge_to[e] = to;
+    t->edge_count++;
+    return e;
+}
+
+static void free_edge(TopoOrder* t, int e) {
+    t->next_out[e] = t->free_edge;
+    t->free_edge = e;
+    t->edge_count--;
+}
+
+static int compare_keys(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+// Function to insert edge e into the order. Nodes placed between its endpoints
+// are searched forward from its head and backward from its tail; if the forward
+// search reaches the tail the edge closes a cycle and becomes a feedback edge.
+// Otherwise the nodes found backward move ahead of the ones found forward,
+// reusing the same places, and every other node stays where it was.
+static int place_edge(TopoOrder* t, int e, int* cycle, int* cycle_length) {
+    int from = t->edge_from[e], to = t->edge_to[e];
+    int lower = t->position[to], upper = t->position[from];
+    if (lower > upper) {
+        t->next_out[e] = t->first_out[from];
+        t->first_out[from] = e;
+        t->next_in[e] = t->first_in[to];
+        t->first_in[to] = e;
+        return 0;
+    }
+
+    int forward = 0, top = 0, closes = from == to;
+    if (!closes) {
+        t->mark[to] = 1;
+        t->parent[to] = -1;
+        t->found[forward++] = to;
+        t->stack[top++] = to;
+    }
+    while (top > 0 && !closes) {
+        int v = t->stack[--top];
+        for (int k = t->first_out[v]; k >= 0; k = t->next_out[k]) {
+            int w = t->edge_to[k];
+            if (w == from) {
+                t->parent[from] = v;
+                closes = 1;
+                break;
+            }
+            if (!t->mark[w] && t->position[w] < upper) {
+                t->mark[w] = 1;
+                t->parent[w] = v;
+                t->found[forward++] = w;
+                t->stack[top++] = w;
+            }
+        }
+    }
+
+    if (closes) {
+        if (cycle) {
+            int length = 0;
+            if (from == to) {
+                cycle[length++] = from;
+            } else {
+                for (int v = from; v >= 0; v = t->parent[v]) {
+                    cycle[length++] = v;
+                }
+            }
+            for (int i = 0; i < length / 2; i++) {
+                int swap = cycle[i];
+                cycle[i] = cycle[length - 1 - i];
+                cycle[length - 1 - i] = swap;
+            }
+            if (cycle_length) *cycle_length = length;
+        }
+        for (int i = 0; i < forward; i++) {
+            t->mark[t->found[i]] = 0;
+        }
+        t->next_out[e] = t->first_feedback;
+        t->next_in[e] = -1;
+        t->first_feedback = e;
+        t->feedback_count++;
+        return 1;
+    }
+
+    // Nothing the head reaches can reach the tail, so the two searches are disjoint
+    int backward = forward;
+    t->mark[from] = 1;
+    t->found[backward++] = from;
+    t->stack[top++] = from;
+    while (top > 0) {
+        int v = t->stack[--top];
+        for (int k = t->first_in[v]; k >= 0; k = t->next_in[k]) {
+            int w = t->edge_from[k];
+            if (!t->mark[w] && t->position[w] > lower) {
+                t->mark[w] = 1;
+                t->found[backward++] = w;
+                t->stack[top++] = w;
+            }
+        }
+    }
+
+    // Sort both groups by place, merge their places, then hand them out
+    // backward group first
+    for (int i = 0; i < backward; i++) {
+        int v = t->found[i];
+        t->keys[i] = (uint64_t)t->position[v] << 32 | (uint32_t)v;
+        t->mark[v] = 0;
+    }
+    qsort(t->keys, forward, sizeof(uint64_t), compare_keys);
+    qsort(t->keys + forward, backward - forward, sizeof(uint64_t), compare_keys);
+    int a = 0, b = forward;
+    for (int i = 0; i < backward; i++) {
+        if (b >= backward || (a < forward && t->keys[a] < t->keys[b])) {
+            t->stack[i] = (int)(t->keys[a++] >> 32);
+        } else {
+            t->stack[i] = (int)(t->keys[b++] >> 32);
+        }
+    }
+    for (int i = 0; i < backward; i++) {
+        uint64_t key = i < backward - forward ? t->keys[forward + i] : t->keys[i - (backward - forward)];
+        int v = (int)(uint32_t)key;
+        t->position[v] = t->stack[i];
+        t->order[t->stack[i]] = v;
+    }
+
+    t->next_out[e] = t->first_out[from];
+    t->first_out[from] = e;
+    t->next_in[e] = t->first_in[to];
+    t->first_in[to] = e;
+    return 0;
+}
+
+int topo_add_edge(TopoOrder* t, int from, int to, int* cycle, int* cycle_length) {
+    if (from < 0 || to < 0 || from >= t->node_count || to >= t->node_count) return -1;
+    int e = new_edge(t, from, to);
+    if (e < 0) return -1;
+    return place_edge(t, e, cycle, cycle_length);
+}
+
+int topo_remove_edge(TopoOrder* t, int from, int to) {
+    if (from < 0 || to < 0 || from >= t->node_count || to >= t->node_count) return -1;
+
+    // A feedback edge is outside the order, dropping it changes nothing else
+    for (int* link = &t->first_feedback; *link >= 0; link = &t->next_out[*link]) {
+        int e = *link;
+        if (t->edge_from[e] == from && t->edge_to[e] == to) {
+            *link = t->next_out[e];
+            t->feedback_count--;
+            free_edge(t, e);
+            return 0;
+        }
+    }
+
+    int e = -1;
+    for (int* link = &t->first_out[from]; *link >= 0; link = &t->next_out[*link]) {
+        if (t->edge_to[*link] == to) {
+            e = *link;
+            *link = t->next_out[e];
+            break;
+        }
+    }
+    if (e < 0) return -1;
+    for (int* link = &t->first_in[to]; *link >= 0; link = &t->next_in[*link]) {
+        if (*link == e) {
+            *link = t->next_in[e];
+            break;
+        }
+    }
+    free_edge(t, e);
+
+    // The order stays valid without the edge, but a cycle may now be broken
+    int pending = t->first_feedback;
+    t->first_feedback = -1;
+    t->feedback_count = 0;
+    while (pending >= 0) {
+        int next = t->next_out[pending];
+        place_edge(t, pending, NULL, NULL);
+        pending = next;
+    }
+    return 0;
+}
+
+int topo_build(TopoOrder* t, int node_count, const int* from, const int* to, int edge_count) {
+    topo_free(t);
+    if (topo_reserve(t, node_count) != 0) return -1;
+    for (int i = 0; i < edge_count; i++) {
+        if (from[i] < 0 || to[i] < 0 || from[i] >= node_count || to[i] >= node_count) return -1;
+    }
+
+    // Out-edges of each node as a contiguous range of targets
+    int* start = calloc(node_count + 2, sizeof(int));
+    int* target = malloc((edge_count + 1) * sizeof(int));
+    if (!start || !target) {
+        free(start);
+        free(target);
+        return -1;
+    }
+    for (int i = 0; i < edge_count; i++) {
+        start[from[i] + 2]++;
+    }
+    for (int v = 0; v < node_count; v++) {
+        start[v + 2] += start[v + 1];
+    }
+    for (int i = 0; i < edge_count; i++) {
+        target[start[from[i] + 1]++] = to[i];
+    }
+
+    // Depth-first search, every node is placed ahead of the nodes it reaches
+    // unless they are still on the search path. Filling the order from the
+    // back makes every edge point forward except the ones closing a cycle.
+    int* next = t->parent;  // next out-edge to follow per node on the path
+    int place = node_count;
+    for (int root = 0; root < node_count; root++) {
+        if (t->mark[root]) continue;
+        int top = 0;
+        t->mark[root] = 1;
+        next[root] = start[root];
+        t->stack[top++] = root;
+        while (top > 0) {
+            int v = t->stack[top - 1];
+            if (next[v] < start[v + 1]) {
+                int w = target[next[v]++];
+                if (!t->mark[w]) {
+                    t->mark[w] = 1;
+                    next[w] = start[w];
+                    t->stack[top++] = w;
+                }
+            } else {
+                top--;
+                t->order[--place] = v;
+            }
+        }
+    }
+    for (int p = 0; p < node_count; p++) {
+        t->position[t->order[p]] = p;
+        t->mark[t->order[p]] = 0;
+    }
+    free(start);
+    free(target);
+
+    // An edge pointing back leads to a node that was on the search path, so
+    // the tree edges already close its cycle
+    for (int i = 0; i < edge_count; i++) {
+        int e = new_edge(t, from[i], to[i]);
+        if (e < 0) return -1;
+        if (t->position[from[i]] < t->position[to[i]]) {
+            t->next_out[e] = t->first_out[from[i]];
+            t->first_out[from[i]] = e;
+            t->next_in[e] = t->first_in[to[i]];
+            t->first_in[to[i]] = e;
+        } else {
+            t->next_out[e] = t->first_feedback;
+            t->next_in[e] = -1;
+            t->first_feedback = e;
+            t->feedback_count++;
+        }
+    }
+    return t->feedback_count;
+}
+
+size_t topo_reserved(const TopoOrder* t) {
+    size_t per_node = 7 * sizeof(int) + sizeof(unsigned char) + sizeof(uint64_t);
+    return (size_t)t->node_capacity * per_node + topo_edges_reserved(t);
+}
+
+size_t topo_edges_reserved(const TopoOrder* t) {
+    return (size_t)t->edge_capacity * 4 * sizeof(int);
+}
@@ -0,0 +1,65 @@
+#ifndef TOPO_H
+#define TOPO_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Topological order of a growing graph, maintained edge by edge (Pearce-Kelly).
+// Inserting an edge that already points forward costs O(1); otherwise only the
+// nodes placed between its endpoints that it can reach, or be reached from, are
+// searched and shuffled. An edge that would close a cycle is kept apart as a
+// feedback edge and retried whenever an edge is removed, so the order always
+// covers the rest of the graph. A zero-initialized TopoOrder is empty.
+typedef struct {
+    int node_count;
+    int node_capacity;
+    int* order;             // node at each place, every ordered edge points to a later place
+    int* position;          // place of each node in order
+    int* first_out;         // per node edge lists, -1 terminated
+    int* first_in;
+    int edge_count;         // live edges, feedback edges included
+    int edge_capacity;
+    int* edge_from;
+    int* edge_to;
+    int* next_out;          // also chains the feedback edges and the free slots
+    int* next_in;
+    int first_feedback;
+    int free_edge;
+    int feedback_count;     // edges left out of the order because they close a cycle
+    // Search scratch, node_capacity entries each
+    unsigned char* mark;
+    int* stack;
+    int* parent;
+    int* found;
+    uint64_t* keys;
+} TopoOrder;
+
+void topo_init(TopoOrder* t);
+void topo_free(TopoOrder* t);
+
+// Make nodes 0 .. node_count - 1 exist, new nodes are placed last.
+// Returns 0 on success, -1 when out of memory.
+int topo_reserve(TopoOrder* t, int node_count);
+
+// Add the edge from -> to. Returns 0 when the order now covers it, 1 when it
+// closes a cycle and was kept as a feedback edge, -1 when out of memory. On 1,
+// cycle (node_count entries, may be NULL) receives the path to .. from that the
+// edge closes and *cycle_length its node count.
+int topo_add_edge(TopoOrder* t, int from, int to, int* cycle, int* cycle_length);
+
+// Replace the graph by nodes 0 .. node_count - 1 and the edges from[i] -> to[i].
+// One depth-first search orders everything in O(nodes + edges), the edges it
+// finds closing a cycle become the feedback edges. Returns the number of
+// feedback edges, -1 when out of memory or given a node out of range.
+int topo_build(TopoOrder* t, int node_count, const int* from, const int* to, int edge_count);
+
+// Remove one edge from -> to, then retry the feedback edges.
+// Returns 0 on success, -1 if there is no such edge.
+int topo_remove_edge(TopoOrder* t, int from, int to);
+
+// Bytes the order holds in its arrays, in use or spare, and the part of them
+// kept per edge
+size_t topo_reserved(const TopoOrder* t);
+size_t topo_edges_reserved(const TopoOrder* t);
+
+#endif
@@ -1,4 +1,13 @@
 #include "truth_table.h"
+#include "ttpool.h"
+#include "codegen.h"
+#include "equiv.h"
+#include "bdd.h"
+#include "minimize.h"
+#include "aig.h"
+#include "rewrite.h"
+#include "simopt.h"
+#include "arena.h"
 #include <SDL3/SDL.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -11,7 +20,8 @@
 #define CELL_HEIGHT 30
 #define HEADER_HEIGHT 40
 #define MARGIN 20
-#define MAX_GATES 50  
+#define SYMBOLIC_MAX_CUBES 32
+#define MINIMIZED_MAX_TERMS 32
 
 // Define the structures locally since we can't include circuit_visual.h
 typedef struct {
@@ -27,7 +37,7 @@ typedef struct {
     int drag_offset_y;
     bool in_palette;
     int id;
-    int* input_values;
+    int input_values[SIM_MAX_PINS];
     int output_value;
     int gate_type;
 } LogicGate;
@@ -40,9 +50,13 @@ typedef struct {
     SDL_Color color;
 } Wire;
 
+// Scratch space of the functions below, sized by the circuit they work on
+static Arena scratch;
+
 // Forward declare the propagate_signals function (defined in your main file)
 void propagate_signals(void* gates_ptr, int gate_count, void* wires_ptr, int wire_count);
 void propagate_signals(void* gates_ptr, int gate_count, void* wires_ptr, int wire_count);
+int build_sim_netlist(void* gates_ptr, int gate_count, void* wires_ptr, int wire_count, SimNetlist* net);
 
 // Function to find all INPUT gates in the circuit
 int find_input_gates(void* gates_ptr, int gate_count, int* input_gate_indices) {
@@ -74,43 +88,36 @@ void simulate_circuit_with_inputs(void* gates_ptr, int gate_count, void* wires_p
     LogicGate* gates = (LogicGate*)gates_ptr;
     Wire* wires = (Wire*)wires_ptr;
     
-    // Create a temporary copy of the circuit to avoid modifying the original
-    LogicGate* temp_gates = malloc(gate_count * sizeof(LogicGate));
-    for (int i = 0; i < gate_count; i++) {
-        temp_gates[i] = gates[i];
-        if (temp_gates[i].input_values && temp_gates[i].inputs > 0) {
-            temp_gates[i].input_values = malloc(temp_gates[i].inputs * sizeof(int));
-            for (int j = 0; j < temp_gates[i].inputs; j++) {
-                temp_gates[i].input_values[j] = 0;
-            }
+    // Create a temporary copy of the circuit to avoid modifying the original.
+    // Pin values are part of the gate records, so one copy takes them along
+    // and every row after the first reuses the same scratch space.
+    ArenaMark mark = arena_mark(&scratch);
+    LogicGate* temp_gates = arena_alloc(&scratch, gate_count, sizeof(LogicGate));
+    int* input_gate_indices = arena_alloc(&scratch, gate_count, sizeof(int));
+    int* output_gate_indices = arena_alloc(&scratch, gate_count, sizeof(int));
+    if (temp_gates && input_gate_indices && output_gate_indices) {
+        for (int i = 0; i < gate_count; i++) {
+            temp_gates[i] = gates[i];
+            memset(temp_gates[i].input_values, 0, sizeof(temp_gates[i].input_values));
+            temp_gates[i].output_value = 0;
         }
-        temp_gates[i].output_value = 0;
-    }
-    
-    // Set input values
-    int input_gate_indices[MAX_GATES];
-    int num_inputs = find_input_gates(temp_gates, gate_count, input_gate_indices);
-    for (int i = 0; i < num_inputs; i++) {
-        temp_gates[input_gate_indices[i]].output_value = input_values[i];
-    }
-    
-    // Propagate signals
-    propagate_signals((void*)temp_gates, gate_count, (void*)wires, wire_count);
-    
-    // Read output values
-    int output_gate_indices[MAX_GATES];
-    int num_outputs = find_output_gates(temp_gates, gate_count, output_gate_indices);
-    for (int i = 0; i < num_outputs; i++) {
-        output_values[i] = temp_gates[output_gate_indices[i]].output_value;
-    }
-    
-    // Cleanup
-    for (int i = 0; i < gate_count; i++) {
-        if (temp_gates[i].input_values && !gates[i].in_palette) {
-            free(temp_gates[i].input_values);
+        
+        // Set input values
+        int num_inputs = find_input_gates(temp_gates, gate_count, input_gate_indices);
+        for (int i = 0; i < num_inputs; i++) {
+            temp_gates[input_gate_indices[i]].output_value = input_values[i];
+        }
+        
+        // Propagate signals
+        propagate_signals((void*)temp_gates, gate_count, (void*)wires, wire_count);
+        
+        // Read output values
+        int num_outputs = find_output_gates(temp_gates, gate_count, output_gate_indices);
+        for (int i = 0; i < num_outputs; i++) {
+            output_values[i] = temp_gates[output_gate_indices[i]].output_value;
         }
     }
-    free(temp_gates);
+    arena_release(&scratch, mark);
 }
 
 // Text drawing function for truth table
@@ -157,9 +164,9 @@ void draw_table_text(SDL_Renderer* renderer, const char* text, float x, float y,
 }
 
 // Function to draw the truth table window
-void draw_truth_table_window(void* gates_ptr, int gate_count, int num_inputs, int num_outputs,
-                           int* input_gate_indices, int* output_gate_indices) {
-    LogicGate* gates = (LogicGate*)gates_ptr;
+void draw_truth_table_window(const TruthTable* table) {
+    int num_inputs = table->num_inputs;
+    int num_outputs = table->num_outputs;
     
     SDL_Window* table_window = SDL_CreateWindow("Truth Table",
                                                TRUTH_TABLE_WIDTH, TRUTH_TABLE_HEIGHT,
@@ -176,7 +183,11 @@ void draw_truth_table_window(void* gates_ptr, int gate_count, int num_inputs, in
         return;
     }
     
-    int num_combinations = 1 << num_inputs; // 2^num_inputs
+    // Only the rows that fit in the window are drawn, the table itself is complete
+    int visible_rows = (TRUTH_TABLE_HEIGHT - HEADER_HEIGHT) / CELL_HEIGHT;
+    if (table->num_rows < visible_rows) {
+        visible_rows = (int)table->num_rows;
+    }
     
     bool table_running = true;
     SDL_Event table_event;
@@ -212,21 +223,11 @@ void draw_truth_table_window(void* gates_ptr, int gate_count, int num_inputs, in
         }
         
         // Draw table grid and data
-        for (int row = 0; row < num_combinations; row++) {
-            // Calculate input values for this combination
-            int input_values[MAX_GATES];
-            for (int i = 0; i < num_inputs; i++) {
-                input_values[i] = (row >> (num_inputs - 1 - i)) & 1;
-            }
-            
-            // Simulate circuit with these inputs
-            int output_values[MAX_GATES];
-            simulate_circuit_with_inputs(gates, gate_count, NULL, 0, input_values, output_values);
-            
+        for (int row = 0; row < visible_rows; row++) {
             // Draw input values
             for (int col = 0; col < num_inputs; col++) {
                 char value[2];
-                sprintf(value, "%d", input_values[col]);
+                sprintf(value, "%d", (row >> (num_inputs - 1 - col)) & 1);
                 draw_table_text(table_renderer, value, 
                                MARGIN + col * CELL_WIDTH, 
                                HEADER_HEIGHT + row * CELL_HEIGHT, cell_color);
@@ -235,7 +236,7 @@ void draw_truth_table_window(void* gates_ptr, int gate_count, int num_inputs, in
             // Draw output values
             for (int col = 0; col < num_outputs; col++) {
                 char value[2];
-                sprintf(value, "%d", output_values[col]);
+                sprintf(value, "%d", truth_table_get(table, col, row));
                 draw_table_text(table_renderer, value, 
                                MARGIN + (num_inputs + col) * CELL_WIDTH, 
                                HEADER_HEIGHT + row * CELL_HEIGHT, cell_color);
@@ -253,7 +254,7 @@ void draw_truth_table_window(void* gates_ptr, int gate_count, int num_inputs, in
             SDL_SetRenderDrawColor(table_renderer, 200, 200, 200, 255);
             SDL_RenderLine(table_renderer, MARGIN + col * CELL_WIDTH, MARGIN, 
                           MARGIN + col * CELL_WIDTH, 
-                          HEADER_HEIGHT + num_combinations * CELL_HEIGHT);
+                          HEADER_HEIGHT + visible_rows * CELL_HEIGHT);
         }
         
         SDL_RenderPresent(table_renderer);
@@ -264,18 +265,156 @@ void draw_truth_table_window(void* gates_ptr, int gate_count, int num_inputs, in
     SDL_DestroyWindow(table_window);
 }
 
-// Main function to generate truth table
-void generate_truth_table(void* gates_ptr, int gate_count, void* wires_ptr, int wire_count) {
-    LogicGate* gates = (LogicGate*)gates_ptr;
-    Wire* wires = (Wire*)wires_ptr;
+// Function to fill a truth table one row at a time (circuits with feedback loops)
+static int truth_table_by_rows(void* gates, int gate_count, void* wires, int wire_count,
+                               int num_inputs, int num_outputs, TruthTable* table) {
+    table->num_inputs = num_inputs;
+    table->num_outputs = num_outputs;
+    table->num_rows = 1LL << num_inputs;
+    table->words_per_output = (table->num_rows + 63) / 64;
+    table->bits = calloc((size_t)(num_outputs * table->words_per_output) + 1, sizeof(uint64_t));
+    ArenaMark mark = arena_mark(&scratch);
+    int* input_values = arena_alloc(&scratch, num_inputs, sizeof(int));
+    int* output_values = arena_alloc(&scratch, num_outputs, sizeof(int));
+    if (!table->bits || !input_values || !output_values) {
+        arena_release(&scratch, mark);
+        return -1;
+    }
     
-    printf("Generating truth table...\n");
+    for (long long row = 0; row < table->num_rows; row++) {
+        for (int i = 0; i < num_inputs; i++) {
+            input_values[i] = (row >> (num_inputs - 1 - i)) & 1;
+        }
+        simulate_circuit_with_inputs(gates, gate_count, wires, wire_count, input_values, output_values);
+        for (int o = 0; o < num_outputs; o++) {
+            if (output_values[o]) {
+                table->bits[o * table->words_per_output + row / 64] |= 1ULL << (row % 64);
+            }
+        }
+    }
+    arena_release(&scratch, mark);
+    return 0;
+}
+
+// Function to replace a compiled circuit by its and-inverter graph form, without
+// duplicate, constant and unobservable logic and with small cones rewritten when
+// that lowers to fewer gates. input_gates / output_gates are
+// moved to the new netlist. On failure the circuit is left as it was.
+static int lower_through_aig(SimNetlist* net, SimProgram* prog, int* input_gates, int num_inputs,
+                             int* output_gates, int num_outputs) {
+    Aig aig;
+    if (aig_init(&aig) != 0) return -1;
+    SimNetlist lowered = {0};
+    SimProgram lowered_prog = {0};
+    ArenaMark mark = arena_mark(&scratch);
+    int* lowered_inputs = arena_alloc(&scratch, num_inputs, sizeof(int));
+    int* lowered_outputs = arena_alloc(&scratch, num_outputs, sizeof(int));
+    int* lit_of_gate = arena_alloc(&scratch, prog->gate_count + 1, sizeof(int));
+    int status = -1;
+    if (lowered_inputs && lowered_outputs && lit_of_gate &&
+        aig_from_program(&aig, prog, input_gates, num_inputs, output_gates, num_outputs, lit_of_gate) == 0 &&
+        aig_rewrite_netlist(&aig, &lowered, lowered_inputs, lowered_outputs, NULL) >= 0 &&
+        sim_compile(&lowered_prog, &lowered) == 0) {
+        sim_free_program(prog);
+        sim_netlist_free(net);
+        *prog = lowered_prog;
+        *net = lowered;
+        memcpy(input_gates, lowered_inputs, num_inputs * sizeof(int));
+        memcpy(output_gates, lowered_outputs, num_outputs * sizeof(int));
+        status = 0;
+    } else {
+        sim_free_program(&lowered_prog);
+        sim_netlist_free(&lowered);
+    }
+    arena_release(&scratch, mark);
+    aig_free(&aig);
+    return status;
+}
+
+// Function to describe each output by its BDD when there are too many rows to list:
+// the number of rows where it is 1, and its rows grouped into cubes ('-' = either value)
+static void symbolic_truth_table(LogicGate* gates, int gate_count, Wire* wires, int wire_count,
+                                 int* input_gate_indices, int num_inputs,
+                                 int* output_gate_indices, int num_outputs) {
+    SimNetlist net = {0};
+    SimProgram prog = {0};
+    BddManager bdd;
+    if (build_sim_netlist(gates, gate_count, wires, wire_count, &net) != 0 ||
+        simopt_prune(&net) != 0 || sim_compile(&prog, &net) != 0 || prog.cyclic) {
+        printf("Circuit has a feedback loop, no truth table!\n");
+        sim_free_program(&prog);
+        sim_netlist_free(&net);
+        return;
+    }
+    lower_through_aig(&net, &prog, input_gate_indices, num_inputs, output_gate_indices, num_outputs);
+    ArenaMark mark = arena_mark(&scratch);
+    int* outputs = arena_alloc(&scratch, num_outputs, sizeof(int));
+    if (!outputs || bdd_init(&bdd, num_inputs, BDD_DEFAULT_MAX_NODES) != 0) {
+        printf("Not enough memory for the BDD manager!\n");
+    } else {
+        if (bdd_build_outputs(&bdd, &prog, input_gate_indices, num_inputs,
+                              output_gate_indices, num_outputs, outputs) != 0) {
+            printf("Circuit is too large for a symbolic truth table!\n");
+        } else {
+            bdd_reorder_sift(&bdd);
+            for (int o = 0; o < num_outputs; o++) {
+                printf("Output %d: %d BDD nodes, 1 in %.0f of 2^%d rows\n", o + 1,
+                       bdd_node_count(&bdd, outputs[o]), bdd_sat_count(&bdd, outputs[o]), num_inputs);
+                if (bdd_print_cubes(&bdd, outputs[o], stdout, SYMBOLIC_MAX_CUBES) == SYMBOLIC_MAX_CUBES) {
+                    printf("...\n");
+                }
+            }
+        }
+        bdd_free(&bdd);
+    }
+    arena_release(&scratch, mark);
+    sim_free_program(&prog);
+    sim_netlist_free(&net);
+}
+
+// Function to print each output as a minimized sum of products, and how many
+// gates that two-level form needs next to the circuit's own logic gates
+static void print_minimized_outputs(LogicGate* gates, int gate_count, const TruthTable* table) {
+    ArenaMark mark = arena_mark(&scratch);
+    SopCover* covers = arena_alloc(&scratch, table->num_outputs, sizeof(SopCover));
+    int* input_gates = arena_alloc(&scratch, table->num_inputs, sizeof(int));
+    int* output_gates = arena_alloc(&scratch, table->num_outputs, sizeof(int));
+    int minimized = 0;
+    while (covers && minimized < table->num_outputs && sop_minimize(table, minimized, &covers[minimized]) == 0) {
+        minimized++;
+    }
     
+    SimNetlist net = {0};
+    if (minimized < table->num_outputs || !input_gates || !output_gates ||
+        sop_build_netlist(covers, table->num_outputs, &net, input_gates, output_gates) != 0) {
+        printf("Not enough memory to minimize the outputs!\n");
+    } else {
+        for (int o = 0; o < table->num_outputs; o++) {
+            printf("Output %d = ", o + 1);
+            sop_print(&covers[o], stdout, MINIMIZED_MAX_TERMS);
+            printf("\n");
+        }
+        int logic_gates = 0;
+        for (int i = 0; i < gate_count; i++) {
+            if (!gates[i].in_palette && gates[i].gate_type != 6 && gates[i].gate_type != 7) logic_gates++;
+        }
+        printf("Logic gates: %d in the circuit, %d as minimized sums of products\n",
+               logic_gates, net.gate_count - table->num_inputs - table->num_outputs);
+    }
+    
+    for (int o = 0; o < minimized; o++) {
+        sop_cover_free(&covers[o]);
+    }
+    arena_release(&scratch, mark);
+    sim_netlist_free(&net);
+}
+
+// Function to generate the truth table, given room for the index of every gate
+// in input_gate_indices and output_gate_indices
+static void generate_truth_table_into(LogicGate* gates, int gate_count, Wire* wires, int wire_count,
+                                      int* input_gate_indices, int* output_gate_indices) {
     // Find all input and output gates
-    int input_gate_indices[MAX_GATES];
     int num_inputs = find_input_gates(gates, gate_count, input_gate_indices);
-    
-    int output_gate_indices[MAX_GATES];
     int num_outputs = find_output_gates(gates, gate_count, output_gate_indices);
     
     if (num_inputs == 0) {
@@ -288,9 +427,138 @@ void generate_truth_table(void* gates_ptr, int gate_count, void* wires_ptr, int
         return;
     }
     
+    if (num_inputs > TRUTH_TABLE_MAX_INPUTS) {
+        printf("Too many INPUT gates to enumerate (limit is %d), building BDDs instead\n", TRUTH_TABLE_MAX_INPUTS);
+        symbolic_truth_table(gates, gate_count, wires, wire_count, input_gate_indices, num_inputs,
+                             output_gate_indices, num_outputs);
+        return;
+    }
+    
     printf("Found %d input gates and %d output gates\n", num_inputs, num_outputs);
     
+    // Evaluate 512 rows per pass on the compiled circuit, spread over every core
+    SimNetlist net = {0};
+    SimProgram prog = {0};
+    TruthTable table = {0};
+    int result = -1;
+    if (build_sim_netlist(gates, gate_count, wires, wire_count, &net) == 0 &&
+        simopt_prune(&net) == 0 && sim_compile(&prog, &net) == 0 && !prog.cyclic) {
+        // Evaluate the structurally hashed and rewritten circuit, with duplicate logic built once
+        int operations = prog.instr_count;
+        if (lower_through_aig(&net, &prog, input_gate_indices, num_inputs,
+                              output_gate_indices, num_outputs) == 0) {
+            printf("Structural hashing and rewriting: %d operations, %d before\n", prog.instr_count, operations);
+        }
+        
+        // Large tables are worth compiling the circuit to native code first
+        CompiledCircuit native = {0};
+        if (num_inputs >= CODEGEN_MIN_INPUTS) {
+            if (codegen_load(&native, &prog) == 0) {
+                printf("Using compiled circuit%s\n", native.from_cache ? " (cached)" : "");
+            } else {
+                printf("Cannot compile the circuit (%s), using the interpreter\n", native.error);
+            }
+        }
+        result = ttpool_truth_table(&prog, input_gate_indices, num_inputs,
+                                    output_gate_indices, num_outputs, &table, 0);
+        codegen_unload(&native, &prog);
+    } else {
+        printf("Circuit has a feedback loop, simulating row by row\n");
+        result = truth_table_by_rows(gates, gate_count, wires, wire_count, num_inputs, num_outputs, &table);
+    }
+    sim_free_program(&prog);
+    sim_netlist_free(&net);
+    
+    if (result != 0) {
+        printf("Not enough memory for a %d-input truth table!\n", num_inputs);
+        truth_table_free(&table);
+        return;
+    }
+    
+    printf("Truth table has %lld rows\n", table.num_rows);
+    print_minimized_outputs(gates, gate_count, &table);
+    
     // Open truth table window
-    draw_truth_table_window((void*)gates, gate_count, num_inputs, num_outputs, 
-                       input_gate_indices, output_gate_indices);
-}
\ No newline at end of file
+    draw_truth_table_window(&table);
+    truth_table_free(&table);
+}
+
+// Main function to generate truth table
+void generate_truth_table(void* gates_ptr, int gate_count, void* wires_ptr, int wire_count) {
+    printf("Generating truth table...\n");
+    
+    ArenaMark mark = arena_mark(&scratch);
+    int* input_gate_indices = arena_alloc(&scratch, gate_count, sizeof(int));
+    int* output_gate_indices = arena_alloc(&scratch, gate_count, sizeof(int));
+    if (!input_gate_indices || !output_gate_indices) {
+        printf("Not enough memory to find the INPUT and OUTPUT gates!\n");
+    } else {
+        generate_truth_table_into((LogicGate*)gates_ptr, gate_count, (Wire*)wires_ptr, wire_count,
+                                  input_gate_indices, output_gate_indices);
+    }
+    arena_release(&scratch, mark);
+}
+
+// Function to check that two circuits compute the same function. INPUT and OUTPUT
+// gates are matched by their order in each gate array. Returns 1 if equivalent,
+// 0 if a counterexample was found, -1 if the check could not run.
+int check_equivalence(void* gates_a, int gate_count_a, void* wires_a, int wire_count_a,
+                      void* gates_b, int gate_count_b, void* wires_b, int wire_count_b) {
+    ArenaMark mark = arena_mark(&scratch);
+    int* inputs_a = arena_alloc(&scratch, gate_count_a, sizeof(int));
+    int* outputs_a = arena_alloc(&scratch, gate_count_a, sizeof(int));
+    int* inputs_b = arena_alloc(&scratch, gate_count_b, sizeof(int));
+    int* outputs_b = arena_alloc(&scratch, gate_count_b, sizeof(int));
+    unsigned char* counterexample = arena_alloc(&scratch, gate_count_a, sizeof(unsigned char));
+    if (!inputs_a || !outputs_a || !inputs_b || !outputs_b || !counterexample) {
+        printf("Not enough memory to compare the circuits!\n");
+        arena_release(&scratch, mark);
+        return -1;
+    }
+    int num_inputs = find_input_gates(gates_a, gate_count_a, inputs_a);
+    int num_outputs = find_output_gates(gates_a, gate_count_a, outputs_a);
+    if (find_input_gates(gates_b, gate_count_b, inputs_b) != num_inputs ||
+        find_output_gates(gates_b, gate_count_b, outputs_b) != num_outputs) {
+        printf("Circuits have different numbers of INPUT or OUTPUT gates!\n");
+        arena_release(&scratch, mark);
+        return 0;
+    }
+
+    SimNetlist net_a = {0}, net_b = {0};
+    SimProgram prog_a = {0}, prog_b = {0};
+    EquivResult result;
+    int status = -1;
+    if (build_sim_netlist(gates_a, gate_count_a, wires_a, wire_count_a, &net_a) != 0 ||
+        simopt_prune(&net_a) != 0 || sim_compile(&prog_a, &net_a) != 0 ||
+        build_sim_netlist(gates_b, gate_count_b, wires_b, wire_count_b, &net_b) != 0 ||
+        simopt_prune(&net_b) != 0 || sim_compile(&prog_b, &net_b) != 0) {
+        printf("Not enough memory to compile the circuits!\n");
+    } else if (prog_a.cyclic || prog_b.cyclic) {
+        printf("Circuit has a feedback loop, equivalence is undefined!\n");
+    } else if (equiv_check(&prog_a, inputs_a, outputs_a, &prog_b, inputs_b, outputs_b,
+                           num_inputs, num_outputs, EQUIV_RANDOM_VECTORS, &result, counterexample) != 0) {
+        printf("Not enough memory for the equivalence check!\n");
+    } else if (result.equivalent && result.symbolic) {
+        printf("Circuits are equivalent (proven by %s)\n", equiv_method_name(result.method));
+        status = 1;
+    } else if (result.equivalent) {
+        printf("Circuits are equivalent (%lld %s vectors)\n", result.vectors_checked,
+               result.exhaustive ? "exhaustive" : "random");
+        status = 1;
+    } else {
+        printf("Circuits differ on output %d (%d vs %d) for inputs", result.output + 1,
+               result.value_a, result.value_b);
+        for (int i = 0; i < num_inputs; i++) {
+            printf(" %d", counterexample[i]);
+        }
+        printf("\n");
+        status = 0;
+    }
+
+    sim_free_program(&prog_a);
+    sim_free_program(&prog_b);
+    sim_netlist_free(&net_a);
+    sim_netlist_free(&net_b);
+    arena_release(&scratch, mark);
+    return status;
+}
@@ -2,12 +2,15 @@
 #define TRUTH_TABLE_H
 
 #include "logicgates.h"
+#include "bitsim.h"
 
 // Use void pointers for all functions
 void generate_truth_table(void* gates, int gate_count, void* wires, int wire_count);
 int find_input_gates(void* gates, int gate_count, int* input_gate_indices);
 int find_output_gates(void* gates, int gate_count, int* output_gate_indices);
 void simulate_circuit_with_inputs(void* gates, int gate_count, void* wires, int wire_count, int* input_values, int* output_values);
-void draw_truth_table_window(void* gates, int gate_count, int num_inputs, int num_outputs, int* input_gate_indices, int* output_gate_indices);
+void draw_truth_table_window(const TruthTable* table);
+int check_equivalence(void* gates_a, int gate_count_a, void* wires_a, int wire_count_a,
+                      void* gates_b, int gate_count_b, void* wires_b, int wire_count_b);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,167 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "ttpool.h"
+#include "logicgates.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+// A worker's remaining chunks [begin, end) packed into one word so owner pops
+// and thief steals are single compare-and-swap operations
+#define RANGE(begin, end) (((uint64_t)(begin) << 32) | (uint32_t)(end))
+#define RANGE_BEGIN(r) ((uint32_t)((r) >> 32))
+#define RANGE_END(r) ((uint32_t)(r))
+
+typedef struct TTPool TTPool;
+
+typedef struct {
+    TTPool* pool;
+    int index;
+    _Atomic uint64_t range;
+    uint64_t* scratch;
+    pthread_t thread;
+} TTWorker;
+
+struct TTPool {
+    const SimProgram* prog;
+    const int* input_gates;
+    const int* output_gates;
+    TruthTable* table;
+    long long chunk_count;
+    int worker_count;
+    TTWorker* workers;
+};
+
+int ttpool_cpu_count(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#endif
+}
+
+// Function to take the next chunk from the front of the worker's own range
+static long long pop_own(TTWorker* w) {
+    uint64_t r = atomic_load(&w->range);
+    while (RANGE_BEGIN(r) < RANGE_END(r)) {
+        if (atomic_compare_exchange_weak(&w->range, &r, RANGE(RANGE_BEGIN(r) + 1, RANGE_END(r)))) {
+            return RANGE_BEGIN(r);
+        }
+    }
+    return -1;
+}
+
+// Function to move the back half of a victim's range to the thief
+static int steal(TTWorker* thief, TTWorker* victim) {
+    uint64_t r = atomic_load(&victim->range);
+    while (RANGE_BEGIN(r) < RANGE_END(r)) {
+        uint32_t begin = RANGE_BEGIN(r), end = RANGE_END(r);
+        uint32_t take = (end - begin + 1) / 2;
+        if (atomic_compare_exchange_weak(&victim->range, &r, RANGE(begin, end - take))) {
+            // Only the owner grows its own range, and it is empty right now
+            atomic_store(&thief->range, RANGE(end - take, end));
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void run_chunk(TTPool* pool, TTWorker* w, long long chunk) {
+    long long first = chunk * TTPOOL_CHUNK_WORDS;
+    long long count = pool->table->words_per_output - first;
+    if (count > TTPOOL_CHUNK_WORDS) count = TTPOOL_CHUNK_WORDS;
+    bitsim_fill_rows(pool->prog, pool->input_gates, pool->output_gates, pool->table, first, count, w->scratch);
+}
+
+static void* worker_main(void* arg) {
+    TTWorker* w = (TTWorker*)arg;
+    TTPool* pool = w->pool;
+
+    for (;;) {
+        long long chunk;
+        while ((chunk = pop_own(w)) >= 0) {
+            run_chunk(pool, w, chunk);
+        }
+
+        // Own range is empty, look for a victim starting with the next worker
+        int stolen = 0;
+        for (int k = 1; k < pool->worker_count && !stolen; k++) {
+            stolen = steal(w, &pool->workers[(w->index + k) % pool->worker_count]);
+        }
+        if (!stolen) break;   // every range is empty, all chunks are claimed
+    }
+    return NULL;
+}
+
+// Function to build a truth table on all cores with work stealing
+int ttpool_truth_table(const SimProgram* prog, const int* input_gates, int num_inputs,
+                       const int* output_gates, int num_outputs, TruthTable* table, int num_threads) {
+    memset(table, 0, sizeof(TruthTable));
+    if (prog->cyclic || truth_table_alloc(table, num_inputs, num_outputs) != 0) {
+        truth_table_free(table);
+        return -1;
+    }
+
+    TTPool pool;
+    pool.prog = prog;
+    pool.input_gates = input_gates;
+    pool.output_gates = output_gates;
+    pool.table = table;
+    pool.chunk_count = (table->words_per_output + TTPOOL_CHUNK_WORDS - 1) / TTPOOL_CHUNK_WORDS;
+
+    if (num_threads <= 0) num_threads = ttpool_cpu_count();
+    if (num_threads > TTPOOL_MAX_THREADS) num_threads = TTPOOL_MAX_THREADS;
+    if (num_threads > pool.chunk_count) num_threads = (int)pool.chunk_count;
+    pool.worker_count = num_threads;
+
+    pool.workers = calloc(num_threads, sizeof(TTWorker));
+    if (!pool.workers) {
+        truth_table_free(table);
+        return -1;
+    }
+    for (int i = 0; i < num_threads; i++) {
+        TTWorker* w = &pool.workers[i];
+        w->pool = &pool;
+        w->index = i;
+        w->scratch = malloc((size_t)(prog->gate_count + 1) * BITSIM_BLOCK_WORDS * sizeof(uint64_t));
+        // Even initial split, stealing evens out whatever the split gets wrong
+        long long begin = pool.chunk_count * i / num_threads;
+        long long end = pool.chunk_count * (i + 1) / num_threads;
+        atomic_init(&w->range, RANGE(begin, end));
+        if (!w->scratch) {
+            for (int j = 0; j <= i; j++) free(pool.workers[j].scratch);
+            free(pool.workers);
+            truth_table_free(table);
+            return -1;
+        }
+    }
+
+    // Pick the gate kernels before any worker evaluates a gate
+    logic_kernels_init();
+
+    // The calling thread works as worker 0
+    int started = 1;
+    for (int i = 1; i < num_threads; i++) {
+        if (pthread_create(&pool.workers[i].thread, NULL, worker_main, &pool.workers[i]) != 0) break;
+        started++;
+    }
+    worker_main(&pool.workers[0]);
+    for (int i = 1; i < started; i++) {
+        pthread_join(pool.workers[i].thread, NULL);
+    }
+
+    // Worker 0 steals from threads that failed to start, so every chunk was run
+    for (int i = 0; i < num_threads; i++) {
+        free(pool.workers[i].scratch);
+    }
+    free(pool.workers);
+    return 0;
+}
@@ -0,0 +1,20 @@
+#ifndef TTPOOL_H
+#define TTPOOL_H
+
+#include "bitsim.h"
+
+// Rows handed to a worker at a time: 64 blocks of BITSIM_BLOCK_WORDS words (32768 rows)
+#define TTPOOL_CHUNK_WORDS (64 * BITSIM_BLOCK_WORDS)
+#define TTPOOL_MAX_THREADS 64
+
+// Number of CPUs available to the pool
+int ttpool_cpu_count(void);
+
+// Same result as bitsim_truth_table, computed by num_threads workers (0 = one per CPU).
+// The 2^n rows are split into chunks; each worker drains its own range and steals
+// half of another worker's remaining range when it runs dry. Chunks write disjoint
+// words of the output bitsets, so no locks are taken.
+int ttpool_truth_table(const SimProgram* prog, const int* input_gates, int num_inputs,
+                       const int* output_gates, int num_outputs, TruthTable* table, int num_threads);
+
+#endif